@@ -0,0 +1,372 @@
+#include "gpcloudbench.h"
+#include "s3bucket_reader.h"
+#include "s3common_reader.h"
+#include "s3common_writer.h"
+#include "s3interface.h"
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+bool hasHeader;
+
+char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";
+
+TableFormat tableFormat;
+
+string s3extErrorMessage;
+
+volatile bool QueryCancelPending = false;
+
+bool S3QueryIsAbortInProgress(void) {
+    return QueryCancelPending;
+}
+
+void MaskThreadSignals() {
+}
+
+void *S3Alloc(size_t size) {
+    return malloc(size);
+}
+
+void S3Free(void *p) {
+    free(p);
+}
+
+static void handleAbortSignal(int signum) {
+    fprintf(stderr, "Interrupted by user (%s), exiting...\n\n", strsignal(signum));
+    QueryCancelPending = true;
+}
+
+struct BenchOptions {
+    BenchOptions()
+        : numOfThreads(4), chunkSize(8 * 1024 * 1024), runRead(true), runWrite(true) {
+        server.objectSize = 64 * 1024 * 1024;
+        server.numOfObjects = 4;
+    }
+
+    MockS3Options server;
+    uint64_t numOfThreads;
+    uint64_t chunkSize;
+    bool runRead;
+    bool runWrite;
+};
+
+// Numbers of a workload.
+struct BenchResult {
+    BenchResult() : bytes(0), seconds(0), cpuSeconds(0), numOfRequests(0), numOfRetries(0) {
+    }
+
+    uint64_t bytes;  // of uncompressed data read or written.
+    double seconds;
+    double cpuSeconds;  // user and system time of this process, server excluded.
+    uint64_t numOfRequests;
+    uint64_t numOfRetries;
+};
+
+CountingRESTfulService::CountingRESTfulService(RESTfulService *service)
+    : service(service), numOfRequests(0), numOfRetries(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+}
+
+CountingRESTfulService::~CountingRESTfulService() {
+    pthread_mutex_destroy(&this->mutex);
+}
+
+void CountingRESTfulService::count(bool failed) {
+    UniqueLock lock(&this->mutex);
+    this->numOfRequests++;
+    if (failed) {
+        this->numOfRetries++;
+    }
+}
+
+uint64_t CountingRESTfulService::getNumOfRequests() {
+    UniqueLock lock(&this->mutex);
+    return this->numOfRequests;
+}
+
+uint64_t CountingRESTfulService::getNumOfRetries() {
+    UniqueLock lock(&this->mutex);
+    return this->numOfRetries;
+}
+
+// S3InterfaceService retries requests failed with S3ConnectionError, like 500 responses.
+#define COUNT_REQUEST(request)            \
+    do {                                  \
+        try {                             \
+            this->count(false);           \
+            return request;               \
+        } catch (S3ConnectionError & e) { \
+            this->count(true);            \
+            throw;                        \
+        }                                 \
+    } while (0)
+
+Response CountingRESTfulService::get(const string &url, HTTPHeaders &headers) {
+    COUNT_REQUEST(this->service->get(url, headers));
+}
+
+Response CountingRESTfulService::put(const string &url, HTTPHeaders &headers,
+                                     const S3VectorUInt8 &data) {
+    COUNT_REQUEST(this->service->put(url, headers, data));
+}
+
+Response CountingRESTfulService::post(const string &url, HTTPHeaders &headers,
+                                      const vector<uint8_t> &data) {
+    COUNT_REQUEST(this->service->post(url, headers, data));
+}
+
+ResponseCode CountingRESTfulService::head(const string &url, HTTPHeaders &headers) {
+    COUNT_REQUEST(this->service->head(url, headers));
+}
+
+Response CountingRESTfulService::deleteRequest(const string &url, HTTPHeaders &headers) {
+    COUNT_REQUEST(this->service->deleteRequest(url, headers));
+}
+
+static double getSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double getCPUSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec / 1e6;
+}
+
+static S3Params makeParams(const BenchOptions &options, const string &url) {
+    S3Params params(url, false);
+
+    params.setCred("gpcloudbench", "gpcloudbench", "");
+    params.setChunkSize(options.chunkSize);
+    params.setNumOfChunks(options.numOfThreads);
+    params.setConnectionPoolSize(options.numOfThreads * 2);
+    params.setLowSpeedLimit(10240);
+    params.setLowSpeedTime(60);
+    params.setAutoCompress(options.server.gzip);
+
+    return params;
+}
+
+// Read all objects through S3BucketReader, like an external table does.
+static BenchResult benchRead(const BenchOptions &options, const string &bucketUrl) {
+    S3Params params = makeParams(options, bucketUrl + "data/");
+    PrepareS3MemContext(params);
+
+    S3RESTfulService restfulService(params);
+    CountingRESTfulService countingService(&restfulService);
+    S3InterfaceService s3InterfaceService(params);
+    s3InterfaceService.setRESTfulService(&countingService);
+
+    S3CommonReader commonReader;
+    commonReader.setS3InterfaceService(&s3InterfaceService);
+
+    S3BucketReader bucketReader;
+    bucketReader.setS3InterfaceService(&s3InterfaceService);
+    bucketReader.setUpstreamReader(&commonReader);
+
+    BenchResult result;
+    double startSeconds = getSeconds();
+    double startCPUSeconds = getCPUSeconds();
+
+    bucketReader.open(params);
+
+    char buf[BENCH_BUF_SIZE];
+    uint64_t len;
+    while ((len = bucketReader.read(buf, sizeof(buf))) != 0 && !S3QueryIsAbortInProgress()) {
+        result.bytes += len;
+    }
+
+    bucketReader.close();
+
+    result.seconds = getSeconds() - startSeconds;
+    result.cpuSeconds = getCPUSeconds() - startCPUSeconds;
+    result.numOfRequests = countingService.getNumOfRequests();
+    result.numOfRetries = countingService.getNumOfRetries();
+
+    return result;
+}
+
+// Upload as many objects as the server serves, through S3KeyWriter, compressed first if gzip.
+static BenchResult benchWrite(const BenchOptions &options, const string &bucketUrl) {
+    S3Params params = makeParams(options, bucketUrl + "upload/");
+    PrepareS3MemContext(params);
+
+    S3RESTfulService restfulService(params);
+    CountingRESTfulService countingService(&restfulService);
+    S3InterfaceService s3InterfaceService(params);
+    s3InterfaceService.setRESTfulService(&countingService);
+
+    // Same kind of lines as the server's objects.
+    string text;
+    for (uint64_t id = 0; text.size() < BENCH_BUF_SIZE; id++) {
+        text += std::to_string((unsigned long long)id) + "," +
+                std::to_string((unsigned long long)(id * 7919 % 1000000)) + ",name_" +
+                std::to_string((unsigned long long)(id * 104729 % 5000)) + "\n";
+    }
+    text.resize(BENCH_BUF_SIZE);
+
+    BenchResult result;
+    double startSeconds = getSeconds();
+    double startCPUSeconds = getCPUSeconds();
+
+    for (uint64_t i = 0; i < options.server.numOfObjects && !S3QueryIsAbortInProgress(); i++) {
+        string key = params.getS3Url().getPrefix() + std::to_string((unsigned long long)i) +
+                     (options.server.gzip ? ".csv.gz" : ".csv");
+
+        S3CommonWriter commonWriter;
+        commonWriter.setS3InterfaceService(&s3InterfaceService);
+        commonWriter.open(params.setPrefix(key));
+
+        for (uint64_t written = 0; written < options.server.objectSize;) {
+            uint64_t len = std::min((uint64_t)text.size(), options.server.objectSize - written);
+            written += commonWriter.write(text.data(), len);
+        }
+
+        commonWriter.close();
+        result.bytes += options.server.objectSize;
+    }
+
+    result.seconds = getSeconds() - startSeconds;
+    result.cpuSeconds = getCPUSeconds() - startCPUSeconds;
+    result.numOfRequests = countingService.getNumOfRequests();
+    result.numOfRetries = countingService.getNumOfRetries();
+
+    return result;
+}
+
+static void printResult(const char *workload, const BenchResult &result) {
+    double mb = result.bytes / (1024.0 * 1024.0);
+
+    printf("%-8s %10.1f %9.3f %9.1f %10.2f %9" PRIu64 " %8" PRIu64 "\n", workload, mb,
+           result.seconds, result.seconds > 0 ? mb / result.seconds : 0,
+           mb > 0 ? result.cpuSeconds * 1000 / mb : 0, result.numOfRequests, result.numOfRetries);
+}
+
+void printUsage(FILE *stream) {
+    fprintf(stream,
+            "Usage: gpcloudbench [-r | -w] [-s object_size] [-n num_of_objects] [-l latency_ms]\n"
+            "                    [-e error_rate] [-t threadnum] [-c chunksize] [-z]\n"
+            "  -r, -w  only read or only write, both by default.\n"
+            "  -s      bytes of every object, 64MB by default.\n"
+            "  -n      number of objects, 4 by default.\n"
+            "  -l      latency of every response of the mock S3 server in ms, 0 by default.\n"
+            "  -e      percentage of object GETs and part PUTs failed with 500, 0 by default.\n"
+            "  -t      threadnum of gpcloud, 4 by default.\n"
+            "  -c      chunksize of gpcloud, 8MB by default.\n"
+            "  -z      read gzip objects and write with autocompress.\n"
+            "  -h      show this help.\n");
+}
+
+static uint64_t parseNumber(int opt, const char *arg, uint64_t min, uint64_t max) {
+    char *end = NULL;
+    uint64_t value = strtoull(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || value < min || value > max) {
+        fprintf(stderr, "Failed. Invalid argument for -%c: '%s'.\n\n", opt, arg);
+        printUsage(stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return value;
+}
+
+BenchOptions parseCommandLineArgs(int argc, char *argv[]) {
+    BenchOptions options;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "rws:n:l:e:t:c:zh")) != -1) {
+        switch (opt) {
+            case 'r':
+                options.runWrite = false;
+                break;
+            case 'w':
+                options.runRead = false;
+                break;
+            case 's':
+                options.server.objectSize = parseNumber(opt, optarg, 1, 1ULL << 40);
+                break;
+            case 'n':
+                options.server.numOfObjects = parseNumber(opt, optarg, 1, 100000);
+                break;
+            case 'l':
+                options.server.latencyMs = parseNumber(opt, optarg, 0, 60000);
+                break;
+            case 'e':
+                options.server.errorRate = parseNumber(opt, optarg, 0, 100);
+                break;
+            case 't':
+                options.numOfThreads = parseNumber(opt, optarg, 1, 1024);
+                break;
+            case 'c':
+                options.chunkSize = parseNumber(opt, optarg, 8 * 1024 * 1024, 128 * 1024 * 1024);
+                break;
+            case 'z':
+                options.server.gzip = true;
+                break;
+            case 'h':
+                printUsage(stdout);
+                exit(EXIT_SUCCESS);
+            default:  // '?'
+                printUsage(stderr);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (!options.runRead && !options.runWrite) {
+        fprintf(stderr, "Failed. Can't set options '-r' '-w' at the same time.\n\n");
+        printUsage(stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return options;
+}
+
+int main(int argc, char *argv[]) {
+    s3ext_loglevel = EXT_ERROR;
+    s3ext_logtype = STDERR_LOG;
+    s3ext_segid = 0;
+    s3ext_segnum = 1;
+
+    BenchOptions options = parseCommandLineArgs(argc, argv);
+
+    MockS3Server server(options.server);
+
+    try {
+        server.start();
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Failed to start mock S3 server: %s\n", e.getFullMessage().c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGINT, handleAbortSignal);
+    signal(SIGTERM, handleAbortSignal);
+
+    printf("%" PRIu64 " objects of %" PRIu64 " bytes%s, latency %" PRIu64 "ms, error rate %" PRIu64
+           "%%, threadnum %" PRIu64 ", chunksize %" PRIu64 "\n\n",
+           options.server.numOfObjects, options.server.objectSize,
+           options.server.gzip ? " (gzip)" : "", options.server.latencyMs,
+           options.server.errorRate, options.numOfThreads, options.chunkSize);
+    printf("%-8s %10s %9s %9s %10s %9s %8s\n", "workload", "MB", "seconds", "MB/s", "CPU ms/MB",
+           "requests", "retries");
+
+    int ret = EXIT_SUCCESS;
+    try {
+        if (options.runRead) {
+            printResult("read", benchRead(options, server.getBucketUrl()));
+        }
+
+        if (options.runWrite) {
+            printResult("write", benchWrite(options, server.getBucketUrl()));
+        }
+    } catch (S3Exception &e) {
+        fprintf(stderr, "Failed: %s\n", e.getFullMessage().c_str());
+        ret = EXIT_FAILURE;
+    }
+
+    server.stop();
+
+    return ret;
+}
@@ -0,0 +1,419 @@
+#include "gpcloudbench.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Buffered reading of HTTP requests from a connection.
+class HTTPConnection {
+   public:
+    HTTPConnection(int fd) : fd(fd) {
+    }
+
+    ~HTTPConnection() {
+        ::close(this->fd);
+    }
+
+    bool readLine(string &line) {
+        size_t pos;
+        while ((pos = this->buffer.find("\r\n")) == string::npos) {
+            if (!this->fill()) {
+                return false;
+            }
+        }
+
+        line = this->buffer.substr(0, pos);
+        this->buffer.erase(0, pos + 2);
+        return true;
+    }
+
+    // Drop len bytes of body.
+    bool skip(uint64_t len) {
+        while (this->buffer.size() < len) {
+            len -= this->buffer.size();
+            this->buffer.clear();
+
+            if (!this->fill()) {
+                return false;
+            }
+        }
+
+        this->buffer.erase(0, len);
+        return true;
+    }
+
+    bool skipChunkedBody() {
+        string line;
+        while (this->readLine(line)) {
+            uint64_t len = strtoull(line.c_str(), NULL, 16);
+            if (len == 0) {
+                // trailers end with an empty line.
+                while (this->readLine(line) && !line.empty()) {
+                }
+                return true;
+            }
+
+            if (!this->skip(len) || !this->readLine(line)) {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    bool send(const string &head, const char *body, uint64_t len) {
+        return this->sendAll(head.data(), head.size()) && this->sendAll(body, len);
+    }
+
+   private:
+    bool fill() {
+        char buf[BENCH_BUF_SIZE];
+        ssize_t ret = recv(this->fd, buf, sizeof(buf), 0);
+        if (ret <= 0) {
+            return false;
+        }
+
+        this->buffer.append(buf, ret);
+        return true;
+    }
+
+    bool sendAll(const char *data, uint64_t len) {
+        while (len > 0) {
+            ssize_t ret = ::send(this->fd, data, len, MSG_NOSIGNAL);
+            if (ret <= 0) {
+                return false;
+            }
+
+            data += ret;
+            len -= ret;
+        }
+
+        return true;
+    }
+
+    int fd;
+    string buffer;
+};
+
+struct HTTPRequest {
+    string method;
+    string path;
+    string query;
+    map<string, string> headers;  // names in lower case.
+
+    string getHeader(const string &name) const {
+        map<string, string>::const_iterator it = headers.find(name);
+        return it == headers.end() ? "" : it->second;
+    }
+};
+
+static bool ReadRequest(HTTPConnection &conn, HTTPRequest &request) {
+    string line;
+    if (!conn.readLine(line)) {
+        return false;
+    }
+
+    // request line: method target version
+    size_t methodEnd = line.find(' ');
+    size_t targetEnd = line.find(' ', methodEnd + 1);
+    if (methodEnd == string::npos || targetEnd == string::npos) {
+        return false;
+    }
+
+    request.method = line.substr(0, methodEnd);
+    string target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+
+    size_t queryPos = target.find('?');
+    request.path = target.substr(0, queryPos);
+    request.query = (queryPos == string::npos) ? "" : target.substr(queryPos + 1);
+
+    while (conn.readLine(line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon == string::npos) {
+            continue;
+        }
+
+        string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        request.headers[name] = (valueStart == string::npos) ? "" : line.substr(valueStart);
+    }
+
+    if (strcasecmp(request.getHeader("expect").c_str(), "100-continue") == 0) {
+        conn.send("HTTP/1.1 100 Continue\r\n\r\n", NULL, 0);
+    }
+
+    // Uploaded data is not kept.
+    if (strcasecmp(request.getHeader("transfer-encoding").c_str(), "chunked") == 0) {
+        return conn.skipChunkedBody();
+    }
+
+    return conn.skip(strtoull(request.getHeader("content-length").c_str(), NULL, 10));
+}
+
+static bool SendResponse(HTTPConnection &conn, int code, const string &reason,
+                         const string &headers, const char *body, uint64_t len,
+                         bool withBody = true) {
+    stringstream head;
+    head << "HTTP/1.1 " << code << " " << reason << "\r\n"
+         << "Content-Length: " << len << "\r\n"
+         << headers << "\r\n";
+
+    return conn.send(head.str(), body, withBody ? len : 0);
+}
+
+static bool SendXML(HTTPConnection &conn, int code, const string &reason, const string &xml) {
+    string body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" + xml;
+    return SendResponse(conn, code, reason, "Content-Type: application/xml\r\n", body.data(),
+                        body.size());
+}
+
+static bool SendError(HTTPConnection &conn, int code, const string &reason, const string &s3Code) {
+    return SendXML(conn, code, reason,
+                   "<Error><Code>" + s3Code + "</Code><Message>" + reason + "</Message></Error>");
+}
+
+MockS3Server::MockS3Server(const MockS3Options &options)
+    : options(options), listenFd(-1), port(0), pid(0) {
+    for (uint64_t i = 0; i < options.numOfObjects; i++) {
+        char key[64];
+        snprintf(key, sizeof(key), "data/%05" PRIu64 ".csv%s", i, options.gzip ? ".gz" : "");
+        this->keys.push_back(key);
+    }
+}
+
+MockS3Server::~MockS3Server() {
+    this->stop();
+}
+
+void MockS3Server::start() {
+    this->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    S3_CHECK_OR_DIE(this->listenFd >= 0, S3RuntimeError, "failed to create socket");
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    socklen_t addrLen = sizeof(addr);
+    S3_CHECK_OR_DIE((bind(this->listenFd, (struct sockaddr *)&addr, sizeof(addr)) == 0) &&
+                        (listen(this->listenFd, SOMAXCONN) == 0) &&
+                        (getsockname(this->listenFd, (struct sockaddr *)&addr, &addrLen) == 0),
+                    S3RuntimeError, string("failed to listen on localhost: ") + strerror(errno));
+
+    this->port = ntohs(addr.sin_port);
+
+    // The server tells it is ready by closing its end of the pipe.
+    int readyPipe[2];
+    S3_CHECK_OR_DIE(pipe(readyPipe) == 0, S3RuntimeError, "failed to create pipe");
+
+    // Fork before any thread of the benchmark starts.
+    this->pid = fork();
+    S3_CHECK_OR_DIE(this->pid >= 0, S3RuntimeError, "failed to fork mock S3 server");
+
+    if (this->pid == 0) {
+        ::close(readyPipe[0]);
+        this->generateObject();
+        ::close(readyPipe[1]);
+
+        this->serve();
+        _exit(EXIT_SUCCESS);
+    }
+
+    ::close(readyPipe[1]);
+    ::close(this->listenFd);
+    this->listenFd = -1;
+
+    char c;
+    while (::read(readyPipe[0], &c, 1) < 0 && errno == EINTR) {
+    }
+    ::close(readyPipe[0]);
+}
+
+void MockS3Server::stop() {
+    if (this->pid > 0) {
+        kill(this->pid, SIGTERM);
+        waitpid(this->pid, NULL, 0);
+        this->pid = 0;
+    }
+}
+
+string MockS3Server::getBucketUrl() const {
+    stringstream url;
+    url << "s3://127.0.0.1:" << this->port << "/" << BENCH_BUCKET << "/";
+    return url.str();
+}
+
+// Lines of pseudo random numbers and names, compress about as well as real data.
+void MockS3Server::generateObject() {
+    string text;
+    text.reserve(this->options.objectSize);
+
+    uint64_t state = 88172645463325252ULL;
+    char line[128];
+    for (uint64_t id = 0; text.size() < this->options.objectSize; id++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        int len = snprintf(line, sizeof(line), "%" PRIu64 ",%" PRIu64 ",name_%" PRIu64
+                                               ",%" PRIu64 ".%02" PRIu64 "\n",
+                           id, state % 1000000, state % 5000, (state >> 20) % 100000,
+                           (state >> 40) % 100);
+        text.append(line, len);
+    }
+
+    // end with a complete line.
+    text.resize(this->options.objectSize);
+    if (!text.empty()) {
+        text[text.size() - 1] = '\n';
+    }
+
+    if (!this->options.gzip) {
+        this->object.swap(text);
+        return;
+    }
+
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    S3_CHECK_OR_DIE(deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                                 Z_DEFAULT_STRATEGY) == Z_OK,
+                    S3RuntimeError, "failed to initialize zlib library");
+
+    this->object.resize(deflateBound(&zstream, text.size()));
+
+    zstream.next_in = (Bytef *)text.data();
+    zstream.avail_in = text.size();
+    zstream.next_out = (Bytef *)&this->object[0];
+    zstream.avail_out = this->object.size();
+
+    int status = deflate(&zstream, Z_FINISH);
+    this->object.resize(zstream.total_out);
+    deflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE(status == Z_STREAM_END, S3RuntimeError, "failed to compress object");
+}
+
+struct ConnectionThreadData {
+    MockS3Server *server;
+    int fd;
+};
+
+void *MockS3Server::ConnectionThreadFunc(void *data) {
+    ConnectionThreadData *threadData = static_cast<ConnectionThreadData *>(data);
+
+    threadData->server->handleConnection(threadData->fd);
+
+    delete threadData;
+    return NULL;
+}
+
+// Runs in the server process until it is killed.
+void MockS3Server::serve() {
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_IGN);
+
+    while (true) {
+        int fd = accept(this->listenFd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        ConnectionThreadData *threadData = new ConnectionThreadData();
+        threadData->server = this;
+        threadData->fd = fd;
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, ConnectionThreadFunc, threadData) != 0) {
+            ::close(fd);
+            delete threadData;
+            continue;
+        }
+
+        pthread_detach(thread);
+    }
+}
+
+// Serve requests of a keep-alive connection until client closes it.
+void MockS3Server::handleConnection(int fd) {
+    HTTPConnection conn(fd);
+    unsigned int seed = fd ^ (unsigned int)time(NULL);
+
+    string bucketPath = string("/") + BENCH_BUCKET;
+
+    HTTPRequest request;
+    while (ReadRequest(conn, request)) {
+        if (this->options.latencyMs > 0) {
+            usleep(this->options.latencyMs * 1000);
+        }
+
+        string key;
+        if (request.path.compare(0, bucketPath.size(), bucketPath) == 0 &&
+            request.path.size() > bucketPath.size() + 1) {
+            key = request.path.substr(bucketPath.size() + 1);
+        }
+
+        bool isObject = std::find(this->keys.begin(), this->keys.end(), key) != this->keys.end();
+        bool injectError = ((uint64_t)rand_r(&seed) % 100) < this->options.errorRate;
+
+        bool ok;
+        if (request.method == "GET" && key.empty()) {
+            // listing, every object is under the prefix.
+            stringstream xml;
+            xml << "<ListBucketResult><Name>" << BENCH_BUCKET
+                << "</Name><Prefix>data/</Prefix><IsTruncated>false</IsTruncated>";
+            for (uint64_t i = 0; i < this->keys.size(); i++) {
+                xml << "<Contents><Key>" << this->keys[i] << "</Key><Size>" << this->object.size()
+                    << "</Size><ETag>\"" << i << "\"</ETag></Contents>";
+            }
+            xml << "</ListBucketResult>";
+
+            ok = SendXML(conn, 200, "OK", xml.str());
+        } else if (request.method == "GET" && isObject) {
+            uint64_t start = 0, end = this->object.size() - 1;
+            string range = request.getHeader("range");
+            bool isRange = !range.empty() && sscanf(range.c_str(), "bytes=%" SCNu64 "-%" SCNu64,
+                                                    &start, &end) == 2;
+            end = std::min(end, (uint64_t)this->object.size() - 1);
+
+            if (injectError) {
+                ok = SendError(conn, 500, "Internal Server Error", "InternalError");
+            } else if (start > end) {
+                ok = SendError(conn, 416, "Requested Range Not Satisfiable", "InvalidRange");
+            } else {
+                ok = SendResponse(conn, isRange ? 206 : 200, isRange ? "Partial Content" : "OK",
+                                  "", this->object.data() + start, end - start + 1);
+            }
+        } else if (request.method == "HEAD") {
+            ok = isObject ? SendResponse(conn, 200, "OK", "", this->object.data(),
+                                         this->object.size(), false)
+                          : SendResponse(conn, 404, "Not Found", "", NULL, 0);
+        } else if (request.method == "POST" && request.query == "uploads") {
+            ok = SendXML(conn, 200, "OK",
+                         "<InitiateMultipartUploadResult><UploadId>" + key +
+                             "</UploadId></InitiateMultipartUploadResult>");
+        } else if (request.method == "POST") {
+            ok = SendXML(conn, 200, "OK",
+                         "<CompleteMultipartUploadResult><Key>" + key +
+                             "</Key></CompleteMultipartUploadResult>");
+        } else if (request.method == "PUT") {
+            ok = injectError ? SendError(conn, 500, "Internal Server Error", "InternalError")
+                             : SendResponse(conn, 200, "OK", "ETag: \"" + request.query + "\"\r\n",
+                                            NULL, 0);
+        } else if (request.method == "DELETE") {
+            ok = SendResponse(conn, 204, "No Content", "", NULL, 0);
+        } else {
+            ok = SendError(conn, 404, "Not Found", "NoSuchKey");
+        }
+
+        if (!ok || strcasecmp(request.getHeader("connection").c_str(), "close") == 0) {
+            break;
+        }
+
+        request = HTTPRequest();
+    }
+}
@@ -1,6 +1,8 @@
 #ifndef INCLUDE_COMPRESS_WRITER_H_
 #define INCLUDE_COMPRESS_WRITER_H_
 
+#include <deque>
+
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3macros.h"
@@ -9,6 +11,23 @@
 // 2MB by default
 extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
+// Compress data into a gzip member recording its size in the "GP" extra subfield of header, see
+// GetGzipMemberSize().
+void CompressToGzipMember(const char *data, uint64_t len, vector<char> &member);
+
+// A block of input data, to be compressed by a worker into one gzip member.
+struct CompressJob {
+    CompressJob() : done(false) {
+    }
+
+    vector<char> input;
+    vector<char> output;
+    bool done;
+};
+
+// CompressWriter splits data into blocks of S3_ZIP_COMPRESS_CHUNKSIZE bytes, and compresses each
+// block into an independent gzip member on worker threads. Members are written to the underlying
+// writer in order, so the output is still a valid gzip stream, of concatenated members.
 class CompressWriter : public Writer {
    public:
     CompressWriter();
@@ -17,8 +36,8 @@ class CompressWriter : public Writer {
     virtual void open(const S3Params &params);
 
     // write() attempts to write up to count bytes from the buffer.
-    // If 'count' is larger than Zip chunk-buffer, it invokes writeOneChunk()
-    // repeatedly to finish upload. Throw exception if encounters errors.
+    // Full blocks are queued to compress, and compressed blocks are written to the underlying
+    // writer. Throw exception if encounters errors.
     virtual uint64_t write(const char *buf, uint64_t count);
 
     // This should be reentrant, has no side effects when called multiple times.
@@ -26,15 +45,37 @@ class CompressWriter : public Writer {
 
     void setWriter(Writer *writer);
 
+    uint64_t getNumOfMembers() const {
+        return numOfMembers;
+    }
+
    private:
-    void flush();
-    uint64_t writeOneChunk(const char *buf, uint64_t count);
+    static void *WorkerThreadFunc(void *data);
+
+    void startThreads();
+    void stopThreads();
+    void runWorker();
+
+    void queueJob();
+    void writeMembers(bool waitAll);
 
     Writer *writer;
 
-    // zlib related variables.
-    z_stream zstream;
-    char *out;  // Output buffer for compression.
+    std::shared_ptr<CompressJob> curJob;  // block being filled by write().
+
+    uint64_t numOfWorkers;
+    uint64_t maxQueuedJobs;
+    uint64_t numOfMembers;
+
+    vector<pthread_t> workerThreads;
+
+    // Protect all below, cond is broadcasted whenever any of them changes.
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    std::deque<std::shared_ptr<CompressJob>> jobs;     // in stream order.
+    std::deque<std::shared_ptr<CompressJob>> pending;  // waiting for worker.
+    bool stopping;
+    std::exception_ptr sharedException;
 
     // add this flag to make close() reentrant
     bool isClosed;
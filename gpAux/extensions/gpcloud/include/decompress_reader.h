@@ -1,6 +1,8 @@
 #ifndef INCLUDE_DECOMPRESS_READER_H_
 #define INCLUDE_DECOMPRESS_READER_H_
 
+#include <deque>
+
 #include "reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
@@ -10,6 +12,29 @@
 // 2MB by default
 extern uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
+// Return size of the gzip member at data if its header records one, as the "BC" extra subfield of
+// BGZF or the "GP" subfield written by CompressWriter does, or 0 if unknown.
+uint64_t GetGzipMemberSize(const char *data, uint64_t len);
+
+// A block of decompressed data, in stream order. Blocks inflated by the pipeline thread are done
+// when queued, while gzip members with known size are batched and inflated by a worker.
+struct DecompressJob {
+    DecompressJob() : done(false) {
+    }
+
+    vector<char> input;  // gzip members for worker to inflate.
+    vector<uint64_t> memberSizes;
+
+    vector<char> output;
+    bool done;
+};
+
+// DecompressReader inflates on its own threads, so that the caller formats data of one block
+// while following blocks are downloaded and inflated:
+//   - the pipeline thread borrows compressed data from the underlying reader by lend(), and
+//     inflates it into blocks of S3_ZIP_DECOMPRESS_CHUNKSIZE bytes.
+//   - independent gzip members are handed to worker threads to inflate in parallel.
+//   - read() or lend() returns data of blocks in order, the number of queued blocks is bounded.
 class DecompressReader : public Reader {
    public:
     DecompressReader();
@@ -24,24 +49,68 @@ class DecompressReader : public Reader {
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
+    virtual uint64_t lend(const char **buf, uint64_t count);
+
     void setReader(Reader *reader);
 
     void resizeDecompressReaderBuffer(uint64_t size);
 
+    uint64_t getNumOfParallelMembers() const {
+        return numOfParallelMembers;
+    }
+
    private:
-    void decompress();
+    static void *PipelineThreadFunc(void *data);
+    static void *WorkerThreadFunc(void *data);
 
-    uint64_t getDecompressedBytesNum() {
-        return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
-    }
+    void startThreads();
+    void stopThreads();
+
+    void runPipeline();
+    void runWorker();
+
+    bool waitForOutput();
+
+    bool lendInput();
+    bool fillInput();
+    void decompress();
+    void queueMember(uint64_t memberSize);
+    void queueJob(const std::shared_ptr<DecompressJob> &job, bool toWorker);
+    void inflateMembers(DecompressJob &job);
 
     Reader *reader;
 
-    // zlib related variables.
+    // zlib related variables, used by pipeline thread.
     z_stream zstream;
-    char *in;            // Input buffer for decompression.
-    char *out;           // Output buffer for decompression.
-    uint64_t outOffset;  // Next position to read in out buffer.
+    char *in;         // Input buffer for data across the end of lent data.
+    bool inMember;    // zstream is inflating a member or stream.
+    bool readerEOF;   // no more data from underlying reader.
+    bool inputLent;   // zstream.next_in might point to data lent by underlying reader.
+
+    // batch of gzip members waiting to be queued for workers.
+    std::shared_ptr<DecompressJob> memberBatch;
+    uint64_t batchOutputSize;
+
+    uint64_t numOfWorkers;
+    uint64_t maxQueuedJobs;
+    uint64_t numOfMembers;
+    uint64_t numOfParallelMembers;
+
+    pthread_t pipelineThread;
+    vector<pthread_t> workerThreads;
+    bool threadsStarted;
+
+    // Protect all below, cond is broadcasted whenever any of them changes.
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    std::deque<std::shared_ptr<DecompressJob>> jobs;     // in stream order.
+    std::deque<std::shared_ptr<DecompressJob>> pending;  // waiting for worker.
+    bool pipelineFinished;
+    bool stopping;
+    std::exception_ptr sharedException;
+
+    std::shared_ptr<DecompressJob> curJob;  // job read() is returning data from.
+    uint64_t outOffset;                     // Next position to read in output of curJob.
 
     bool isClosed;
 };
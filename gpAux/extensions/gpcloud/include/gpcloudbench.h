@@ -0,0 +1,87 @@
+#ifndef __GP_CLOUD_BENCH_H__
+#define __GP_CLOUD_BENCH_H__
+
+#include "restful_service.h"
+#include "s3common_headers.h"
+#include "s3memory_mgmt.h"
+#include "s3restful_service.h"
+
+#define BENCH_BUF_SIZE (64 * 1024)
+
+// Bucket served by MockS3Server, objects to read are "data/NNNNN.csv[.gz]".
+#define BENCH_BUCKET "gpcloudbench"
+
+extern volatile bool QueryCancelPending;
+extern bool S3QueryIsAbortInProgress(void);
+
+struct MockS3Options {
+    MockS3Options() : objectSize(0), numOfObjects(0), latencyMs(0), errorRate(0), gzip(false) {
+    }
+
+    uint64_t objectSize;  // bytes of text of every object, before compression.
+    uint64_t numOfObjects;
+    uint64_t latencyMs;  // delay of every response.
+    uint64_t errorRate;  // percentage of object GETs and part PUTs answered with 500.
+    bool gzip;
+};
+
+// MockS3Server is a local stand-in of S3, serving listing, ranged GET and multipart upload of
+// its bucket over plain HTTP. It runs in a child process, so that its CPU time is not counted
+// in the benchmark. Uploaded data is discarded.
+class MockS3Server {
+   public:
+    MockS3Server(const MockS3Options &options);
+    ~MockS3Server();
+
+    // Listen on a free port of localhost, and fork the server process.
+    void start();
+
+    void stop();
+
+    // URL of the bucket, like "s3://127.0.0.1:12345/gpcloudbench/".
+    string getBucketUrl() const;
+
+   private:
+    static void *ConnectionThreadFunc(void *data);
+
+    void serve();
+    void generateObject();
+    void handleConnection(int fd);
+
+    MockS3Options options;
+
+    int listenFd;
+    uint16_t port;
+    pid_t pid;
+
+    string object;  // content of every object, generated by the server process.
+    vector<string> keys;
+};
+
+// Forward requests to S3RESTfulService, counting them and the failed ones that S3InterfaceService
+// retries.
+class CountingRESTfulService : public RESTfulService {
+   public:
+    CountingRESTfulService(RESTfulService *service);
+    virtual ~CountingRESTfulService();
+
+    Response get(const string &url, HTTPHeaders &headers);
+    Response put(const string &url, HTTPHeaders &headers, const S3VectorUInt8 &data);
+    Response post(const string &url, HTTPHeaders &headers, const vector<uint8_t> &data);
+    ResponseCode head(const string &url, HTTPHeaders &headers);
+    Response deleteRequest(const string &url, HTTPHeaders &headers);
+
+    uint64_t getNumOfRequests();
+    uint64_t getNumOfRetries();
+
+   private:
+    void count(bool failed);
+
+    RESTfulService *service;
+
+    pthread_mutex_t mutex;
+    uint64_t numOfRequests;
+    uint64_t numOfRetries;
+};
+
+#endif
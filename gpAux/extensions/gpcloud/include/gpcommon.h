@@ -12,6 +12,21 @@ extern bool S3QueryIsAbortInProgress(void);
 extern char eolString[];
 extern bool hasHeader;
 
+// Layout of rows for readers generating them from other formats, e.g. ParquetReader, taken from
+// FORMAT options and columns of the external table.
+struct TableFormat {
+    TableFormat() : isCsv(false), delimiter('\t'), escape('\\'), quote('"'), nullString("\\N") {
+    }
+
+    bool isCsv;
+    char delimiter;  // '\0' if delimiter is off.
+    char escape;     // '\0' if escape is off.
+    char quote;
+    string nullString;
+    vector<string> columns;  // names of columns, empty to read all columns of the file.
+};
+extern TableFormat tableFormat;
+
 // TODO change to functions getgpsegmentId() and getgpsegmentCount()
 typedef int32_t int32;
 typedef int32 int4;
@@ -24,4 +39,8 @@ typedef struct GpId {
 } GpId;
 extern GpId GpIdentity;
 
+// Identify the statement being executed, same on all segments.
+extern int gp_session_id;
+extern int gp_command_count;
+
 #endif
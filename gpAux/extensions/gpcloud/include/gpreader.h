@@ -1,6 +1,7 @@
 #ifndef __GP_READER_H__
 #define __GP_READER_H__
 
+#include "parquet_reader.h"
 #include "reader.h"
 #include "s3bucket_reader.h"
 #include "s3common_headers.h"
@@ -26,6 +27,9 @@ class GPReader : public Reader {
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
+    virtual uint64_t lend(const char **buf, uint64_t count);
+    virtual void giveBack();
+
     const ListBucketResult &getKeyList() {
         return bucketReader.getKeyList();
     }
@@ -34,6 +38,7 @@ class GPReader : public Reader {
     S3Params params;
     S3BucketReader bucketReader;
     S3CommonReader commonReader;
+    ParquetReader parquetReader;
     S3RESTfulService restfulService;
 
     S3InterfaceService s3InterfaceService;
@@ -0,0 +1,345 @@
+#ifndef INCLUDE_PARQUET_READER_H_
+#define INCLUDE_PARQUET_READER_H_
+
+#include "gpcommon.h"
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+
+// Magic bytes at the beginning and the end of a Parquet file.
+#define PARQUET_MAGIC "PAR1"
+#define PARQUET_MAGIC_LEN 4
+
+// Size of the first request for the footer, enough for the metadata of most files.
+#define PARQUET_FOOTER_FETCH_SIZE (64 * 1024)
+
+// Column chunks of a row group closer than this are fetched in one request.
+#define PARQUET_MAX_MERGE_GAP (1024 * 1024)
+
+// Subset of definitions in parquet.thrift used by ParquetReader.
+enum ParquetType {
+    PARQUET_BOOLEAN = 0,
+    PARQUET_INT32 = 1,
+    PARQUET_INT64 = 2,
+    PARQUET_INT96 = 3,
+    PARQUET_FLOAT = 4,
+    PARQUET_DOUBLE = 5,
+    PARQUET_BYTE_ARRAY = 6,
+    PARQUET_FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+enum ParquetConvertedType {
+    PARQUET_CONVERTED_NONE = -1,
+    PARQUET_UTF8 = 0,
+    PARQUET_DECIMAL = 5,
+    PARQUET_DATE = 6,
+    PARQUET_TIMESTAMP_MILLIS = 9,
+    PARQUET_TIMESTAMP_MICROS = 10,
+    PARQUET_UINT_8 = 11,
+    PARQUET_UINT_16 = 12,
+    PARQUET_UINT_32 = 13,
+    PARQUET_UINT_64 = 14,
+    PARQUET_JSON = 19,
+};
+
+enum ParquetTimeUnit {
+    PARQUET_TIME_UNIT_NONE = 0,
+    PARQUET_MILLIS = 1,
+    PARQUET_MICROS = 2,
+    PARQUET_NANOS = 3,
+};
+
+enum ParquetRepetition {
+    PARQUET_REQUIRED = 0,
+    PARQUET_OPTIONAL = 1,
+    PARQUET_REPEATED = 2,
+};
+
+enum ParquetEncoding {
+    PARQUET_PLAIN = 0,
+    PARQUET_PLAIN_DICTIONARY = 2,
+    PARQUET_RLE = 3,
+    PARQUET_RLE_DICTIONARY = 8,
+};
+
+enum ParquetCodec {
+    PARQUET_UNCOMPRESSED = 0,
+    PARQUET_SNAPPY = 1,
+    PARQUET_GZIP = 2,
+};
+
+enum ParquetPageType {
+    PARQUET_DATA_PAGE = 0,
+    PARQUET_INDEX_PAGE = 1,
+    PARQUET_DICTIONARY_PAGE = 2,
+    PARQUET_DATA_PAGE_V2 = 3,
+};
+
+struct ParquetStatistics {
+    ParquetStatistics()
+        : hasMin(false), hasMax(false), isLegacy(false), hasNullCount(false), nullCount(0) {
+    }
+
+    // min_value/max_value, or the deprecated min/max if the former are absent, see isLegacy.
+    bool hasMin;
+    bool hasMax;
+    string min;
+    string max;
+    bool isLegacy;
+
+    bool hasNullCount;
+    int64_t nullCount;
+};
+
+struct ParquetColumnChunk {
+    ParquetColumnChunk()
+        : type(0),
+          codec(0),
+          numValues(0),
+          totalCompressedSize(0),
+          dataPageOffset(0),
+          dictionaryPageOffset(0) {
+    }
+
+    // Offset of the first page of the chunk.
+    int64_t getStart() const {
+        return (dictionaryPageOffset > 0) ? std::min(dictionaryPageOffset, dataPageOffset)
+                                          : dataPageOffset;
+    }
+
+    int32_t type;
+    int32_t codec;
+    vector<string> path;
+    int64_t numValues;
+    int64_t totalCompressedSize;
+    int64_t dataPageOffset;
+    int64_t dictionaryPageOffset;
+    ParquetStatistics statistics;
+};
+
+struct ParquetRowGroup {
+    ParquetRowGroup() : numRows(0) {
+    }
+
+    vector<ParquetColumnChunk> columns;
+    int64_t numRows;
+};
+
+struct ParquetSchemaElement {
+    ParquetSchemaElement()
+        : type(-1),
+          typeLength(0),
+          repetition(PARQUET_REQUIRED),
+          numChildren(0),
+          convertedType(PARQUET_CONVERTED_NONE),
+          scale(0),
+          precision(0),
+          timeUnit(PARQUET_TIME_UNIT_NONE),
+          isAdjustedToUTC(false) {
+    }
+
+    int32_t type;  // -1 for groups.
+    int32_t typeLength;
+    int32_t repetition;
+    string name;
+    int32_t numChildren;
+    int32_t convertedType;
+    int32_t scale;
+    int32_t precision;
+
+    // of timestamps, from logicalType or convertedType.
+    int32_t timeUnit;
+    bool isAdjustedToUTC;
+};
+
+struct ParquetFileMetaData {
+    ParquetFileMetaData() : numRows(0) {
+    }
+
+    vector<ParquetSchemaElement> schema;  // depth-first, the root first.
+    int64_t numRows;
+    vector<ParquetRowGroup> rowGroups;
+};
+
+struct ParquetPageHeader {
+    ParquetPageHeader()
+        : type(0),
+          uncompressedSize(0),
+          compressedSize(0),
+          numValues(0),
+          encoding(0),
+          defLevelEncoding(0),
+          defLevelsByteLength(0),
+          repLevelsByteLength(0),
+          isCompressed(true) {
+    }
+
+    int32_t type;
+    int32_t uncompressedSize;
+    int32_t compressedSize;
+
+    // of data page, data page v2 or dictionary page.
+    int32_t numValues;
+    int32_t encoding;
+    int32_t defLevelEncoding;  // of data page.
+
+    // of data page v2, whose levels are not compressed.
+    int32_t defLevelsByteLength;
+    int32_t repLevelsByteLength;
+    bool isCompressed;
+};
+
+// Parse FileMetaData in the footer, or PageHeader at the beginning of a page, both encoded in
+// Thrift compact protocol. Return the number of bytes parsed, throw exception if data is invalid.
+uint64_t ParseParquetFileMetaData(const char *data, uint64_t len, ParquetFileMetaData *metadata);
+uint64_t ParseParquetPageHeader(const char *data, uint64_t len, ParquetPageHeader *header);
+
+// Uncompress a raw Snappy block of uncompressedSize bytes into output.
+void SnappyUncompress(const char *data, uint64_t len, uint64_t uncompressedSize,
+                      vector<char> &output);
+
+// A leaf column of the file, found by name.
+struct ParquetColumn {
+    ParquetColumn() : leafIndex(-1), maxDefLevel(0) {
+    }
+
+    string name;
+    int64_t leafIndex;  // index of its chunk in a row group, -1 if the file doesn't have it.
+    ParquetSchemaElement element;
+    int32_t maxDefLevel;
+};
+
+// A simple condition, "column op value", rows groups whose statistics show no row satisfies it
+// are skipped.
+struct ParquetPredicate {
+    string column;
+    string op;  // one of "=", "<", "<=", ">", ">=".
+    string value;
+};
+
+// Parse comma-separated predicates like "id>=100,name=bob".
+vector<ParquetPredicate> ParseParquetFilter(const string &filter);
+
+// Return false if statistics of the chunk show no value satisfies predicate. Types or statistics
+// it doesn't understand never skip.
+bool ParquetChunkMayMatch(const ParquetColumn &column, const ParquetColumnChunk &chunk,
+                          const ParquetPredicate &predicate);
+
+// Decode values of a column chunk page by page.
+class ParquetColumnReader {
+   public:
+    ParquetColumnReader();
+
+    // data is the whole chunk, must live until the next reset().
+    void reset(const ParquetColumn &column, const ParquetColumnChunk &chunk, const char *data,
+               uint64_t len);
+
+    // Set value to the text of the next value, return false if it is NULL.
+    bool next(string &value);
+
+   private:
+    void readPage();
+    void readDictionaryPage(const ParquetPageHeader &header, const char *data, uint64_t len);
+    void readDataPage(const ParquetPageHeader &header, const char *data, uint64_t len);
+    const char *uncompress(const char *data, uint64_t len, uint64_t uncompressedSize,
+                           vector<char> &buffer);
+
+    void formatPlainValue(string &value);
+    void formatValue(const char *data, uint64_t len, string &value);
+
+    const ParquetColumn *column;
+    int32_t codec;
+
+    const char *chunkData;
+    uint64_t chunkLen;
+    uint64_t chunkPos;
+
+    // Values of the dictionary page.
+    vector<char> dictBuffer;
+    vector<std::pair<const char *, uint64_t>> dictValues;
+
+    // Current data page, values are dictionary indexes, RLE encoded booleans or PLAIN encoded.
+    vector<char> pageBuffer;
+    vector<uint32_t> defLevels;
+    vector<uint32_t> dictIndexes;  // or booleans of RLE encoding.
+    uint64_t numOfPageValues;
+    uint64_t pageValueIndex;  // among all values of the page, including NULLs.
+    uint64_t nonNullIndex;    // among non-NULL values of the page.
+    bool dictEncoded;
+    bool rleEncoded;
+    const char *plainPos;
+    const char *plainEnd;
+};
+
+// ParquetReader reads Parquet files as rows in the layout of tableFormat. It fetches the footer
+// of a key, then only the column chunks of columns in tableFormat.columns, which are matched by
+// name, and skips row groups ruled out by the filter. When the key is read in byte ranges, a range
+// reads the row groups starting in it.
+class ParquetReader : public Reader {
+   public:
+    ParquetReader();
+    virtual ~ParquetReader();
+
+    virtual void open(const S3Params &params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    virtual uint64_t read(char *buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setS3InterfaceService(S3Interface *s3) {
+        this->s3Interface = s3;
+    }
+
+    uint64_t getNumOfSkippedRowGroups() const {
+        return numOfSkippedRowGroups;
+    }
+
+    uint64_t getFetchedBytes() const {
+        return fetchedBytes;
+    }
+
+   private:
+    void readFooter();
+    void resolveColumns();
+    bool nextRowGroup();
+    bool rowGroupMayMatch(const ParquetRowGroup &rowGroup);
+    void fetchRowGroup(const ParquetRowGroup &rowGroup);
+    void fetch(uint64_t offset, uint64_t len, S3VectorUInt8 &data);
+
+    void appendHeader();
+    void appendRow();
+    void appendField(const string &value, bool isNull);
+
+    S3Interface *s3Interface;
+    S3Url s3Url;
+    uint64_t keySize;
+    uint64_t rangeStart;
+    uint64_t rangeEnd;
+
+    ParquetFileMetaData metadata;
+    vector<ParquetColumn> fileColumns;  // supported columns of the file.
+    vector<ParquetColumn> columns;      // columns to read, in order of tableFormat.columns.
+    vector<std::pair<ParquetColumn, ParquetPredicate>> predicates;
+
+    uint64_t rowGroupIndex;  // next row group to read.
+    int64_t rowsLeft;        // of the current row group.
+
+    // Column chunks of the current row group, and their readers.
+    vector<S3VectorUInt8> chunkData;
+    vector<ParquetColumnReader> columnReaders;
+
+    string rows;  // formatted rows not returned yet.
+    uint64_t rowsOffset;
+    string value;
+
+    uint64_t numOfSkippedRowGroups;
+    uint64_t fetchedBytes;
+
+    bool isClosed;
+};
+
+#endif /* INCLUDE_PARQUET_READER_H_ */
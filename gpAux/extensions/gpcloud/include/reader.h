@@ -18,6 +18,25 @@ class Reader {
 
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close() = 0;
+
+    // lend() sets buf to up to count bytes of data held by the reader, instead of copying them
+    // like read() does, and returns its size, 0 if EOF. The data stays valid until giveBack(),
+    // which must be called before the next lend() or read(). Readers holding no data of their own
+    // lend a buffer filled by read().
+    virtual uint64_t lend(const char **buf, uint64_t count) {
+        this->lendBuffer.resize(count);
+
+        uint64_t len = this->read(this->lendBuffer.data(), count);
+        *buf = this->lendBuffer.data();
+        return len;
+    }
+
+    // Done with data of the last lend(), the reader may reuse or free it.
+    virtual void giveBack() {
+    }
+
+   private:
+    vector<char> lendBuffer;
 };
 
 #endif
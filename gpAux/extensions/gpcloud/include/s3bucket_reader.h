@@ -6,6 +6,23 @@
 #include "s3exception.h"
 #include "s3interface.h"
 
+// A key, or a byte range of it, for this segment to read.
+struct KeyRange {
+    KeyRange(uint64_t keyIndex, uint64_t rangeStart, uint64_t rangeEnd)
+        : keyIndex(keyIndex), rangeStart(rangeStart), rangeEnd(rangeEnd) {
+    }
+
+    uint64_t keyIndex;  // index of the key in keyList.contents.
+
+    // Byte range of the key to read, [0, 0) means the whole key.
+    uint64_t rangeStart;
+    uint64_t rangeEnd;
+};
+
+// Serialize keys of listing into a string, or parse the string back, to share it among segments.
+string SerializeKeyList(const ListBucketResult &keyList);
+bool DeserializeKeyList(const string &data, ListBucketResult *keyList);
+
 // S3BucketReader read multiple files in a bucket.
 class S3BucketReader : public Reader {
    public:
@@ -16,6 +33,9 @@ class S3BucketReader : public Reader {
     uint64_t read(char *buf, uint64_t count);
     void close();
 
+    uint64_t lend(const char **buf, uint64_t count);
+    void giveBack();
+
     void setS3InterfaceService(S3Interface *s3) {
         this->s3Interface = s3;
     }
@@ -36,6 +56,7 @@ class S3BucketReader : public Reader {
     // upstreamReader is where we get data from.
     Reader *upstreamReader;
     bool needNewReader;
+    bool lentByUpstream;  // data of the last lend() belongs to upstreamReader.
 
     // when load multiple files on one segment and each of them has a header line,
     // we should read header line only for the 1st file and ignore remainings.
@@ -46,9 +67,25 @@ class S3BucketReader : public Reader {
     uint64_t readWithoutHeaderLine(char *buf, uint64_t count);
 
     ListBucketResult keyList;  // List of matched keys/files.
-    uint64_t keyIndex;         // BucketContent index of keylist->contents.
 
-    BucketContent &getNextKey();
+    string sharedListingPath;  // shared listing file to remove at close(), empty if none.
+
+    vector<KeyRange> segmentKeys;  // Keys or ranges for this segment, in order of keyList.
+    uint64_t keyIndex;             // Index of segmentKeys.
+
+    // Byte range of current key to read, [0, 0) means the whole key.
+    uint64_t rangeStart;
+    uint64_t rangeEnd;
+
+    ListBucketResult listBucket(S3Url &s3Url);
+    bool loadSharedKeyList(int fd, ListBucketResult *keyList);
+    void saveSharedKeyList(int fd, const ListBucketResult &keyList);
+    string getSharedListingPath(S3Url &s3Url);
+
+    void assignKeys();
+    BucketContent *getNextKey();
+    uint64_t getNumOfRanges(BucketContent &key);
+    S3Url getKeyUrl(BucketContent &key);
     S3Params constructReaderParams(BucketContent &key);
 };
 
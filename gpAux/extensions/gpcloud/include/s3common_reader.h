@@ -24,6 +24,9 @@ class S3CommonReader : public Reader {
     // This should be reentrant, has no side effects when called multiple times.
     virtual void close();
 
+    virtual uint64_t lend(const char** buf, uint64_t count);
+    virtual void giveBack();
+
     // Used by Mock, DO NOT call it in other places.
     void setS3InterfaceService(S3Interface* s3InterfaceService) {
         this->s3InterfaceService = s3InterfaceService;
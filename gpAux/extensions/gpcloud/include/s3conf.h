@@ -9,6 +9,12 @@ extern int32_t s3ext_segid;
 // total segment number
 extern int32_t s3ext_segnum;
 
+// identify the statement segments are running, empty if unknown
+extern string s3ext_queryid;
+
+// where segments of the host share bucket listing, empty if unknown
+extern string s3ext_listingdir;
+
 // UDP socket to send log
 extern int32_t s3ext_logsock_udp;
 
@@ -0,0 +1,62 @@
+#ifndef INCLUDE_S3DISK_CACHE_H_
+#define INCLUDE_S3DISK_CACHE_H_
+
+#include "s3common_headers.h"
+#include "s3macros.h"
+#include "s3memory_mgmt.h"
+
+// Lock file of the cache directory, held while evicting.
+#define S3_DISK_CACHE_LOCK_FILE ".lock"
+
+// Evict down to this percentage of the max size, so that eviction doesn't run on every put().
+#define S3_DISK_CACHE_LOW_WATERMARK 90
+
+struct S3DiskCacheStats {
+    S3DiskCacheStats() : numOfHits(0), numOfMisses(0), hitBytes(0), numOfEvictions(0) {
+    }
+
+    uint64_t numOfHits;
+    uint64_t numOfMisses;
+    uint64_t hitBytes;
+    uint64_t numOfEvictions;
+};
+
+// S3DiskCache keeps downloaded data in files of a local directory, shared by all segments of a
+// host. Every entry is a file named after SHA256 of its key, and mtime of the file is updated on
+// every hit, so that least recently used files are evicted when total size exceeds the max size.
+class S3DiskCache {
+   public:
+    S3DiskCache();
+    ~S3DiskCache();
+
+    static S3DiskCache &getInstance();
+
+    // Empty dir disables the cache. Must be called when no other threads are using the cache.
+    void configure(const string &dir, uint64_t maxSize);
+
+    bool isEnabled() const {
+        return !dir.empty();
+    }
+
+    // Fill data with len bytes cached for key, return false if not cached.
+    bool get(const string &key, S3VectorUInt8 &data, uint64_t len);
+
+    void put(const string &key, const S3VectorUInt8 &data, uint64_t len);
+
+    S3DiskCacheStats getStats();
+
+   private:
+    string getPath(const string &key);
+    void evict();
+
+    string dir;
+    uint64_t maxSize;
+
+    // Protect all below.
+    pthread_mutex_t mutex;
+    uint64_t usedSize;  // updated by directory scan of evict(), and put() of this process since.
+    bool usageKnown;
+    S3DiskCacheStats stats;
+};
+
+#endif /* INCLUDE_S3DISK_CACHE_H_ */
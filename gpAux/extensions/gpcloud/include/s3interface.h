@@ -23,9 +23,10 @@ enum S3CompressionType {
 struct BucketContent {
     BucketContent() : name(""), size(0) {
     }
-    BucketContent(string name, uint64_t size) {
+    BucketContent(string name, uint64_t size, string etag = "") {
         this->name = name;
         this->size = size;
+        this->etag = etag;
     }
     ~BucketContent() {
     }
@@ -36,9 +37,13 @@ struct BucketContent {
     uint64_t getSize() const {
         return this->size;
     };
+    string getETag() const {
+        return this->etag;
+    };
 
     string name;
     uint64_t size;
+    string etag;
 };
 
 struct ListBucketResult {
@@ -3,17 +3,35 @@
 
 #include "reader.h"
 #include "s3common_headers.h"
+#include "s3disk_cache.h"
 #include "s3exception.h"
 #include "s3interface.h"
 
+// Size of each request to fetch the line crossing the end of a key range.
+#define S3_RANGE_TAIL_FETCH_SIZE (64 * 1024)
+
+// Chunks downloaded in a round of DownloadTuner, per thread.
+#define S3_TUNE_SAMPLES_PER_THREAD 2
+
+// Chunks downloaded faster than this are dominated by request overhead, so chunk size grows.
+#define S3_TUNE_MIN_CHUNK_LATENCY_MS 500
+
+// Chunks downloaded slower than this stall the reader and are costly to retry, so chunk size
+// shrinks.
+#define S3_TUNE_MAX_CHUNK_LATENCY_MS 5000
+
+// Changes of throughput within this percentage are taken as noise.
+#define S3_TUNE_THROUGHPUT_TOLERANCE 10
+
 struct Range {
     uint64_t offset;
     uint64_t length;
+    uint64_t index;  // sequence number of the chunk.
 };
 
 class OffsetMgr {
    public:
-    OffsetMgr() : keySize(0), chunkSize(0), curPos(0) {
+    OffsetMgr() : keySize(0), chunkSize(0), curPos(0), numOfRanges(0) {
         pthread_mutex_init(&this->offsetLock, NULL);
     }
     ~OffsetMgr() {
@@ -26,7 +44,9 @@ class OffsetMgr {
         return chunkSize;
     }
 
+    // Chunk size may change while threads are getting offsets, it applies to the next chunk.
     void setChunkSize(uint64_t chunkSize) {
+        UniqueLock lock(&this->offsetLock);
         this->chunkSize = chunkSize;
     }
 
@@ -46,6 +66,7 @@ class OffsetMgr {
         this->setCurPos(0);
         this->setChunkSize(0);
         this->setKeySize(0);
+        this->numOfRanges = 0;
     }
 
     uint64_t getCurPos() const {
@@ -57,6 +78,67 @@ class OffsetMgr {
     uint64_t keySize;  // size of S3 key(file)
     uint64_t chunkSize;
     uint64_t curPos;
+    uint64_t numOfRanges;  // handed out so far.
+};
+
+// DownloadTuner adjusts chunk size and number of concurrent downloads of a key within configured
+// bounds. It measures chunks in rounds: chunk size doubles when latency of chunks is dominated by
+// request overhead and halves when chunks are too slow, otherwise the number of threads climbs in
+// the direction that improves throughput, and goes down when throughput is flat.
+class DownloadTuner {
+   public:
+    DownloadTuner();
+
+    // Start with all threads, and chunks small enough to give every thread one of rangeLen.
+    void reset(uint64_t minChunkSize, uint64_t maxChunkSize, uint64_t minNumOfThreads,
+               uint64_t maxNumOfThreads, uint64_t rangeLen);
+
+    bool isEnabled() const {
+        return (minChunkSize < maxChunkSize) || (minNumOfThreads < maxNumOfThreads);
+    }
+
+    // Record a chunk of len bytes downloaded between startUs and endUs, return true if chunk size
+    // or number of threads changes.
+    bool addSample(uint64_t len, uint64_t startUs, uint64_t endUs);
+
+    uint64_t getChunkSize() const {
+        return chunkSize;
+    }
+
+    uint64_t getNumOfThreads() const {
+        return numOfThreads;
+    }
+
+    // Of the last round.
+    uint64_t getThroughput() const {
+        return lastThroughput;
+    }
+
+    uint64_t getLatencyMs() const {
+        return lastLatencyMs;
+    }
+
+   private:
+    void tune(uint64_t throughput, uint64_t latencyMs);
+
+    uint64_t minChunkSize;
+    uint64_t maxChunkSize;
+    uint64_t minNumOfThreads;
+    uint64_t maxNumOfThreads;
+
+    uint64_t chunkSize;
+    uint64_t numOfThreads;
+    int direction;  // of the next change of numOfThreads, 1 or -1.
+
+    // Samples of the current round.
+    uint64_t numOfSamples;
+    uint64_t roundBytes;
+    uint64_t roundLatencyUs;
+    uint64_t roundStartUs;
+    uint64_t roundEndUs;
+
+    uint64_t lastThroughput;  // bytes per second, 0 if unknown or not comparable.
+    uint64_t lastLatencyMs;
 };
 
 enum ChunkStatus {
@@ -73,20 +155,36 @@ class S3KeyReader : public Reader {
           numOfChunks(0),
           curReadingChunk(0),
           transferredKeyLen(0),
+          lentBuffer(NULL),
           s3Interface(NULL),
-          hasEol(false),
+          s3Url(""),
+          keySize(0),
+          rangeOffset(0),
+          rangeEnd(0),
+          tailPos(0),
+          tailDataOffset(0),
+          skippingHeadLine(false),
+          lastChar('\0'),
           eolAppended(false) {
         pthread_mutex_init(&this->mutexErrorMessage, NULL);
+        pthread_mutex_init(&this->tuneMutex, NULL);
+        pthread_cond_init(&this->tuneCond, NULL);
     }
     virtual ~S3KeyReader() {
         this->close();
         pthread_mutex_destroy(&this->mutexErrorMessage);
+        pthread_mutex_destroy(&this->tuneMutex);
+        pthread_cond_destroy(&this->tuneCond);
     }
 
     void open(const S3Params& params);
     uint64_t read(char* buf, uint64_t count);
     void close();
 
+    // Lend data of downloaded chunks, a chunk is refilled after all of it is given back.
+    uint64_t lend(const char** buf, uint64_t count);
+    void giveBack();
+
     void setS3InterfaceService(S3Interface* s3) {
         this->s3Interface = s3;
     }
@@ -140,6 +238,21 @@ class S3KeyReader : public Reader {
         return region;
     }
 
+    const string& getCacheKey() const {
+        return cacheKey;
+    }
+
+    // Wait until the chunk is among the ones DownloadTuner allows to download ahead of the reader,
+    // return false if reading is aborted.
+    bool waitForDownload(uint64_t chunkIndex);
+
+    // Feed a chunk downloaded from S3 to DownloadTuner.
+    void addDownloadSample(uint64_t len, uint64_t startUs, uint64_t endUs);
+
+    const DownloadTuner& getDownloadTuner() const {
+        return tuner;
+    }
+
    private:
     pthread_mutex_t mutexErrorMessage;
 
@@ -157,12 +270,37 @@ class S3KeyReader : public Reader {
 
     vector<ChunkBuffer> chunkBuffers;
     vector<pthread_t> threads;
+    ChunkBuffer* lentBuffer;  // of the last lend(), NULL if given back.
 
     S3Interface* s3Interface;
 
+    // URL and ETag of the key, prefix of keys of its chunks in S3DiskCache. Empty if not cached.
+    string cacheKey;
+
+    // Protect tuner and curReadingChunk, tuneCond signals their changes.
+    pthread_mutex_t tuneMutex;
+    pthread_cond_t tuneCond;
+    DownloadTuner tuner;
+
     void reset();
 
-    bool hasEol;
+    uint64_t skipHeadLine(char* buf, uint64_t len);
+    uint64_t readRangeTail(char* buf, uint64_t count);
+
+    // Chunks are downloaded from [rangeOffset, rangeEnd) of the key, lines starting before the
+    // range are skipped and the line crossing rangeEnd is completed from tailPos.
+    S3Url s3Url;
+    uint64_t keySize;
+    uint64_t rangeOffset;
+    uint64_t rangeEnd;
+    uint64_t tailPos;
+
+    S3VectorUInt8 tailData;
+    uint64_t tailDataOffset;
+
+    bool skippingHeadLine;
+
+    char lastChar;  // last char returned to caller.
     bool eolAppended;
 };
 
@@ -189,6 +327,9 @@ class ChunkBuffer {
     uint64_t read(char* buf, uint64_t len);
     uint64_t fill();
 
+    uint64_t lend(const char** buf, uint64_t len);
+    bool giveBack();
+
     void setS3InterfaceService(S3Interface* s3) {
         this->s3Interface = s3;
     }
@@ -222,6 +363,8 @@ class ChunkBuffer {
     S3Url s3Url;
 
    private:
+    void recycle();
+
     bool eof;
 
     ChunkStatus status;
@@ -232,6 +375,7 @@ class ChunkBuffer {
     uint64_t curFileOffset;
     uint64_t curChunkOffset;
     uint64_t chunkDataSize;
+    uint64_t chunkIndex;
 
     S3VectorUInt8 chunkData;
     OffsetMgr& offsetMgr;
@@ -35,4 +35,15 @@ extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 // to enable zlib and gzip decoding with automatic header detection.
 #define S3_INFLATE_WINDOWSBITS (MAX_WBITS + 16 + 16)
 
+// CompressWriter records size of each gzip member it writes in the "GP" extra subfield of member
+// header, so that DecompressReader can inflate the members in parallel.
+#define S3_GZIP_SUBFIELD_SI1 'G'
+#define S3_GZIP_SUBFIELD_SI2 'P'
+
+// Segments on the same host share bucket listing of a statement through files in the parent
+// directory of their data directories. Files are removed when the scan ends, files older than
+// S3_SHARED_LISTING_TTL seconds are left by crashed segments and are never loaded.
+#define S3_SHARED_LISTING_PREFIX "gpcloud_listing_"
+#define S3_SHARED_LISTING_TTL 3600
+
 #endif
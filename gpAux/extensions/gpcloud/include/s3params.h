@@ -11,8 +11,15 @@ class S3Params {
              const string& region = "")
         : s3Url(sourceUrl, useHttps, version, region),
           keySize(0),
+          cacheSize(0),
+          rangeStart(0),
+          rangeEnd(0),
+          splitSize(0),
           chunkSize(0),
           numOfChunks(0),
+          minChunkSize(0),
+          minNumOfChunks(0),
+          connectionPoolSize(0),
           lowSpeedLimit(0),
           lowSpeedTime(0),
           debugCurl(false),
@@ -59,6 +66,22 @@ class S3Params {
         this->numOfChunks = numOfChunks;
     }
 
+    uint64_t getMinChunkSize() const {
+        return minChunkSize;
+    }
+
+    void setMinChunkSize(uint64_t minChunkSize) {
+        this->minChunkSize = minChunkSize;
+    }
+
+    uint64_t getMinNumOfChunks() const {
+        return minNumOfChunks;
+    }
+
+    void setMinNumOfChunks(uint64_t minNumOfChunks) {
+        this->minNumOfChunks = minNumOfChunks;
+    }
+
     uint64_t getKeySize() const {
         return keySize;
     }
@@ -67,6 +90,84 @@ class S3Params {
         this->keySize = size;
     }
 
+    const string& getKeyETag() const {
+        return keyETag;
+    }
+
+    void setKeyETag(const string& etag) {
+        this->keyETag = etag;
+    }
+
+    const string& getCacheDir() const {
+        return cacheDir;
+    }
+
+    void setCacheDir(const string& cacheDir) {
+        this->cacheDir = cacheDir;
+    }
+
+    uint64_t getCacheSize() const {
+        return cacheSize;
+    }
+
+    void setCacheSize(uint64_t cacheSize) {
+        this->cacheSize = cacheSize;
+    }
+
+    uint64_t getRangeStart() const {
+        return rangeStart;
+    }
+
+    uint64_t getRangeEnd() const {
+        return rangeEnd;
+    }
+
+    // Read only the lines starting in [start, end) of the key, end == 0 means the whole key.
+    void setRange(uint64_t start, uint64_t end) {
+        this->rangeStart = start;
+        this->rangeEnd = end;
+    }
+
+    const string& getFormat() const {
+        return format;
+    }
+
+    void setFormat(const string& format) {
+        this->format = format;
+    }
+
+    const string& getFilter() const {
+        return filter;
+    }
+
+    void setFilter(const string& filter) {
+        this->filter = filter;
+    }
+
+    uint64_t getSplitSize() const {
+        return splitSize;
+    }
+
+    void setSplitSize(uint64_t splitSize) {
+        this->splitSize = splitSize;
+    }
+
+    const string& getSharedListingDir() const {
+        return sharedListingDir;
+    }
+
+    void setSharedListingDir(const string& sharedListingDir) {
+        this->sharedListingDir = sharedListingDir;
+    }
+
+    uint64_t getConnectionPoolSize() const {
+        return connectionPoolSize;
+    }
+
+    void setConnectionPoolSize(uint64_t connectionPoolSize) {
+        this->connectionPoolSize = connectionPoolSize;
+    }
+
     uint64_t getLowSpeedLimit() const {
         return lowSpeedLimit;
     }
@@ -122,12 +223,32 @@ class S3Params {
     S3Url s3Url;  // original url to read/write.
 
     uint64_t keySize;  // key/file size.
+    string keyETag;    // ETag of key from bucket listing, identify version of its content.
+
+    string cacheDir;     // local directory to cache downloaded data, empty to disable.
+    uint64_t cacheSize;  // max total size of cached data.
+
+    uint64_t rangeStart;  // byte range of the key to read.
+    uint64_t rangeEnd;
+
+    string format;  // format of keys, "parquet" or empty for data readable as is.
+    string filter;  // conditions to skip Parquet row groups, see ParseParquetFilter().
+
+    uint64_t splitSize;  // keys larger than this are read by all segments, 0 to disable.
+
+    string sharedListingDir;  // where segments of a host share bucket listing, empty to disable.
 
     S3Credential cred;  // S3 credential.
 
     uint64_t chunkSize;    // chunk size
     uint64_t numOfChunks;  // number of chunks(threads).
 
+    // Readers tune chunk size and number of threads down to these, 0 to disable tuning.
+    uint64_t minChunkSize;
+    uint64_t minNumOfChunks;
+
+    uint64_t connectionPoolSize;  // max idle keep-alive connections, 0 to disable reuse.
+
     uint64_t lowSpeedLimit;  // low speed limit
     uint64_t lowSpeedTime;   // low speed timeout
 
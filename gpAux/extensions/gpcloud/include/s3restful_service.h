@@ -10,6 +10,59 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+struct CURLConnectionStats {
+    CURLConnectionStats()
+        : numOfRequests(0), numOfNewConnections(0), numOfReusedConnections(0), connectTime(0) {
+    }
+
+    uint64_t numOfRequests;
+    uint64_t numOfNewConnections;
+    uint64_t numOfReusedConnections;
+    double connectTime;  // seconds spent on TCP and TLS handshakes.
+};
+
+// Idle curl handles shared by all S3RESTfulService of the process. A handle keeps its connections
+// alive after a request, so the next request to the same host saves TCP and TLS handshakes.
+class CURLHandlePool {
+   public:
+    // Hold a reference of curl global state, so that idle handles outlive curl_global_cleanup()
+    // of the last S3RESTfulService.
+    CURLHandlePool() : maxSize(0) {
+        pthread_mutex_init(&this->mutex, NULL);
+        curl_global_init(CURL_GLOBAL_ALL);
+    }
+
+    // Handles are not cleaned up at exit, the process is going away with its connections.
+    ~CURLHandlePool() {
+        pthread_mutex_destroy(&this->mutex);
+    }
+
+    static CURLHandlePool& getInstance();
+
+    CURL* acquire();
+    void release(CURL* curl);
+
+    // Count connections of the request just performed on curl.
+    void recordRequest(CURL* curl);
+
+    // Must be called when no other threads are running, like curl_global_init().
+    void setMaxSize(uint64_t maxSize);
+
+    uint64_t getMaxSize() const {
+        return maxSize;
+    }
+
+    uint64_t getNumOfIdleHandles();
+
+    CURLConnectionStats getStats();
+
+   private:
+    pthread_mutex_t mutex;
+    uint64_t maxSize;
+    vector<CURL*> idleHandles;
+    CURLConnectionStats stats;
+};
+
 class S3RESTfulService : public RESTfulService {
    public:
     S3RESTfulService();
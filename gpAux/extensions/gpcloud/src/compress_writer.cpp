@@ -2,8 +2,59 @@
 
 uint64_t S3_ZIP_COMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
+// Offset of member size in gzip header: ID1, ID2, CM, FLG, MTIME(4), XFL, OS, XLEN(2), then the
+// extra subfield: SI1, SI2, LEN(2), member size(4).
+#define GZIP_MEMBER_SIZE_OFFSET 16
+
+void CompressToGzipMember(const char *data, uint64_t len, vector<char> &member) {
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+
+    // With S3_DEFLATE_WINDOWSBITS, it generates gzip stream with header and trailer
+    int ret = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, S3_DEFLATE_WINDOWSBITS, 8,
+                           Z_DEFAULT_STRATEGY);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "Failed to initialize zlib library");
+
+    // Member size is unknown until deflated, fill it in afterwards. Header has no CRC to update.
+    Byte extra[] = {S3_GZIP_SUBFIELD_SI1, S3_GZIP_SUBFIELD_SI2, 4, 0, 0, 0, 0, 0};
+
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.os = 3;  // Unix
+    header.extra = extra;
+    header.extra_len = sizeof(extra);
+    deflateSetHeader(&zstream, &header);
+
+    member.resize(deflateBound(&zstream, len) + sizeof(extra));
+
+    zstream.next_in = (Byte *)data;
+    zstream.avail_in = len;
+    zstream.next_out = (Byte *)member.data();
+    zstream.avail_out = member.size();
+
+    int status = deflate(&zstream, Z_FINISH);
+    uint64_t memberSize = zstream.total_out;
+    deflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE(status == Z_STREAM_END, S3RuntimeError,
+                    string("Failed to compress data: ") +
+                        std::to_string((unsigned long long)status));
+
+    member.resize(memberSize);
+
+    for (int i = 0; i < 4; i++) {
+        member[GZIP_MEMBER_SIZE_OFFSET + i] = (char)((memberSize >> (8 * i)) & 0xFF);
+    }
+}
+
 CompressWriter::CompressWriter() : writer(NULL), isClosed(true) {
-    this->out = new char[S3_ZIP_COMPRESS_CHUNKSIZE];
+    this->numOfWorkers = 1;
+    this->maxQueuedJobs = 1;
+    this->numOfMembers = 0;
+    this->stopping = false;
+
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
 }
 
 CompressWriter::~CompressWriter() {
@@ -11,77 +62,167 @@ CompressWriter::~CompressWriter() {
         this->close();
     } catch (...) {
     }
-    delete this->out;
+
+    this->stopThreads();
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
 }
 
-void CompressWriter::open(const S3Params& params) {
-    this->zstream.zalloc = Z_NULL;
-    this->zstream.zfree = Z_NULL;
-    this->zstream.opaque = Z_NULL;
+void CompressWriter::open(const S3Params &params) {
+    // Compress with as many threads as uploading.
+    this->numOfWorkers = std::max(params.getNumOfChunks(), (uint64_t)1);
+    this->maxQueuedJobs = this->numOfWorkers * 2;
+    this->numOfMembers = 0;
 
-    // With S3_DEFLATE_WINDOWSBITS, it generates gzip stream with header and trailer
-    int ret = deflateInit2(&this->zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-                           S3_DEFLATE_WINDOWSBITS, 8, Z_DEFAULT_STRATEGY);
+    this->curJob = std::make_shared<CompressJob>();
+    this->curJob->input.reserve(S3_ZIP_COMPRESS_CHUNKSIZE);
 
-    this->isClosed = false;
+    this->jobs.clear();
+    this->pending.clear();
+    this->stopping = false;
+    this->sharedException = NULL;
 
-    // init them here to get ready for both writer() and close()
-    this->zstream.next_in = NULL;
-    this->zstream.avail_in = 0;
-    this->zstream.next_out = (Byte*)this->out;
-    this->zstream.avail_out = S3_ZIP_COMPRESS_CHUNKSIZE;
+    this->isClosed = false;
 
-    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError,
-                    string("Failed to initialize zlib library: ") + this->zstream.msg);
+    this->startThreads();
 
     this->writer->open(params);
 }
 
-uint64_t CompressWriter::writeOneChunk(const char* buf, uint64_t count) {
-    // Defensive code
-    if (buf == NULL || count == 0) {
-        return 0;
+void *CompressWriter::WorkerThreadFunc(void *data) {
+    MaskThreadSignals();
+
+    CompressWriter *compressWriter = static_cast<CompressWriter *>(data);
+    compressWriter->runWorker();
+
+    return NULL;
+}
+
+void CompressWriter::startThreads() {
+    for (uint64_t i = 0; i < this->numOfWorkers; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, WorkerThreadFunc, this);
+        this->workerThreads.push_back(thread);
+    }
+}
+
+void CompressWriter::stopThreads() {
+    {
+        UniqueLock lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_broadcast(&this->cond);
     }
 
-    this->zstream.next_in = (Byte*)buf;
-    this->zstream.avail_in = count;
-
-    int status;
-    do {
-        status = deflate(&this->zstream, Z_NO_FLUSH);
-        if (status < 0 && status != Z_BUF_ERROR) {
-            deflateEnd(&this->zstream);
-            S3_CHECK_OR_DIE(false, S3RuntimeError,
-                            string("Failed to compress data: ") +
-                                std::to_string((unsigned long long)status) + ", " +
-                                this->zstream.msg);
+    for (uint64_t i = 0; i < this->workerThreads.size(); i++) {
+        pthread_join(this->workerThreads[i], NULL);
+    }
+
+    this->workerThreads.clear();
+}
+
+void CompressWriter::runWorker() {
+    while (true) {
+        std::shared_ptr<CompressJob> job;
+
+        {
+            UniqueLock lock(&this->mutex);
+            while (this->pending.empty() && !this->stopping) {
+                pthread_cond_wait(&this->cond, &this->mutex);
+            }
+
+            if (this->stopping) {
+                return;
+            }
+
+            job = this->pending.front();
+            this->pending.pop_front();
         }
 
-        this->flush();
+        std::exception_ptr exception;
+        try {
+            CompressToGzipMember(job->input.data(), job->input.size(), job->output);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        UniqueLock lock(&this->mutex);
+        if (exception != NULL && this->sharedException == NULL) {
+            this->sharedException = exception;
+        }
+
+        job->input.clear();
+        job->input.shrink_to_fit();
+        job->done = true;
+        pthread_cond_broadcast(&this->cond);
+    }
+}
+
+// Queue current block to compress, and write out members compressed by now.
+void CompressWriter::queueJob() {
+    {
+        UniqueLock lock(&this->mutex);
+        this->jobs.push_back(this->curJob);
+        this->pending.push_back(this->curJob);
+        pthread_cond_broadcast(&this->cond);
+    }
+
+    this->numOfMembers++;
+
+    this->curJob = std::make_shared<CompressJob>();
+    this->curJob->input.reserve(S3_ZIP_COMPRESS_CHUNKSIZE);
+
+    this->writeMembers(false);
+}
 
-        // output buffer is same size to input buffer, most cases data
-        // is smaller after compressed. But if this->zstream.avail_in > 0 after deflate(), then data
-        // is larger after compressed and some input data is pending. For example when compressing a
-        // chunk that is already compressed, we will encounter this case. So we need to loop here.
-    } while (status == Z_OK && (this->zstream.avail_in > 0));
+// Write compressed members in order. Wait for the first one if queue is full, so that at most
+// maxQueuedJobs blocks are in memory, or wait for all if waitAll is true.
+void CompressWriter::writeMembers(bool waitAll) {
+    while (true) {
+        std::shared_ptr<CompressJob> job;
+
+        {
+            UniqueLock lock(&this->mutex);
+            while (!this->jobs.empty() && !this->jobs.front()->done &&
+                   (waitAll || this->jobs.size() >= this->maxQueuedJobs) &&
+                   this->sharedException == NULL) {
+                pthread_cond_wait(&this->cond, &this->mutex);
+            }
+
+            if (this->sharedException != NULL) {
+                std::rethrow_exception(this->sharedException);
+            }
+
+            if (this->jobs.empty() || !this->jobs.front()->done) {
+                return;
+            }
+
+            job = this->jobs.front();
+            this->jobs.pop_front();
+        }
 
-    return count;
+        this->writer->write(job->output.data(), job->output.size());
+    }
 }
 
-uint64_t CompressWriter::write(const char* buf, uint64_t count) {
+uint64_t CompressWriter::write(const char *buf, uint64_t count) {
     // Defensive code
     if (buf == NULL || count == 0) {
         return 0;
     }
 
     uint64_t writtenLen = 0;
+    while (writtenLen < count) {
+        uint64_t len = std::min(count - writtenLen,
+                                S3_ZIP_COMPRESS_CHUNKSIZE - this->curJob->input.size());
 
-    for (uint64_t i = 0; i < (count / S3_ZIP_COMPRESS_CHUNKSIZE); i++) {
-        writtenLen += this->writeOneChunk(buf + writtenLen, S3_ZIP_COMPRESS_CHUNKSIZE);
-    }
+        this->curJob->input.insert(this->curJob->input.end(), buf + writtenLen,
+                                   buf + writtenLen + len);
+        writtenLen += len;
 
-    if (writtenLen < count) {
-        writtenLen += this->writeOneChunk(buf + writtenLen, count - writtenLen);
+        if (this->curJob->input.size() >= S3_ZIP_COMPRESS_CHUNKSIZE) {
+            this->queueJob();
+        }
     }
 
     return writtenLen;
@@ -92,34 +233,22 @@ void CompressWriter::close() {
         return;
     }
 
-    int status;
-    do {
-        status = deflate(&this->zstream, Z_FINISH);
-        this->flush();
-    } while (status == Z_OK);
-
-    deflateEnd(&this->zstream);
+    // mark it closed first, so that an exception here does not make the next close() write again.
+    this->isClosed = true;
 
-    if (status != Z_STREAM_END) {
-        S3_CHECK_OR_DIE(false, S3RuntimeError,
-                        string("Failed to compress data: ") +
-                            std::to_string((unsigned long long)status) + ", " + this->zstream.msg);
+    // Even empty data is compressed to a member with header and trailer.
+    if (!this->curJob->input.empty() || this->numOfMembers == 0) {
+        this->queueJob();
     }
 
-    S3DEBUG("Compression finished: Z_STREAM_END.");
+    this->writeMembers(true);
+    this->stopThreads();
+
+    S3DEBUG("Compression finished: %" PRIu64 " gzip members.", this->numOfMembers);
 
     this->writer->close();
-    this->isClosed = true;
 }
 
-void CompressWriter::setWriter(Writer* writer) {
+void CompressWriter::setWriter(Writer *writer) {
     this->writer = writer;
 }
-
-void CompressWriter::flush() {
-    if (this->zstream.avail_out < S3_ZIP_COMPRESS_CHUNKSIZE) {
-        this->writer->write(this->out, S3_ZIP_COMPRESS_CHUNKSIZE - this->zstream.avail_out);
-        this->zstream.next_out = (Byte*)this->out;
-        this->zstream.avail_out = S3_ZIP_COMPRESS_CHUNKSIZE;
-    }
-}
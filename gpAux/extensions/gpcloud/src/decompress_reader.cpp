@@ -2,28 +2,94 @@
 
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
+// Fixed part of gzip header: ID1, ID2, CM, FLG, MTIME(4), XFL, OS, and XLEN(2) if FLG.FEXTRA.
+#define GZIP_HEADER_SIZE 12
+#define GZIP_TRAILER_SIZE 8
+#define GZIP_FLAG_FEXTRA 0x04
+#define GZIP_MAX_HEADER_SIZE (GZIP_HEADER_SIZE + 0xFFFF)
+
+static inline uint32_t GetUInt32LE(const char *data) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ISIZE, the last 4 bytes of a gzip member, is size of uncompressed data modulo 2^32.
+static inline uint64_t GetGzipMemberISize(const char *member, uint64_t memberSize) {
+    return GetUInt32LE(member + memberSize - 4);
+}
+
+uint64_t GetGzipMemberSize(const char *data, uint64_t len) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+
+    if (len < GZIP_HEADER_SIZE || p[0] != 0x1f || p[1] != 0x8b || p[2] != Z_DEFLATED ||
+        !(p[3] & GZIP_FLAG_FEXTRA)) {
+        return 0;
+    }
+
+    uint64_t xlen = p[10] | (p[11] << 8);
+    if (len < GZIP_HEADER_SIZE + xlen) {
+        return 0;
+    }
+
+    // subfields of extra field: SI1, SI2, LEN(2), data.
+    const uint8_t *end = p + GZIP_HEADER_SIZE + xlen;
+    for (const uint8_t *sub = p + GZIP_HEADER_SIZE; sub + 4 <= end;) {
+        uint64_t slen = sub[2] | (sub[3] << 8);
+
+        uint64_t memberSize = 0;
+        if (sub[0] == 'B' && sub[1] == 'C' && slen == 2 && sub + 6 <= end) {
+            // BSIZE of BGZF is total size of the member minus 1.
+            memberSize = (sub[4] | (sub[5] << 8)) + 1;
+        } else if (sub[0] == S3_GZIP_SUBFIELD_SI1 && sub[1] == S3_GZIP_SUBFIELD_SI2 && slen == 4 &&
+                   sub + 8 <= end) {
+            memberSize = GetUInt32LE((const char *)sub + 4);
+        }
+
+        if (memberSize != 0) {
+            return memberSize >= GZIP_HEADER_SIZE + xlen + GZIP_TRAILER_SIZE ? memberSize : 0;
+        }
+
+        sub += 4 + slen;
+    }
+
+    return 0;
+}
+
 DecompressReader::DecompressReader() : isClosed(true) {
     this->reader = NULL;
     this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
-    this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
+    this->inMember = false;
+    this->readerEOF = false;
+    this->inputLent = false;
+    this->batchOutputSize = 0;
+
+    this->numOfWorkers = 1;
+    this->maxQueuedJobs = 1;
+    this->numOfMembers = 0;
+    this->numOfParallelMembers = 0;
+
+    this->threadsStarted = false;
+    this->pipelineFinished = false;
+    this->stopping = false;
     this->outOffset = 0;
+
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
 }
 
 DecompressReader::~DecompressReader() {
     this->close();
 
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
 }
 
 // Used for unit test to adjust buffer size
 void DecompressReader::resizeDecompressReaderBuffer(uint64_t size) {
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
     this->in = new char[size];
-    this->out = new char[size];
-    this->outOffset = 0;
-    this->zstream.avail_out = size;
 }
 
 void DecompressReader::setReader(Reader *reader) {
@@ -36,94 +102,469 @@ void DecompressReader::open(const S3Params &params) {
     zstream.zfree = Z_NULL;
     zstream.opaque = Z_NULL;
     zstream.next_in = Z_NULL;
-    zstream.next_out = (Byte *)this->out;
+    zstream.next_out = Z_NULL;
 
     zstream.avail_in = 0;
-    zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-
-    this->outOffset = 0;
+    zstream.avail_out = 0;
 
     // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
     int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
     S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
 
+    this->inMember = false;
+    this->readerEOF = false;
+    this->inputLent = false;
+    this->memberBatch.reset();
+    this->batchOutputSize = 0;
+
+    // Inflate with as many threads as downloading.
+    this->numOfWorkers = std::max(params.getNumOfChunks(), (uint64_t)1);
+    this->maxQueuedJobs = this->numOfWorkers * 2 + 1;
+    this->numOfMembers = 0;
+    this->numOfParallelMembers = 0;
+
+    this->jobs.clear();
+    this->pending.clear();
+    this->pipelineFinished = false;
+    this->stopping = false;
+    this->sharedException = NULL;
+
+    this->curJob.reset();
+    this->outOffset = 0;
+
     this->isClosed = false;
 
     this->reader->open(params);
 }
 
-uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
-    uint64_t remainingOutLen = this->getDecompressedBytesNum() - this->outOffset;
+void *DecompressReader::PipelineThreadFunc(void *data) {
+    MaskThreadSignals();
 
-    if (remainingOutLen == 0) {
-        this->decompress();
+    DecompressReader *decompressReader = static_cast<DecompressReader *>(data);
+    S3DEBUG("Decompression pipeline thread starts");
+
+    try {
+        decompressReader->runPipeline();
+    } catch (...) {
+        UniqueLock lock(&decompressReader->mutex);
+        decompressReader->sharedException = std::current_exception();
+    }
+
+    UniqueLock lock(&decompressReader->mutex);
+    decompressReader->pipelineFinished = true;
+    pthread_cond_broadcast(&decompressReader->cond);
+
+    S3DEBUG("Decompression pipeline thread ended");
+    return NULL;
+}
+
+void *DecompressReader::WorkerThreadFunc(void *data) {
+    MaskThreadSignals();
+
+    DecompressReader *decompressReader = static_cast<DecompressReader *>(data);
+
+    try {
+        decompressReader->runWorker();
+    } catch (...) {
+        UniqueLock lock(&decompressReader->mutex);
+        if (decompressReader->sharedException == NULL) {
+            decompressReader->sharedException = std::current_exception();
+        }
+        pthread_cond_broadcast(&decompressReader->cond);
+    }
+
+    return NULL;
+}
+
+// Threads are started by the first read(), since underlying reader might be set up after open().
+void DecompressReader::startThreads() {
+    pthread_create(&this->pipelineThread, NULL, PipelineThreadFunc, this);
+
+    for (uint64_t i = 0; i < this->numOfWorkers; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, WorkerThreadFunc, this);
+        this->workerThreads.push_back(thread);
+    }
+
+    this->threadsStarted = true;
+}
+
+// Pipeline thread might be waiting for underlying reader, it quits after that read returns.
+void DecompressReader::stopThreads() {
+    if (!this->threadsStarted) {
+        return;
+    }
+
+    {
+        UniqueLock lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_broadcast(&this->cond);
+    }
+
+    pthread_join(this->pipelineThread, NULL);
+
+    for (uint64_t i = 0; i < this->workerThreads.size(); i++) {
+        pthread_join(this->workerThreads[i], NULL);
+    }
+
+    this->workerThreads.clear();
+    this->threadsStarted = false;
+}
+
+// Wait until curJob has data to return, return false if EOF.
+bool DecompressReader::waitForOutput() {
+    if (!this->threadsStarted) {
+        this->startThreads();
+    }
+
+    while (this->curJob == NULL || this->outOffset == this->curJob->output.size()) {
+        UniqueLock lock(&this->mutex);
+        this->curJob.reset();
+
+        while (this->sharedException == NULL &&
+               (this->jobs.empty() ? !this->pipelineFinished : !this->jobs.front()->done)) {
+            pthread_cond_wait(&this->cond, &this->mutex);
+        }
+
+        if (this->sharedException != NULL) {
+            std::rethrow_exception(this->sharedException);
+        }
+
+        // EOF, no more data to decompress.
+        if (this->jobs.empty()) {
+            return false;
+        }
+
+        this->curJob = this->jobs.front();
+        this->jobs.pop_front();
         this->outOffset = 0;  // reset cursor for out buffer to read from beginning.
-        remainingOutLen = this->getDecompressedBytesNum();
+
+        pthread_cond_broadcast(&this->cond);
     }
 
-    uint64_t count = std::min(remainingOutLen, bufSize);
-    memcpy(buf, this->out + outOffset, count);
+    return true;
+}
+
+uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
+    if (!this->waitForOutput()) {
+        return 0;
+    }
+
+    uint64_t count = std::min(this->curJob->output.size() - this->outOffset, bufSize);
+    memcpy(buf, this->curJob->output.data() + this->outOffset, count);
 
     this->outOffset += count;
 
     return count;
 }
 
-// Read compressed data from underlying reader and decompress to this->out buffer.
-// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
-void DecompressReader::decompress() {
-    if (this->zstream.avail_in == 0) {
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
+// Lend decompressed data of curJob, which is kept until the next lend() or read() finds it
+// consumed, so giveBack() has nothing to do.
+uint64_t DecompressReader::lend(const char **buf, uint64_t count) {
+    if (!this->waitForOutput()) {
+        return 0;
+    }
 
-        // read S3_ZIP_DECOMPRESS_CHUNKSIZE data from underlying reader and put into this->in
-        // buffer. read() might happen more than once when reaching EOF, make sure every time read()
-        // will return 0.
-        uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+    count = std::min(this->curJob->output.size() - this->outOffset, count);
+    *buf = this->curJob->output.data() + this->outOffset;
 
-        // EOF, no more data to decompress.
-        if (hasRead == 0) {
-            S3DEBUG(
-                "No more data to decompress: avail_in = %u, avail_out = %u, total_in = %u, "
-                "total_out = %u",
-                zstream.avail_in, zstream.avail_out, zstream.total_in, zstream.total_out);
-            return;
+    this->outOffset += count;
+
+    return count;
+}
+
+// Inflate data lent by underlying reader in place, instead of copying it into this->in. Only data
+// across the end of lent data, like a gzip header or member, is copied by fillInput().
+// Return false if there is no data to decompress.
+bool DecompressReader::lendInput() {
+    if (this->inputLent) {
+        this->reader->giveBack();
+        this->inputLent = false;
+    }
+
+    if (this->readerEOF) {
+        return false;
+    }
+
+    const char *data = NULL;
+    uint64_t count = this->reader->lend(&data, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+    this->inputLent = true;
+
+    if (count == 0) {
+        this->reader->giveBack();
+        this->inputLent = false;
+        this->readerEOF = true;
+        return false;
+    }
+
+    this->zstream.next_in = (Byte *)data;
+    this->zstream.avail_in = count;
+
+    return true;
+}
+
+// Move unconsumed data to the front of this->in and fill the rest from underlying reader.
+// Return false if there is no data to decompress.
+bool DecompressReader::fillInput() {
+    uint64_t hasRead = this->zstream.avail_in;
+    if (hasRead > 0 && (char *)this->zstream.next_in != this->in) {
+        memmove(this->in, this->zstream.next_in, hasRead);
+    }
+
+    if (this->inputLent) {
+        this->reader->giveBack();
+        this->inputLent = false;
+    }
+
+    // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
+    // inflated. read() might happen more than once when reaching EOF, stop at the first 0.
+    while (!this->readerEOF && hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+        uint64_t count =
+            this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+
+        if (count == 0) {
+            this->readerEOF = true;
+            break;
+        }
+
+        hasRead += count;
+    }
+
+    this->zstream.next_in = (Byte *)this->in;
+    this->zstream.avail_in = hasRead;
+
+    return hasRead > 0;
+}
+
+// Runs in pipeline thread: split compressed data into gzip members for workers if their sizes are
+// known, otherwise inflate it here.
+void DecompressReader::runPipeline() {
+    while (true) {
+        {
+            UniqueLock lock(&this->mutex);
+            if (this->stopping) {
+                return;
+            }
+        }
+
+        if (this->zstream.avail_in == 0 && !this->lendInput()) {
+            break;
         }
 
-        // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
-        // inflated.
-        while (hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
-            uint64_t count =
-                this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+        if (!this->inMember) {
+            if (this->zstream.avail_in < GZIP_MAX_HEADER_SIZE && !this->readerEOF) {
+                this->fillInput();
+            }
+
+            const char *data = (const char *)this->zstream.next_in;
+            uint64_t len = this->zstream.avail_in;
 
-            if (count == 0) {
+            // Like gzip, ignore garbage following the members, e.g. eol appended by S3KeyReader.
+            if (this->numOfMembers > 0 &&
+                (len < 2 || (uint8_t)data[0] != 0x1f || (uint8_t)data[1] != 0x8b)) {
+                S3DEBUG("Ignore %u bytes of trailing data after %" PRIu64 " gzip members",
+                        this->zstream.avail_in, this->numOfMembers);
                 break;
             }
 
-            hasRead += count;
+            this->numOfMembers++;
+
+            uint64_t memberSize = GetGzipMemberSize(data, len);
+            if (memberSize > len && memberSize <= S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+                this->fillInput();
+            }
+
+            if (memberSize != 0 && memberSize <= this->zstream.avail_in) {
+                this->queueMember(memberSize);
+                continue;
+            }
+
+            // keep the batch ahead of data inflated after it.
+            if (this->memberBatch != NULL) {
+                this->queueJob(this->memberBatch, true);
+                this->memberBatch.reset();
+            }
+
+            this->inMember = true;
         }
 
-        this->zstream.next_in = (Byte *)this->in;
-        this->zstream.avail_in = hasRead;
-    } else {
-        // Still have more data in 'in' buffer to decode.
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
+        this->decompress();
     }
 
+    if (this->memberBatch != NULL) {
+        this->queueJob(this->memberBatch, true);
+        this->memberBatch.reset();
+    }
+
+    S3DEBUG(
+        "No more data to decompress: avail_in = %u, total_in = %lu, total_out = %lu, %" PRIu64
+        " of %" PRIu64 " gzip members inflated in parallel",
+        zstream.avail_in, zstream.total_in, zstream.total_out, this->numOfParallelMembers,
+        this->numOfMembers);
+}
+
+// Decompress data at this->zstream.next_in to one block of at most S3_ZIP_DECOMPRESS_CHUNKSIZE
+// bytes.
+void DecompressReader::decompress() {
+    std::shared_ptr<DecompressJob> block = std::make_shared<DecompressJob>();
+    block->output.resize(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    this->zstream.next_out = (Byte *)block->output.data();
+    this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+
     int status = inflate(&this->zstream, Z_NO_FLUSH);
     if (status == Z_STREAM_END) {
         S3DEBUG("Decompression finished: Z_STREAM_END.");
+
+        // there might be more gzip members following.
+        inflateReset(&this->zstream);
+        this->inMember = false;
     } else if (status < 0 || status == Z_NEED_DICT) {
-        inflateEnd(&this->zstream);
         S3_CHECK_OR_DIE(
             false, S3RuntimeError,
             string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
     }
+
+    block->output.resize(S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out);
+
+    if (!block->output.empty()) {
+        block->done = true;
+        this->queueJob(block, false);
+    }
+}
+
+// Add the gzip member at this->zstream.next_in to current batch, batches are queued once their
+// decompressed size reaches S3_ZIP_DECOMPRESS_CHUNKSIZE.
+void DecompressReader::queueMember(uint64_t memberSize) {
+    const char *member = (const char *)this->zstream.next_in;
+
+    if (this->memberBatch == NULL) {
+        this->memberBatch = std::make_shared<DecompressJob>();
+        this->batchOutputSize = 0;
+    }
+
+    this->memberBatch->input.insert(this->memberBatch->input.end(), member, member + memberSize);
+    this->memberBatch->memberSizes.push_back(memberSize);
+    this->batchOutputSize += GetGzipMemberISize(member, memberSize);
+
+    this->zstream.next_in += memberSize;
+    this->zstream.avail_in -= memberSize;
+    this->numOfParallelMembers++;
+
+    if (this->batchOutputSize >= S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+        this->queueJob(this->memberBatch, true);
+        this->memberBatch.reset();
+    }
+}
+
+// Wait for room in the queue, so that at most maxQueuedJobs blocks are in memory.
+void DecompressReader::queueJob(const std::shared_ptr<DecompressJob> &job, bool toWorker) {
+    UniqueLock lock(&this->mutex);
+
+    while (this->jobs.size() >= this->maxQueuedJobs && !this->stopping) {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
+
+    if (this->stopping) {
+        return;
+    }
+
+    this->jobs.push_back(job);
+    if (toWorker) {
+        this->pending.push_back(job);
+    }
+
+    pthread_cond_broadcast(&this->cond);
+}
+
+void DecompressReader::runWorker() {
+    while (true) {
+        std::shared_ptr<DecompressJob> job;
+
+        {
+            UniqueLock lock(&this->mutex);
+            while (this->pending.empty() && !this->pipelineFinished && !this->stopping) {
+                pthread_cond_wait(&this->cond, &this->mutex);
+            }
+
+            if (this->pending.empty() || this->stopping) {
+                return;
+            }
+
+            job = this->pending.front();
+            this->pending.pop_front();
+        }
+
+        this->inflateMembers(*job);
+
+        UniqueLock lock(&this->mutex);
+        job->done = true;
+        pthread_cond_broadcast(&this->cond);
+    }
+}
+
+// Runs in worker thread: each member is a complete gzip stream, inflate it to its ISIZE.
+void DecompressReader::inflateMembers(DecompressJob &job) {
+    uint64_t outputSize = 0;
+    uint64_t inPos = 0;
+    for (uint64_t i = 0; i < job.memberSizes.size(); i++) {
+        outputSize += GetGzipMemberISize(job.input.data() + inPos, job.memberSizes[i]);
+        inPos += job.memberSizes[i];
+    }
+
+    job.output.resize(outputSize);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    int status = inflateInit2(&stream, S3_INFLATE_WINDOWSBITS);
+    S3_CHECK_OR_DIE(status == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+    uint64_t outPos = 0;
+    inPos = 0;
+    for (uint64_t i = 0; i < job.memberSizes.size(); i++) {
+        char *member = job.input.data() + inPos;
+        uint64_t isize = GetGzipMemberISize(member, job.memberSizes[i]);
+
+        stream.next_in = (Byte *)member;
+        stream.avail_in = job.memberSizes[i];
+        stream.next_out = (Byte *)job.output.data() + outPos;
+        stream.avail_out = isize;
+
+        status = inflate(&stream, Z_FINISH);
+        if (status != Z_STREAM_END || stream.avail_out != 0) {
+            inflateEnd(&stream);
+            S3_CHECK_OR_DIE(false, S3RuntimeError,
+                            string("Failed to decompress gzip member: ") +
+                                std::to_string((unsigned long long)status));
+        }
+
+        inflateReset(&stream);
+
+        inPos += job.memberSizes[i];
+        outPos += isize;
+    }
+
+    inflateEnd(&stream);
+
+    // Release compressed data.
+    vector<char>().swap(job.input);
 }
 
 void DecompressReader::close() {
     if (!this->isClosed) {
+        this->stopThreads();
+
+        if (this->inputLent) {
+            this->reader->giveBack();
+            this->inputLent = false;
+        }
+
+        this->jobs.clear();
+        this->pending.clear();
+        this->curJob.reset();
+        this->memberBatch.reset();
+
         inflateEnd(&zstream);
         this->reader->close();
         this->isClosed = true;
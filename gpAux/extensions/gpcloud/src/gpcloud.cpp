@@ -116,6 +116,68 @@ bool hasHeader = false;
 
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+TableFormat tableFormat;
+
+/*
+ * Get value of option "name 'value'" from fmtopts, the value ends with a quote followed by space
+ * or end of string, so that a quote itself can be the value, as in "quote '''".
+ */
+static bool getFormatOpt(const char *fmtopts, const char *name, string &value) {
+    string prefix = string(name) + " '";
+
+    const char *begin = strstr(fmtopts, prefix.c_str());
+    if (begin == NULL) {
+        return false;
+    }
+    begin += prefix.length();
+
+    const char *end = begin;
+    while (*end != '\0' && !(*end == '\'' && (end[1] == ' ' || end[1] == '\0'))) {
+        end++;
+    }
+
+    value.assign(begin, end - begin);
+    return true;
+}
+
+/*
+ * Parse delimiter, null, escape and quote, and get names of columns, for rows of tableFormat.
+ */
+static void parseTableFormat(Relation rel, char fmtcode, const char *fmtopts) {
+    tableFormat = TableFormat();
+    tableFormat.isCsv = fmttype_is_csv(fmtcode);
+
+    if (tableFormat.isCsv) {
+        tableFormat.delimiter = ',';
+        tableFormat.escape = '"';
+        tableFormat.nullString = "";
+    }
+
+    string value;
+    if (getFormatOpt(fmtopts, "delimiter", value)) {
+        tableFormat.delimiter = (value.empty() || value == "off") ? '\0' : value[0];
+    }
+
+    if (getFormatOpt(fmtopts, "escape", value)) {
+        tableFormat.escape = (value.empty() || value == "off") ? '\0' : value[0];
+    }
+
+    if (getFormatOpt(fmtopts, "quote", value) && !value.empty()) {
+        tableFormat.quote = value[0];
+    }
+
+    if (getFormatOpt(fmtopts, "null", value)) {
+        tableFormat.nullString = value;
+    }
+
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (!tupdesc->attrs[i]->attisdropped) {
+            tableFormat.columns.push_back(NameStr(tupdesc->attrs[i]->attname));
+        }
+    }
+}
+
 static void parseFormatOpts(FunctionCallInfo fcinfo) {
     Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
     ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
@@ -161,6 +223,8 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
                                           newline)));
             }
         }
+
+        parseTableFormat(rel, fmtcode, fmtopts);
     }
 }
 
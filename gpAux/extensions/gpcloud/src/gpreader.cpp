@@ -59,8 +59,15 @@ GPReader::GPReader(const S3Params& params)
 void GPReader::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
     this->bucketReader.setS3InterfaceService(&this->s3InterfaceService);
-    this->bucketReader.setUpstreamReader(&this->commonReader);
     this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+    this->parquetReader.setS3InterfaceService(&this->s3InterfaceService);
+
+    // Parquet files are read as rows, others are passed to formatter as is.
+    if (this->params.getFormat() == "parquet") {
+        this->bucketReader.setUpstreamReader(&this->parquetReader);
+    } else {
+        this->bucketReader.setUpstreamReader(&this->commonReader);
+    }
     this->bucketReader.open(this->params);
 }
 
@@ -70,6 +77,14 @@ uint64_t GPReader::read(char* buf, uint64_t count) {
     return this->bucketReader.read(buf, count);
 }
 
+uint64_t GPReader::lend(const char** buf, uint64_t count) {
+    return this->bucketReader.lend(buf, count);
+}
+
+void GPReader::giveBack() {
+    this->bucketReader.giveBack();
+}
+
 // This should be reentrant, has no side effects when called multiple times.
 void GPReader::close() {
     this->bucketReader.close();
@@ -0,0 +1,1621 @@
+#include "parquet_reader.h"
+
+#include <cmath>
+
+// Types of Thrift compact protocol.
+enum ThriftType {
+    THRIFT_STOP = 0,
+    THRIFT_BOOLEAN_TRUE = 1,
+    THRIFT_BOOLEAN_FALSE = 2,
+    THRIFT_BYTE = 3,
+    THRIFT_I16 = 4,
+    THRIFT_I32 = 5,
+    THRIFT_I64 = 6,
+    THRIFT_DOUBLE = 7,
+    THRIFT_BINARY = 8,
+    THRIFT_LIST = 9,
+    THRIFT_SET = 10,
+    THRIFT_MAP = 11,
+    THRIFT_STRUCT = 12,
+};
+
+// Guard against stack overflow by deeply nested structs, lists or maps of a corrupted file.
+#define THRIFT_MAX_DEPTH 64
+
+#define CHECK_PARQUET(_condition, _what) \
+    S3_CHECK_OR_DIE(_condition, S3RuntimeError, string("Invalid Parquet data: ") + _what)
+
+// Seconds of a day, and days from the julian day 0 to 1970-01-01.
+#define SECONDS_PER_DAY 86400
+#define JULIAN_DAY_OF_EPOCH 2440588
+
+// Decoder of Thrift compact protocol, which encodes the metadata of Parquet files.
+class ThriftCompactReader {
+   public:
+    ThriftCompactReader(const char *data, uint64_t len)
+        : begin((const uint8_t *)data), pos((const uint8_t *)data), end(begin + len), depth(0) {
+    }
+
+    uint64_t getPos() const {
+        return pos - begin;
+    }
+
+    uint64_t readVarint() {
+        uint64_t result = 0;
+        for (int shift = 0;; shift += 7) {
+            CHECK_PARQUET((pos < end) && (shift < 64), "bad varint");
+
+            uint8_t byte = *pos++;
+            result |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return result;
+            }
+        }
+    }
+
+    int64_t readI64() {
+        uint64_t value = readVarint();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    int32_t readI32() {
+        return (int32_t)readI64();
+    }
+
+    string readBinary() {
+        uint64_t len = readVarint();
+        CHECK_PARQUET(len <= (uint64_t)(end - pos), "binary out of bound");
+
+        string value((const char *)pos, len);
+        pos += len;
+        return value;
+    }
+
+    // Read the header of next field of a struct, return false at the end of the struct. lastId is
+    // id of the previous field, field ids are delta encoded.
+    bool readFieldHeader(int16_t &lastId, int16_t &id, uint8_t &type) {
+        CHECK_PARQUET(pos < end, "struct out of bound");
+
+        uint8_t byte = *pos++;
+        if (byte == THRIFT_STOP) {
+            return false;
+        }
+
+        type = byte & 0x0F;
+        id = (byte >> 4) ? lastId + (byte >> 4) : (int16_t)readI64();
+        lastId = id;
+        return true;
+    }
+
+    uint64_t readListHeader(uint8_t &elemType) {
+        CHECK_PARQUET(pos < end, "list out of bound");
+
+        uint8_t byte = *pos++;
+        elemType = byte & 0x0F;
+
+        uint64_t size = byte >> 4;
+        if (size == 15) {
+            size = readVarint();
+        }
+
+        // every element takes at least one byte, except booleans of a field.
+        CHECK_PARQUET(size <= (uint64_t)(end - pos), "list out of bound");
+        return size;
+    }
+
+    void enterStruct() {
+        CHECK_PARQUET(++depth <= THRIFT_MAX_DEPTH, "structs nested too deep");
+    }
+
+    void leaveStruct() {
+        depth--;
+    }
+
+    void skip(uint8_t type, bool inList = false) {
+        switch (type) {
+            case THRIFT_BOOLEAN_TRUE:
+            case THRIFT_BOOLEAN_FALSE:
+                // booleans of fields are in the field header, while of lists take a byte.
+                if (inList) {
+                    skipBytes(1);
+                }
+                break;
+            case THRIFT_BYTE:
+                skipBytes(1);
+                break;
+            case THRIFT_I16:
+            case THRIFT_I32:
+            case THRIFT_I64:
+                readVarint();
+                break;
+            case THRIFT_DOUBLE:
+                skipBytes(8);
+                break;
+            case THRIFT_BINARY:
+                skipBytes(readVarint());
+                break;
+            case THRIFT_LIST:
+            case THRIFT_SET: {
+                // nested lists take a byte per level, limit them as structs.
+                CHECK_PARQUET(++depth <= THRIFT_MAX_DEPTH, "lists nested too deep");
+                uint8_t elemType;
+                uint64_t size = readListHeader(elemType);
+                for (uint64_t i = 0; i < size; i++) {
+                    skip(elemType, true);
+                }
+                depth--;
+                break;
+            }
+            case THRIFT_MAP: {
+                CHECK_PARQUET(++depth <= THRIFT_MAX_DEPTH, "maps nested too deep");
+                uint64_t size = readVarint();
+                if (size > 0) {
+                    CHECK_PARQUET(pos < end, "map out of bound");
+                    uint8_t types = *pos++;
+                    for (uint64_t i = 0; i < size; i++) {
+                        skip(types >> 4, true);
+                        skip(types & 0x0F, true);
+                    }
+                }
+                depth--;
+                break;
+            }
+            case THRIFT_STRUCT: {
+                enterStruct();
+                int16_t lastId = 0, id;
+                uint8_t fieldType;
+                while (readFieldHeader(lastId, id, fieldType)) {
+                    skip(fieldType);
+                }
+                leaveStruct();
+                break;
+            }
+            default:
+                CHECK_PARQUET(false, "unknown thrift type " + std::to_string((int)type));
+        }
+    }
+
+   private:
+    void skipBytes(uint64_t len) {
+        CHECK_PARQUET(len <= (uint64_t)(end - pos), "field out of bound");
+        pos += len;
+    }
+
+    const uint8_t *begin;
+    const uint8_t *pos;
+    const uint8_t *end;
+    int depth;
+};
+
+static void ParseStatistics(ThriftCompactReader &thrift, ParquetStatistics *statistics) {
+    bool hasLegacyMin = false, hasLegacyMax = false;
+    string legacyMin, legacyMax;
+
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_BINARY) {
+            legacyMax = thrift.readBinary();
+            hasLegacyMax = true;
+        } else if (id == 2 && type == THRIFT_BINARY) {
+            legacyMin = thrift.readBinary();
+            hasLegacyMin = true;
+        } else if (id == 3 && type == THRIFT_I64) {
+            statistics->nullCount = thrift.readI64();
+            statistics->hasNullCount = true;
+        } else if (id == 5 && type == THRIFT_BINARY) {
+            statistics->max = thrift.readBinary();
+            statistics->hasMax = true;
+        } else if (id == 6 && type == THRIFT_BINARY) {
+            statistics->min = thrift.readBinary();
+            statistics->hasMin = true;
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+
+    if (!statistics->hasMin && !statistics->hasMax && hasLegacyMin && hasLegacyMax) {
+        statistics->min = legacyMin;
+        statistics->max = legacyMax;
+        statistics->hasMin = statistics->hasMax = true;
+        statistics->isLegacy = true;
+    }
+}
+
+static void ParseColumnMetaData(ThriftCompactReader &thrift, ParquetColumnChunk *chunk) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            chunk->type = thrift.readI32();
+        } else if (id == 3 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListHeader(elemType);
+            CHECK_PARQUET(elemType == THRIFT_BINARY, "bad path_in_schema");
+            for (uint64_t i = 0; i < size; i++) {
+                chunk->path.push_back(thrift.readBinary());
+            }
+        } else if (id == 4 && type == THRIFT_I32) {
+            chunk->codec = thrift.readI32();
+        } else if (id == 5 && type == THRIFT_I64) {
+            chunk->numValues = thrift.readI64();
+        } else if (id == 7 && type == THRIFT_I64) {
+            chunk->totalCompressedSize = thrift.readI64();
+        } else if (id == 9 && type == THRIFT_I64) {
+            chunk->dataPageOffset = thrift.readI64();
+        } else if (id == 11 && type == THRIFT_I64) {
+            chunk->dictionaryPageOffset = thrift.readI64();
+        } else if (id == 12 && type == THRIFT_STRUCT) {
+            ParseStatistics(thrift, &chunk->statistics);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+}
+
+static void ParseColumnChunk(ThriftCompactReader &thrift, ParquetColumnChunk *chunk) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_BINARY) {
+            CHECK_PARQUET(thrift.readBinary().empty(), "column chunks in other files");
+        } else if (id == 3 && type == THRIFT_STRUCT) {
+            ParseColumnMetaData(thrift, chunk);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+}
+
+static void ParseRowGroup(ThriftCompactReader &thrift, ParquetRowGroup *rowGroup) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListHeader(elemType);
+            CHECK_PARQUET(elemType == THRIFT_STRUCT, "bad columns of row group");
+
+            rowGroup->columns.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseColumnChunk(thrift, &rowGroup->columns[i]);
+            }
+        } else if (id == 3 && type == THRIFT_I64) {
+            rowGroup->numRows = thrift.readI64();
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+}
+
+// Parse TIMESTAMP of LogicalType union, which has no converted type if it is not adjusted to UTC,
+// or of nanoseconds. Others have converted types.
+static void ParseLogicalType(ThriftCompactReader &thrift, ParquetSchemaElement *element) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id != 8 || type != THRIFT_STRUCT) {
+            thrift.skip(type);
+            continue;
+        }
+
+        // TimestampType: isAdjustedToUTC, then unit as a union of empty structs.
+        thrift.enterStruct();
+        int16_t timestampLastId = 0;
+        while (thrift.readFieldHeader(timestampLastId, id, type)) {
+            if (id == 1 && (type == THRIFT_BOOLEAN_TRUE || type == THRIFT_BOOLEAN_FALSE)) {
+                element->isAdjustedToUTC = (type == THRIFT_BOOLEAN_TRUE);
+            } else if (id == 2 && type == THRIFT_STRUCT) {
+                thrift.enterStruct();
+                int16_t unitLastId = 0;
+                while (thrift.readFieldHeader(unitLastId, id, type)) {
+                    if (id >= PARQUET_MILLIS && id <= PARQUET_NANOS) {
+                        element->timeUnit = id;
+                    }
+                    thrift.skip(type);
+                }
+                thrift.leaveStruct();
+            } else {
+                thrift.skip(type);
+            }
+        }
+        thrift.leaveStruct();
+    }
+    thrift.leaveStruct();
+}
+
+static void ParseSchemaElement(ThriftCompactReader &thrift, ParquetSchemaElement *element) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            element->type = thrift.readI32();
+        } else if (id == 2 && type == THRIFT_I32) {
+            element->typeLength = thrift.readI32();
+        } else if (id == 3 && type == THRIFT_I32) {
+            element->repetition = thrift.readI32();
+        } else if (id == 4 && type == THRIFT_BINARY) {
+            element->name = thrift.readBinary();
+        } else if (id == 5 && type == THRIFT_I32) {
+            element->numChildren = thrift.readI32();
+        } else if (id == 6 && type == THRIFT_I32) {
+            element->convertedType = thrift.readI32();
+        } else if (id == 7 && type == THRIFT_I32) {
+            element->scale = thrift.readI32();
+        } else if (id == 8 && type == THRIFT_I32) {
+            element->precision = thrift.readI32();
+        } else if (id == 10 && type == THRIFT_STRUCT) {
+            ParseLogicalType(thrift, element);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+
+    // writers set both for compatibility, logicalType wins.
+    if ((element->timeUnit == PARQUET_TIME_UNIT_NONE) &&
+        ((element->convertedType == PARQUET_TIMESTAMP_MILLIS) ||
+         (element->convertedType == PARQUET_TIMESTAMP_MICROS))) {
+        element->timeUnit =
+            (element->convertedType == PARQUET_TIMESTAMP_MILLIS) ? PARQUET_MILLIS : PARQUET_MICROS;
+        element->isAdjustedToUTC = true;
+    }
+}
+
+uint64_t ParseParquetFileMetaData(const char *data, uint64_t len, ParquetFileMetaData *metadata) {
+    ThriftCompactReader thrift(data, len);
+
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 2 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListHeader(elemType);
+            CHECK_PARQUET(elemType == THRIFT_STRUCT, "bad schema");
+
+            metadata->schema.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseSchemaElement(thrift, &metadata->schema[i]);
+            }
+        } else if (id == 3 && type == THRIFT_I64) {
+            metadata->numRows = thrift.readI64();
+        } else if (id == 4 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListHeader(elemType);
+            CHECK_PARQUET(elemType == THRIFT_STRUCT, "bad row groups");
+
+            metadata->rowGroups.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseRowGroup(thrift, &metadata->rowGroups[i]);
+            }
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+
+    CHECK_PARQUET(!metadata->schema.empty(), "no schema");
+    return thrift.getPos();
+}
+
+// Parse DataPageHeader, DataPageHeaderV2 or DictionaryPageHeader.
+static void ParsePageTypeHeader(ThriftCompactReader &thrift, int32_t pageType,
+                                ParquetPageHeader *header) {
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header->numValues = thrift.readI32();
+        } else if (pageType != PARQUET_DATA_PAGE_V2 && id == 2 && type == THRIFT_I32) {
+            header->encoding = thrift.readI32();
+        } else if (pageType == PARQUET_DATA_PAGE && id == 3 && type == THRIFT_I32) {
+            header->defLevelEncoding = thrift.readI32();
+        } else if (pageType == PARQUET_DATA_PAGE_V2 && id == 4 && type == THRIFT_I32) {
+            header->encoding = thrift.readI32();
+        } else if (pageType == PARQUET_DATA_PAGE_V2 && id == 5 && type == THRIFT_I32) {
+            header->defLevelsByteLength = thrift.readI32();
+        } else if (pageType == PARQUET_DATA_PAGE_V2 && id == 6 && type == THRIFT_I32) {
+            header->repLevelsByteLength = thrift.readI32();
+        } else if (pageType == PARQUET_DATA_PAGE_V2 && id == 7 &&
+                   (type == THRIFT_BOOLEAN_TRUE || type == THRIFT_BOOLEAN_FALSE)) {
+            header->isCompressed = (type == THRIFT_BOOLEAN_TRUE);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+}
+
+uint64_t ParseParquetPageHeader(const char *data, uint64_t len, ParquetPageHeader *header) {
+    ThriftCompactReader thrift(data, len);
+
+    thrift.enterStruct();
+    int16_t lastId = 0, id;
+    uint8_t type;
+    while (thrift.readFieldHeader(lastId, id, type)) {
+        if (id == 1 && type == THRIFT_I32) {
+            header->type = thrift.readI32();
+        } else if (id == 2 && type == THRIFT_I32) {
+            header->uncompressedSize = thrift.readI32();
+        } else if (id == 3 && type == THRIFT_I32) {
+            header->compressedSize = thrift.readI32();
+        } else if (id == 5 && type == THRIFT_STRUCT) {
+            ParsePageTypeHeader(thrift, PARQUET_DATA_PAGE, header);
+        } else if (id == 7 && type == THRIFT_STRUCT) {
+            ParsePageTypeHeader(thrift, PARQUET_DICTIONARY_PAGE, header);
+        } else if (id == 8 && type == THRIFT_STRUCT) {
+            ParsePageTypeHeader(thrift, PARQUET_DATA_PAGE_V2, header);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.leaveStruct();
+
+    CHECK_PARQUET((header->uncompressedSize >= 0) && (header->compressedSize >= 0) &&
+                      (header->numValues >= 0),
+                  "bad page header");
+    return thrift.getPos();
+}
+
+void SnappyUncompress(const char *data, uint64_t len, uint64_t uncompressedSize,
+                      vector<char> &output) {
+    const uint8_t *pos = (const uint8_t *)data;
+    const uint8_t *end = pos + len;
+
+    // the preamble is the uncompressed length as varint.
+    uint64_t outLen = 0;
+    for (int shift = 0;; shift += 7) {
+        CHECK_PARQUET((pos < end) && (shift < 35), "bad snappy length");
+
+        uint8_t byte = *pos++;
+        outLen |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+
+    // check the untrusted preamble before allocating for it.
+    CHECK_PARQUET(outLen == uncompressedSize, "bad page size");
+    output.resize(outLen);
+    char *out = output.data();
+    uint64_t outPos = 0;
+
+    while (pos < end) {
+        uint8_t tag = *pos++;
+
+        uint64_t copyLen, offset;
+        switch (tag & 0x03) {
+            case 0: {  // literal, length-1 in upper 6 bits, or in following 1~4 bytes.
+                uint64_t literalLen = tag >> 2;
+                if (literalLen >= 60) {
+                    uint64_t numOfBytes = literalLen - 59;
+                    CHECK_PARQUET(numOfBytes <= (uint64_t)(end - pos), "bad snappy literal");
+
+                    literalLen = 0;
+                    for (uint64_t i = 0; i < numOfBytes; i++) {
+                        literalLen |= (uint64_t)pos[i] << (8 * i);
+                    }
+                    pos += numOfBytes;
+                }
+                literalLen++;
+
+                CHECK_PARQUET((literalLen <= (uint64_t)(end - pos)) &&
+                                  (literalLen <= outLen - outPos),
+                              "bad snappy literal");
+                memcpy(out + outPos, pos, literalLen);
+                pos += literalLen;
+                outPos += literalLen;
+                continue;
+            }
+            case 1:  // copy with 1-byte offset.
+                CHECK_PARQUET(pos < end, "bad snappy copy");
+                copyLen = ((tag >> 2) & 0x07) + 4;
+                offset = ((uint64_t)(tag >> 5) << 8) | *pos++;
+                break;
+            case 2:  // copy with 2-byte offset.
+                CHECK_PARQUET(end - pos >= 2, "bad snappy copy");
+                copyLen = (tag >> 2) + 1;
+                offset = pos[0] | ((uint64_t)pos[1] << 8);
+                pos += 2;
+                break;
+            default:  // copy with 4-byte offset.
+                CHECK_PARQUET(end - pos >= 4, "bad snappy copy");
+                copyLen = (tag >> 2) + 1;
+                offset = pos[0] | ((uint64_t)pos[1] << 8) | ((uint64_t)pos[2] << 16) |
+                         ((uint64_t)pos[3] << 24);
+                pos += 4;
+                break;
+        }
+
+        CHECK_PARQUET((offset > 0) && (offset <= outPos) && (copyLen <= outLen - outPos),
+                      "bad snappy copy");
+
+        // source and destination may overlap, copy byte by byte to repeat the pattern.
+        for (uint64_t i = 0; i < copyLen; i++) {
+            out[outPos + i] = out[outPos - offset + i];
+        }
+        outPos += copyLen;
+    }
+
+    CHECK_PARQUET(outPos == outLen, "snappy data is truncated");
+}
+
+static void GzipUncompress(const char *data, uint64_t len, vector<char> &output) {
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+
+    // detect gzip or zlib header automatically.
+    int ret = inflateInit2(&zstream, MAX_WBITS + 32);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "Failed to initialize zlib library");
+
+    zstream.next_in = (Byte *)data;
+    zstream.avail_in = len;
+    zstream.next_out = (Byte *)output.data();
+    zstream.avail_out = output.size();
+
+    int status = inflate(&zstream, Z_FINISH);
+    uint64_t outLen = zstream.total_out;
+    inflateEnd(&zstream);
+
+    CHECK_PARQUET((status == Z_STREAM_END) && (outLen == output.size()), "bad gzip page");
+}
+
+// Decode count values of RLE/bit-packing hybrid encoding, used by levels and dictionary indexes.
+static void DecodeRleHybrid(const char *data, uint64_t len, uint32_t bitWidth, uint64_t count,
+                            vector<uint32_t> &values) {
+    CHECK_PARQUET(bitWidth <= 32, "bad bit width");
+
+    values.clear();
+    values.reserve(count);
+
+    uint64_t pos = 0;
+    while (values.size() < count) {
+        ThriftCompactReader varint(data + pos, len - pos);
+        uint64_t header = varint.readVarint();
+        pos += varint.getPos();
+
+        const uint8_t *run = (const uint8_t *)data + pos;
+
+        if (header & 1) {  // bit-packed groups of 8 values.
+            uint64_t numOfValues = (header >> 1) * 8;
+            uint64_t numOfBytes = (header >> 1) * bitWidth;
+            CHECK_PARQUET((numOfValues > 0) && (numOfBytes <= len - pos), "bad bit-packed run");
+
+            uint64_t mask = (1ULL << bitWidth) - 1;
+            for (uint64_t i = 0; (i < numOfValues) && (values.size() < count); i++) {
+                uint64_t bitPos = i * bitWidth;
+                uint64_t bytePos = bitPos / 8;
+
+                uint64_t word = 0;
+                memcpy(&word, run + bytePos, std::min((uint64_t)8, numOfBytes - bytePos));
+                values.push_back((uint32_t)((word >> (bitPos % 8)) & mask));
+            }
+
+            pos += numOfBytes;
+        } else {  // RLE run of a value.
+            uint64_t runLen = header >> 1;
+            uint64_t numOfBytes = (bitWidth + 7) / 8;
+            CHECK_PARQUET((runLen > 0) && (numOfBytes <= len - pos), "bad RLE run");
+
+            uint32_t value = 0;
+            for (uint64_t i = 0; i < numOfBytes; i++) {
+                value |= (uint32_t)run[i] << (8 * i);
+            }
+
+            values.resize(values.size() + std::min(runLen, count - values.size()), value);
+
+            pos += numOfBytes;
+        }
+    }
+}
+
+// Return the next PLAIN encoded value of a type other than BOOLEAN, and its length.
+static const char *NextPlainValue(const ParquetSchemaElement &element, const char *&pos,
+                                  const char *end, uint64_t &len) {
+    switch (element.type) {
+        case PARQUET_INT32:
+        case PARQUET_FLOAT:
+            len = 4;
+            break;
+        case PARQUET_INT64:
+        case PARQUET_DOUBLE:
+            len = 8;
+            break;
+        case PARQUET_INT96:
+            len = 12;
+            break;
+        case PARQUET_FIXED_LEN_BYTE_ARRAY:
+            len = element.typeLength;
+            break;
+        case PARQUET_BYTE_ARRAY: {
+            CHECK_PARQUET(end - pos >= 4, "value out of bound");
+
+            uint32_t byteLen;
+            memcpy(&byteLen, pos, 4);
+            pos += 4;
+            len = byteLen;
+            break;
+        }
+        default:
+            CHECK_PARQUET(false, "unsupported type " + std::to_string(element.type));
+    }
+
+    CHECK_PARQUET(len <= (uint64_t)(end - pos), "value out of bound");
+
+    const char *value = pos;
+    pos += len;
+    return value;
+}
+
+// Days since 1970-01-01 to year, month and day of proleptic Gregorian calendar.
+static void CivilFromDays(int64_t days, int64_t &year, int &month, int &day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t mp = (5 * dayOfYear + 2) / 153;
+
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+static int64_t DaysFromCivil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+static void FormatDate(int64_t days, string &value) {
+    int64_t year;
+    int month, day;
+    CivilFromDays(days, year, month, day);
+
+    // there is no year 0, 1 BC comes before 1 AD.
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%04" PRId64 "-%02d-%02d%s", year > 0 ? year : 1 - year, month, day,
+             year > 0 ? "" : " BC");
+    value = buf;
+}
+
+static int64_t FloorDiv(int64_t a, int64_t b) {
+    return (a % b < 0) ? a / b - 1 : a / b;
+}
+
+static void FormatTimestamp(int64_t micros, bool isUTC, string &value) {
+    const int64_t microsPerDay = (int64_t)SECONDS_PER_DAY * 1000000;
+
+    int64_t days = FloorDiv(micros, microsPerDay);
+    int64_t timeOfDay = micros - days * microsPerDay;
+
+    int64_t year;
+    int month, day;
+    CivilFromDays(days, year, month, day);
+
+    int64_t seconds = timeOfDay / 1000000;
+
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%04" PRId64 "-%02d-%02d %02d:%02d:%02d.%06d%s%s",
+             year > 0 ? year : 1 - year, month, day, (int)(seconds / 3600),
+             (int)(seconds / 60 % 60), (int)(seconds % 60), (int)(timeOfDay % 1000000),
+             isUTC ? "+00" : "", year > 0 ? "" : " BC");
+    value = buf;
+}
+
+static void FormatDecimal(__int128 unscaled, int32_t scale, string &value) {
+    bool negative = unscaled < 0;
+    unsigned __int128 magnitude = negative ? -(unsigned __int128)unscaled : unscaled;
+
+    string digits;
+    do {
+        digits.push_back('0' + (int)(magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    while ((int64_t)digits.size() <= scale) {
+        digits.push_back('0');
+    }
+
+    value.clear();
+    if (negative) {
+        value.push_back('-');
+    }
+
+    for (int64_t i = digits.size() - 1; i >= 0; i--) {
+        value.push_back(digits[i]);
+        if ((i == scale) && (scale > 0)) {
+            value.push_back('.');
+        }
+    }
+}
+
+static void FormatFloat(double number, int precision, string &value) {
+    if (std::isnan(number)) {
+        value = "NaN";
+    } else if (std::isinf(number)) {
+        value = number > 0 ? "Infinity" : "-Infinity";
+    } else {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*g", precision, number);
+        value = buf;
+    }
+}
+
+ParquetColumnReader::ParquetColumnReader()
+    : column(NULL),
+      codec(PARQUET_UNCOMPRESSED),
+      chunkData(NULL),
+      chunkLen(0),
+      chunkPos(0),
+      numOfPageValues(0),
+      pageValueIndex(0),
+      nonNullIndex(0),
+      dictEncoded(false),
+      rleEncoded(false),
+      plainPos(NULL),
+      plainEnd(NULL) {
+}
+
+void ParquetColumnReader::reset(const ParquetColumn &column, const ParquetColumnChunk &chunk,
+                                const char *data, uint64_t len) {
+    this->column = &column;
+    this->codec = chunk.codec;
+
+    this->chunkData = data;
+    this->chunkLen = len;
+    this->chunkPos = 0;
+
+    this->dictValues.clear();
+    this->numOfPageValues = 0;
+    this->pageValueIndex = 0;
+    this->nonNullIndex = 0;
+}
+
+bool ParquetColumnReader::next(string &value) {
+    while (this->pageValueIndex >= this->numOfPageValues) {
+        this->readPage();
+    }
+
+    uint64_t index = this->pageValueIndex++;
+    int32_t maxDefLevel = this->column->maxDefLevel;
+    if ((maxDefLevel > 0) && (this->defLevels[index] < (uint32_t)maxDefLevel)) {
+        return false;
+    }
+
+    if (this->dictEncoded) {
+        uint32_t dictIndex = this->dictIndexes[this->nonNullIndex++];
+        CHECK_PARQUET(dictIndex < this->dictValues.size(), "dictionary index out of bound");
+
+        this->formatValue(this->dictValues[dictIndex].first, this->dictValues[dictIndex].second,
+                          value);
+    } else if (this->rleEncoded) {
+        value = this->dictIndexes[this->nonNullIndex++] ? "true" : "false";
+    } else {
+        this->formatPlainValue(value);
+    }
+
+    return true;
+}
+
+void ParquetColumnReader::readPage() {
+    CHECK_PARQUET(this->chunkPos < this->chunkLen, "column chunk has fewer values than rows");
+
+    ParquetPageHeader header;
+    this->chunkPos += ParseParquetPageHeader(this->chunkData + this->chunkPos,
+                                             this->chunkLen - this->chunkPos, &header);
+
+    CHECK_PARQUET((uint64_t)header.compressedSize <= this->chunkLen - this->chunkPos,
+                  "page out of bound");
+
+    const char *data = this->chunkData + this->chunkPos;
+    this->chunkPos += header.compressedSize;
+
+    switch (header.type) {
+        case PARQUET_DICTIONARY_PAGE:
+            this->readDictionaryPage(header, data, header.compressedSize);
+            break;
+        case PARQUET_DATA_PAGE:
+        case PARQUET_DATA_PAGE_V2:
+            this->readDataPage(header, data, header.compressedSize);
+            break;
+        default:  // index pages are not used.
+            break;
+    }
+}
+
+// Return uncompressed data of a page, which is either data itself or in buffer.
+const char *ParquetColumnReader::uncompress(const char *data, uint64_t len,
+                                            uint64_t uncompressedSize, vector<char> &buffer) {
+    switch (this->codec) {
+        case PARQUET_UNCOMPRESSED:
+            CHECK_PARQUET(len == uncompressedSize, "bad page size");
+            return data;
+        case PARQUET_SNAPPY:
+            SnappyUncompress(data, len, uncompressedSize, buffer);
+            return buffer.data();
+        case PARQUET_GZIP:
+            buffer.resize(uncompressedSize);
+            GzipUncompress(data, len, buffer);
+            return buffer.data();
+        default:
+            S3_DIE(S3RuntimeError,
+                   "Unsupported Parquet compression codec " + std::to_string(this->codec));
+    }
+}
+
+void ParquetColumnReader::readDictionaryPage(const ParquetPageHeader &header, const char *data,
+                                             uint64_t len) {
+    CHECK_PARQUET(
+        (header.encoding == PARQUET_PLAIN) || (header.encoding == PARQUET_PLAIN_DICTIONARY),
+        "bad dictionary encoding");
+    CHECK_PARQUET(this->column->element.type != PARQUET_BOOLEAN, "dictionary of booleans");
+
+    const char *pos = this->uncompress(data, len, header.uncompressedSize, this->dictBuffer);
+    const char *end = pos + header.uncompressedSize;
+
+    this->dictValues.clear();
+    this->dictValues.reserve(header.numValues);
+    for (int32_t i = 0; i < header.numValues; i++) {
+        uint64_t valueLen;
+        const char *value = NextPlainValue(this->column->element, pos, end, valueLen);
+        this->dictValues.emplace_back(value, valueLen);
+    }
+}
+
+void ParquetColumnReader::readDataPage(const ParquetPageHeader &header, const char *data,
+                                       uint64_t len) {
+    const char *values;
+    uint64_t valuesLen;
+
+    int32_t maxDefLevel = this->column->maxDefLevel;
+    uint32_t defLevelBitWidth = (maxDefLevel > 0) ? 32 - __builtin_clz(maxDefLevel) : 0;
+
+    if (header.type == PARQUET_DATA_PAGE_V2) {
+        // levels are never compressed, followed by values compressed or not.
+        uint64_t levelsLen = (uint64_t)header.repLevelsByteLength + header.defLevelsByteLength;
+        CHECK_PARQUET((header.repLevelsByteLength == 0) && (header.defLevelsByteLength >= 0) &&
+                          (levelsLen <= len) && (levelsLen <= (uint64_t)header.uncompressedSize),
+                      "bad levels of page");
+
+        if (maxDefLevel > 0) {
+            DecodeRleHybrid(data, header.defLevelsByteLength, defLevelBitWidth, header.numValues,
+                            this->defLevels);
+        }
+
+        valuesLen = header.uncompressedSize - levelsLen;
+        values = header.isCompressed ? this->uncompress(data + levelsLen, len - levelsLen,
+                                                        valuesLen, this->pageBuffer)
+                                     : data + levelsLen;
+        CHECK_PARQUET(header.isCompressed || (valuesLen == len - levelsLen), "bad page size");
+    } else {
+        values = this->uncompress(data, len, header.uncompressedSize, this->pageBuffer);
+        valuesLen = header.uncompressedSize;
+
+        // definition levels of RLE encoding, prefixed by their length.
+        if (maxDefLevel > 0) {
+            CHECK_PARQUET(header.defLevelEncoding == PARQUET_RLE, "unsupported level encoding");
+            CHECK_PARQUET(valuesLen >= 4, "bad levels of page");
+
+            uint32_t levelsLen;
+            memcpy(&levelsLen, values, 4);
+            CHECK_PARQUET(levelsLen <= valuesLen - 4, "bad levels of page");
+
+            DecodeRleHybrid(values + 4, levelsLen, defLevelBitWidth, header.numValues,
+                            this->defLevels);
+
+            values += 4 + levelsLen;
+            valuesLen -= 4 + levelsLen;
+        }
+    }
+
+    uint64_t numOfNonNulls = header.numValues;
+    if (maxDefLevel > 0) {
+        numOfNonNulls =
+            std::count(this->defLevels.begin(), this->defLevels.end(), (uint32_t)maxDefLevel);
+    }
+
+    if ((header.encoding == PARQUET_PLAIN_DICTIONARY) ||
+        (header.encoding == PARQUET_RLE_DICTIONARY)) {
+        this->dictEncoded = true;
+        this->rleEncoded = false;
+        this->dictIndexes.clear();
+
+        // indexes are prefixed by their bit width.
+        if (numOfNonNulls > 0) {
+            CHECK_PARQUET(valuesLen >= 1, "bad dictionary indexes");
+            DecodeRleHybrid(values + 1, valuesLen - 1, (uint8_t)values[0], numOfNonNulls,
+                            this->dictIndexes);
+        }
+    } else if ((header.encoding == PARQUET_RLE) &&
+               (this->column->element.type == PARQUET_BOOLEAN)) {
+        this->dictEncoded = false;
+        this->rleEncoded = true;
+        this->dictIndexes.clear();
+
+        // booleans of bit width 1, prefixed by their length.
+        if (numOfNonNulls > 0) {
+            uint32_t booleansLen;
+            CHECK_PARQUET(valuesLen >= 4, "bad booleans of page");
+            memcpy(&booleansLen, values, 4);
+            CHECK_PARQUET(booleansLen <= valuesLen - 4, "bad booleans of page");
+
+            DecodeRleHybrid(values + 4, booleansLen, 1, numOfNonNulls, this->dictIndexes);
+        }
+    } else if (header.encoding == PARQUET_PLAIN) {
+        this->dictEncoded = false;
+        this->rleEncoded = false;
+        this->plainPos = values;
+        this->plainEnd = values + valuesLen;
+
+        if (this->column->element.type == PARQUET_BOOLEAN) {
+            CHECK_PARQUET((numOfNonNulls + 7) / 8 <= valuesLen, "booleans out of bound");
+        }
+    } else {
+        S3_DIE(S3RuntimeError, "Unsupported Parquet encoding " + std::to_string(header.encoding));
+    }
+
+    this->numOfPageValues = header.numValues;
+    this->pageValueIndex = 0;
+    this->nonNullIndex = 0;
+}
+
+void ParquetColumnReader::formatPlainValue(string &value) {
+    // booleans are bit-packed, LSB first.
+    if (this->column->element.type == PARQUET_BOOLEAN) {
+        uint64_t index = this->nonNullIndex++;
+        bool bit = (this->plainPos[index / 8] >> (index % 8)) & 1;
+        value = bit ? "true" : "false";
+        return;
+    }
+
+    this->nonNullIndex++;
+
+    uint64_t len;
+    const char *data = NextPlainValue(this->column->element, this->plainPos, this->plainEnd, len);
+    this->formatValue(data, len, value);
+}
+
+void ParquetColumnReader::formatValue(const char *data, uint64_t len, string &value) {
+    const ParquetSchemaElement &element = this->column->element;
+
+    switch (element.type) {
+        case PARQUET_INT32: {
+            int32_t number;
+            memcpy(&number, data, 4);
+
+            if (element.convertedType == PARQUET_DATE) {
+                FormatDate(number, value);
+            } else if (element.convertedType == PARQUET_DECIMAL) {
+                FormatDecimal(number, element.scale, value);
+            } else if ((element.convertedType >= PARQUET_UINT_8) &&
+                       (element.convertedType <= PARQUET_UINT_32)) {
+                value = std::to_string((unsigned long long)(uint32_t)number);
+            } else {
+                value = std::to_string((long long)number);
+            }
+            break;
+        }
+        case PARQUET_INT64: {
+            int64_t number;
+            memcpy(&number, data, 8);
+
+            if (element.timeUnit == PARQUET_MILLIS) {
+                FormatTimestamp(number * 1000, element.isAdjustedToUTC, value);
+            } else if (element.timeUnit == PARQUET_MICROS) {
+                FormatTimestamp(number, element.isAdjustedToUTC, value);
+            } else if (element.timeUnit == PARQUET_NANOS) {
+                FormatTimestamp(FloorDiv(number, 1000), element.isAdjustedToUTC, value);
+            } else if (element.convertedType == PARQUET_DECIMAL) {
+                FormatDecimal(number, element.scale, value);
+            } else if (element.convertedType == PARQUET_UINT_64) {
+                value = std::to_string((unsigned long long)number);
+            } else {
+                value = std::to_string((long long)number);
+            }
+            break;
+        }
+        case PARQUET_INT96: {
+            // legacy timestamp of Hive and Impala: nanoseconds of the day, then julian day.
+            int64_t nanos;
+            int32_t julianDay;
+            memcpy(&nanos, data, 8);
+            memcpy(&julianDay, data + 8, 4);
+
+            int64_t micros =
+                ((int64_t)julianDay - JULIAN_DAY_OF_EPOCH) * SECONDS_PER_DAY * 1000000 +
+                nanos / 1000;
+            FormatTimestamp(micros, false, value);
+            break;
+        }
+        case PARQUET_FLOAT: {
+            float number;
+            memcpy(&number, data, 4);
+            FormatFloat(number, 9, value);
+            break;
+        }
+        case PARQUET_DOUBLE: {
+            double number;
+            memcpy(&number, data, 8);
+            FormatFloat(number, 17, value);
+            break;
+        }
+        case PARQUET_BYTE_ARRAY:
+        case PARQUET_FIXED_LEN_BYTE_ARRAY:
+            if (element.convertedType == PARQUET_DECIMAL) {
+                // big-endian two's complement.
+                CHECK_PARQUET((len > 0) && (len <= 16), "decimal too long");
+
+                __int128 unscaled = (int8_t)data[0];
+                for (uint64_t i = 1; i < len; i++) {
+                    unscaled = unscaled * 256 + (uint8_t)data[i];
+                }
+                FormatDecimal(unscaled, element.scale, value);
+            } else if (element.type == PARQUET_BYTE_ARRAY) {
+                value.assign(data, len);
+            } else {
+                // hex format of bytea.
+                static const char hex[] = "0123456789abcdef";
+                value = "\\x";
+                for (uint64_t i = 0; i < len; i++) {
+                    value.push_back(hex[(uint8_t)data[i] >> 4]);
+                    value.push_back(hex[(uint8_t)data[i] & 0x0F]);
+                }
+            }
+            break;
+        default:
+            S3_DIE(S3RuntimeError, "Unsupported Parquet type " + std::to_string(element.type));
+    }
+}
+
+vector<ParquetPredicate> ParseParquetFilter(const string &filter) {
+    vector<ParquetPredicate> predicates;
+
+    std::stringstream terms(filter);
+    string term;
+    while (std::getline(terms, term, ',')) {
+        size_t opPos = term.find_first_of("<>=");
+        S3_CHECK_OR_DIE((opPos != string::npos) && (opPos > 0), S3ConfigError,
+                        "Invalid filter condition: " + term, "filter");
+
+        size_t opLen = ((term[opPos] != '=') && (term[opPos + 1] == '=')) ? 2 : 1;
+
+        ParquetPredicate predicate;
+        predicate.column = term.substr(0, opPos);
+        predicate.op = term.substr(opPos, opLen);
+        predicate.value = term.substr(opPos + opLen);
+
+        // only "=", "<", "<=", ">" and ">=", others like "<>", "!=" or "=>" would be taken as one
+        // of those with the rest in the column or value, and skip row groups that match.
+        S3_CHECK_OR_DIE((predicate.column.back() != '!') &&
+                            (predicate.value.find_first_of("<>=!") != 0),
+                        S3ConfigError, "Invalid filter operator: " + term, "filter");
+        predicates.push_back(predicate);
+    }
+
+    return predicates;
+}
+
+// Compare a min or max value of statistics to value of predicate, set result to negative, zero or
+// positive as strcmp() does. Return false if the type is not supported.
+static bool CompareStatistic(const ParquetColumn &column, const string &statistic, bool isLegacy,
+                             const string &value, int &result) {
+    const ParquetSchemaElement &element = column.element;
+    char *end = NULL;
+
+    switch (element.type) {
+        case PARQUET_INT32:
+        case PARQUET_INT64: {
+            if (((element.convertedType != PARQUET_CONVERTED_NONE) &&
+                 (element.convertedType != PARQUET_DATE)) ||
+                (element.timeUnit != PARQUET_TIME_UNIT_NONE)) {
+                return false;
+            }
+
+            int64_t number;
+            if (element.convertedType == PARQUET_DATE) {
+                int year, month, day;
+                if (sscanf(value.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+                    return false;
+                }
+                number = DaysFromCivil(year, month, day);
+            } else {
+                number = strtoll(value.c_str(), &end, 10);
+                if (value.empty() || *end != '\0') {
+                    return false;
+                }
+            }
+
+            int64_t stat;
+            if (element.type == PARQUET_INT32) {
+                int32_t stat32;
+                if (statistic.size() != 4) {
+                    return false;
+                }
+                memcpy(&stat32, statistic.data(), 4);
+                stat = stat32;
+            } else {
+                if (statistic.size() != 8) {
+                    return false;
+                }
+                memcpy(&stat, statistic.data(), 8);
+            }
+
+            result = (stat < number) ? -1 : (stat > number);
+            return true;
+        }
+        case PARQUET_FLOAT:
+        case PARQUET_DOUBLE: {
+            double number = strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || std::isnan(number)) {
+                return false;
+            }
+
+            double stat;
+            if (element.type == PARQUET_FLOAT) {
+                float stat32;
+                if (statistic.size() != 4) {
+                    return false;
+                }
+                memcpy(&stat32, statistic.data(), 4);
+                stat = stat32;
+            } else {
+                if (statistic.size() != 8) {
+                    return false;
+                }
+                memcpy(&stat, statistic.data(), 8);
+            }
+
+            if (std::isnan(stat)) {
+                return false;
+            }
+
+            result = (stat < number) ? -1 : (stat > number);
+            return true;
+        }
+        case PARQUET_BYTE_ARRAY:
+            // the legacy min and max of strings were compared as signed bytes.
+            if (isLegacy || ((element.convertedType != PARQUET_CONVERTED_NONE) &&
+                             (element.convertedType != PARQUET_UTF8))) {
+                return false;
+            }
+
+            result = statistic.compare(value);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ParquetChunkMayMatch(const ParquetColumn &column, const ParquetColumnChunk &chunk,
+                          const ParquetPredicate &predicate) {
+    const ParquetStatistics &statistics = chunk.statistics;
+
+    // NULL never satisfies a comparison.
+    if (statistics.hasNullCount && (chunk.numValues > 0) &&
+        (statistics.nullCount >= chunk.numValues)) {
+        return false;
+    }
+
+    if (!statistics.hasMin || !statistics.hasMax) {
+        return true;
+    }
+
+    int minResult, maxResult;
+    if (!CompareStatistic(column, statistics.min, statistics.isLegacy, predicate.value,
+                          minResult) ||
+        !CompareStatistic(column, statistics.max, statistics.isLegacy, predicate.value,
+                          maxResult)) {
+        return true;
+    }
+
+    if (predicate.op == "=") {
+        return (minResult <= 0) && (maxResult >= 0);
+    } else if (predicate.op == "<") {
+        return minResult < 0;
+    } else if (predicate.op == "<=") {
+        return minResult <= 0;
+    } else if (predicate.op == ">") {
+        return maxResult > 0;
+    } else if (predicate.op == ">=") {
+        return maxResult >= 0;
+    }
+
+    return true;
+}
+
+// Find a column by name, exact match first, then ignoring case as unquoted names of GPDB are in
+// lower case.
+static const ParquetColumn *FindColumn(const vector<ParquetColumn> &columns, const string &name) {
+    for (const ParquetColumn &column : columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+
+    for (const ParquetColumn &column : columns) {
+        if (strcasecmp(column.name.c_str(), name.c_str()) == 0) {
+            return &column;
+        }
+    }
+
+    return NULL;
+}
+
+ParquetReader::ParquetReader()
+    : s3Interface(NULL),
+      s3Url(""),
+      keySize(0),
+      rangeStart(0),
+      rangeEnd(0),
+      rowGroupIndex(0),
+      rowsLeft(0),
+      rowsOffset(0),
+      numOfSkippedRowGroups(0),
+      fetchedBytes(0),
+      isClosed(true) {
+}
+
+ParquetReader::~ParquetReader() {
+    this->close();
+}
+
+void ParquetReader::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    this->s3Url = params.getS3Url();
+    this->keySize = params.getKeySize();
+    this->rangeStart = params.getRangeStart();
+    this->rangeEnd = (params.getRangeEnd() == 0) ? this->keySize : params.getRangeEnd();
+
+    this->metadata = ParquetFileMetaData();
+    this->rowGroupIndex = 0;
+    this->rowsLeft = 0;
+    this->rows.clear();
+    this->rowsOffset = 0;
+    this->numOfSkippedRowGroups = 0;
+    this->fetchedBytes = 0;
+    this->isClosed = false;
+
+    this->readFooter();
+    this->resolveColumns();
+
+    this->predicates.clear();
+    for (const ParquetPredicate &predicate : ParseParquetFilter(params.getFilter())) {
+        const ParquetColumn *column = FindColumn(this->fileColumns, predicate.column);
+        if (column == NULL) {
+            S3WARN("Filter column %s is not found in %s, ignore it", predicate.column.c_str(),
+                   this->s3Url.getFullUrlForCurl().c_str());
+            continue;
+        }
+
+        this->predicates.push_back(std::make_pair(*column, predicate));
+    }
+
+    // every file has a header line, so that S3BucketReader skips it of all but the first one.
+    if (hasHeader) {
+        this->appendHeader();
+    }
+}
+
+void ParquetReader::fetch(uint64_t offset, uint64_t len, S3VectorUInt8 &data) {
+    uint64_t readLen = this->s3Interface->fetchData(offset, data, len, this->s3Url);
+    S3_CHECK_OR_DIE(readLen == len, S3PartialResponseError, len, readLen);
+
+    this->fetchedBytes += len;
+}
+
+// File ends with metadata, its length in 4 bytes and the magic. Fetch the tail in one request,
+// and the rest of metadata if it is longer.
+void ParquetReader::readFooter() {
+    S3_CHECK_OR_DIE(this->keySize >= 2 * PARQUET_MAGIC_LEN + 4, S3RuntimeError,
+                    this->s3Url.getFullUrlForCurl() + " is too small to be a Parquet file");
+
+    uint64_t tailLen = std::min(this->keySize, (uint64_t)PARQUET_FOOTER_FETCH_SIZE);
+
+    S3VectorUInt8 tail;
+    this->fetch(this->keySize - tailLen, tailLen, tail);
+
+    const char *magic = (const char *)tail.data() + tailLen - PARQUET_MAGIC_LEN;
+    S3_CHECK_OR_DIE(memcmp(magic, PARQUET_MAGIC, PARQUET_MAGIC_LEN) == 0, S3RuntimeError,
+                    this->s3Url.getFullUrlForCurl() + " is not a Parquet file");
+
+    uint32_t metadataLen;
+    memcpy(&metadataLen, magic - 4, 4);
+    CHECK_PARQUET((uint64_t)metadataLen + 2 * PARQUET_MAGIC_LEN + 4 <= this->keySize,
+                  "bad metadata length");
+
+    if (metadataLen + PARQUET_MAGIC_LEN + 4 <= tailLen) {
+        ParseParquetFileMetaData(magic - 4 - metadataLen, metadataLen, &this->metadata);
+    } else {
+        S3VectorUInt8 data;
+        this->fetch(this->keySize - PARQUET_MAGIC_LEN - 4 - metadataLen, metadataLen, data);
+        ParseParquetFileMetaData((const char *)data.data(), metadataLen, &this->metadata);
+    }
+
+    S3DEBUG("Parquet file %s has %" PRId64 " rows in %zu row groups",
+            this->s3Url.getFullUrlForCurl().c_str(), this->metadata.numRows,
+            this->metadata.rowGroups.size());
+}
+
+// Find leaf columns at the top level of schema, and the ones to read among them.
+void ParquetReader::resolveColumns() {
+    const vector<ParquetSchemaElement> &schema = this->metadata.schema;
+
+    this->fileColumns.clear();
+    std::set<string> nestedColumns;
+
+    // number of children not visited yet of each group on the path.
+    vector<int64_t> remaining(1, schema[0].numChildren);
+    int64_t numOfLeaves = 0;
+
+    for (uint64_t i = 1; i < schema.size(); i++) {
+        while (!remaining.empty() && (remaining.back() <= 0)) {
+            remaining.pop_back();
+        }
+        CHECK_PARQUET(!remaining.empty(), "bad schema");
+
+        remaining.back()--;
+        bool isTopLevel = (remaining.size() == 1);
+
+        const ParquetSchemaElement &element = schema[i];
+        if (element.numChildren > 0) {
+            if (isTopLevel) {
+                nestedColumns.insert(element.name);
+            }
+            remaining.push_back(element.numChildren);
+            continue;
+        }
+
+        if (isTopLevel && (element.repetition != PARQUET_REPEATED)) {
+            ParquetColumn column;
+            column.name = element.name;
+            column.leafIndex = numOfLeaves;
+            column.element = element;
+            column.maxDefLevel = (element.repetition == PARQUET_OPTIONAL) ? 1 : 0;
+            this->fileColumns.push_back(column);
+        } else if (isTopLevel) {
+            nestedColumns.insert(element.name);
+        }
+
+        numOfLeaves++;
+    }
+
+    for (const ParquetRowGroup &rowGroup : this->metadata.rowGroups) {
+        CHECK_PARQUET(rowGroup.columns.size() == (uint64_t)numOfLeaves,
+                      "row group doesn't match schema");
+    }
+
+    this->columns.clear();
+    if (tableFormat.columns.empty()) {
+        this->columns = this->fileColumns;
+        return;
+    }
+
+    for (const string &name : tableFormat.columns) {
+        const ParquetColumn *found = FindColumn(this->fileColumns, name);
+        if (found != NULL) {
+            this->columns.push_back(*found);
+            continue;
+        }
+
+        S3_CHECK_OR_DIE(nestedColumns.find(name) == nestedColumns.end(), S3RuntimeError,
+                        "Nested or repeated Parquet column " + name + " is not supported");
+
+        // missing columns are NULL.
+        ParquetColumn column;
+        column.name = name;
+        this->columns.push_back(column);
+    }
+}
+
+bool ParquetReader::rowGroupMayMatch(const ParquetRowGroup &rowGroup) {
+    for (const std::pair<ParquetColumn, ParquetPredicate> &predicate : this->predicates) {
+        const ParquetColumnChunk &chunk = rowGroup.columns[predicate.first.leafIndex];
+        if (!ParquetChunkMayMatch(predicate.first, chunk, predicate.second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Move to the next row group of this range to read, return false if there is none.
+bool ParquetReader::nextRowGroup() {
+    while (this->rowGroupIndex < this->metadata.rowGroups.size()) {
+        const ParquetRowGroup &rowGroup = this->metadata.rowGroups[this->rowGroupIndex++];
+        if (rowGroup.numRows <= 0 || rowGroup.columns.empty()) {
+            continue;
+        }
+
+        // row group belongs to the range where it starts.
+        uint64_t start = rowGroup.columns[0].getStart();
+        if ((start < this->rangeStart) || (start >= this->rangeEnd)) {
+            continue;
+        }
+
+        if (!this->rowGroupMayMatch(rowGroup)) {
+            this->numOfSkippedRowGroups++;
+            continue;
+        }
+
+        this->fetchRowGroup(rowGroup);
+        this->rowsLeft = rowGroup.numRows;
+        return true;
+    }
+
+    return false;
+}
+
+// Fetch column chunks of the columns to read, chunks close to each other in one request.
+void ParquetReader::fetchRowGroup(const ParquetRowGroup &rowGroup) {
+    // (start, index in columns) of column chunks to read.
+    vector<std::pair<uint64_t, uint64_t>> chunks;
+    for (uint64_t i = 0; i < this->columns.size(); i++) {
+        if (this->columns[i].leafIndex < 0) {
+            continue;
+        }
+
+        const ParquetColumnChunk &chunk = rowGroup.columns[this->columns[i].leafIndex];
+        CHECK_PARQUET((chunk.getStart() >= 0) && (chunk.totalCompressedSize >= 0) &&
+                          ((uint64_t)chunk.getStart() + chunk.totalCompressedSize <= this->keySize),
+                      "column chunk out of bound");
+
+        chunks.emplace_back(chunk.getStart(), i);
+    }
+    std::sort(chunks.begin(), chunks.end());
+
+    // readers point into chunkData, which must not reallocate.
+    this->chunkData.clear();
+    this->chunkData.reserve(chunks.size());
+    this->columnReaders.resize(this->columns.size());
+
+    for (uint64_t first = 0; first < chunks.size();) {
+        uint64_t start = chunks[first].first;
+        uint64_t end = start;
+
+        uint64_t last = first;
+        for (; last < chunks.size(); last++) {
+            const ParquetColumnChunk &chunk =
+                rowGroup.columns[this->columns[chunks[last].second].leafIndex];
+            if (chunk.getStart() > (int64_t)(end + PARQUET_MAX_MERGE_GAP)) {
+                break;
+            }
+            end = std::max(end, (uint64_t)(chunk.getStart() + chunk.totalCompressedSize));
+        }
+
+        this->chunkData.emplace_back();
+        S3VectorUInt8 &data = this->chunkData.back();
+        this->fetch(start, end - start, data);
+
+        for (uint64_t i = first; i < last; i++) {
+            const ParquetColumn &column = this->columns[chunks[i].second];
+            const ParquetColumnChunk &chunk = rowGroup.columns[column.leafIndex];
+
+            this->columnReaders[chunks[i].second].reset(
+                column, chunk, (const char *)data.data() + (chunk.getStart() - start),
+                chunk.totalCompressedSize);
+        }
+
+        first = last;
+    }
+}
+
+void ParquetReader::appendField(const string &value, bool isNull) {
+    if (isNull) {
+        this->rows += tableFormat.nullString;
+        return;
+    }
+
+    char delimiter = tableFormat.delimiter;
+    char escape = tableFormat.escape;
+
+    if (!tableFormat.isCsv) {
+        for (char c : value) {
+            if ((escape != '\0') &&
+                ((c == escape) || (c == delimiter) || (c == '\n') || (c == '\r'))) {
+                this->rows.push_back(escape);
+                c = (c == '\n') ? 'n' : (c == '\r') ? 'r' : c;
+            }
+            this->rows.push_back(c);
+        }
+        return;
+    }
+
+    // quote the value if it might be read as NULL or has special chars.
+    char quote = tableFormat.quote;
+    if (!value.empty() && (value != tableFormat.nullString) &&
+        (value.find_first_of(string(1, delimiter) + quote + escape + "\r\n") == string::npos)) {
+        this->rows += value;
+        return;
+    }
+
+    this->rows.push_back(quote);
+    for (char c : value) {
+        if ((c == quote) || (c == escape)) {
+            this->rows.push_back(escape);
+        }
+        this->rows.push_back(c);
+    }
+    this->rows.push_back(quote);
+}
+
+void ParquetReader::appendHeader() {
+    for (uint64_t i = 0; i < this->columns.size(); i++) {
+        if ((i > 0) && (tableFormat.delimiter != '\0')) {
+            this->rows.push_back(tableFormat.delimiter);
+        }
+        this->appendField(this->columns[i].name, false);
+    }
+    this->rows += eolString;
+}
+
+void ParquetReader::appendRow() {
+    for (uint64_t i = 0; i < this->columns.size(); i++) {
+        if ((i > 0) && (tableFormat.delimiter != '\0')) {
+            this->rows.push_back(tableFormat.delimiter);
+        }
+
+        bool isNull = (this->columns[i].leafIndex < 0) || !this->columnReaders[i].next(this->value);
+        this->appendField(this->value, isNull);
+    }
+    this->rows += eolString;
+}
+
+uint64_t ParquetReader::read(char *buf, uint64_t count) {
+    while (this->rowsOffset >= this->rows.size()) {
+        S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
+
+        this->rows.clear();
+        this->rowsOffset = 0;
+
+        if ((this->rowsLeft == 0) && !this->nextRowGroup()) {
+            return 0;
+        }
+
+        while ((this->rowsLeft > 0) && (this->rows.size() < count)) {
+            this->appendRow();
+            this->rowsLeft--;
+        }
+    }
+
+    uint64_t len = std::min(count, (uint64_t)(this->rows.size() - this->rowsOffset));
+    memcpy(buf, this->rows.data() + this->rowsOffset, len);
+    this->rowsOffset += len;
+
+    return len;
+}
+
+void ParquetReader::close() {
+    if (this->isClosed) {
+        return;
+    }
+
+    this->isClosed = true;
+
+    S3DEBUG("Parquet file %s: fetched %" PRIu64 " bytes, skipped %" PRIu64 " row groups",
+            this->s3Url.getFullUrlForCurl().c_str(), this->fetchedBytes,
+            this->numOfSkippedRowGroups);
+
+    this->chunkData.clear();
+    this->columnReaders.clear();
+    this->metadata = ParquetFileMetaData();
+    this->rows.clear();
+    this->rowsOffset = 0;
+    this->rowsLeft = 0;
+}
@@ -1,12 +1,21 @@
 #include "s3bucket_reader.h"
 
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include <queue>
+
 S3BucketReader::S3BucketReader() : Reader() {
     this->keyIndex = 0;  // doesn't matter, be set in open()
+    this->rangeStart = 0;
+    this->rangeEnd = 0;
 
     this->s3Interface = NULL;
     this->upstreamReader = NULL;
 
     this->needNewReader = true;
+    this->lentByUpstream = false;
     this->isFirstFile = true;
 }
 
@@ -17,7 +26,7 @@ S3BucketReader::~S3BucketReader() {
 void S3BucketReader::open(const S3Params& params) {
     this->params = params;
 
-    this->keyIndex = s3ext_segid;  // we may change it in unit tests
+    this->keyIndex = 0;
 
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface is NULL");
 
@@ -26,27 +35,315 @@ void S3BucketReader::open(const S3Params& params) {
     S3_CHECK_OR_DIE(s3Url.isValidUrl(), S3ConfigError, s3Url.getFullUrlForCurl() + " is not valid",
                     s3Url.getFullUrlForCurl());
 
-    this->keyList = this->s3Interface->listBucket(s3Url);
+    this->keyList = this->listBucket(s3Url);
+    this->assignKeys();
 }
 
-BucketContent& S3BucketReader::getNextKey() {
-    BucketContent& key = this->keyList.contents[this->keyIndex];
-    this->keyIndex += s3ext_segnum;
-    return key;
+// Every segment of a statement needs the same listing. The first segment of a host to lock the
+// shared listing file lists the bucket and saves the keys into it, the others wait for the lock and
+// load the keys instead of listing again.
+ListBucketResult S3BucketReader::listBucket(S3Url& s3Url) {
+    string path = this->getSharedListingPath(s3Url);
+    if (path.empty()) {
+        return this->s3Interface->listBucket(s3Url);
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        S3WARN("Failed to open shared listing file %s: %s", path.c_str(), strerror(errno));
+        return this->s3Interface->listBucket(s3Url);
+    }
+
+    // segments that open it later list the bucket again, which is slower but still correct.
+    this->sharedListingPath = path;
+
+    int ret;
+    do {
+        ret = flock(fd, LOCK_EX);
+    } while (ret < 0 && errno == EINTR);
+
+    ListBucketResult keyList;
+    if ((ret == 0) && this->loadSharedKeyList(fd, &keyList)) {
+        S3DEBUG("Loaded %zu keys from shared listing file %s", keyList.contents.size(),
+                path.c_str());
+    } else {
+        try {
+            keyList = this->s3Interface->listBucket(s3Url);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+
+        if (ret == 0) {
+            this->saveSharedKeyList(fd, keyList);
+        }
+    }
+
+    // release the lock.
+    ::close(fd);
+
+    return keyList;
 }
 
-S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
+bool S3BucketReader::loadSharedKeyList(int fd, ListBucketResult* keyList) {
+    struct stat st;
+    if ((fstat(fd, &st) < 0) || (st.st_size == 0)) {
+        return false;
+    }
+
+    // never trust a file left by a crashed segment, even if its name matches.
+    if (st.st_mtime < time(NULL) - S3_SHARED_LISTING_TTL) {
+        S3WARN("%s", "Shared listing file is stale, list the bucket again");
+        return false;
+    }
+
+    string data(st.st_size, '\0');
+    if (pread(fd, &data[0], data.size(), 0) != (ssize_t)data.size()) {
+        return false;
+    }
+
+    // file left by a segment failed in the middle of saving.
+    if (!DeserializeKeyList(data, keyList)) {
+        S3WARN("%s", "Shared listing file is corrupted, list the bucket again");
+        return false;
+    }
+
+    return true;
+}
+
+void S3BucketReader::saveSharedKeyList(int fd, const ListBucketResult& keyList) {
+    string data = SerializeKeyList(keyList);
+
+    if ((ftruncate(fd, 0) < 0) ||
+        (pwrite(fd, data.c_str(), data.size(), 0) != (ssize_t)data.size())) {
+        S3WARN("Failed to save shared listing file: %s", strerror(errno));
+        return;
+    }
+
+    // Clean up files left by crashed segments, while holding the lock of ours.
+    const string& dirPath = this->params.getSharedListingDir();
+    DIR* dir = opendir(dirPath.c_str());
+    if (dir == NULL) {
+        return;
+    }
+
+    time_t expiration = time(NULL) - S3_SHARED_LISTING_TTL;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, S3_SHARED_LISTING_PREFIX, strlen(S3_SHARED_LISTING_PREFIX))) {
+            continue;
+        }
+
+        string path = dirPath + "/" + entry->d_name;
+        struct stat st;
+        if ((lstat(path.c_str(), &st) == 0) && (st.st_mtime < expiration)) {
+            unlink(path.c_str());
+        }
+    }
+
+    closedir(dir);
+}
+
+// Return path of the file to share listing of s3Url among segments running the same statement, or
+// empty string if sharing is disabled.
+string S3BucketReader::getSharedListingPath(S3Url& s3Url) {
+    const string& dir = this->params.getSharedListingDir();
+    if (dir.empty() || s3ext_queryid.empty()) {
+        return "";
+    }
+
+    std::stringstream path;
+    path << dir << "/" << S3_SHARED_LISTING_PREFIX << s3ext_queryid << "_" << std::hex
+         << std::hash<string>()(s3Url.getFullUrlForCurl());
+    return path.str();
+}
+
+string SerializeKeyList(const ListBucketResult& keyList) {
+    std::stringstream out;
+    out << S3_SHARED_LISTING_PREFIX << " " << keyList.contents.size() << "\n";
+
+    // names are prefixed with their length, as they might contain any character.
+    for (const BucketContent& key : keyList.contents) {
+        out << key.getSize() << " " << key.getETag().size() << " " << key.getETag() << " "
+            << key.getName().size() << " " << key.getName() << "\n";
+    }
+
+    return out.str();
+}
+
+// Read a string in format of "<length> <string>".
+static bool ReadLengthPrefixed(std::stringstream& in, uint64_t maxLen, string* str) {
+    uint64_t len = 0;
+    if (!(in >> len) || (in.get() != ' ') || (len > maxLen)) {
+        return false;
+    }
+
+    str->resize(len);
+    return len == 0 || in.read(&(*str)[0], len);
+}
+
+bool DeserializeKeyList(const string& data, ListBucketResult* keyList) {
+    std::stringstream in(data);
+
+    string magic;
+    uint64_t numOfKeys = 0;
+    if (!(in >> magic >> numOfKeys) || (magic != S3_SHARED_LISTING_PREFIX)) {
+        return false;
+    }
+
+    keyList->contents.clear();
+    keyList->contents.reserve(numOfKeys);
+
+    for (uint64_t i = 0; i < numOfKeys; i++) {
+        uint64_t size = 0;
+        string etag;
+        string name;
+        if (!(in >> size) || !ReadLengthPrefixed(in, data.size(), &etag) || (in.get() != ' ') ||
+            !ReadLengthPrefixed(in, data.size(), &name) || (in.get() != '\n')) {
+            return false;
+        }
+
+        keyList->contents.emplace_back(name, size, etag);
+    }
+
+    return true;
+}
+
+// Split keys are read in byte ranges by several segments, see getNumOfRanges(). Whole keys are then
+// assigned, largest first, to the segment with fewest bytes to read so far, to balance bytes rather
+// than number of keys among segments. Every segment computes the same assignment.
+void S3BucketReader::assignKeys() {
+    vector<BucketContent>& contents = this->keyList.contents;
+    uint64_t segNum = std::max(s3ext_segnum, 1);
+
+    vector<uint64_t> segmentBytes(segNum, 0);
+    vector<uint64_t> wholeKeys;
+
+    this->segmentKeys.clear();
+
+    for (uint64_t index = 0; index < contents.size(); index++) {
+        BucketContent& key = contents[index];
+
+        uint64_t numOfRanges = this->getNumOfRanges(key);
+        if (numOfRanges <= 1) {
+            wholeKeys.push_back(index);
+            continue;
+        }
+
+        // rotate by key index, so that segments take turns to get the leftover ranges.
+        uint64_t rangeSize = (key.getSize() + numOfRanges - 1) / numOfRanges;
+        for (uint64_t rangeIndex = 0; rangeIndex < numOfRanges; rangeIndex++) {
+            uint64_t segId = (rangeIndex + index) % segNum;
+            uint64_t rangeStart = rangeIndex * rangeSize;
+            uint64_t rangeEnd = std::min(rangeStart + rangeSize, key.getSize());
+
+            segmentBytes[segId] += rangeEnd - rangeStart;
+            if (segId == (uint64_t)s3ext_segid) {
+                this->segmentKeys.emplace_back(index, rangeStart, rangeEnd);
+            }
+        }
+    }
+
+    std::stable_sort(wholeKeys.begin(), wholeKeys.end(), [&contents](uint64_t a, uint64_t b) {
+        return contents[a].getSize() > contents[b].getSize();
+    });
+
+    // segments by bytes assigned, ties go to the lowest segment id, i.e. round-robin if keys are of
+    // the same size.
+    typedef std::pair<uint64_t, uint64_t> SegmentLoad;
+    std::priority_queue<SegmentLoad, vector<SegmentLoad>, std::greater<SegmentLoad>> segments;
+    for (uint64_t segId = 0; segId < segNum; segId++) {
+        segments.push(SegmentLoad(segmentBytes[segId], segId));
+    }
+
+    for (uint64_t index : wholeKeys) {
+        SegmentLoad load = segments.top();
+        segments.pop();
+
+        if (load.second == (uint64_t)s3ext_segid) {
+            this->segmentKeys.emplace_back(index, 0, 0);
+        }
+
+        load.first += contents[index].getSize();
+        segments.push(load);
+    }
+
+    std::sort(this->segmentKeys.begin(), this->segmentKeys.end(),
+              [](const KeyRange& a, const KeyRange& b) { return a.keyIndex < b.keyIndex; });
+
+    uint64_t bytes = 0;
+    for (const KeyRange& range : this->segmentKeys) {
+        bytes += range.rangeEnd ? range.rangeEnd - range.rangeStart
+                                : contents[range.keyIndex].getSize();
+    }
+
+    S3INFO("Segment %d reads %zu of %zu keys, %" PRIu64 " bytes", s3ext_segid,
+           this->segmentKeys.size(), contents.size(), bytes);
+}
+
+// Return the next key assigned by assignKeys(), or NULL if there are no more keys for this segment.
+BucketContent* S3BucketReader::getNextKey() {
+    if (this->keyIndex >= this->segmentKeys.size()) {
+        return NULL;
+    }
+
+    const KeyRange& range = this->segmentKeys[this->keyIndex++];
+    this->rangeStart = range.rangeStart;
+    this->rangeEnd = range.rangeEnd;
+
+    return &this->keyList.contents[range.keyIndex];
+}
+
+// Uncompressed keys larger than splitsize are split into ranges of at least one chunk, up to one
+// range per segment. Every segment calls this for every key, and gets the same result.
+uint64_t S3BucketReader::getNumOfRanges(BucketContent& key) {
+    uint64_t splitSize = this->params.getSplitSize();
+    uint64_t chunkSize = std::max(this->params.getChunkSize(), (uint64_t)1);
+
+    // Header line is only in the first range, while every segment expects one to skip.
+    if (splitSize == 0 || key.getSize() < splitSize || s3ext_segnum <= 1 || hasHeader) {
+        return 1;
+    }
+
+    // Ranges start and end at raw EOLs, but a quoted CSV field may contain EOLs itself.
+    if (tableFormat.isCsv) {
+        return 1;
+    }
+
+    uint64_t numOfRanges =
+        std::min((uint64_t)s3ext_segnum, (key.getSize() + chunkSize - 1) / chunkSize);
+    if (numOfRanges <= 1) {
+        return 1;
+    }
+
+    // gzip stream can't be decompressed from the middle.
+    if (this->s3Interface->checkCompressionType(this->getKeyUrl(key)) != S3_COMPRESSION_PLAIN) {
+        return 1;
+    }
+
+    return numOfRanges;
+}
+
+S3Url S3BucketReader::getKeyUrl(BucketContent& key) {
     // encode the key name but leave the "/"
     // "/encoded_path/encoded_name"
     string keyEncoded = UriEncode(key.getName());
     FindAndReplace(keyEncoded, "%2F", "/");
 
-    S3Params readerParams = this->params.setPrefix(keyEncoded);
+    return this->params.setPrefix(keyEncoded).getS3Url();
+}
+
+S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
+    S3Params readerParams = this->params;
+    readerParams.getS3Url() = this->getKeyUrl(key);
 
     readerParams.setKeySize(key.getSize());
+    readerParams.setKeyETag(key.getETag());
+    readerParams.setRange(this->rangeStart, this->rangeEnd);
 
-    S3DEBUG("key: %s, size: %" PRIu64, readerParams.getS3Url().getFullUrlForCurl().c_str(),
-            readerParams.getKeySize());
+    S3DEBUG("key: %s, size: %" PRIu64 ", range: [%" PRIu64 ", %" PRIu64 ")",
+            readerParams.getS3Url().getFullUrlForCurl().c_str(), readerParams.getKeySize(),
+            readerParams.getRangeStart(), readerParams.getRangeEnd());
     return readerParams;
 }
 
@@ -98,13 +395,13 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     uint64_t readCount = 0;
     while (true) {
         if (this->needNewReader) {
-            if (this->keyIndex >= this->keyList.contents.size()) {
+            BucketContent* key = this->getNextKey();
+            if (key == NULL) {
                 S3DEBUG("Read finished for segment: %d", s3ext_segid);
                 return 0;
             }
-            BucketContent& key = this->getNextKey();
 
-            this->upstreamReader->open(constructReaderParams(key));
+            this->upstreamReader->open(constructReaderParams(*key));
             this->needNewReader = false;
 
             // ignore header line if it is not the first file
@@ -128,13 +425,47 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     }
 }
 
+// Lend data of current key from upstreamReader. Switching to the next key, which might skip its
+// header line, is left to read().
+uint64_t S3BucketReader::lend(const char** buf, uint64_t count) {
+    S3_CHECK_OR_DIE(this->upstreamReader != NULL, S3RuntimeError, "upstreamReader is NULL");
+
+    if (!this->needNewReader) {
+        uint64_t len = this->upstreamReader->lend(buf, count);
+        if (len != 0) {
+            this->lentByUpstream = true;
+            return len;
+        }
+
+        this->upstreamReader->giveBack();
+    }
+
+    return Reader::lend(buf, count);
+}
+
+void S3BucketReader::giveBack() {
+    if (this->lentByUpstream) {
+        this->upstreamReader->giveBack();
+        this->lentByUpstream = false;
+    }
+}
+
 void S3BucketReader::close() {
     if (this->upstreamReader != NULL) {
         this->upstreamReader->close();
         this->upstreamReader = NULL;
     }
 
+    this->lentByUpstream = false;
+
     if (!this->keyList.contents.empty()) {
         this->keyList.contents.clear();
     }
+
+    this->segmentKeys.clear();
+
+    if (!this->sharedListingPath.empty()) {
+        unlink(this->sharedListingPath.c_str());
+        this->sharedListingPath.clear();
+    }
 }
\ No newline at end of file
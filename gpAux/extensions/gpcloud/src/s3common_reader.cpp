@@ -26,6 +26,14 @@ uint64_t S3CommonReader::read(char *buf, uint64_t count) {
     return this->upstreamReader->read(buf, count);
 }
 
+uint64_t S3CommonReader::lend(const char **buf, uint64_t count) {
+    return this->upstreamReader->lend(buf, count);
+}
+
+void S3CommonReader::giveBack() {
+    this->upstreamReader->giveBack();
+}
+
 // This should be reentrant, has no side effects when called multiple times.
 void S3CommonReader::close() {
     if (this->upstreamReader != NULL) {
@@ -7,6 +7,8 @@
 #ifndef S3_STANDALONE
 extern "C" {
 void write_log(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+bool getDistributedTransactionIdentifier(char* id);
+extern char* DataDir;
 }
 #endif
 
@@ -14,6 +16,9 @@ void write_log(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
 int32_t s3ext_segid = -1;
 int32_t s3ext_segnum = -1;
 
+string s3ext_queryid;
+string s3ext_listingdir;
+
 string s3ext_logserverhost;
 int32_t s3ext_loglevel = EXT_WARNING;
 int32_t s3ext_logtype = INTERNAL_LOG;
@@ -28,6 +33,22 @@ S3Params InitConfig(const string& urlWithOptions) {
 #else
     s3ext_segid = GpIdentity.segindex;
     s3ext_segnum = GpIdentity.numsegments;
+
+    // Session ids and command counts start over when the cluster restarts, and are the same in
+    // clusters sharing the host. The distributed transaction identifier of the QD carries the time
+    // its cluster started, so that a listing is never taken from another cluster or statement.
+    char dtxId[64];  // TMGIDSIZE bytes are copied into it.
+    s3ext_queryid.clear();
+    if (getDistributedTransactionIdentifier(dtxId)) {
+        std::stringstream queryId;
+        queryId << gp_session_id << "_" << gp_command_count << "_" << dtxId;
+        s3ext_queryid = queryId.str();
+    }
+
+    // segments of a host usually keep their data directories in the same directory.
+    string dataDir = (DataDir != NULL) ? DataDir : "";
+    size_t slash = dataDir.find_last_of('/');
+    s3ext_listingdir = (slash != string::npos && slash > 0) ? dataDir.substr(0, slash) : "";
 #endif
 
     if (s3ext_segid == -1 && s3ext_segnum > 0) {
@@ -92,6 +113,31 @@ S3Params InitConfig(const string& urlWithOptions) {
                                        8 * 1024 * 1024, 128 * 1024 * 1024);
     params.setChunkSize(chunkSize);
 
+    int64_t minNumOfChunks =
+        s3Cfg.SafeScan("min_threadnum", configSection, numOfChunks, 1, numOfChunks);
+    params.setMinNumOfChunks(minNumOfChunks);
+
+    int64_t minChunkSize =
+        s3Cfg.SafeScan("min_chunksize", configSection, chunkSize, 1024 * 1024, chunkSize);
+    params.setMinChunkSize(minChunkSize);
+
+    int64_t splitSize =
+        s3Cfg.SafeScan("splitsize", configSection, 1024 * 1024 * 1024, 0, INT64_MAX);
+    params.setSplitSize(splitSize);
+
+    if (s3Cfg.GetBool(configSection, "sharelisting", "false") && !s3ext_queryid.empty()) {
+        params.setSharedListingDir(s3ext_listingdir);
+    }
+
+    params.setCacheDir(s3Cfg.Get(configSection, "cache_dir", ""));
+
+    int64_t cacheSize =
+        s3Cfg.SafeScan("cache_size", configSection, 10LL * 1024 * 1024 * 1024, 0, INT64_MAX);
+    params.setCacheSize(cacheSize);
+
+    int64_t connectionPoolSize = s3Cfg.SafeScan("connection_pool_size", configSection, 16, 0, 128);
+    params.setConnectionPoolSize(connectionPoolSize);
+
     int64_t lowSpeedLimit = s3Cfg.SafeScan("low_speed_limit", configSection, 10240, 0, INT_MAX);
     params.setLowSpeedLimit(lowSpeedLimit);
 
@@ -100,6 +146,13 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setVerifyCert(verifyCert);
 
+    string format = GetOptS3(urlWithOptions, "format");
+    S3_CHECK_OR_DIE(format.empty() || format == "parquet", S3ConfigError,
+                    "Unsupported format '" + format + "', only 'parquet' is supported", "format");
+    params.setFormat(format);
+
+    params.setFilter(GetOptS3(urlWithOptions, "filter"));
+
     CheckEssentialConfig(params);
 
     return params;
@@ -0,0 +1,190 @@
+#include "s3disk_cache.h"
+#include "s3utils.h"
+
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+S3DiskCache::S3DiskCache() : maxSize(0), usedSize(0), usageKnown(false) {
+    pthread_mutex_init(&this->mutex, NULL);
+}
+
+S3DiskCache::~S3DiskCache() {
+    pthread_mutex_destroy(&this->mutex);
+}
+
+S3DiskCache &S3DiskCache::getInstance() {
+    static S3DiskCache cache;
+    return cache;
+}
+
+void S3DiskCache::configure(const string &dir, uint64_t maxSize) {
+    if ((dir == this->dir) && (maxSize == this->maxSize)) {
+        return;
+    }
+
+    this->dir = dir;
+    this->maxSize = maxSize;
+    this->usageKnown = false;
+
+    if (!dir.empty() && (mkdir(dir.c_str(), 0700) < 0) && (errno != EEXIST)) {
+        S3WARN("Failed to create cache directory %s: %s, disable disk cache", dir.c_str(),
+               strerror(errno));
+        this->dir.clear();
+    }
+}
+
+string S3DiskCache::getPath(const string &key) {
+    char hash[SHA256_DIGEST_STRING_LENGTH];
+    sha256_hex(key.c_str(), key.length(), hash);
+
+    return this->dir + "/" + hash;
+}
+
+bool S3DiskCache::get(const string &key, S3VectorUInt8 &data, uint64_t len) {
+    string path = this->getPath(key);
+
+    bool hit = false;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat st;
+        if ((fstat(fd, &st) == 0) && ((uint64_t)st.st_size == len)) {
+            data.resize(len);
+
+            uint64_t offset = 0;
+            while (offset < len) {
+                ssize_t ret = pread(fd, data.data() + offset, len - offset, offset);
+                if (ret <= 0) {
+                    break;
+                }
+                offset += ret;
+            }
+
+            hit = (offset == len);
+        }
+
+        // mark it recently used.
+        if (hit) {
+            futimens(fd, NULL);
+        }
+
+        ::close(fd);
+    }
+
+    UniqueLock lock(&this->mutex);
+    if (hit) {
+        this->stats.numOfHits++;
+        this->stats.hitBytes += len;
+    } else {
+        this->stats.numOfMisses++;
+    }
+
+    return hit;
+}
+
+// Write to a temporary file and rename it, so that readers never see a partial entry.
+void S3DiskCache::put(const string &key, const S3VectorUInt8 &data, uint64_t len) {
+    if (len > this->maxSize) {
+        return;
+    }
+
+    string path = this->getPath(key);
+
+    std::stringstream tmpPath;
+    tmpPath << path << ".tmp." << getpid() << "." << pthread_self();
+
+    int fd = ::open(tmpPath.str().c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        S3DEBUG("Failed to create cache file %s: %s", tmpPath.str().c_str(), strerror(errno));
+        return;
+    }
+
+    uint64_t offset = 0;
+    while (offset < len) {
+        ssize_t ret = write(fd, data.data() + offset, len - offset);
+        if (ret <= 0) {
+            break;
+        }
+        offset += ret;
+    }
+
+    ::close(fd);
+
+    if ((offset != len) || (rename(tmpPath.str().c_str(), path.c_str()) < 0)) {
+        S3DEBUG("Failed to write cache file %s: %s", path.c_str(), strerror(errno));
+        unlink(tmpPath.str().c_str());
+        return;
+    }
+
+    UniqueLock lock(&this->mutex);
+    this->usedSize += len;
+
+    if (!this->usageKnown || (this->usedSize > this->maxSize)) {
+        this->evict();
+    }
+}
+
+// Scan the cache directory for its size, and remove least recently used files if it exceeds
+// maxSize. Segments of the host take turns to do this, a segment skips if another is evicting.
+void S3DiskCache::evict() {
+    string lockPath = this->dir + "/" + S3_DISK_CACHE_LOCK_FILE;
+    int lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFd < 0) {
+        return;
+    }
+
+    if (flock(lockFd, LOCK_EX | LOCK_NB) < 0) {
+        ::close(lockFd);
+        return;
+    }
+
+    DIR *dir = opendir(this->dir.c_str());
+    if (dir == NULL) {
+        ::close(lockFd);
+        return;
+    }
+
+    // (mtime, size, name) of cache files.
+    typedef std::tuple<time_t, uint64_t, string> CacheFile;
+    vector<CacheFile> files;
+    uint64_t totalSize = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        struct stat st;
+        string path = this->dir + "/" + entry->d_name;
+        if ((lstat(path.c_str(), &st) == 0) && S_ISREG(st.st_mode)) {
+            files.emplace_back(st.st_mtime, st.st_size, path);
+            totalSize += st.st_size;
+        }
+    }
+
+    closedir(dir);
+
+    if (totalSize > this->maxSize) {
+        uint64_t targetSize =
+            this->maxSize - this->maxSize / 100 * (100 - S3_DISK_CACHE_LOW_WATERMARK);
+
+        std::sort(files.begin(), files.end());
+        for (uint64_t i = 0; (i < files.size()) && (totalSize > targetSize); i++) {
+            if (unlink(std::get<2>(files[i]).c_str()) == 0) {
+                totalSize -= std::get<1>(files[i]);
+                this->stats.numOfEvictions++;
+            }
+        }
+    }
+
+    this->usedSize = totalSize;
+    this->usageKnown = true;
+
+    ::close(lockFd);
+}
+
+S3DiskCacheStats S3DiskCache::getStats() {
+    UniqueLock lock(&this->mutex);
+    return this->stats;
+}
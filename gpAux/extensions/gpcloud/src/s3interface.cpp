@@ -177,6 +177,7 @@ bool S3InterfaceService::parseBucketXML(ListBucketResult *result, xmlParserCtxtP
     char *content = NULL;
     char *key = NULL;
     char *key_size = NULL;
+    char *etag = NULL;
 
     cur = rootElement->xmlChildrenNode;
     while (cur != NULL) {
@@ -227,12 +228,15 @@ bool S3InterfaceService::parseBucketXML(ListBucketResult *result, xmlParserCtxtP
                     // Size of S3 file is a natural number, don't worry
                     size = (uint64_t)atoll((const char *)key_size);
                 }
+                if (!xmlStrcmp(contNode->name, (const xmlChar *)"ETag")) {
+                    etag = (char *)xmlNodeGetContent(contNode);
+                }
                 contNode = contNode->next;
             }
 
             if (key) {
                 if (size > 0) {  // skip empty item
-                    result->contents.emplace_back(key, size);
+                    result->contents.emplace_back(key, size, etag ? etag : "");
                 } else {
                     S3INFO("Size of \"%s\" is %" PRIu64 ", skip it", key, size);
                 }
@@ -242,6 +246,11 @@ bool S3InterfaceService::parseBucketXML(ListBucketResult *result, xmlParserCtxtP
                 xmlFree(key_size);
                 key_size = NULL;
             }
+
+            if (etag) {
+                xmlFree(etag);
+                etag = NULL;
+            }
         }
 
         cur = cur->next;
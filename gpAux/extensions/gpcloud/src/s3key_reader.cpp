@@ -7,6 +7,7 @@ Range OffsetMgr::getNextOffset() {
 
     pthread_mutex_lock(&this->offsetLock);
     ret.offset = std::min(this->curPos, this->keySize);
+    ret.index = this->numOfRanges++;
 
     if (this->curPos + this->chunkSize > this->keySize) {
         ret.length = this->keySize - this->curPos;
@@ -20,12 +21,115 @@ Range OffsetMgr::getNextOffset() {
     return ret;
 }
 
+static uint64_t GetMonotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+DownloadTuner::DownloadTuner() {
+    this->reset(0, 0, 0, 0, 0);
+}
+
+void DownloadTuner::reset(uint64_t minChunkSize, uint64_t maxChunkSize, uint64_t minNumOfThreads,
+                          uint64_t maxNumOfThreads, uint64_t rangeLen) {
+    this->minChunkSize = std::min(minChunkSize, maxChunkSize);
+    this->maxChunkSize = maxChunkSize;
+    this->minNumOfThreads = std::min(minNumOfThreads, maxNumOfThreads);
+    this->maxNumOfThreads = maxNumOfThreads;
+
+    this->numOfThreads = maxNumOfThreads;
+    this->direction = -1;
+
+    uint64_t chunkSize = maxNumOfThreads ? (rangeLen + maxNumOfThreads - 1) / maxNumOfThreads : 0;
+    this->chunkSize = std::max(std::min(chunkSize, this->maxChunkSize), this->minChunkSize);
+
+    this->numOfSamples = 0;
+    this->roundBytes = 0;
+    this->roundLatencyUs = 0;
+    this->roundStartUs = 0;
+    this->roundEndUs = 0;
+
+    this->lastThroughput = 0;
+    this->lastLatencyMs = 0;
+}
+
+bool DownloadTuner::addSample(uint64_t len, uint64_t startUs, uint64_t endUs) {
+    if (!this->isEnabled()) {
+        return false;
+    }
+
+    if ((this->numOfSamples == 0) || (startUs < this->roundStartUs)) {
+        this->roundStartUs = startUs;
+    }
+    this->roundEndUs = std::max(this->roundEndUs, endUs);
+
+    this->numOfSamples++;
+    this->roundBytes += len;
+    this->roundLatencyUs += endUs - startUs;
+
+    if (this->numOfSamples < this->numOfThreads * S3_TUNE_SAMPLES_PER_THREAD) {
+        return false;
+    }
+
+    // Threads download at the same time, so throughput is of the whole round.
+    uint64_t elapsedUs = std::max(this->roundEndUs - this->roundStartUs, (uint64_t)1);
+    uint64_t throughput = (uint64_t)((double)this->roundBytes * 1000000 / elapsedUs);
+    uint64_t latencyMs = this->roundLatencyUs / this->numOfSamples / 1000;
+
+    uint64_t oldChunkSize = this->chunkSize;
+    uint64_t oldNumOfThreads = this->numOfThreads;
+    this->tune(throughput, latencyMs);
+
+    this->numOfSamples = 0;
+    this->roundBytes = 0;
+    this->roundLatencyUs = 0;
+    this->roundEndUs = 0;
+
+    return (this->chunkSize != oldChunkSize) || (this->numOfThreads != oldNumOfThreads);
+}
+
+void DownloadTuner::tune(uint64_t throughput, uint64_t latencyMs) {
+    this->lastLatencyMs = latencyMs;
+
+    // Chunk size first, throughput of rounds with different chunk sizes is not comparable.
+    if ((latencyMs < S3_TUNE_MIN_CHUNK_LATENCY_MS) && (this->chunkSize < this->maxChunkSize)) {
+        this->chunkSize = std::min(this->chunkSize * 2, this->maxChunkSize);
+        this->lastThroughput = 0;
+        return;
+    }
+
+    if ((latencyMs > S3_TUNE_MAX_CHUNK_LATENCY_MS) && (this->chunkSize > this->minChunkSize)) {
+        this->chunkSize = std::max(this->chunkSize / 2, this->minChunkSize);
+        this->lastThroughput = 0;
+        return;
+    }
+
+    // Keep going if throughput improves, go back if it drops, and try fewer threads if it doesn't
+    // change.
+    uint64_t last = this->lastThroughput;
+    if ((last > 0) && (throughput < last / 100 * (100 - S3_TUNE_THROUGHPUT_TOLERANCE))) {
+        this->direction = -this->direction;
+    } else if ((last > 0) && (throughput <= last / 100 * (100 + S3_TUNE_THROUGHPUT_TOLERANCE))) {
+        this->direction = -1;
+    }
+
+    this->lastThroughput = throughput;
+
+    if ((this->direction > 0) && (this->numOfThreads < this->maxNumOfThreads)) {
+        this->numOfThreads++;
+    } else if ((this->direction < 0) && (this->numOfThreads > this->minNumOfThreads)) {
+        this->numOfThreads--;
+    }
+}
+
 ChunkBuffer::ChunkBuffer(const S3Url& s3Url, S3KeyReader& reader, const S3MemoryContext& context)
     : s3Url(s3Url), chunkData(context), offsetMgr(reader.getOffsetMgr()), sharedKeyReader(reader) {
     s3Interface = NULL;
     Range range = offsetMgr.getNextOffset();
     curFileOffset = range.offset;
     chunkDataSize = range.length;
+    chunkIndex = range.index;
     status = ReadyToFill;
     eof = false;
     curChunkOffset = 0;
@@ -45,6 +149,7 @@ ChunkBuffer& ChunkBuffer::operator=(const ChunkBuffer& other) {
     this->curFileOffset = other.curFileOffset;
     this->curChunkOffset = other.curChunkOffset;
     this->chunkDataSize = other.chunkDataSize;
+    this->chunkIndex = other.chunkIndex;
 
     return *this;
 }
@@ -78,23 +183,62 @@ uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
     if (len <= leftLen) {                   // [1]
         this->curChunkOffset += lenToRead;  // not empty
     } else {                                // empty, reset everything
-        this->curChunkOffset = 0;
+        this->recycle();
+    }
 
-        if (!this->isEOF()) {
-            // Release chunkData memory to reduce consumption.
-            this->chunkData.release();
+    return lenToRead;
+}
 
-            this->status = ReadyToFill;
+// Lend up to len bytes of chunkData, which is not refilled until giveBack() returns all of it.
+uint64_t ChunkBuffer::lend(const char** buf, uint64_t len) {
+    S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
 
-            Range range = this->offsetMgr.getNextOffset();
-            this->curFileOffset = range.offset;
-            this->chunkDataSize = range.length;
+    UniqueLock statusLock(&this->statusMutex);
+    while (this->status != ReadyToRead) {
+        pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
+    }
 
-            pthread_cond_signal(&this->statusCondVar);
-        }
+    if (this->isError()) {
+        return 0;
     }
 
-    return lenToRead;
+    uint64_t lenToLend = std::min(len, this->chunkDataSize - this->curChunkOffset);
+
+    *buf = reinterpret_cast<const char*>(this->chunkData.data() + this->curChunkOffset);
+    this->curChunkOffset += lenToLend;
+
+    return lenToLend;
+}
+
+// Return true if all data of the chunk is lent and returned, and the buffer is refilled with next
+// chunk.
+bool ChunkBuffer::giveBack() {
+    UniqueLock statusLock(&this->statusMutex);
+    if (this->curChunkOffset < this->chunkDataSize) {
+        return false;
+    }
+
+    this->recycle();
+    return true;
+}
+
+// Called with statusMutex held when all data of the chunk is consumed.
+void ChunkBuffer::recycle() {
+    this->curChunkOffset = 0;
+
+    if (!this->isEOF()) {
+        // Release chunkData memory to reduce consumption.
+        this->chunkData.release();
+
+        this->status = ReadyToFill;
+
+        Range range = this->offsetMgr.getNextOffset();
+        this->curFileOffset = range.offset;
+        this->chunkDataSize = range.length;
+        this->chunkIndex = range.index;
+
+        pthread_cond_signal(&this->statusCondVar);
+    }
 }
 
 // returning uint64_t(-1) means error
@@ -105,7 +249,8 @@ uint64_t ChunkBuffer::fill() {
         pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
     }
 
-    if (S3QueryIsAbortInProgress() || this->isError()) {
+    if (S3QueryIsAbortInProgress() || this->isError() ||
+        !this->sharedKeyReader.waitForDownload(this->chunkIndex)) {
         this->setSharedError(true);
         this->status = ReadyToRead;
         pthread_cond_signal(&this->statusCondVar);
@@ -118,13 +263,36 @@ uint64_t ChunkBuffer::fill() {
     uint64_t readLen = 0;
 
     if (leftLen != 0) {
+        S3DiskCache& diskCache = S3DiskCache::getInstance();
+
+        string cacheKey = this->sharedKeyReader.getCacheKey();
+        if (!cacheKey.empty()) {
+            std::stringstream chunkKey;
+            chunkKey << cacheKey << "\n" << offset << "\n" << leftLen;
+            cacheKey = chunkKey.str();
+        }
+
         try {
-            readLen = this->s3Interface->fetchData(offset, this->chunkData, leftLen, this->s3Url);
-            if (readLen != leftLen) {
-                S3DEBUG("Failed to fetch expected data from S3");
-                this->setSharedError(true, S3PartialResponseError(leftLen, readLen));
+            if (!cacheKey.empty() && diskCache.get(cacheKey, this->chunkData, leftLen)) {
+                readLen = leftLen;
+                S3DEBUG("Got %" PRIu64 " bytes from disk cache", readLen);
             } else {
-                S3DEBUG("Got %" PRIu64 " bytes from S3", readLen);
+                uint64_t startUs = GetMonotonicMicros();
+                readLen =
+                    this->s3Interface->fetchData(offset, this->chunkData, leftLen, this->s3Url);
+                if (readLen != leftLen) {
+                    S3DEBUG("Failed to fetch expected data from S3");
+                    this->setSharedError(true, S3PartialResponseError(leftLen, readLen));
+                } else {
+                    S3DEBUG("Got %" PRIu64 " bytes from S3", readLen);
+
+                    this->sharedKeyReader.addDownloadSample(readLen, startUs,
+                                                            GetMonotonicMicros());
+
+                    if (!cacheKey.empty()) {
+                        diskCache.put(cacheKey, this->chunkData, readLen);
+                    }
+                }
             }
         } catch (S3Exception& e) {
             S3DEBUG("Failed to fetch expected data from S3");
@@ -189,12 +357,56 @@ void S3KeyReader::open(const S3Params& params) {
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
 
-    this->offsetMgr.setKeySize(params.getKeySize());
-    this->offsetMgr.setChunkSize(params.getChunkSize());
+    this->s3Url = params.getS3Url();
+    this->keySize = params.getKeySize();
+    this->rangeEnd = params.getRangeEnd() == 0 ? this->keySize
+                                               : std::min(params.getRangeEnd(), this->keySize);
+
+    S3_CHECK_OR_DIE(params.getRangeStart() <= this->rangeEnd, S3RuntimeError,
+                    "range start must not be greater than range end");
+
+    // A range owns the lines starting in it, so download from one byte ahead of the range to see
+    // whether a line starts at rangeStart, and skip the partial line before it.
+    this->rangeOffset = params.getRangeStart() > 0 ? params.getRangeStart() - 1 : 0;
+    this->skippingHeadLine = params.getRangeStart() > 0;
+    this->tailPos = this->rangeEnd;
 
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
                     "chunk size must be greater than zero");
 
+    // Chunk size and number of threads are tuned within [min, configured], which is what memory
+    // is preallocated for. Zero min disables tuning.
+    uint64_t minChunkSize =
+        params.getMinChunkSize() ? params.getMinChunkSize() : params.getChunkSize();
+    uint64_t minNumOfThreads =
+        params.getMinNumOfChunks() ? params.getMinNumOfChunks() : this->numOfChunks;
+    this->tuner.reset(minChunkSize, params.getChunkSize(), minNumOfThreads, this->numOfChunks,
+                      this->rangeEnd - this->rangeOffset);
+
+    if (this->tuner.isEnabled()) {
+        S3INFO("Download %s with %" PRIu64 " threads and chunk size %" PRIu64
+               ", tuned within [%" PRIu64 ", %" PRIu64 "] threads and [%" PRIu64 ", %" PRIu64
+               "] bytes",
+               this->s3Url.getFullUrlForCurl().c_str(), this->tuner.getNumOfThreads(),
+               this->tuner.getChunkSize(), minNumOfThreads, this->numOfChunks, minChunkSize,
+               params.getChunkSize());
+    }
+
+    // OffsetMgr hands out the chunks of [rangeOffset, rangeEnd).
+    this->offsetMgr.setKeySize(this->rangeEnd);
+    this->offsetMgr.setCurPos(this->rangeOffset);
+    this->offsetMgr.setChunkSize(this->tuner.getChunkSize());
+
+    // Only cache keys with known ETag, which changes whenever content of the key changes.
+    this->cacheKey.clear();
+    if (!params.getCacheDir().empty() && !params.getKeyETag().empty()) {
+        S3DiskCache::getInstance().configure(params.getCacheDir(), params.getCacheSize());
+
+        if (S3DiskCache::getInstance().isEnabled()) {
+            this->cacheKey = params.getS3Url().getFullUrlForCurl() + "\n" + params.getKeyETag();
+        }
+    }
+
     this->chunkBuffers.reserve(this->numOfChunks);
 
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
@@ -210,23 +422,116 @@ void S3KeyReader::open(const S3Params& params) {
     }
 }
 
-uint64_t S3KeyReader::read(char* buf, uint64_t count) {
-    uint64_t fileLen = this->offsetMgr.getKeySize();
-    uint64_t readLen = 0;
+// The reader reads chunks in order, so threads download the chunks right after the one it is
+// reading, no more than the number of threads chosen by tuner.
+bool S3KeyReader::waitForDownload(uint64_t chunkIndex) {
+    if (!this->tuner.isEnabled()) {
+        return true;
+    }
 
-    do {
-        // confirm there is no more available data, done with this file
-        if (this->transferredKeyLen >= fileLen) {
-            if (!this->hasEol && !this->eolAppended) {
-                uint64_t eolLen = strlen(eolString);
-                strncpy(buf, eolString, eolLen);
+    UniqueLock lock(&this->tuneMutex);
+    while (!this->sharedError &&
+           (chunkIndex >= this->curReadingChunk + this->tuner.getNumOfThreads())) {
+        pthread_cond_wait(&this->tuneCond, &this->tuneMutex);
+    }
 
-                this->eolAppended = true;
+    return !this->sharedError;
+}
 
-                return eolLen;
-            }
+void S3KeyReader::addDownloadSample(uint64_t len, uint64_t startUs, uint64_t endUs) {
+    if (!this->tuner.isEnabled()) {
+        return;
+    }
+
+    UniqueLock lock(&this->tuneMutex);
+    if (!this->tuner.addSample(len, startUs, endUs)) {
+        return;
+    }
+
+    this->offsetMgr.setChunkSize(this->tuner.getChunkSize());
+    pthread_cond_broadcast(&this->tuneCond);
+
+    S3INFO("Download %s with %" PRIu64 " threads and chunk size %" PRIu64
+           ", last round: %" PRIu64 " bytes/s, %" PRIu64 " ms per chunk",
+           this->s3Url.getFullUrlForCurl().c_str(), this->tuner.getNumOfThreads(),
+           this->tuner.getChunkSize(), this->tuner.getThroughput(), this->tuner.getLatencyMs());
+}
+
+// Lines end with the last char of eolString, "\n" of "\r\n" for instance.
+static inline char lineTerminator() {
+    return eolString[strlen(eolString) - 1];
+}
+
+// Drop the partial line at the beginning of a range, return size of data left in buf.
+uint64_t S3KeyReader::skipHeadLine(char* buf, uint64_t len) {
+    char* eol = static_cast<char*>(memchr(buf, lineTerminator(), len));
+    if (eol == NULL) {
+        return 0;
+    }
+
+    this->skippingHeadLine = false;
+
+    uint64_t remain = buf + len - (eol + 1);
+    memmove(buf, eol + 1, remain);
+    return remain;
+}
+
+// Called when [rangeOffset, rangeEnd) is consumed, return the rest of the line crossing rangeEnd,
+// which belongs to this range, or the eol appended to a key without trailing eol.
+uint64_t S3KeyReader::readRangeTail(char* buf, uint64_t count) {
+    // No line starts in this range, the previous range reads the one across it.
+    if (this->skippingHeadLine) {
+        return 0;
+    }
+
+    if (this->lastChar != lineTerminator() &&
+        (this->tailDataOffset < this->tailData.size() || this->tailPos < this->keySize)) {
+        if (this->tailDataOffset == this->tailData.size()) {
+            uint64_t len =
+                std::min(this->keySize - this->tailPos, (uint64_t)S3_RANGE_TAIL_FETCH_SIZE);
+
+            this->tailData.release();
+            this->tailDataOffset = 0;
+            this->s3Interface->fetchData(this->tailPos, this->tailData, len, this->s3Url);
+            this->tailPos += len;
+        }
+
+        uint64_t lenToRead = std::min(count, this->tailData.size() - this->tailDataOffset);
+        char* data = reinterpret_cast<char*>(this->tailData.data() + this->tailDataOffset);
+
+        char* eol = static_cast<char*>(memchr(data, lineTerminator(), lenToRead));
+        if (eol != NULL) {
+            lenToRead = eol - data + 1;
+        }
+
+        memcpy(buf, data, lenToRead);
+        this->tailDataOffset += lenToRead;
+        this->lastChar = buf[lenToRead - 1];
+
+        return lenToRead;
+    }
+
+    // confirm there is no more available data, done with this file
+    if (this->tailPos >= this->keySize && this->lastChar != '\r' && this->lastChar != '\n' &&
+        !this->eolAppended) {
+        uint64_t eolLen = strlen(eolString);
+        strncpy(buf, eolString, eolLen);
+
+        this->eolAppended = true;
+
+        return eolLen;
+    }
 
-            return 0;
+    return 0;
+}
+
+uint64_t S3KeyReader::read(char* buf, uint64_t count) {
+    uint64_t rangeLen = this->rangeEnd - this->rangeOffset;
+    uint64_t readLen = 0;
+
+    do {
+        if (this->transferredKeyLen >= rangeLen) {
+            return this->readRangeTail(buf, count);
         }
 
         ChunkBuffer& buffer = chunkBuffers[this->curReadingChunk % this->numOfChunks];
@@ -242,43 +547,104 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
         }
 
         this->transferredKeyLen += readLen;
-        if (this->transferredKeyLen == fileLen) {
-            if (buf[readLen - 1] == '\r' || buf[readLen - 1] == '\n') {
-                this->hasEol = true;
-            }
-        }
 
         if (readLen < count) {
+            UniqueLock lock(&this->tuneMutex);
             this->curReadingChunk++;
+            pthread_cond_broadcast(&this->tuneCond);
         }
 
-        count -= readLen;
+        if (readLen != 0) {
+            this->lastChar = buf[readLen - 1];
+
+            if (this->skippingHeadLine) {
+                readLen = this->skipHeadLine(buf, readLen);
+            }
+        }
     } while (readLen == 0);  // retry to confirm whether thread reading is finished or chunk size is
                              // divisible by get()'s buffer size
 
     return readLen;
 }
 
+// Lend data of chunks to caller. Partial lines at both ends of a range are cut or completed by
+// read(), which copies.
+uint64_t S3KeyReader::lend(const char** buf, uint64_t count) {
+    if (this->skippingHeadLine || (this->transferredKeyLen >= this->rangeEnd - this->rangeOffset)) {
+        return Reader::lend(buf, count);
+    }
+
+    ChunkBuffer& buffer = chunkBuffers[this->curReadingChunk % this->numOfChunks];
+
+    uint64_t len = buffer.lend(buf, count);
+
+    if (this->isSharedError()) {
+        if (this->sharedException != NULL) {
+            std::rethrow_exception(this->sharedException);
+        } else {
+            throw S3RuntimeError("Unexpected runtime error, sharedException is NULL");
+        }
+    }
+
+    this->transferredKeyLen += len;
+    this->lentBuffer = &buffer;
+
+    if (len != 0) {
+        this->lastChar = (*buf)[len - 1];
+    }
+
+    return len;
+}
+
+void S3KeyReader::giveBack() {
+    if (this->lentBuffer == NULL) {
+        return;
+    }
+
+    if (this->lentBuffer->giveBack()) {
+        UniqueLock lock(&this->tuneMutex);
+        this->curReadingChunk++;
+        pthread_cond_broadcast(&this->tuneCond);
+    }
+
+    this->lentBuffer = NULL;
+}
+
 // reset marks before reading next key
 void S3KeyReader::reset() {
     this->sharedError = false;
     this->curReadingChunk = 0;
     this->transferredKeyLen = 0;
+    this->lentBuffer = NULL;
 
     this->offsetMgr.reset();
 
     this->chunkBuffers.clear();
     this->threads.clear();
 
-    this->hasEol = false;
+    this->keySize = 0;
+    this->rangeOffset = 0;
+    this->rangeEnd = 0;
+    this->tailPos = 0;
+    this->tailData.release();
+    this->tailDataOffset = 0;
+    this->skippingHeadLine = false;
+
+    this->lastChar = '\0';
     this->eolAppended = false;
+
+    this->cacheKey.clear();
 }
 
 void S3KeyReader::close() {
     // to interupt downlading thread, we must: (check ChunkBuffer::fill())
     // 1. set condition to ReadyToFill and signal conditional_variable.
     // 2. set the shared error status to prevent download thread from continuing.
-    this->sharedError = true;
+    {
+        UniqueLock lock(&this->tuneMutex);
+        this->sharedError = true;
+        pthread_cond_broadcast(&this->tuneCond);
+    }
 
     for (uint64_t i = 0; i < this->chunkBuffers.size(); i++) {
         UniqueLock lock(this->chunkBuffers[i].getStatMutex());
@@ -296,5 +662,18 @@ void S3KeyReader::close() {
         this->threads[i] = 0;
     }
 
+    if (this->tuner.isEnabled() && !this->threads.empty()) {
+        S3INFO("Downloaded %s with %" PRIu64 " threads and chunk size %" PRIu64 " at last",
+               this->s3Url.getFullUrlForCurl().c_str(), this->tuner.getNumOfThreads(),
+               this->tuner.getChunkSize());
+    }
+
+    if (!this->cacheKey.empty()) {
+        S3DiskCacheStats stats = S3DiskCache::getInstance().getStats();
+        S3INFO("Disk cache: %" PRIu64 " hits (%" PRIu64 " bytes), %" PRIu64 " misses, %" PRIu64
+               " evictions",
+               stats.numOfHits, stats.hitBytes, stats.numOfMisses, stats.numOfEvictions);
+    }
+
     this->reset();
 }
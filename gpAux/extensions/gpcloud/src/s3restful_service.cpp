@@ -19,9 +19,17 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
     this->debugCurl = params.isDebugCurl();
     this->chunkBufferSize = params.getChunkSize();
     this->verifyCert = params.isVerifyCert();
+
+    CURLHandlePool::getInstance().setMaxSize(params.getConnectionPoolSize());
 }
 
 S3RESTfulService::~S3RESTfulService() {
+    CURLConnectionStats stats = CURLHandlePool::getInstance().getStats();
+    S3INFO("curl requests: %" PRIu64 ", new connections: %" PRIu64 ", reused connections: %" PRIu64
+           ", connect time: %.3fs",
+           stats.numOfRequests, stats.numOfNewConnections, stats.numOfReusedConnections,
+           stats.connectTime);
+
     // This function is not thread safe, must NOT call it when any other
     // threads are running, that is, do NOT put it in threads.
     curl_global_cleanup();
@@ -82,12 +90,86 @@ size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmemb, void
     return copiedItemNum;
 }
 
+CURLHandlePool &CURLHandlePool::getInstance() {
+    static CURLHandlePool pool;
+    return pool;
+}
+
+CURL *CURLHandlePool::acquire() {
+    {
+        UniqueLock lock(&this->mutex);
+        if (!this->idleHandles.empty()) {
+            CURL *curl = this->idleHandles.back();
+            this->idleHandles.pop_back();
+            return curl;
+        }
+    }
+
+    return curl_easy_init();
+}
+
+// curl_easy_reset() clears options but keeps live connections, and DNS and TLS session caches.
+void CURLHandlePool::release(CURL *curl) {
+    {
+        UniqueLock lock(&this->mutex);
+        if (this->idleHandles.size() < this->maxSize) {
+            curl_easy_reset(curl);
+            this->idleHandles.push_back(curl);
+            return;
+        }
+    }
+
+    curl_easy_cleanup(curl);
+}
+
+void CURLHandlePool::recordRequest(CURL *curl) {
+    long numOfConnects = 0;
+    double connectTime = 0;
+    double appConnectTime = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &numOfConnects);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connectTime);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &appConnectTime);
+
+    UniqueLock lock(&this->mutex);
+    this->stats.numOfRequests++;
+    if (numOfConnects > 0) {
+        this->stats.numOfNewConnections += numOfConnects;
+        // APPCONNECT_TIME includes TLS handshake, it is 0 for plain HTTP.
+        this->stats.connectTime += std::max(connectTime, appConnectTime);
+    } else {
+        this->stats.numOfReusedConnections++;
+    }
+}
+
+void CURLHandlePool::setMaxSize(uint64_t maxSize) {
+    UniqueLock lock(&this->mutex);
+    this->maxSize = maxSize;
+
+    while (this->idleHandles.size() > this->maxSize) {
+        curl_easy_cleanup(this->idleHandles.back());
+        this->idleHandles.pop_back();
+    }
+}
+
+uint64_t CURLHandlePool::getNumOfIdleHandles() {
+    UniqueLock lock(&this->mutex);
+    return this->idleHandles.size();
+}
+
+CURLConnectionStats CURLHandlePool::getStats() {
+    UniqueLock lock(&this->mutex);
+    return this->stats;
+}
+
 struct CURLWrapper {
     CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
                 uint64_t lowSpeedTime, bool debugCurl) {
-        curl = curl_easy_init();
+        CURLHandlePool &pool = CURLHandlePool::getInstance();
+
+        curl = pool.acquire();
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, pool.getMaxSize() == 0 ? 1L : 0L);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
@@ -98,13 +180,15 @@ struct CURLWrapper {
         }
     }
     ~CURLWrapper() {
-        curl_easy_cleanup(curl);
+        CURLHandlePool::getInstance().release(curl);
     }
     CURL *curl;
 };
 
 void S3RESTfulService::performCurl(CURL *curl, Response &response) {
     CURLcode res = curl_easy_perform(curl);
+    CURLHandlePool::getInstance().recordRequest(curl);
+
     if (res != CURLE_OK) {
         if (res == CURLE_COULDNT_RESOLVE_HOST) {
             S3_DIE(S3ResolveError, curl_easy_strerror(res));
@@ -1,6 +1,7 @@
 #include "compress_writer.cpp"
 #include <memory>
 #include <random>
+#include "decompress_reader.h"
 #include "gtest/gtest.h"
 
 class MockWriter : public Writer {
@@ -76,7 +77,10 @@ class CompressWriterTest : public testing::Test {
         zstream.next_out = output;
         zstream.avail_out = out_len;
 
-        ret = inflate(&zstream, Z_FULL_FLUSH);
+        // output is a stream of concatenated gzip members.
+        do {
+            ret = inflate(&zstream, Z_FULL_FLUSH);
+        } while (ret == Z_STREAM_END && zstream.avail_in > 0 && inflateReset(&zstream) == Z_OK);
 
         if (ret != Z_STREAM_END) {
             S3DEBUG("Failed to uncompress sample data");
@@ -210,3 +214,67 @@ TEST_F(CompressWriterTest, CompressCompressedData) {
 
     EXPECT_TRUE(memcmp(compressedData.data(), result.get(), compressedData.size()) == 0);
 }
+
+TEST_F(CompressWriterTest, CompressBlocksToMembersWithSize) {
+    const char pangram[] = "The quick brown fox jumps over the lazy dog";
+    uint64_t times = S3_ZIP_COMPRESS_CHUNKSIZE * 3 / (sizeof(pangram) - 1);
+
+    string input;
+    for (uint64_t i = 0; i < times; i++) input.append(pangram);
+
+    compressWriter.write(input.c_str(), input.length());
+    compressWriter.close();
+
+    EXPECT_EQ((uint64_t)3, compressWriter.getNumOfMembers());
+
+    // every member records its size, members follow one another till the end.
+    const char *data = writer.getRawData();
+    uint64_t offset = 0;
+    for (int i = 0; i < 3; i++) {
+        uint64_t memberSize = GetGzipMemberSize(data + offset, writer.getDataSize() - offset);
+        ASSERT_NE((uint64_t)0, memberSize);
+        offset += memberSize;
+    }
+    EXPECT_EQ(writer.getDataSize(), offset);
+
+    Byte *result = new Byte[input.length() + 1];
+    this->coreUncompress((Byte *)writer.getRawData(), writer.getDataSize(), result,
+                         input.length() + 1);
+
+    EXPECT_TRUE(memcmp(input.c_str(), result, input.length()) == 0);
+
+    delete[] result;
+}
+
+TEST_F(CompressWriterTest, CompressInParallel) {
+    // reopen with more workers.
+    compressWriter.close();
+    writer.getRawDataVector().clear();
+
+    S3Params params("s3://abc/def/");
+    params.setNumOfChunks(4);
+    compressWriter.open(params);
+
+    std::default_random_engine re(42);
+    string input;
+    for (uint64_t i = 0; i < S3_ZIP_COMPRESS_CHUNKSIZE * 10; i++) {
+        input.push_back('a' + re() % 4);
+    }
+
+    // write in odd-sized pieces, crossing block boundaries.
+    for (uint64_t offset = 0; offset < input.length(); offset += 12345) {
+        compressWriter.write(input.c_str() + offset,
+                             std::min((uint64_t)12345, input.length() - offset));
+    }
+    compressWriter.close();
+
+    EXPECT_EQ((uint64_t)10, compressWriter.getNumOfMembers());
+
+    Byte *result = new Byte[input.length() + 1];
+    this->coreUncompress((Byte *)writer.getRawData(), writer.getDataSize(), result,
+                         input.length() + 1);
+
+    EXPECT_TRUE(memcmp(input.c_str(), result, input.length()) == 0);
+
+    delete[] result;
+}
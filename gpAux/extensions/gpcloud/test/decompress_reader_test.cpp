@@ -6,6 +6,8 @@ class MockBufferReader : public Reader {
     MockBufferReader() {
         this->offset = 0;
         this->chunkSize = 0;
+        this->numOfLends = 0;
+        this->numOfGiveBacks = 0;
     }
 
     void open(const S3Params &params) {
@@ -21,6 +23,8 @@ class MockBufferReader : public Reader {
     }
 
     uint64_t read(char *buf, uint64_t count) {
+        EXPECT_EQ(this->numOfLends, this->numOfGiveBacks);
+
         uint64_t remaining = this->data.size() - offset;
         if (remaining <= 0) {
             return 0;
@@ -36,6 +40,29 @@ class MockBufferReader : public Reader {
         return size;
     }
 
+    uint64_t lend(const char **buf, uint64_t count) {
+        EXPECT_EQ(this->numOfLends, this->numOfGiveBacks);
+
+        uint64_t size = std::min(std::min(this->data.size() - offset, count), this->chunkSize);
+        *buf = reinterpret_cast<const char *>(this->data.data() + offset);
+
+        this->offset += size;
+        this->numOfLends++;
+        return size;
+    }
+
+    void giveBack() {
+        this->numOfGiveBacks++;
+    }
+
+    uint64_t getNumOfLends() const {
+        return numOfLends;
+    }
+
+    uint64_t getNumOfGiveBacks() const {
+        return numOfGiveBacks;
+    }
+
     void clear() {
         this->data.clear();
         this->offset = 0;
@@ -49,6 +76,8 @@ class MockBufferReader : public Reader {
     std::vector<uint8_t> data;
     uint64_t offset;
     uint64_t chunkSize;
+    uint64_t numOfLends;
+    uint64_t numOfGiveBacks;
 };
 
 class DecompressReaderTest : public testing::Test {
@@ -311,3 +340,159 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+// Compress data to a gzip member, with BGZF "BC" extra subfield recording member size if bgzf.
+static string compressToGzipMember(const string &data, bool bgzf) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+    string deflated(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = (Bytef *)data.data();
+    stream.avail_in = data.size();
+    stream.next_out = (Bytef *)&deflated[0];
+    stream.avail_out = deflated.size();
+    deflate(&stream, Z_FINISH);
+    deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    string member("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    if (bgzf) {
+        uint64_t bsize = 18 + deflated.size() + 8 - 1;
+        member[3] = 0x04;  // FEXTRA
+        member += string("\x06\x00" "BC\x02\x00", 6);
+        member += (char)(bsize & 0xff);
+        member += (char)(bsize >> 8);
+    }
+    member += deflated;
+
+    uint32_t trailer[2] = {(uint32_t)crc32(0, (const Bytef *)data.data(), data.size()),
+                           (uint32_t)data.size()};
+    member.append((const char *)trailer, sizeof(trailer));  // little endian
+    return member;
+}
+
+static string readAll(DecompressReader &reader) {
+    string result;
+    char buf[1000];
+    uint64_t count;
+    while ((count = reader.read(buf, sizeof(buf))) != 0) {
+        result.append(buf, count);
+    }
+    return result;
+}
+
+TEST(DecompressReader, GetGzipMemberSize) {
+    string bgzf = compressToGzipMember("hello", true);
+    EXPECT_EQ(bgzf.size(), GetGzipMemberSize(bgzf.data(), bgzf.size()));
+
+    // header is not complete.
+    EXPECT_EQ((uint64_t)0, GetGzipMemberSize(bgzf.data(), 16));
+
+    string gzip = compressToGzipMember("hello", false);
+    EXPECT_EQ((uint64_t)0, GetGzipMemberSize(gzip.data(), gzip.size()));
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressMultipleGzipMembers) {
+    string data = compressToGzipMember("The quick brown fox ", false) +
+                  compressToGzipMember("jumps over the lazy dog", false);
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ("The quick brown fox jumps over the lazy dog", readAll(decompressReader));
+    EXPECT_EQ((uint64_t)0, decompressReader.getNumOfParallelMembers());
+}
+
+TEST_F(DecompressReaderTest, AbleToIgnoreTrailingDataAfterGzipMember) {
+    string data = compressToGzipMember("The quick brown fox", false) + "\n";
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ("The quick brown fox", readAll(decompressReader));
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressBGZFMembersInParallel) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(4);
+
+    decompressReader.close();
+    decompressReader.open(params);
+
+    // small chunk size to make batches of a few members.
+    S3_ZIP_DECOMPRESS_CHUNKSIZE = 1024;
+    decompressReader.resizeDecompressReaderBuffer(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    string expected, data;
+    for (int i = 0; i < 100; i++) {
+        string line = std::to_string(i) + string(i * 3, 'a' + i % 26) + "\n";
+        expected += line;
+        data += compressToGzipMember(line, true);
+    }
+
+    // sequential member in the middle keeps its order.
+    expected += "not indexed\n";
+    data += compressToGzipMember("not indexed\n", false);
+
+    for (int i = 0; i < 50; i++) {
+        expected += "tail\n";
+        data += compressToGzipMember("tail\n", true);
+    }
+
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ(expected, readAll(decompressReader));
+    EXPECT_EQ((uint64_t)150, decompressReader.getNumOfParallelMembers());
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressBGZFMemberWithIncorrectEncodedStream) {
+    string data = compressToGzipMember("The quick brown fox jumps over the lazy dog", true);
+    data[20] ^= 0xff;
+    bufReader.setData(data.data(), data.size());
+
+    char outputBuffer[128] = {0};
+    EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
+}
+
+TEST_F(DecompressReaderTest, AbleToInflateLentDataAcrossPieces) {
+    string expected, data;
+    for (int i = 0; i < 20; i++) {
+        string line = std::to_string(i) + string(i * 7, 'a' + i % 26) + "\n";
+        expected += line;
+        data += compressToGzipMember(line, i % 2 == 0);
+    }
+
+    // gzip headers and members are split between lent pieces.
+    bufReader.setChunkSize(13);
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ(expected, readAll(decompressReader));
+
+    decompressReader.close();
+    EXPECT_LT((uint64_t)0, bufReader.getNumOfLends());
+    EXPECT_EQ(bufReader.getNumOfLends(), bufReader.getNumOfGiveBacks());
+}
+
+TEST_F(DecompressReaderTest, AbleToLendDecompressedData) {
+    string expected;
+    for (int i = 0; i < 100; i++) {
+        expected += "The quick brown fox jumps over the lazy dog\n";
+    }
+    setBufReaderByRawData(expected.data(), expected.size());
+
+    const char *first = NULL;
+    EXPECT_EQ((uint64_t)10, decompressReader.lend(&first, 10));
+    decompressReader.giveBack();
+
+    // the rest of the same block follows.
+    const char *next = NULL;
+    EXPECT_EQ((uint64_t)10, decompressReader.lend(&next, 10));
+    EXPECT_EQ(first + 10, next);
+    decompressReader.giveBack();
+
+    string result(first, 20);
+    uint64_t len;
+    while ((len = decompressReader.lend(&next, 1000)) != 0) {
+        result.append(next, len);
+        decompressReader.giveBack();
+    }
+
+    EXPECT_EQ(expected, result);
+}
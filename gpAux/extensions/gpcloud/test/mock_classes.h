@@ -87,8 +87,11 @@ class XMLGenerator {
         for (vector<BucketContent>::iterator it = contents.begin(); it != contents.end(); it++) {
             sstr << "<Contents>"
                  << "<Key>" << it->name << "</Key>"
-                 << "<Size>" << it->size << "</Size>"
-                 << "</Contents>";
+                 << "<Size>" << it->size << "</Size>";
+            if (!it->etag.empty()) {
+                sstr << "<ETag>" << it->etag << "</ETag>";
+            }
+            sstr << "</Contents>";
         }
         sstr << "</ListBucketResult>";
         string xml = sstr.str();
@@ -0,0 +1,681 @@
+#include "parquet_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::Invoke;
+using ::testing::_;
+
+// Encoder of Thrift compact protocol, to build metadata of test files.
+class ThriftWriter {
+   public:
+    ThriftWriter() : lastIds(1, 0) {
+    }
+
+    void field(int16_t id, uint8_t type) {
+        int16_t &lastId = lastIds.back();
+        if (id > lastId && id - lastId <= 15) {
+            out.push_back((char)(((id - lastId) << 4) | type));
+        } else {
+            out.push_back((char)type);
+            varint(((uint64_t)id << 1) ^ (uint64_t)(id >> 15));
+        }
+        lastId = id;
+    }
+
+    void i32(int16_t id, int32_t value) {
+        field(id, THRIFT_I32);
+        varint(((uint64_t)(int64_t)value << 1) ^ (uint64_t)((int64_t)value >> 63));
+    }
+
+    void i64(int16_t id, int64_t value) {
+        field(id, THRIFT_I64);
+        varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    void binary(int16_t id, const string &value) {
+        field(id, THRIFT_BINARY);
+        rawBinary(value);
+    }
+
+    void rawBinary(const string &value) {
+        varint(value.size());
+        out += value;
+    }
+
+    void list(int16_t id, uint8_t elemType, uint64_t size) {
+        field(id, THRIFT_LIST);
+        if (size < 15) {
+            out.push_back((char)((size << 4) | elemType));
+        } else {
+            out.push_back((char)(0xF0 | elemType));
+            varint(size);
+        }
+    }
+
+    void beginStruct(int16_t id) {
+        field(id, THRIFT_STRUCT);
+        beginElement();
+    }
+
+    // a struct as element of list.
+    void beginElement() {
+        lastIds.push_back(0);
+    }
+
+    void endStruct() {
+        out.push_back(THRIFT_STOP);
+        lastIds.pop_back();
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    string out;
+    vector<int16_t> lastIds;  // of structs being written.
+};
+
+// A value of test file, PLAIN encoded.
+struct TestValue {
+    bool isNull;
+    string plain;
+};
+
+static TestValue Null() {
+    return TestValue{true, ""};
+}
+
+static TestValue I32(int32_t value) {
+    return TestValue{false, string((const char *)&value, 4)};
+}
+
+static TestValue I64(int64_t value) {
+    return TestValue{false, string((const char *)&value, 8)};
+}
+
+static TestValue Str(const string &value) {
+    uint32_t len = value.size();
+    return TestValue{false, string((const char *)&len, 4) + value};
+}
+
+// Build Parquet files of flat schema, one data page of PLAIN or dictionary encoding per column
+// chunk, with statistics of INT32, INT64 and BYTE_ARRAY columns.
+class ParquetFileBuilder {
+   public:
+    ParquetFileBuilder() : codec(PARQUET_UNCOMPRESSED), numOfRowGroups(0), numRows(0) {
+        file = PARQUET_MAGIC;
+    }
+
+    void addColumn(const string &name, int32_t type, int32_t repetition,
+                   int32_t convertedType = PARQUET_CONVERTED_NONE, int32_t scale = 0,
+                   bool dictionary = false) {
+        ParquetSchemaElement element;
+        element.name = name;
+        element.type = type;
+        element.repetition = repetition;
+        element.convertedType = convertedType;
+        element.scale = scale;
+        schema.push_back(element);
+        dictionaries.push_back(dictionary);
+    }
+
+    void setCodec(int32_t codec) {
+        this->codec = codec;
+    }
+
+    // rows of values in order of columns.
+    void addRowGroup(const vector<vector<TestValue>> &rows) {
+        ThriftWriter &meta = rowGroups;
+        meta.beginElement();
+        meta.list(1, THRIFT_STRUCT, schema.size());
+
+        for (uint64_t c = 0; c < schema.size(); c++) {
+            vector<TestValue> values;
+            for (const vector<TestValue> &row : rows) {
+                values.push_back(row[c]);
+            }
+            writeColumnChunk(c, values);
+        }
+
+        meta.i64(3, rows.size());
+        meta.endStruct();
+
+        numOfRowGroups++;
+        numRows += rows.size();
+    }
+
+    string finish() {
+        ThriftWriter meta;
+        meta.i32(1, 1);
+
+        meta.list(2, THRIFT_STRUCT, schema.size() + 1);
+        meta.beginElement();
+        meta.binary(4, "schema");
+        meta.i32(5, schema.size());
+        meta.endStruct();
+        for (const ParquetSchemaElement &element : schema) {
+            meta.beginElement();
+            meta.i32(1, element.type);
+            meta.i32(3, element.repetition);
+            meta.binary(4, element.name);
+            if (element.convertedType != PARQUET_CONVERTED_NONE) {
+                meta.i32(6, element.convertedType);
+                meta.i32(7, element.scale);
+            }
+            meta.endStruct();
+        }
+
+        meta.i64(3, numRows);
+        meta.list(4, THRIFT_STRUCT, numOfRowGroups);
+        meta.out += rowGroups.out;
+        meta.out.push_back(THRIFT_STOP);
+
+        uint32_t len = meta.out.size();
+        return file + meta.out + string((const char *)&len, 4) + PARQUET_MAGIC;
+    }
+
+    uint64_t getSize() const {
+        return file.size();
+    }
+
+   private:
+    string compress(const string &data) {
+        if (codec == PARQUET_UNCOMPRESSED) {
+            return data;
+        }
+
+        vector<char> member;
+        z_stream zstream;
+        memset(&zstream, 0, sizeof(zstream));
+        deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                     Z_DEFAULT_STRATEGY);
+        member.resize(deflateBound(&zstream, data.size()));
+
+        zstream.next_in = (Byte *)data.data();
+        zstream.avail_in = data.size();
+        zstream.next_out = (Byte *)member.data();
+        zstream.avail_out = member.size();
+        deflate(&zstream, Z_FINISH);
+        member.resize(zstream.total_out);
+        deflateEnd(&zstream);
+
+        return string(member.begin(), member.end());
+    }
+
+    // Append a page to file, return its size.
+    uint64_t writePage(int32_t type, int32_t numValues, int32_t encoding, const string &data) {
+        string compressed = compress(data);
+
+        ThriftWriter header;
+        header.i32(1, type);
+        header.i32(2, data.size());
+        header.i32(3, compressed.size());
+        header.beginStruct(type == PARQUET_DATA_PAGE ? 5 : 7);
+        header.i32(1, numValues);
+        header.i32(2, encoding);
+        if (type == PARQUET_DATA_PAGE) {
+            header.i32(3, PARQUET_RLE);
+            header.i32(4, PARQUET_RLE);
+        }
+        header.endStruct();
+        header.out.push_back(THRIFT_STOP);
+
+        file += header.out + compressed;
+        return header.out.size() + compressed.size();
+    }
+
+    // Decode a PLAIN value for statistics, strings without the length.
+    string statValue(uint64_t column, const string &plain) {
+        return (schema[column].type == PARQUET_BYTE_ARRAY) ? plain.substr(4) : plain;
+    }
+
+    bool lessThan(uint64_t column, const string &a, const string &b) {
+        switch (schema[column].type) {
+            case PARQUET_INT32:
+                return *(const int32_t *)a.data() < *(const int32_t *)b.data();
+            case PARQUET_INT64:
+                return *(const int64_t *)a.data() < *(const int64_t *)b.data();
+            default:
+                return a < b;
+        }
+    }
+
+    void writeColumnChunk(uint64_t column, const vector<TestValue> &values) {
+        const ParquetSchemaElement &element = schema[column];
+        bool dictionary = dictionaries[column];
+
+        uint64_t start = file.size();
+        uint64_t size = 0;
+
+        // definition levels, a RLE run for every value.
+        string levels;
+        int64_t nullCount = 0;
+        for (const TestValue &value : values) {
+            levels.push_back(2);
+            levels.push_back(value.isNull ? 0 : 1);
+            nullCount += value.isNull;
+        }
+
+        string data;
+        if (element.repetition == PARQUET_OPTIONAL) {
+            uint32_t len = levels.size();
+            data = string((const char *)&len, 4) + levels;
+        }
+
+        bool hasStat = false;
+        string min, max;
+        vector<string> dictValues;
+        string plain, indexes(1, 8);  // indexes of 8 bits.
+
+        for (const TestValue &value : values) {
+            if (value.isNull) {
+                continue;
+            }
+
+            string stat = statValue(column, value.plain);
+            if (!hasStat || lessThan(column, stat, min)) {
+                min = stat;
+            }
+            if (!hasStat || lessThan(column, max, stat)) {
+                max = stat;
+            }
+            hasStat = true;
+
+            if (dictionary) {
+                uint64_t index =
+                    std::find(dictValues.begin(), dictValues.end(), value.plain) -
+                    dictValues.begin();
+                if (index == dictValues.size()) {
+                    dictValues.push_back(value.plain);
+                }
+                indexes.push_back(2);
+                indexes.push_back((char)index);
+            } else {
+                plain += value.plain;
+            }
+        }
+
+        if (dictionary) {
+            string dictData;
+            for (const string &value : dictValues) {
+                dictData += value;
+            }
+            size += writePage(PARQUET_DICTIONARY_PAGE, dictValues.size(), PARQUET_PLAIN, dictData);
+        }
+
+        uint64_t dataPageOffset = file.size();
+        size += writePage(PARQUET_DATA_PAGE, values.size(),
+                          dictionary ? PARQUET_RLE_DICTIONARY : PARQUET_PLAIN,
+                          data + (dictionary ? indexes : plain));
+
+        ThriftWriter &meta = rowGroups;
+        meta.beginElement();
+        meta.i64(2, start);
+        meta.beginStruct(3);
+        meta.i32(1, element.type);
+        meta.list(2, THRIFT_I32, 1);
+        meta.varint(0);
+        meta.list(3, THRIFT_BINARY, 1);
+        meta.rawBinary(element.name);
+        meta.i32(4, codec);
+        meta.i64(5, values.size());
+        meta.i64(6, size);
+        meta.i64(7, size);
+        meta.i64(9, dataPageOffset);
+        if (dictionary) {
+            meta.i64(11, start);
+        }
+        meta.beginStruct(12);
+        meta.i64(3, nullCount);
+        // writers leave out statistics of large values.
+        if (hasStat && element.type != PARQUET_DOUBLE && max.size() <= 4096) {
+            meta.binary(5, max);
+            meta.binary(6, min);
+        }
+        meta.endStruct();
+        meta.endStruct();
+        meta.endStruct();
+    }
+
+    string file;
+    vector<ParquetSchemaElement> schema;
+    vector<bool> dictionaries;
+    int32_t codec;
+
+    ThriftWriter rowGroups;
+    uint64_t numOfRowGroups;
+    uint64_t numRows;
+};
+
+// Mock function object of fetchData, serving ranges of file and remembering them.
+class MockFetchFile {
+   public:
+    MockFetchFile(const string &file, vector<std::pair<uint64_t, uint64_t>> &ranges)
+        : file(file), ranges(ranges) {
+    }
+
+    uint64_t operator()(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url) {
+        EXPECT_LE(offset + len, file.size());
+        data.assign(file.begin() + offset, file.begin() + offset + len);
+        ranges.emplace_back(offset, len);
+        return len;
+    }
+
+   private:
+    string file;
+    vector<std::pair<uint64_t, uint64_t>> &ranges;
+};
+
+class ParquetReaderTest : public testing::Test, public ParquetReader {
+   protected:
+    virtual void SetUp() {
+        eolString[0] = '\n';
+        eolString[1] = '\0';
+        hasHeader = false;
+        tableFormat = TableFormat();
+
+        this->setS3InterfaceService(&s3Interface);
+    }
+
+    virtual void TearDown() {
+        this->close();
+
+        tableFormat = TableFormat();
+    }
+
+    // Open file as a key, and read all of it.
+    string readFile(const string &file, const string &filter = "", uint64_t rangeStart = 0,
+                    uint64_t rangeEnd = 0) {
+        EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(Invoke(MockFetchFile(file, ranges)));
+
+        S3Params params("s3://abc/def.parquet");
+        params.setKeySize(file.size());
+        params.setFilter(filter);
+        params.setRange(rangeStart, rangeEnd);
+        this->open(params);
+
+        string result;
+        char buf[7];  // small buffer to return rows in pieces.
+        uint64_t len;
+        while ((len = this->read(buf, sizeof(buf))) > 0) {
+            result.append(buf, len);
+        }
+
+        EXPECT_EQ((uint64_t)0, this->read(buf, sizeof(buf)));
+        return result;
+    }
+
+    MockS3Interface s3Interface;
+    vector<std::pair<uint64_t, uint64_t>> ranges;
+};
+
+TEST_F(ParquetReaderTest, ReadRowsAsText) {
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addColumn("name", PARQUET_BYTE_ARRAY, PARQUET_OPTIONAL, PARQUET_UTF8);
+    builder.addRowGroup({{I32(1), Str("foo")}, {I32(-2), Null()}});
+    builder.addRowGroup({{I32(3), Str("a\tb\\c\nd")}});
+
+    EXPECT_EQ("1\tfoo\n-2\t\\N\n3\ta\\\tb\\\\c\\nd\n", this->readFile(builder.finish()));
+}
+
+TEST_F(ParquetReaderTest, ReadRowsAsCsv) {
+    tableFormat.isCsv = true;
+    tableFormat.delimiter = ',';
+    tableFormat.escape = '"';
+    tableFormat.nullString = "";
+
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT64, PARQUET_OPTIONAL);
+    builder.addColumn("name", PARQUET_BYTE_ARRAY, PARQUET_OPTIONAL, PARQUET_UTF8);
+    builder.addRowGroup(
+        {{I64(1), Str("a,b")}, {Null(), Str("")}, {I64(3), Null()}, {I64(4), Str("say \"hi\"")}});
+
+    EXPECT_EQ("1,\"a,b\"\n,\"\"\n3,\n4,\"say \"\"hi\"\"\"\n", this->readFile(builder.finish()));
+}
+
+TEST_F(ParquetReaderTest, ReadOnlyColumnsOfTable) {
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addColumn("payload", PARQUET_BYTE_ARRAY, PARQUET_REQUIRED);
+    builder.addColumn("Name", PARQUET_BYTE_ARRAY, PARQUET_REQUIRED, PARQUET_UTF8);
+
+    string payload(4 * PARQUET_MAX_MERGE_GAP, 'x');
+    builder.addRowGroup({{I32(1), Str(payload), Str("foo")}, {I32(2), Str(payload), Str("bar")}});
+    string file = builder.finish();
+
+    // columns are matched by name ignoring case, missing ones are NULL.
+    tableFormat.columns = {"name", "missing", "id"};
+    EXPECT_EQ("foo\t\\N\t1\nbar\t\\N\t2\n", this->readFile(file));
+
+    // the footer, then chunks of "id" and "Name" separately, not the payload between them.
+    ASSERT_EQ((uint64_t)3, ranges.size());
+    EXPECT_LT(this->getFetchedBytes(), (uint64_t)PARQUET_MAX_MERGE_GAP);
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByStatistics) {
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addColumn("name", PARQUET_BYTE_ARRAY, PARQUET_OPTIONAL, PARQUET_UTF8);
+    builder.addRowGroup({{I32(1), Str("a")}, {I32(2), Str("b")}});
+    builder.addRowGroup({{I32(3), Str("c")}, {I32(4), Null()}});
+    builder.addRowGroup({{I32(5), Null()}, {I32(6), Null()}});
+    string file = builder.finish();
+
+    EXPECT_EQ("3\tc\n4\t\\N\n5\t\\N\n6\t\\N\n", this->readFile(file, "id>2"));
+    EXPECT_EQ((uint64_t)1, this->getNumOfSkippedRowGroups());
+    this->close();
+
+    // all NULLs never match, unknown columns are ignored.
+    EXPECT_EQ("3\tc\n4\t\\N\n", this->readFile(file, "name>b,id<=4,unknown=1"));
+    EXPECT_EQ((uint64_t)2, this->getNumOfSkippedRowGroups());
+    this->close();
+
+    EXPECT_EQ("", this->readFile(file, "id=7"));
+    EXPECT_EQ((uint64_t)3, this->getNumOfSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, ReadRowGroupsStartingInRange) {
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addRowGroup({{I32(1)}, {I32(2)}});
+    uint64_t secondStart = builder.getSize();
+    builder.addRowGroup({{I32(3)}});
+    builder.addRowGroup({{I32(4)}});
+    string file = builder.finish();
+
+    EXPECT_EQ("1\n2\n", this->readFile(file, "", 0, secondStart));
+    this->close();
+
+    EXPECT_EQ("3\n4\n", this->readFile(file, "", secondStart, file.size()));
+}
+
+TEST_F(ParquetReaderTest, ReadDictionaryEncodedGzipPages) {
+    ParquetFileBuilder builder;
+    builder.setCodec(PARQUET_GZIP);
+    builder.addColumn("city", PARQUET_BYTE_ARRAY, PARQUET_OPTIONAL, PARQUET_UTF8, 0, true);
+    builder.addColumn("zip", PARQUET_INT32, PARQUET_REQUIRED, PARQUET_CONVERTED_NONE, 0, true);
+    builder.addRowGroup({{Str("paris"), I32(75001)},
+                         {Null(), I32(75001)},
+                         {Str("rome"), I32(118)},
+                         {Str("paris"), I32(75002)}});
+
+    EXPECT_EQ("paris\t75001\n\\N\t75001\nrome\t118\nparis\t75002\n",
+              this->readFile(builder.finish()));
+}
+
+TEST_F(ParquetReaderTest, FormatLogicalTypes) {
+    ParquetFileBuilder builder;
+    builder.addColumn("day", PARQUET_INT32, PARQUET_REQUIRED, PARQUET_DATE);
+    builder.addColumn("ts", PARQUET_INT64, PARQUET_REQUIRED, PARQUET_TIMESTAMP_MICROS);
+    builder.addColumn("price", PARQUET_INT64, PARQUET_REQUIRED, PARQUET_DECIMAL, 2);
+    builder.addRowGroup({{I32(17532), I64(1514764800123456LL), I64(-5)},
+                         {I32(-719528), I64(-1), I64(123456)}});
+
+    EXPECT_EQ(
+        "2018-01-01\t2018-01-01 00:00:00.123456+00\t-0.05\n"
+        "0001-01-01 BC\t1969-12-31 23:59:59.999999+00\t1234.56\n",
+        this->readFile(builder.finish()));
+}
+
+TEST_F(ParquetReaderTest, EveryFileHasHeaderLine) {
+    hasHeader = true;
+
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addColumn("name", PARQUET_BYTE_ARRAY, PARQUET_REQUIRED);
+    builder.addRowGroup({{I32(1), Str("foo")}});
+
+    EXPECT_EQ("id\tname\n1\tfoo\n", this->readFile(builder.finish()));
+}
+
+TEST_F(ParquetReaderTest, RejectNonParquetFile) {
+    string file = "id,name\n1,foo\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchFile(file, ranges)));
+
+    S3Params params("s3://abc/def.csv");
+    params.setKeySize(file.size());
+    EXPECT_THROW(this->open(params), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, RejectTruncatedMetaData) {
+    ParquetFileBuilder builder;
+    builder.addColumn("id", PARQUET_INT32, PARQUET_REQUIRED);
+    builder.addRowGroup({{I32(1)}});
+    uint64_t metadataStart = builder.getSize();
+    string file = builder.finish();
+
+    // drop the last byte of metadata.
+    uint32_t len = file.size() - metadataStart - PARQUET_MAGIC_LEN - 4 - 1;
+    file = file.substr(0, metadataStart + len) + string((const char *)&len, 4) + PARQUET_MAGIC;
+    EXPECT_THROW(this->readFile(file), S3RuntimeError);
+}
+
+TEST(ParquetFilter, Parse) {
+    vector<ParquetPredicate> predicates = ParseParquetFilter("id>=100,name=bob,x<1");
+    ASSERT_EQ((uint64_t)3, predicates.size());
+
+    EXPECT_EQ("id", predicates[0].column);
+    EXPECT_EQ(">=", predicates[0].op);
+    EXPECT_EQ("100", predicates[0].value);
+    EXPECT_EQ("=", predicates[1].op);
+    EXPECT_EQ("bob", predicates[1].value);
+    EXPECT_EQ("<", predicates[2].op);
+
+    EXPECT_TRUE(ParseParquetFilter("").empty());
+    EXPECT_THROW(ParseParquetFilter("id"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("=1"), S3ConfigError);
+}
+
+TEST(ParquetFilter, ParseUnsupportedOperators) {
+    EXPECT_THROW(ParseParquetFilter("name<>abc"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("a=>5"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("a=<5"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("a==5"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("a!=5"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("a<=>5"), S3ConfigError);
+    EXPECT_THROW(ParseParquetFilter("id>=1,a>>5"), S3ConfigError);
+
+    // the operator characters are fine later in the value.
+    vector<ParquetPredicate> predicates = ParseParquetFilter("a=b<c");
+    ASSERT_EQ((uint64_t)1, predicates.size());
+    EXPECT_EQ("=", predicates[0].op);
+    EXPECT_EQ("b<c", predicates[0].value);
+}
+
+TEST(ParquetFilter, ChunkMayMatch) {
+    ParquetColumn column;
+    column.element.type = PARQUET_INT64;
+
+    int64_t min = 10, max = 20;
+    ParquetColumnChunk chunk;
+    chunk.numValues = 100;
+    chunk.statistics.hasMin = chunk.statistics.hasMax = true;
+    chunk.statistics.min = string((const char *)&min, 8);
+    chunk.statistics.max = string((const char *)&max, 8);
+
+    EXPECT_TRUE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "10"}));
+    EXPECT_FALSE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "21"}));
+    EXPECT_FALSE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "<", "10"}));
+    EXPECT_TRUE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "<=", "10"}));
+    EXPECT_FALSE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", ">", "20"}));
+    EXPECT_TRUE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", ">=", "20"}));
+
+    // values that don't parse never skip.
+    EXPECT_TRUE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "abc"}));
+
+    // legacy statistics of strings were compared as signed bytes.
+    column.element.type = PARQUET_BYTE_ARRAY;
+    chunk.statistics.min = "a";
+    chunk.statistics.max = "c";
+    EXPECT_FALSE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "d"}));
+    chunk.statistics.isLegacy = true;
+    EXPECT_TRUE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "d"}));
+
+    chunk.statistics.hasNullCount = true;
+    chunk.statistics.nullCount = 100;
+    EXPECT_FALSE(ParquetChunkMayMatch(column, chunk, ParquetPredicate{"a", "=", "b"}));
+}
+
+TEST(Snappy, Uncompress) {
+    // literal "abc", then copy of 9 bytes at offset 3.
+    const char compressed[] = {12, 2 << 2, 'a', 'b', 'c', 1 | (5 << 2), 3};
+
+    vector<char> output;
+    SnappyUncompress(compressed, sizeof(compressed), 12, output);
+    EXPECT_EQ("abcabcabcabc", string(output.begin(), output.end()));
+
+    EXPECT_THROW(SnappyUncompress(compressed, sizeof(compressed) - 1, 12, output), S3RuntimeError);
+}
+
+TEST(Snappy, UncompressWrongLength) {
+    // a preamble of 0xFFFFFFFF bytes must not be allocated.
+    const char compressed[] = {'\xFF', '\xFF', '\xFF', '\xFF', 0x0F, 0 << 2, 'a'};
+
+    vector<char> output;
+    EXPECT_THROW(SnappyUncompress(compressed, sizeof(compressed), 1, output), S3RuntimeError);
+    EXPECT_TRUE(output.empty());
+
+    const char short_compressed[] = {12, 2 << 2, 'a', 'b', 'c', 1 | (5 << 2), 3};
+    EXPECT_THROW(SnappyUncompress(short_compressed, sizeof(short_compressed), 11, output),
+                 S3RuntimeError);
+}
+
+// A page header with an unknown field that is a list or map nested levels deep.
+static string NestedPageHeader(uint8_t fieldType, int levels) {
+    string header(1, (char)((10 << 4) | fieldType));
+    for (int i = 0; i < levels; i++) {
+        if (fieldType == THRIFT_LIST) {
+            header.push_back((char)((1 << 4) | THRIFT_LIST));  // one element, a list.
+        } else {
+            header.push_back(1);                                       // one entry,
+            header.push_back((char)((THRIFT_I32 << 4) | THRIFT_MAP));  // i32 to map,
+            header.push_back(0);                                       // key 0.
+        }
+    }
+    header.push_back(0);  // innermost list or map is empty.
+    header.push_back(0);  // end of the page header.
+    return header;
+}
+
+TEST(ParquetThrift, SkipNestedContainers) {
+    ParquetPageHeader header;
+
+    string shallow = NestedPageHeader(THRIFT_LIST, 10);
+    EXPECT_EQ(shallow.size(), ParseParquetPageHeader(shallow.data(), shallow.size(), &header));
+    shallow = NestedPageHeader(THRIFT_MAP, 10);
+    EXPECT_EQ(shallow.size(), ParseParquetPageHeader(shallow.data(), shallow.size(), &header));
+
+    // one byte per level, deep enough to overflow the stack without a limit.
+    string deep = NestedPageHeader(THRIFT_LIST, 1000000);
+    EXPECT_THROW(ParseParquetPageHeader(deep.data(), deep.size(), &header), S3RuntimeError);
+    deep = NestedPageHeader(THRIFT_MAP, 1000000);
+    EXPECT_THROW(ParseParquetPageHeader(deep.data(), deep.size(), &header), S3RuntimeError);
+}
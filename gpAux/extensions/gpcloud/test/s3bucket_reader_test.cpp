@@ -3,6 +3,8 @@
 #include "gtest/gtest.h"
 #include "mock_classes.h"
 
+#include <utime.h>
+
 using ::testing::AtLeast;
 using ::testing::Return;
 using ::testing::Invoke;
@@ -38,6 +40,7 @@ class S3BucketReaderTest : public testing::Test {
 
         s3ext_segid = 0;
         s3ext_segnum = 1;
+        s3ext_queryid.clear();
     }
 
     S3BucketReader* bucketReader;
@@ -169,6 +172,301 @@ TEST_F(S3BucketReaderTest, UpstreamReaderThrowException) {
     EXPECT_THROW(bucketReader->read(buf, sizeof(buf)), S3RuntimeError);
 }
 
+MATCHER_P2(KeyRangeIs, start, end, "") {
+    return arg.getRangeStart() == (uint64_t)start && arg.getRangeEnd() == (uint64_t)end;
+}
+
+TEST_F(S3BucketReaderTest, ReadLargeKeyInRangesAcrossSegments) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 1000);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(10);
+    params.setSplitSize(100);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+
+    EXPECT_CALL(s3Reader, open(KeyRangeIs(250, 500))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Return(256)).WillOnce(Return(0));
+
+    s3ext_segid = 1;
+    s3ext_segnum = 4;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)256, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+}
+
+TEST_F(S3BucketReaderTest, ReadRangesOfLargeKeysRotatedAcrossSegments) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+    result.contents.emplace_back("bar", 20);
+
+    // each key is split into two ranges, key "foo" for segment 0 and 1, "bar" for 1 and 2.
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(10);
+    params.setSplitSize(10);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_))
+        .Times(2)
+        .WillRepeatedly(Return(S3_COMPRESSION_PLAIN));
+
+    EXPECT_CALL(s3Reader, open(KeyRangeIs(10, 20))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Return(10)).WillOnce(Return(0));
+
+    s3ext_segid = 2;
+    s3ext_segnum = 4;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)10, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+}
+
+TEST_F(S3BucketReaderTest, ReadLargeCompressedKeyAsWhole) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 1000);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(10);
+    params.setSplitSize(100);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+
+    EXPECT_CALL(s3Reader, open(KeyRangeIs(0, 0))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Return(256)).WillOnce(Return(0));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 4;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)256, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+}
+
+TEST_F(S3BucketReaderTest, ReaderShouldSkipLargeCompressedKeyIfNotForThisSegment) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 1000);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(10);
+    params.setSplitSize(100);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+
+    s3ext_segid = 1;
+    s3ext_segnum = 4;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+}
+
+MATCHER_P(KeySizeIs, size, "") {
+    return arg.getKeySize() == (uint64_t)size;
+}
+
+TEST_F(S3BucketReaderTest, BalanceWholeKeysByBytes) {
+    ListBucketResult result;
+    result.contents.emplace_back("large", 100);
+    result.contents.emplace_back("small1", 10);
+    result.contents.emplace_back("small2", 10);
+    result.contents.emplace_back("small3", 10);
+    result.contents.emplace_back("small4", 10);
+    result.contents.emplace_back("medium", 60);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    // segment 0 reads the large key, segment 1 reads all the others, 100 bytes each.
+    EXPECT_CALL(s3Reader, open(KeySizeIs(100))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Return(0));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+}
+
+TEST_F(S3BucketReaderTest, ShareKeyListAmongReaders) {
+    char dir[] = "/tmp/gpcloud_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 456, "\"abc\"");
+    result.contents.emplace_back("bar baz\n", 0);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSharedListingDir(dir);
+    s3ext_queryid = "1_2_1500000000-0000000003";
+
+    // only the first reader lists the bucket.
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    bucketReader->open(params);
+
+    S3BucketReader anotherReader;
+    anotherReader.setS3InterfaceService(&s3Interface);
+    anotherReader.open(params);
+
+    const ListBucketResult& keyList = anotherReader.getKeyList();
+    ASSERT_EQ((uint64_t)2, keyList.contents.size());
+    EXPECT_EQ("foo", keyList.contents[0].getName());
+    EXPECT_EQ((uint64_t)456, keyList.contents[0].getSize());
+    EXPECT_EQ("\"abc\"", keyList.contents[0].getETag());
+    EXPECT_EQ("bar baz\n", keyList.contents[1].getName());
+    EXPECT_EQ((uint64_t)0, keyList.contents[1].getSize());
+    EXPECT_EQ("", keyList.contents[1].getETag());
+
+    string cleanup = string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+// Return paths of shared listing files in dir.
+static vector<string> SharedListingFiles(const char* dir) {
+    vector<string> files;
+    DIR* d = opendir(dir);
+    struct dirent* entry;
+    while (d != NULL && (entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, S3_SHARED_LISTING_PREFIX, strlen(S3_SHARED_LISTING_PREFIX)) == 0) {
+            files.push_back(string(dir) + "/" + entry->d_name);
+        }
+    }
+    if (d != NULL) {
+        closedir(d);
+    }
+    return files;
+}
+
+TEST_F(S3BucketReaderTest, StaleSharedListingIsNotLoaded) {
+    char dir[] = "/tmp/gpcloud_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    ListBucketResult staleResult;
+    staleResult.contents.emplace_back("stale", 123);
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 456);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSharedListingDir(dir);
+    s3ext_queryid = "1_2_1500000000-0000000003";
+
+    EXPECT_CALL(s3Interface, listBucket(_))
+        .Times(2)
+        .WillOnce(Return(staleResult))
+        .WillOnce(Return(result));
+
+    // leave the file of a crashed segment behind, with the same name as ours.
+    S3BucketReader crashedReader;
+    crashedReader.setS3InterfaceService(&s3Interface);
+    crashedReader.open(params);
+
+    vector<string> files = SharedListingFiles(dir);
+    ASSERT_EQ((size_t)1, files.size());
+
+    struct utimbuf old;
+    old.actime = old.modtime = time(NULL) - S3_SHARED_LISTING_TTL - 60;
+    ASSERT_EQ(0, utime(files[0].c_str(), &old));
+
+    bucketReader->open(params);
+
+    const ListBucketResult& keyList = bucketReader->getKeyList();
+    ASSERT_EQ((uint64_t)1, keyList.contents.size());
+    EXPECT_EQ("foo", keyList.contents[0].getName());
+
+    string cleanup = string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST_F(S3BucketReaderTest, SharedListingOfAnotherStatementIsNotLoaded) {
+    char dir[] = "/tmp/gpcloud_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    ListBucketResult otherResult;
+    otherResult.contents.emplace_back("other", 123);
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 456);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSharedListingDir(dir);
+
+    EXPECT_CALL(s3Interface, listBucket(_))
+        .Times(2)
+        .WillOnce(Return(otherResult))
+        .WillOnce(Return(result));
+
+    // same session and command count, but another cluster (or a restart of this one).
+    s3ext_queryid = "1_2_1500000000-0000000003";
+    S3BucketReader otherReader;
+    otherReader.setS3InterfaceService(&s3Interface);
+    otherReader.open(params);
+
+    s3ext_queryid = "1_2_1600000000-0000000003";
+    bucketReader->open(params);
+
+    const ListBucketResult& keyList = bucketReader->getKeyList();
+    ASSERT_EQ((uint64_t)1, keyList.contents.size());
+    EXPECT_EQ("foo", keyList.contents[0].getName());
+
+    string cleanup = string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST_F(S3BucketReaderTest, SharedListingIsRemovedAtClose) {
+    char dir[] = "/tmp/gpcloud_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 456);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSharedListingDir(dir);
+    s3ext_queryid = "1_2_1500000000-0000000003";
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+
+    bucketReader->open(params);
+    EXPECT_EQ((size_t)1, SharedListingFiles(dir).size());
+
+    bucketReader->close();
+    EXPECT_EQ((size_t)0, SharedListingFiles(dir).size());
+
+    string cleanup = string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+TEST(SharedKeyList, DeserializeTruncatedData) {
+    ListBucketResult keyList;
+    keyList.contents.emplace_back("foo", 456, "\"abc\"");
+    keyList.contents.emplace_back("bar", 123);
+
+    string data = SerializeKeyList(keyList);
+
+    ListBucketResult parsed;
+    EXPECT_TRUE(DeserializeKeyList(data, &parsed));
+    EXPECT_EQ((uint64_t)2, parsed.contents.size());
+
+    for (size_t len = 0; len < data.size(); len++) {
+        EXPECT_FALSE(DeserializeKeyList(data.substr(0, len), &parsed)) << len;
+    }
+}
+
 class MockRead {
    public:
     MockRead(const char* ptr) : p(ptr) {
@@ -184,6 +482,37 @@ class MockRead {
     uint64_t size;
 };
 
+TEST_F(S3BucketReaderTest, ReadLargeCsvKeyAsWhole) {
+    // a range boundary at byte 10 would fall within the quoted field of the second row.
+    const char* data = "1,\"a\"\n2,\"b\nc\nd\"\n3,\"e\"\n";
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", strlen(data));
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(10);
+    params.setSplitSize(10);
+    tableFormat.isCsv = true;
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).Times(0);
+
+    EXPECT_CALL(s3Reader, open(KeyRangeIs(0, 0))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Invoke(MockRead(data))).WillOnce(Return(0));
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)strlen(data), bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(buf, data, strlen(data)));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    tableFormat = TableFormat();
+}
+
 TEST_F(S3BucketReaderTest, ReadBucketFileWithHeader) {
     hasHeader = true;
 
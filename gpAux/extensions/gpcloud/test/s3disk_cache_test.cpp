@@ -0,0 +1,104 @@
+#include "s3disk_cache.cpp"
+#include "gtest/gtest.h"
+
+#include <utime.h>
+
+class S3DiskCacheTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        strcpy(dir, "/tmp/gpcloud_cache_XXXXXX");
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+    }
+
+    virtual void TearDown() {
+        string cleanup = string("rm -rf ") + dir;
+        EXPECT_EQ(0, system(cleanup.c_str()));
+    }
+
+    S3VectorUInt8 makeData(uint64_t len, uint8_t value) {
+        S3VectorUInt8 data;
+        data.assign(len, value);
+        return data;
+    }
+
+    // Make the cache file of key look like last used seconds ago.
+    void setLastUsed(const string &key, time_t seconds) {
+        char hash[SHA256_DIGEST_STRING_LENGTH];
+        sha256_hex(key.c_str(), key.length(), hash);
+
+        struct utimbuf times;
+        times.actime = times.modtime = time(NULL) - seconds;
+        string path = string(dir) + "/" + hash;
+        ASSERT_EQ(0, utime(path.c_str(), &times));
+    }
+
+    char dir[64];
+};
+
+TEST_F(S3DiskCacheTest, PutAndGet) {
+    S3DiskCache cache;
+    cache.configure(dir, 1024);
+    ASSERT_TRUE(cache.isEnabled());
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.get("foo", data, 100));
+
+    cache.put("foo", makeData(100, 'a'), 100);
+    ASSERT_TRUE(cache.get("foo", data, 100));
+    EXPECT_TRUE(data == makeData(100, 'a'));
+
+    S3DiskCacheStats stats = cache.getStats();
+    EXPECT_EQ((uint64_t)1, stats.numOfHits);
+    EXPECT_EQ((uint64_t)100, stats.hitBytes);
+    EXPECT_EQ((uint64_t)1, stats.numOfMisses);
+}
+
+TEST_F(S3DiskCacheTest, MissIfSizeDiffers) {
+    S3DiskCache cache;
+    cache.configure(dir, 1024);
+
+    cache.put("foo", makeData(100, 'a'), 100);
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.get("foo", data, 99));
+    EXPECT_FALSE(cache.get("bar", data, 100));
+    EXPECT_EQ((uint64_t)2, cache.getStats().numOfMisses);
+}
+
+TEST_F(S3DiskCacheTest, SkipDataLargerThanCache) {
+    S3DiskCache cache;
+    cache.configure(dir, 10);
+
+    cache.put("foo", makeData(100, 'a'), 100);
+
+    S3VectorUInt8 data;
+    EXPECT_FALSE(cache.get("foo", data, 100));
+}
+
+TEST_F(S3DiskCacheTest, EvictLeastRecentlyUsed) {
+    S3DiskCache cache;
+    cache.configure(dir, 250);
+
+    cache.put("first", makeData(100, 'a'), 100);
+    cache.put("second", makeData(100, 'b'), 100);
+    setLastUsed("first", 200);
+    setLastUsed("second", 100);
+
+    // a hit makes "first" the most recently used.
+    S3VectorUInt8 data;
+    EXPECT_TRUE(cache.get("first", data, 100));
+
+    cache.put("third", makeData(100, 'c'), 100);
+
+    EXPECT_FALSE(cache.get("second", data, 100));
+    EXPECT_TRUE(cache.get("first", data, 100));
+    EXPECT_TRUE(cache.get("third", data, 100));
+    EXPECT_EQ((uint64_t)1, cache.getStats().numOfEvictions);
+}
+
+TEST_F(S3DiskCacheTest, DisableIfDirectoryNotCreatable) {
+    S3DiskCache cache;
+    cache.configure("/proc/gpcloud_cache", 1024);
+
+    EXPECT_FALSE(cache.isEnabled());
+}
@@ -233,6 +233,25 @@ TEST_F(S3InterfaceServiceTest, ListBucketWithNormalBucket) {
     EXPECT_EQ((uint64_t)1, result.contents.size());
 }
 
+TEST_F(S3InterfaceServiceTest, ListBucketWithETags) {
+    XMLGenerator generator;
+    XMLGenerator *gen = &generator;
+    gen->setName("s3test.pivotal.io")
+        ->setPrefix("threebytes/")
+        ->setIsTruncated(false)
+        ->pushBuckentContent(BucketContent("threebytes/one", 3, "&quot;abc&quot;"))
+        ->pushBuckentContent(BucketContent("threebytes/two", 3));
+
+    Response response(RESPONSE_OK, gen->toXML());
+
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    result = this->listBucket(this->params.getS3Url());
+    ASSERT_EQ((uint64_t)2, result.contents.size());
+    EXPECT_EQ("\"abc\"", result.contents[0].getETag());
+    EXPECT_EQ("", result.contents[1].getETag());
+}
+
 TEST_F(S3InterfaceServiceTest, ListBucketWithBucketWith1000Keys) {
     EXPECT_CALL(mockRESTfulService, get(_, _))
         .WillOnce(Return(this->buildListBucketResponse(1000, false)));
@@ -14,6 +14,8 @@ bool hasHeader = false;
 
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+TableFormat tableFormat;
+
 string s3extErrorMessage;
 
 volatile bool QueryCancelPending = false;
@@ -216,6 +218,127 @@ TEST(OffsetMgr, reset) {
     EXPECT_EQ((uint64_t)0, o.getCurPos());
 }
 
+TEST(OffsetMgr, ChangeChunkSizeOfNextChunks) {
+    OffsetMgr o;
+    o.setKeySize(4096);
+    o.setChunkSize(1000);
+
+    Range r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)0, r.index);
+    EXPECT_EQ((uint64_t)1000, r.length);
+
+    o.setChunkSize(3000);
+
+    r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)1, r.index);
+    EXPECT_EQ((uint64_t)1000, r.offset);
+    EXPECT_EQ((uint64_t)3000, r.length);
+
+    r = o.getNextOffset();
+    EXPECT_EQ((uint64_t)2, r.index);
+    EXPECT_EQ((uint64_t)4000, r.offset);
+    EXPECT_EQ((uint64_t)96, r.length);
+}
+
+// Add n chunks of len bytes downloaded at the same time in one second.
+static bool addSamples(DownloadTuner &tuner, uint64_t n, uint64_t len, uint64_t &nowUs) {
+    bool changed = false;
+    for (uint64_t i = 0; i < n; i++) {
+        changed = tuner.addSample(len, nowUs, nowUs + 1000000);
+    }
+
+    nowUs += 1000000;
+    return changed;
+}
+
+TEST(DownloadTuner, DisabledWithoutRange) {
+    DownloadTuner tuner;
+    tuner.reset(100, 100, 4, 4, 1000);
+
+    EXPECT_FALSE(tuner.isEnabled());
+    EXPECT_EQ((uint64_t)100, tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)4, tuner.getNumOfThreads());
+
+    uint64_t nowUs = 0;
+    EXPECT_FALSE(addSamples(tuner, 100, 100, nowUs));
+    EXPECT_EQ((uint64_t)100, tuner.getChunkSize());
+}
+
+TEST(DownloadTuner, StartWithChunksForAllThreads) {
+    DownloadTuner tuner;
+
+    tuner.reset(10, 1000, 1, 4, 1000);
+    EXPECT_TRUE(tuner.isEnabled());
+    EXPECT_EQ((uint64_t)250, tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)4, tuner.getNumOfThreads());
+
+    tuner.reset(10, 1000, 1, 4, 20);
+    EXPECT_EQ((uint64_t)10, tuner.getChunkSize());
+
+    tuner.reset(10, 100, 1, 4, 1000);
+    EXPECT_EQ((uint64_t)100, tuner.getChunkSize());
+}
+
+TEST(DownloadTuner, GrowChunkSizeOfFastChunks) {
+    DownloadTuner tuner;
+    tuner.reset(10, 60, 2, 2, 100);
+    EXPECT_EQ((uint64_t)50, tuner.getChunkSize());
+
+    // a round is 2 chunks per thread.
+    for (uint64_t i = 0; i < 3; i++) {
+        EXPECT_FALSE(tuner.addSample(50, 0, 1000));
+    }
+    EXPECT_TRUE(tuner.addSample(50, 0, 1000));
+    EXPECT_EQ((uint64_t)60, tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)2, tuner.getNumOfThreads());
+}
+
+TEST(DownloadTuner, ShrinkChunkSizeOfSlowChunks) {
+    DownloadTuner tuner;
+    tuner.reset(300, 1000, 2, 2, 2000);
+    EXPECT_EQ((uint64_t)1000, tuner.getChunkSize());
+
+    for (uint64_t i = 0; i < 4; i++) {
+        tuner.addSample(1000, 0, (S3_TUNE_MAX_CHUNK_LATENCY_MS + 1) * 1000);
+    }
+    EXPECT_EQ((uint64_t)500, tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)(S3_TUNE_MAX_CHUNK_LATENCY_MS + 1), tuner.getLatencyMs());
+
+    for (uint64_t i = 0; i < 4; i++) {
+        tuner.addSample(500, 0, (S3_TUNE_MAX_CHUNK_LATENCY_MS + 1) * 1000);
+    }
+    EXPECT_EQ((uint64_t)300, tuner.getChunkSize());
+}
+
+TEST(DownloadTuner, ClimbNumOfThreadsByThroughput) {
+    DownloadTuner tuner;
+    tuner.reset(100, 100, 1, 4, 1000);
+    EXPECT_EQ((uint64_t)4, tuner.getNumOfThreads());
+
+    uint64_t nowUs = 0;
+
+    // the first round has nothing to compare, try fewer threads.
+    EXPECT_TRUE(addSamples(tuner, 8, 100, nowUs));
+    EXPECT_EQ((uint64_t)800, tuner.getThroughput());
+    EXPECT_EQ((uint64_t)3, tuner.getNumOfThreads());
+
+    // same throughput with fewer threads, try even fewer.
+    EXPECT_TRUE(addSamples(tuner, 6, 133, nowUs));
+    EXPECT_EQ((uint64_t)2, tuner.getNumOfThreads());
+
+    // throughput drops, go back.
+    EXPECT_TRUE(addSamples(tuner, 4, 100, nowUs));
+    EXPECT_EQ((uint64_t)3, tuner.getNumOfThreads());
+
+    // throughput improves, keep going.
+    EXPECT_TRUE(addSamples(tuner, 6, 100, nowUs));
+    EXPECT_EQ((uint64_t)4, tuner.getNumOfThreads());
+
+    // no more than max threads.
+    EXPECT_FALSE(addSamples(tuner, 8, 200, nowUs));
+    EXPECT_EQ((uint64_t)4, tuner.getNumOfThreads());
+}
+
 TEST_F(S3KeyReaderTest, OpenWithZeroChunk) {
     S3Params params("s3://abc/def");
 
@@ -477,6 +600,206 @@ TEST_F(S3KeyReaderTest, ReadWithSameKeyChunkReadSize) {
     EXPECT_EQ((uint64_t)0, this->read(buffer, 255));
 }
 
+// Mock function object of fetchData, return the bytes of content at the requested offset.
+class MockFetchContent {
+   public:
+    MockFetchContent(const string &content) : content(content) {
+    }
+
+    uint64_t operator()(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                        const S3Url &sourceUrl) {
+        data.assign(content.begin() + offset, content.begin() + offset + len);
+        return len;
+    }
+
+   private:
+    string content;
+};
+
+static string readRange(S3KeyReader &reader, const string &content, uint64_t start, uint64_t end) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(content.size());
+    params.setChunkSize(4);
+    params.setRange(start, end);
+
+    reader.open(params);
+
+    // read with small buffer to cross chunks and lines
+    string result;
+    char buf[3];
+    uint64_t len;
+    while ((len = reader.read(buf, sizeof(buf))) != 0) {
+        result.append(buf, len);
+    }
+
+    reader.close();
+    return result;
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeSkipsHeadLineAndCompletesTailLine) {
+    string content = "aaa\nbbbb\ncc\ndddd\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    EXPECT_EQ("bbbb\ncc\n", readRange(*this, content, 2, 10));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeStartsAndEndsAtLineBoundary) {
+    string content = "aaa\nbbbb\ncc\ndddd\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    EXPECT_EQ("aaa\n", readRange(*this, content, 0, 4));
+    EXPECT_EQ("bbbb\n", readRange(*this, content, 4, 9));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeInsideOneLine) {
+    string content = "aaaaaaaaaaaa\nbb\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    EXPECT_EQ("", readRange(*this, content, 3, 9));
+}
+
+TEST_F(S3KeyReaderTest, ReadLastRangeWithoutEol) {
+    string content = "aaa\nbbb";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    EXPECT_EQ("bbb\n", readRange(*this, content, 2, 7));
+}
+
+// Lend until EOF, collect the data.
+static string lendAll(Reader &reader, uint64_t count) {
+    string result;
+    const char *data = NULL;
+    uint64_t len;
+    while ((len = reader.lend(&data, count)) != 0) {
+        result.append(data, len);
+        reader.giveBack();
+    }
+    reader.giveBack();
+
+    return result;
+}
+
+TEST_F(S3KeyReaderTest, LendDataOfChunks) {
+    string content = "aaa\nbbbb\ncc\ndddd\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(content.size());
+    params.setChunkSize(4);
+
+    this->open(params);
+
+    // data of a chunk is lent in place.
+    const char *first = NULL;
+    EXPECT_EQ((uint64_t)3, this->lend(&first, 3));
+    this->giveBack();
+
+    const char *next = NULL;
+    EXPECT_EQ((uint64_t)1, this->lend(&next, 3));
+    EXPECT_EQ(first + 3, next);
+    EXPECT_EQ("aaa\n", string(first, 4));
+    this->giveBack();
+
+    EXPECT_EQ(content.substr(4), lendAll(*this, 3));
+}
+
+TEST_F(S3KeyReaderTest, LendLastLineWithoutEol) {
+    string content = "aaa\nbbb";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(content.size());
+    params.setChunkSize(3);
+
+    this->open(params);
+
+    EXPECT_EQ("aaa\nbbb\n", lendAll(*this, 2));
+}
+
+TEST_F(S3KeyReaderTest, LendRangeSkipsHeadLineAndCompletesTailLine) {
+    string content = "aaa\nbbbb\ncc\ndddd\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(content.size());
+    params.setChunkSize(4);
+    params.setRange(2, 10);
+
+    this->open(params);
+
+    EXPECT_EQ("bbbb\ncc\n", lendAll(*this, 3));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangesWithCRLFCoverEveryLineOnce) {
+    eolString[0] = '\r';
+    eolString[1] = '\n';
+    eolString[2] = '\0';
+
+    string content = "a\r\nbbbbbbbbbbbb\r\ncc\r\n\r\nddddd\re\r\nf\r\n";
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    for (uint64_t rangeSize = 1; rangeSize <= content.size(); rangeSize++) {
+        string result;
+        for (uint64_t start = 0; start < content.size(); start += rangeSize) {
+            result += readRange(*this, content, start, std::min(start + rangeSize, content.size()));
+        }
+        EXPECT_EQ(content, result) << "range size: " << rangeSize;
+    }
+}
+
+TEST_F(S3KeyReaderTest, ReadFromDiskCacheOnSecondScan) {
+    char dir[] = "/tmp/gpcloud_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+    string content = "aaa\nbbbb\ncc\ndddd\n";
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(content.size());
+    params.setChunkSize(4);
+    params.setKeyETag("\"abc\"");
+    params.setCacheDir(dir);
+    params.setCacheSize(1024);
+
+    // only the first scan downloads the 5 chunks.
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .Times(5)
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    uint64_t hits = S3DiskCache::getInstance().getStats().numOfHits;
+
+    for (int scan = 0; scan < 2; scan++) {
+        this->open(params);
+
+        string result;
+        uint64_t len;
+        while ((len = this->read(buffer, sizeof(buffer))) != 0) {
+            result.append(buffer, len);
+        }
+        this->close();
+
+        EXPECT_EQ(content, result);
+    }
+
+    EXPECT_EQ(hits + 5, S3DiskCache::getInstance().getStats().numOfHits);
+
+    S3DiskCache::getInstance().configure("", 0);
+    string cleanup = string("rm -rf ") + dir;
+    EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
 TEST_F(S3KeyReaderTest, MTReadWith2Chunks) {
     S3Params params("s3://abc/def");
 
@@ -831,6 +1154,57 @@ TEST_F(S3KeyReaderTest, MTReadWithHundredsOfThreadsAndSignalCancel) {
     EXPECT_THROW(this->read(buffer, 31), S3QueryAbort);
 }
 
+TEST_F(S3KeyReaderTest, ReadWithTunedChunkSize) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(4);
+    params.setKeySize(255);
+    params.setChunkSize(128);
+    params.setMinChunkSize(32);
+
+    // chunks of the key for all threads.
+    EXPECT_CALL(s3Interface, fetchData(0, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(64, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(128, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(192, _, 63, _)).WillOnce(Invoke(MockFetchData(63, 63)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 128));
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 128));
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 128));
+    EXPECT_EQ((uint64_t)63, this->read(buffer, 128));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 128));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 128));
+}
+
+TEST_F(S3KeyReaderTest, MTReadInOrderWhileTuning) {
+    string content;
+    for (uint64_t i = 0; i < 10000; i++) {
+        content.push_back('a' + i % 26);
+    }
+
+    EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+        .WillRepeatedly(Invoke(MockFetchContent(content)));
+
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(8);
+    params.setMinNumOfChunks(1);
+    params.setKeySize(content.size());
+    params.setChunkSize(64);
+    params.setMinChunkSize(8);
+
+    this->open(params);
+
+    string result;
+    uint64_t len;
+    while ((len = this->read(buffer, 100)) != 0) {
+        result.append(buffer, len);
+    }
+
+    EXPECT_EQ(content + "\n", result);
+    EXPECT_EQ((uint64_t)64, this->getDownloadTuner().getChunkSize());
+}
+
 TEST(ChunkBuffer, ChunkBufferOperatorEqual) {
     S3Url s3Url("s3://whatever");
     S3KeyReader reader;
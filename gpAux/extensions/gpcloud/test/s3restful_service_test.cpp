@@ -320,3 +320,38 @@ TEST(S3RESTfulService, DISABLED_DeleteToDummyServerWithData) {
     Response resp = service.deleteRequest(url, headers);
     EXPECT_EQ(RESPONSE_OK, resp.getStatus());
 }
+
+TEST(CURLHandlePool, ReuseIdleHandles) {
+    CURLHandlePool pool;
+    pool.setMaxSize(1);
+
+    CURL *first = pool.acquire();
+    CURL *second = pool.acquire();
+    ASSERT_TRUE(first != NULL);
+    ASSERT_TRUE(second != NULL);
+    EXPECT_NE(first, second);
+
+    pool.release(first);
+    pool.release(second);
+    EXPECT_EQ((uint64_t)1, pool.getNumOfIdleHandles());
+
+    EXPECT_EQ(first, pool.acquire());
+    EXPECT_EQ((uint64_t)0, pool.getNumOfIdleHandles());
+    pool.release(first);
+
+    pool.setMaxSize(0);
+    EXPECT_EQ((uint64_t)0, pool.getNumOfIdleHandles());
+}
+
+TEST(CURLHandlePool, CountRequestWithoutNewConnection) {
+    CURLHandlePool pool;
+
+    CURL *curl = pool.acquire();
+    pool.recordRequest(curl);
+    pool.release(curl);
+
+    CURLConnectionStats stats = pool.getStats();
+    EXPECT_EQ((uint64_t)1, stats.numOfRequests);
+    EXPECT_EQ((uint64_t)0, stats.numOfNewConnections);
+    EXPECT_EQ((uint64_t)1, stats.numOfReusedConnections);
+}
@@ -246,6 +246,8 @@ static void close_ds_write(DatumStreamWrite **ds, int nvp)
 }
 
 
+static void aocs_end_batchmode(AOCSScanDesc scan);
+
 static void aocs_initscan(AOCSScanDesc scan)
 {
     scan->cur_seg = -1;
@@ -473,6 +475,13 @@ void aocs_rescan(AOCSScanDesc scan)
     close_cur_scan_seg(scan);
     close_ds_read(scan->ds, scan->relationTupleDesc->natts);
     aocs_initscan(scan);
+
+	if (scan->batch)
+	{
+		scan->batch->nrows = 0;
+		scan->batch->nextrow = 0;
+		scan->batch->segExhausted = false;
+	}
 }
 
 void aocs_endscan(AOCSScanDesc scan)
@@ -499,9 +508,318 @@ void aocs_endscan(AOCSScanDesc scan)
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 
+	if (scan->batch)
+		aocs_end_batchmode(scan);
+
     pfree(scan);
 }
 
+/*
+ * aocs_begin_batchmode
+ *
+ * Switch the scan to batch mode (see cdbaocsam.h), filtering every batch
+ * with the given quals. Returns false, leaving the scan in tuple-at-a-time
+ * mode, if the scan cannot use batch mode.
+ */
+bool
+aocs_begin_batchmode(AOCSScanDesc scan, AOCSBatchQual *quals, int nquals)
+{
+	int			nvp = scan->relationTupleDesc->natts;
+	AOCSBatch  *batch;
+	int			i;
+
+	Assert(scan->batch == NULL);
+
+	/* The block directory is built as the rows are returned */
+	if (scan->blockDirectory)
+		return false;
+
+	for (i = 0; i < nvp; i++)
+	{
+		if (scan->proj[i] && !scan->relationTupleDesc->attrs[i]->attbyval)
+			return false;
+	}
+
+	batch = (AOCSBatch *) palloc0(sizeof(AOCSBatch));
+	batch->values = (Datum **) palloc0(sizeof(Datum *) * nvp);
+	batch->nulls = (bool **) palloc0(sizeof(bool *) * nvp);
+	for (i = 0; i < nvp; i++)
+	{
+		if (scan->proj[i])
+		{
+			batch->values[i] = (Datum *) palloc(sizeof(Datum) * AOCS_BATCH_SIZE);
+			batch->nulls[i] = (bool *) palloc(sizeof(bool) * AOCS_BATCH_SIZE);
+		}
+	}
+	batch->rowNums = (int64 *) palloc(sizeof(int64) * AOCS_BATCH_SIZE);
+	batch->selected = (bool *) palloc(sizeof(bool) * AOCS_BATCH_SIZE);
+
+	if (nquals > 0)
+	{
+		for (i = 0; i < nquals; i++)
+			Assert(quals[i].attno < nvp && scan->proj[quals[i].attno]);
+
+		batch->quals = (AOCSBatchQual *) palloc(sizeof(AOCSBatchQual) * nquals);
+		memcpy(batch->quals, quals, sizeof(AOCSBatchQual) * nquals);
+	}
+	batch->nquals = nquals;
+
+	scan->batch = batch;
+	return true;
+}
+
+static void
+aocs_end_batchmode(AOCSScanDesc scan)
+{
+	AOCSBatch  *batch = scan->batch;
+	int			i;
+
+	for (i = 0; i < scan->relationTupleDesc->natts; i++)
+	{
+		if (batch->values[i])
+		{
+			pfree(batch->values[i]);
+			pfree(batch->nulls[i]);
+		}
+	}
+	pfree(batch->values);
+	pfree(batch->nulls);
+	pfree(batch->rowNums);
+	pfree(batch->selected);
+	if (batch->quals)
+		pfree(batch->quals);
+	pfree(batch);
+
+	scan->batch = NULL;
+}
+
+/*
+ * Read up to nrows values of column i into the batch, moving on to the next
+ * blocks as needed. Returns the number of values read, which is less than
+ * nrows only at the end of the segment file.
+ */
+static int
+aocs_batch_read_column(AOCSScanDesc scan, int i, int nrows)
+{
+	DatumStreamRead *ds = scan->ds[i];
+	Datum	   *values = scan->batch->values[i];
+	bool	   *nulls = scan->batch->nulls[i];
+	int64	   *rowNums = scan->batch->rowNums;
+	int			err;
+	int			r;
+
+	for (r = 0; r < nrows; r++)
+	{
+		err = datumstreamread_advance(ds);
+		Assert(err >= 0);
+		if (err == 0)
+		{
+			err = datumstreamread_block(ds, scan->blockDirectory, i);
+			if (err < 0)
+				break;
+
+			err = datumstreamread_advance(ds);
+			Assert(err > 0);
+		}
+
+		datumstreamread_get(ds, &values[r], &nulls[r]);
+
+		if (rowNums[r] == INT64CONST(-1) &&
+			ds->blockFirstRowNum != INT64CONST(-1))
+		{
+			Assert(ds->blockFirstRowNum > 0);
+			rowNums[r] = ds->blockFirstRowNum + datumstreamread_nth(ds);
+		}
+	}
+
+	return r;
+}
+
+/*
+ * The batch qual loops below are branch-free so that the compiler can
+ * vectorise them. A NULL never passes a strict comparison. A float8 NaN
+ * (the only value for which v != v) is let through, since NaN sorts above
+ * all other values in PostgreSQL but not in C; the executor's qual decides
+ * about it.
+ */
+#define AOCS_BATCH_FILTER(ctype, getter, cmpop) \
+	do { \
+		ctype		c = getter(qual->value); \
+		for (r = 0; r < nrows; r++) \
+		{ \
+			ctype		v = getter(values[r]); \
+			selected[r] = selected[r] & !nulls[r] & ((v cmpop c) | (v != v)); \
+		} \
+	} while (0)
+
+#define AOCS_BATCH_FILTER_OPS(ctype, getter) \
+	do { \
+		switch (qual->op) \
+		{ \
+			case AOCSBatchQualOp_Eq: AOCS_BATCH_FILTER(ctype, getter, ==); break; \
+			case AOCSBatchQualOp_Ne: AOCS_BATCH_FILTER(ctype, getter, !=); break; \
+			case AOCSBatchQualOp_Lt: AOCS_BATCH_FILTER(ctype, getter, <); break; \
+			case AOCSBatchQualOp_Le: AOCS_BATCH_FILTER(ctype, getter, <=); break; \
+			case AOCSBatchQualOp_Gt: AOCS_BATCH_FILTER(ctype, getter, >); break; \
+			case AOCSBatchQualOp_Ge: AOCS_BATCH_FILTER(ctype, getter, >=); break; \
+		} \
+	} while (0)
+
+static void
+aocs_batch_filter(AOCSBatch *batch, AOCSBatchQual *qual, int nrows)
+{
+	Datum	   *values = batch->values[qual->attno];
+	bool	   *nulls = batch->nulls[qual->attno];
+	bool	   *selected = batch->selected;
+	int			r;
+
+	switch (qual->type)
+	{
+		case AOCSBatchQualType_Int2:
+			AOCS_BATCH_FILTER_OPS(int16, DatumGetInt16);
+			break;
+		case AOCSBatchQualType_Int4:
+			AOCS_BATCH_FILTER_OPS(int32, DatumGetInt32);
+			break;
+		case AOCSBatchQualType_Int8:
+			AOCS_BATCH_FILTER_OPS(int64, DatumGetInt64);
+			break;
+		case AOCSBatchQualType_Float8:
+			AOCS_BATCH_FILTER_OPS(float8, DatumGetFloat8);
+			break;
+	}
+}
+
+/*
+ * Decode the next batch of rows of the scan, opening the next segment file
+ * when the current one is exhausted, and apply the batch quals to it.
+ * Returns the number of rows in the batch, 0 at the end of the scan.
+ */
+static int
+aocs_batch_fill(AOCSScanDesc scan)
+{
+	AOCSBatch  *batch = scan->batch;
+	int			nvp = scan->relationTupleDesc->natts;
+	int			nrows = 0;
+	int			i;
+	int			r;
+
+	batch->nrows = 0;
+	batch->nextrow = 0;
+
+	while (nrows == 0)
+	{
+		/* If necessary, open next seg */
+		if (scan->cur_seg < 0 || batch->segExhausted)
+		{
+			if (batch->segExhausted)
+			{
+				close_cur_scan_seg(scan);
+				batch->segExhausted = false;
+			}
+
+			if (open_next_scan_seg(scan) < 0)
+			{
+				/* No more seg, we are at the end */
+				scan->cur_seg = -1;
+				return 0;
+			}
+			scan->cur_seg_row = 0;
+		}
+
+		for (r = 0; r < AOCS_BATCH_SIZE; r++)
+			batch->rowNums[r] = INT64CONST(-1);
+
+		/*
+		 * All the columns of a segment file have the same number of rows, so
+		 * the first projected column decides how many rows the batch has.
+		 */
+		nrows = AOCS_BATCH_SIZE;
+		for (i = 0; i < nvp && nrows > 0; i++)
+		{
+			int			nread;
+
+			if (!scan->proj[i])
+				continue;
+
+			nread = aocs_batch_read_column(scan, i, nrows);
+			if (nread < nrows)
+			{
+				batch->segExhausted = true;
+				nrows = nread;
+			}
+		}
+	}
+
+	for (r = 0; r < nrows; r++)
+	{
+		if (batch->rowNums[r] == INT64CONST(-1))
+			batch->rowNums[r] = scan->cur_seg_row + r + 1;
+		batch->selected[r] = true;
+	}
+	scan->cur_seg_row += nrows;
+
+	for (i = 0; i < batch->nquals; i++)
+		aocs_batch_filter(batch, &batch->quals[i], nrows);
+
+	batch->nrows = nrows;
+	return nrows;
+}
+
+/*
+ * aocs_getnext for scans in batch mode: return the next row of the current
+ * batch that passed the batch quals and is visible.
+ */
+static void
+aocs_getnext_batch(AOCSScanDesc scan, TupleTableSlot *slot)
+{
+	AOCSBatch  *batch = scan->batch;
+	int			ncol = slot->tts_tupleDescriptor->natts;
+	Datum	   *d = slot_get_values(slot);
+	bool	   *null = slot_get_isnull(slot);
+	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+	AOTupleId	aoTupleId;
+	int			r;
+	int			i;
+
+	Assert(ncol <= scan->relationTupleDesc->natts);
+
+	while (1)
+	{
+		if (batch->nextrow >= batch->nrows && aocs_batch_fill(scan) == 0)
+		{
+			ExecClearTuple(slot);
+			return;
+		}
+
+		r = batch->nextrow++;
+		if (!batch->selected[r])
+			continue;
+
+		AOTupleIdInit_Init(&aoTupleId);
+		AOTupleIdInit_segmentFileNum(&aoTupleId,
+									 scan->seginfo[scan->cur_seg]->segno);
+		AOTupleIdInit_rowNum(&aoTupleId, batch->rowNums[r]);
+
+		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
+			continue;
+
+		for (i = 0; i < ncol; i++)
+		{
+			if (scan->proj[i])
+			{
+				d[i] = batch->values[i][r];
+				null[i] = batch->nulls[i][r];
+			}
+		}
+		scan->cdb_fake_ctid = *((ItemPointer)&aoTupleId);
+
+		TupSetVirtualTupleNValid(slot, ncol);
+		slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+		return;
+	}
+}
+
 void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 {
 	int ncol;
@@ -516,6 +834,12 @@ void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *sl
 
 	Assert(ScanDirectionIsForward(direction));
 
+	if (scan->batch)
+	{
+		aocs_getnext_batch(scan, slot);
+		return;
+	}
+
 	ncol = slot->tts_tupleDescriptor->natts;
 	Assert(ncol <= scan->relationTupleDesc->natts);
 
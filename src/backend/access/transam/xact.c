@@ -61,6 +61,7 @@
 #include "access/distributedlog.h"
 #include "access/clog.h"
 #include "utils/vmem_tracker.h"
+#include "codegen/codegen_wrapper.h"
 
 #include "cdb/cdbgang.h"
 #include "cdb/cdbvars.h" /* Gp_role, Gp_is_writer, interconnect_setup_timeout */
@@ -3857,6 +3858,12 @@ AbortTransaction(void)
 	AfterTriggerEndXact(false);
 	AtAbort_Portals();
 
+	/*
+	 * Failed portals skip ExecutorEnd, so join the background compilations of
+	 * their code generator managers here.
+	 */
+	CodeGeneratorManagerAbortPending();
+
 	AtEOXact_SharedSnapshot();
 
 	/* Perform any Resource Scheduler abort procesing. */
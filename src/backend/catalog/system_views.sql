@@ -186,10 +186,12 @@ CREATE VIEW pg_prepared_xacts AS
          LEFT JOIN pg_database D ON P.dbid = D.oid;
 
 CREATE VIEW pg_prepared_statements AS
-    SELECT P.name, P.statement, P.prepare_time, P.parameter_types, P.from_sql
+    SELECT P.name, P.statement, P.prepare_time, P.parameter_types, P.from_sql,
+           P.generic_plans, P.custom_plans
     FROM pg_prepared_statement() AS P
     (name text, statement text, prepare_time timestamptz,
-     parameter_types regtype[], from_sql boolean);
+     parameter_types regtype[], from_sql boolean,
+     generic_plans int8, custom_plans int8);
 
 CREATE VIEW pg_settings AS 
     SELECT * 
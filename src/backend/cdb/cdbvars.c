@@ -191,6 +191,13 @@ int			Gp_interconnect_min_rto = 20;
 int			Gp_interconnect_fc_method = INTERCONNECT_FC_METHOD_LOSS;
 int			Gp_interconnect_transmit_timeout = 3600;
 int			Gp_interconnect_min_retries_before_timeout = 100;
+int			Gp_interconnect_mmsg_batch_size = 16;
+int			Gp_interconnect_rx_threads = 1;
+bool		gp_interconnect_shm_transport = false;
+
+bool		gp_interconnect_compress = false;
+
+int			Gp_motion_hash_batch_size = 64;
 
 int			Gp_interconnect_hash_multiplier = 2;		/* sets the size of the
 														 * hash table used by
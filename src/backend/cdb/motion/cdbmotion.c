@@ -21,6 +21,7 @@
 #include "cdb/ml_ipc.h"
 #include "cdb/tupser.h"
 #include "libpq/pqformat.h"
+#include "utils/pg_lzcompress.h"
 #include "utils/memutils.h"
 #include "utils/typcache.h"
 
@@ -60,6 +61,10 @@ static void processIncomingChunks(MotionLayerState *mlStates,
 								  int16 motNodeID,
 								  int16 srcRoute);
 
+static TupleChunkListItem decompressChunk(MotionNodeEntry * pMNEntry,
+										  TupleChunkListItem tcItem,
+										  TupleChunkListItem tcNext);
+
 static inline void reconstructTuple(MotionNodeEntry * pMNEntry, ChunkSorterEntry * pCSEntry, TupleRemapper *remapper);
 
 /* Stats-function declarations. */
@@ -359,6 +364,10 @@ UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserve
 	pEntry->stat_total_chunks_recvd = 0;
 	pEntry->stat_total_bytes_recvd = 0;
 	pEntry->stat_tuple_bytes_recvd = 0;
+	pEntry->stat_compress_bytes_in = 0;
+	pEntry->stat_compress_bytes_out = 0;
+	pEntry->stat_decompress_bytes_in = 0;
+	pEntry->stat_decompress_bytes_out = 0;
 	pEntry->sel_rd_wait = 0;
 	pEntry->sel_wr_wait = 0;
 
@@ -750,12 +759,24 @@ processIncomingChunks(MotionLayerState *mlStates,
 
 	while (tcItem != NULL)
 	{
-		numChunks++;
+		TupleChunkType tcType;
 
 		/* Detach the current chunk off of the front of the list. */
 		tcNext = tcItem->p_next;
 		tcItem->p_next = NULL;
 
+		/* A compressed chunk stands for the chunks it holds. */
+		GetChunkType(tcItem, &tcType);
+		if (tcType == TC_COMPRESSED)
+		{
+			tcNext = decompressChunk(pMNEntry, tcItem, tcNext);
+			pfree(tcItem);
+			tcItem = tcNext;
+			continue;
+		}
+
+		numChunks++;
+
 		/* Track stats. */
 		chunkBytes += tcItem->chunk_length;
 		if (tcItem->chunk_length >= TUPLE_CHUNK_HEADER_SIZE)
@@ -784,6 +805,118 @@ processIncomingChunks(MotionLayerState *mlStates,
 	MemoryContextSwitchTo(oldCtxt);
 }
 
+/*
+ * Decompress a TC_COMPRESSED chunk, built by compressPacket() of the UDP
+ * interconnect, and return the chunks it held followed by tcNext.
+ *
+ * Like the chunks of a receive buffer, the returned chunks point in place
+ * into the decompression buffer, which is reused for the next compressed
+ * chunk.  That is safe for the same reason it is safe to give the receive
+ * buffer back at the end of processIncomingChunks(): addChunkToSorter()
+ * materializes the chunks it has to keep.
+ */
+static TupleChunkListItem
+decompressChunk(MotionNodeEntry * pMNEntry,
+				TupleChunkListItem tcItem,
+				TupleChunkListItem tcNext)
+{
+	static char *decompressBuffer = NULL;
+	static int	decompressBufferSize = 0;
+
+	const PGLZ_Header *compressed;
+	TupleChunkListItem firstItem = NULL;
+	TupleChunkListItem lastItem = NULL;
+	uint16		compressedSize;
+	int32		rawSize;
+	int			pos;
+	TupleChunkType tcType;
+
+	if (tcItem->chunk_length < TUPLE_CHUNK_HEADER_SIZE)
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+						errdetail("chunk length %u < chunk-header %d",
+								  tcItem->chunk_length, TUPLE_CHUNK_HEADER_SIZE)));
+
+	compressed = (const PGLZ_Header *) (GetChunkDataPtr(tcItem) + TUPLE_CHUNK_HEADER_SIZE);
+	GetChunkDataSize(tcItem, &compressedSize);
+
+	/*
+	 * pglz_decompress() trusts its input: it reads VARSIZE bytes and writes
+	 * rawsize bytes.  So the compressed data has to lie within the packet
+	 * and the raw data has to fit the decompression buffer.
+	 */
+	if (compressedSize < sizeof(PGLZ_Header) ||
+		compressedSize > tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE ||
+		VARSIZE(compressed) != compressedSize)
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+						errdetail("chunk data size %d, chunk length %u",
+								  compressedSize, tcItem->chunk_length)));
+
+	if (decompressBuffer == NULL || decompressBufferSize < Gp_max_packet_size)
+	{
+		if (decompressBuffer != NULL)
+			pfree(decompressBuffer);
+		decompressBuffer = MemoryContextAlloc(TopMemoryContext, Gp_max_packet_size);
+		decompressBufferSize = Gp_max_packet_size;
+	}
+
+	rawSize = PGLZ_RAW_SIZE(compressed);
+	if (rawSize <= 0 || rawSize > decompressBufferSize)
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+						errdetail("raw size %d, decompression buffer size %d",
+								  rawSize, decompressBufferSize)));
+
+	pglz_decompress(compressed, decompressBuffer);
+
+	for (pos = 0; pos < rawSize;)
+	{
+		TupleChunkListItem item;
+		uint16		size;
+
+		if (rawSize - pos < TUPLE_CHUNK_HEADER_SIZE)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+							errdetail("%d bytes left < chunk-header %d",
+									  rawSize - pos, TUPLE_CHUNK_HEADER_SIZE)));
+
+		memcpy(&size, decompressBuffer + pos, sizeof(uint16));
+		if (TUPLE_CHUNK_HEADER_SIZE + size > rawSize - pos)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+							errdetail("chunk size %d > %d bytes left",
+									  TUPLE_CHUNK_HEADER_SIZE + size, rawSize - pos)));
+
+		item = (TupleChunkListItem) palloc0(sizeof(TupleChunkListItemData));
+		item->chunk_length = TUPLE_CHUNK_HEADER_SIZE + size;
+		item->inplace = decompressBuffer + pos;
+
+		GetChunkType(item, &tcType);
+		if (tcType == TC_COMPRESSED)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error: corrupt compressed tuple-chunk received."),
+							errdetail("compressed chunk nested in a compressed chunk")));
+
+		if (firstItem == NULL)
+			firstItem = item;
+		else
+			lastItem->p_next = item;
+		lastItem = item;
+
+		pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, item->chunk_length);
+	}
+
+	pMNEntry->stat_decompress_bytes_in += tcItem->chunk_length;
+	pMNEntry->stat_decompress_bytes_out += rawSize;
+
+	if (lastItem == NULL)
+		return tcNext;
+
+	lastItem->p_next = tcNext;
+	return firstItem;
+}
+
 void
 EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLayer)
 {
@@ -689,6 +689,8 @@ createChunkTransportState(ChunkTransportState *transportStates,
     pEntry->numConns = numPrimaryConns;
 	pEntry->numPrimaryConns = numPrimaryConns;
     pEntry->scanStart = 0;
+	pEntry->compressSkip = 0;
+	pEntry->compressBackoff = 0;
     pEntry->sendSlice = sendSlice;
     pEntry->recvSlice = recvSlice;
 
@@ -33,6 +33,7 @@
 #include "utils/builtins.h"
 #include "utils/debugbreak.h"
 #include "utils/faultinjector.h"
+#include "utils/pg_lzcompress.h"
 #include "port/atomics.h"
 #include "port/pg_crc32c.h"
 #include "storage/pmsignal.h"
@@ -51,6 +52,11 @@
 #include <arpa/inet.h>
 #include "pgtime.h"
 #include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
 
 #include "port.h"
 
@@ -134,6 +140,13 @@ timeoutArray[] =
 /* 1/4 sec in msec */
 #define RX_THREAD_POLL_TIMEOUT (250)
 
+/* upper bound of gp_interconnect_rx_threads */
+#define MAX_RX_THREADS (16)
+
+/* packets sent uncompressed after a failed compression, see compressPacket() */
+#define MIN_COMPRESS_BACKOFF (8)
+#define MAX_COMPRESS_BACKOFF (1024)
+
 /*
  * Flags definitions for flag-field of UDP-messages
  *
@@ -286,6 +299,12 @@ struct ReceiveControlInfo
 	 * cases.
 	 */
 	DistributedTransactionId lastDXatId;
+
+	/*
+	 * The number of rx buffers reserved for the background thread to receive a
+	 * batch of packets into.
+	 */
+	int rxBatchSize;
 };
 
 /*
@@ -380,6 +399,86 @@ struct SendControlInfo
  */
 static SendControlInfo snd_control_info;
 
+/*
+ * ICShmRing
+ *
+ * A ring of packets in POSIX shared memory, written by one sender process and
+ * read by one rx thread of one receiver process on the same host.
+ *
+ * When gp_interconnect_shm_transport is on and the peer of a connection has the
+ * same listener address as we do, the sender copies all data packets of the
+ * connection into the ring instead of sending them to the socket, so they are
+ * never reordered against packets sent through UDP. The rest of the protocol is
+ * unchanged: the receiver acks the packets through UDP, and a packet which does
+ * not fit into the ring is lost and retransmitted by the retransmit logic. Only
+ * once the receiver has detached, the packets go to the socket, where they are
+ * handled like the ones of any torn down connection.
+ *
+ * The ring has gp_interconnect_queue_depth slots of gp_max_packet_size bytes,
+ * both are dispatched to every process of the query: the sender never has more
+ * packets than the queue depth of the receiver unacked, so only retransmits can
+ * find the ring full.
+ *
+ * The ring is created zero-filled by whichever side comes first, which is a valid
+ * empty ring. Its name is removed as soon as both sides have mapped it, so that
+ * a ring is not left behind in /dev/shm when a process dies without detaching.
+ *
+ * head            - the number of packets written, advanced by the sender.
+ * tail            - the number of packets read, advanced by the receiver.
+ * detached        - set by the receiver when it stops draining the ring.
+ * receiverWaiting - set by the receiver before it sleeps in poll(), the sender wakes
+ *                   it up with a SHM_WAKEUP_SIZE datagram.
+ * mapped          - the number of sides that have mapped the ring.
+ * senderAddr      - the address of the socket the sender sends from, the receiver
+ *                   sends the acks there. Written before the first packet.
+ */
+typedef struct ICShmRing
+{
+	pg_atomic_uint32 head;
+	pg_atomic_uint32 tail;
+	pg_atomic_uint32 detached;
+	pg_atomic_uint32 receiverWaiting;
+	pg_atomic_uint32 mapped;
+
+	struct sockaddr_storage senderAddr;
+	socklen_t	senderAddrLen;
+
+	/* followed by the slots, at SHM_RING_SLOTS_OFFSET */
+} ICShmRing;
+
+#define SHM_RING_SLOTS_OFFSET MAXALIGN(sizeof(ICShmRing))
+#define SHM_CHANNEL_SLOT(channel, seq) \
+	((icpkthdr *) ((char *) (channel)->ring + SHM_RING_SLOTS_OFFSET + \
+				   ((seq) % (channel)->nslots) * (channel)->slotSize))
+
+/*
+ * The wakeup of a shared memory channel is the start of a packet header, up to
+ * srcPid, so that the socket group delivers it to the thread owning the channel.
+ */
+#define SHM_WAKEUP_SIZE offsetof(icpkthdr, srcListenerPort)
+
+/*
+ * ICShmChannel
+ *
+ * The mapping of an ICShmRing of one connection in this process.
+ */
+typedef struct ICShmChannel ICShmChannel;
+struct ICShmChannel
+{
+	char		name[64];
+	ICShmRing  *ring;
+	Size		size;
+	uint32		nslots;
+	uint32		slotSize;
+	bool		isReceiver;
+
+	/* the rx thread draining the channel, see rxThreadOfSender() */
+	int			owner;
+
+	/* next receiving channel in ic_control_info.shmChannels[owner] */
+	ICShmChannel *next;
+};
+
 /*
  * ICGlobalControlInfo
  *
@@ -390,12 +489,26 @@ static SendControlInfo snd_control_info;
 typedef struct ICGlobalControlInfo ICGlobalControlInfo;
 struct ICGlobalControlInfo
 {
-	/* The background thread handle. */
-	pthread_t threadHandle;
+	/* The background thread handles. */
+	pthread_t threadHandles[MAX_RX_THREADS];
 
-	/* Flag showing whether the thread is created. */
+	/* Flag showing whether the threads are created. */
 	bool threadCreated;
 
+	/* The number of background threads created. */
+	int numThreads;
+
+	/*
+	 * The sockets the background threads receive from, one per thread.
+	 * rxSockets[0] is ICListenerSocket, the others are bound to the same port
+	 * with SO_REUSEPORT once it is known. The filter of the group picks the
+	 * socket of a packet by the srcPid of its header, so all packets of a
+	 * connection are handled by the same thread and stay in order, and no
+	 * socket joining the group after ours is ever picked.
+	 */
+	int numRxSockets;
+	int rxSockets[MAX_RX_THREADS];
+
 	/* The lock protecting eno field. */
 	pthread_mutex_t	errorLock;
 	int  eno;
@@ -432,6 +545,13 @@ struct ICGlobalControlInfo
     /* The connection htab used to cache future packets. */
 	ConnHashTable startupCacheHtab;
 
+	/*
+	 * The shared memory channels of receiving connections, one list per
+	 * background thread which drains them. Protected by the lock in this
+	 * data structure.
+	 */
+	ICShmChannel *shmChannels[MAX_RX_THREADS];
+
 	/* Used by main thread to ask the background thread to exit. */
 	uint32 shutdown;
 };
@@ -521,6 +641,28 @@ static ICGlobalControlInfo ic_control_info;
 
 #define MAX_SEQS_IN_DISORDER_ACK (4)
 
+/*
+ * Packets are received and sent in batches of up to gp_interconnect_mmsg_batch_size
+ * packets with recvmmsg() and sendmmsg() where they are available, which saves
+ * system calls when a motion moves many packets. MAX_MMSG_BATCH_SIZE is the upper
+ * bound of the guc.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define UDPIC_USE_MMSG
+#endif
+
+#define MAX_MMSG_BATCH_SIZE (64)
+
+/*
+ * More than one rx-thread needs the receive sockets to be a SO_REUSEPORT
+ * group, and any other process of the same user could join that group and
+ * be handed a share of our packets. So the group is only used where a classic
+ * BPF program can be attached to it, see setRxSocketFilter().
+ */
+#if defined(__linux__) && defined(SO_REUSEPORT) && defined(SO_ATTACH_REUSEPORT_CBPF)
+#define UDPIC_USE_REUSEPORT
+#endif
+
 /*
  * UnackQueueRing
  *
@@ -599,6 +741,12 @@ typedef struct AckSendParam
  * duplicatedPktNum          - duplicate packet number.
  * recvAckNum                - the number of Acks received.
  * statusQueryMsgNum         - the number of status query messages sent.
+ * sndSyscallNum             - the number of system calls used to send the sndPktNum packets.
+ * recvSyscallNum            - the number of system calls used to receive packets by rx thread.
+ * sndAckNum                 - the number of Acks sent by rx thread after processing a batch.
+ * sndAckSyscallNum          - the number of system calls used to send the sndAckNum Acks.
+ * sndShmPktNum              - the number of packets sent through shared memory channels.
+ * recvShmPktNum             - the number of packets received from shared memory channels.
  *
  */
 typedef struct ICStatistics
@@ -619,6 +767,12 @@ typedef struct ICStatistics
 	int32   duplicatedPktNum;
 	int32	recvAckNum;
 	int32	statusQueryMsgNum;
+	int32	sndSyscallNum;
+	int32	recvSyscallNum;
+	int32	sndAckNum;
+	int32	sndAckSyscallNum;
+	int32	sndShmPktNum;
+	int32	recvShmPktNum;
 } ICStatistics;
 
 /* Statistics for UDP interconnect. */
@@ -648,7 +802,11 @@ static void SendDummyPacket(void);
 static void getSockAddr(struct sockaddr_storage * peer, socklen_t * peer_len, const char * listenerAddr, int listenerPort);
 static void setXmitSocketOptions(int txfd);
 static uint32 setSocketBufferSize(int fd, int type, int expectedSize, int leastSize);
-static void setUDPSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily);
+static void setUDPSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily, bool reusePort);
+#ifdef UDPIC_USE_REUSEPORT
+static bool setRxSocketFilter(int fd, const char **fun);
+#endif
+static void setUDPReusePortSocket(int *socketFd, int listenerFd);
 static ChunkTransportStateEntry *startOutgoingUDPConnections(ChunkTransportState *transportStates,
 															 Slice *sendSlice,
 															 int *pOutgoingCount);
@@ -663,6 +821,7 @@ static MotionConn *findConnByHeader(ConnHashTable *ht, icpkthdr *hdr);
 static void destroyConnHashTable(ConnHashTable *ht);
 
 static inline void sendAckWithParam(AckSendParam *param);
+static void sendAcksWithParam(int fd, AckSendParam *params, int count);
 static void sendAck(MotionConn *conn, int32 flags, uint32 seq, uint32 extraSeq);
 static void sendDisorderAck(MotionConn *conn, uint32 seq, uint32 extraSeq, uint32 lostPktCnt);
 static void sendStatusQueryMessage(MotionConn *conn, int fd, uint32 seq);
@@ -726,6 +885,16 @@ static bool dispatcherAYT(void);
 static void checkQDConnectionAlive(void);
 
 
+static const char *getLocalListenerAddr(Slice *mySlice);
+static ICShmChannel *attachShmChannel(MotionConn *conn, int motNodeId, bool isReceiver);
+static void detachShmChannel(MotionConn *conn);
+static bool sendShmPacket(ChunkTransportStateEntry *pEntry, MotionConn *conn, icpkthdr *pkt);
+static int rxThreadOfSender(int32 srcPid);
+static int receiveShmPackets(int owner, icpkthdr **pkts, int count, struct sockaddr_storage *peers, socklen_t *peerLens, int *readCounts);
+static bool armShmChannels(int owner);
+static int receivePackets(int fd, icpkthdr **pkts, int count, struct sockaddr_storage *peers, socklen_t *peerLens, int *readCounts);
+static bool checkRxPacket(icpkthdr *pkt, int read_count);
+static bool handleRxPacket(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t *peerLen, AckSendParam *param);
 static void *rxThreadFunc(void *arg);
 
 static bool handleMismatch(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
@@ -738,10 +907,12 @@ static bool handleAckForDuplicatePkt(MotionConn *conn, icpkthdr *pkt);
 static bool handleAckForDisorderPkt(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, icpkthdr *pkt);
 
 static inline void prepareXmit(MotionConn *conn);
+static void compressPacket(MotionLayerState *mlStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, int16 motionId);
 static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn * conn);
+static void sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer **bufs, int count, MotionConn *conn);
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
@@ -1146,7 +1317,7 @@ resetRxThreadError()
  * 		Setup udp listening socket.
  */
 static void
-setUDPSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily)
+setUDPSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily, bool reusePort)
 {
 	int					errnoSave;
 	int					fd = -1;
@@ -1254,6 +1425,23 @@ setUDPSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily)
 			continue;
 		}
 
+#ifdef UDPIC_USE_REUSEPORT
+		/* let the other receive sockets bind to the same port later. */
+		if (reusePort)
+		{
+			int			on = 1;
+
+			fun = "setsockopt(SO_REUSEPORT)";
+			if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0 ||
+				!setRxSocketFilter(fd, &fun))
+			{
+				closesocket(fd);
+				fd = -1;
+				continue;
+			}
+		}
+#endif
+
 		fun = "bind";
 		elog(DEBUG1,"bind addrlen %d fam %d",rp->ai_addrlen,rp->ai_addr->sa_family);
 		if (bind(fd, rp->ai_addr, rp->ai_addrlen) == 0)
@@ -1311,6 +1499,94 @@ error:
 	return;
 }
 
+#ifdef UDPIC_USE_REUSEPORT
+/*
+ * setRxSocketFilter
+ * 		Attach the socket selection program to the SO_REUSEPORT group of fd.
+ *
+ * The program is run on the UDP payload of every packet, i.e. its icpkthdr,
+ * and returns the index of the socket in the group, in the order the sockets
+ * joined it: srcPid, loaded in network byte order, modulo the number of our
+ * receive sockets. It must be attached before fd is bound, so that it is in
+ * place before anyone else can join the group.
+ */
+static bool
+setRxSocketFilter(int fd, const char **fun)
+{
+	struct sock_filter code[] = {
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(icpkthdr, srcPid)),
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32) ic_control_info.numRxSockets),
+		BPF_STMT(BPF_RET | BPF_A, 0),
+	};
+	struct sock_fprog prog;
+
+	prog.len = lengthof(code);
+	prog.filter = code;
+
+	*fun = "setsockopt(SO_ATTACH_REUSEPORT_CBPF)";
+	return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *) &prog, sizeof(prog)) == 0;
+}
+#endif
+
+/*
+ * setUDPReusePortSocket
+ * 		Setup one more UDP socket bound to the address and port of listenerFd.
+ *
+ * listenerFd must be created with reusePort by setUDPSocket.
+ */
+static void
+setUDPReusePortSocket(int *socketFd, int listenerFd)
+{
+#ifdef UDPIC_USE_REUSEPORT
+	int			errnoSave;
+	int			fd = -1;
+	int			on = 1;
+	const char *fun;
+	struct sockaddr_storage addr;
+	socklen_t	addrLen;
+
+	MemSet(&addr, 0, sizeof(addr));
+	addrLen = sizeof(addr);
+
+	fun = "getsockname";
+	if (getsockname(listenerFd, (struct sockaddr *) &addr, &addrLen) < 0)
+		goto error;
+
+	fun = "socket";
+	fd = socket(addr.ss_family, SOCK_DGRAM, 0);
+	if (fd < 0)
+		goto error;
+
+	fun = "fcntl(O_NONBLOCK)";
+	if (!pg_set_noblock(fd))
+		goto error;
+
+	fun = "setsockopt(SO_REUSEPORT)";
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0)
+		goto error;
+
+	fun = "bind";
+	if (bind(fd, (struct sockaddr *) &addr, addrLen) < 0)
+		goto error;
+
+	setXmitSocketOptions(fd);
+
+	*socketFd = fd;
+	return;
+
+error:
+	errnoSave = errno;
+	if (fd >= 0)
+		closesocket(fd);
+	errno = errnoSave;
+	ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					errmsg("Interconnect Error: Could not set up udp listener socket."),
+					errdetail("%m%s", fun)));
+#else
+	elog(ERROR, "SO_ATTACH_REUSEPORT_CBPF is not supported on this platform");
+#endif
+}
+
 /*
  * InitMutex
  * 		Initialize mutex.
@@ -1333,6 +1609,7 @@ void
 InitMotionUDPIFC(void)
 {
 	int pthread_err;
+	int i;
 
 	/* attributes of the thread we're creating */
 	pthread_attr_t t_atts;
@@ -1357,6 +1634,13 @@ InitMotionUDPIFC(void)
 	pthread_cond_init(&ic_control_info.cond, NULL);
 	ic_control_info.shutdown = 0;
 	ic_control_info.threadCreated = false;
+	ic_control_info.numThreads = 0;
+	MemSet(ic_control_info.shmChannels, 0, sizeof(ic_control_info.shmChannels));
+#ifdef UDPIC_USE_REUSEPORT
+	ic_control_info.numRxSockets = Gp_interconnect_rx_threads;
+#else
+	ic_control_info.numRxSockets = 1;
+#endif
 
 	old = MemoryContextSwitchTo(ic_control_info.memContext);
 
@@ -1368,8 +1652,13 @@ InitMotionUDPIFC(void)
 	/*
 	 * setup listening socket and sending socket for Interconnect.
 	 */
-	setUDPSocket(&ICListenerSocket, &ICListenerPort, NULL);
-	setUDPSocket(&ICSenderSocket, &ICSenderPort, &ICSenderFamily);
+	setUDPSocket(&ICListenerSocket, &ICListenerPort, NULL, ic_control_info.numRxSockets > 1);
+	setUDPSocket(&ICSenderSocket, &ICSenderPort, &ICSenderFamily, false);
+
+	/* setup one more receive socket for every additional rx-thread. */
+	ic_control_info.rxSockets[0] = ICListenerSocket;
+	for (i = 1; i < ic_control_info.numRxSockets; i++)
+		setUDPReusePortSocket(&ic_control_info.rxSockets[i], ICListenerSocket);
 
 	/* Initialize receive control data. */
 	resetMainThreadWaiting(&rx_control_info.mainWaitingState);
@@ -1380,9 +1669,17 @@ InitMotionUDPIFC(void)
 	rx_control_info.lastTornIcId = 0;
 	initCursorICHistoryTable(&rx_control_info.cursorHistoryTable);
 
-	/* Initialize receive buffer pool */
+	/*
+	 * Initialize receive buffer pool, every background thread holds up to
+	 * rxBatchSize buffers to receive packets into.
+	 */
+#ifdef UDPIC_USE_MMSG
+	rx_control_info.rxBatchSize = Gp_interconnect_mmsg_batch_size;
+#else
+	rx_control_info.rxBatchSize = 1;
+#endif
 	rx_buffer_pool.count = 0;
-	rx_buffer_pool.maxCount = 1;
+	rx_buffer_pool.maxCount = rx_control_info.rxBatchSize * ic_control_info.numRxSockets;
 	rx_buffer_pool.freeList = NULL;
 
 	/* Initialize send control data */
@@ -1396,28 +1693,49 @@ InitMotionUDPIFC(void)
 	initMutex(&trans_proto_stats.lock);
 #endif
 
-	/* Start up our rx-thread */
+	/* Start up our rx-threads, one per receive socket */
 
 	/* save ourselves some memory: the defaults for thread stack
 	 * size are large (1M+) */
 	pthread_attr_init(&t_atts);
 
 	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128*1024)));
-	pthread_err = pthread_create(&ic_control_info.threadHandle, &t_atts, rxThreadFunc, NULL);
+	for (i = 0; i < ic_control_info.numRxSockets; i++)
+	{
+		pthread_err = pthread_create(&ic_control_info.threadHandles[i], &t_atts, rxThreadFunc,
+									 (void *) (intptr_t) i);
+		if (pthread_err != 0)
+			break;
+
+		ic_control_info.numThreads++;
+		ic_control_info.threadCreated = true;
+	}
 
 	pthread_attr_destroy(&t_atts);
 	if (pthread_err != 0)
 	{
-		ic_control_info.threadCreated = false;
 		ereport(FATAL, (errcode(ERRCODE_INTERNAL_ERROR),
 						errmsg("InitMotionLayerIPC: failed to create thread"),
 						errdetail("pthread_create() failed with err %d", pthread_err)));
 	}
 
-	ic_control_info.threadCreated = true;
 	return;
 }
 
+/*
+ * joinRxThreads
+ * 		Wait for the rx-threads to exit, the shutdown flag must be set.
+ */
+static void
+joinRxThreads(void)
+{
+	int			i;
+
+	for (i = 0; i < ic_control_info.numThreads; i++)
+		pthread_join(ic_control_info.threadHandles[i], NULL);
+	ic_control_info.numThreads = 0;
+}
+
 /*
  * CleanupMotionUDPIFC
  * 		Clean up UDP specific stuff such as cursor ic hash table, thread etc.
@@ -1425,6 +1743,8 @@ InitMotionUDPIFC(void)
 void
 CleanupMotionUDPIFC(void)
 {
+	int i;
+
 	elog(DEBUG2, "udp-ic: telling receiver thread to shutdown.");
 
 	/*
@@ -1440,7 +1760,7 @@ CleanupMotionUDPIFC(void)
 	pg_atomic_compare_exchange_u32((pg_atomic_uint32 *)&ic_control_info.shutdown, &expected, 1);
 
 	if(ic_control_info.threadCreated)
-		pthread_join(ic_control_info.threadHandle, NULL);
+		joinRxThreads();
 
 	elog(DEBUG2, "udp-ic: receiver thread shutdown.");
 
@@ -1468,6 +1788,11 @@ CleanupMotionUDPIFC(void)
 	ICSenderPort = 0;
 	ICSenderFamily = 0;
 
+	/* ICListenerSocket, rxSockets[0], is closed by CleanUpMotionLayerIPC. */
+	for (i = 1; i < ic_control_info.numRxSockets; i++)
+		closesocket(ic_control_info.rxSockets[i]);
+	ic_control_info.numRxSockets = 0;
+
 #ifdef USE_ASSERT_CHECKING
 	/*
 	 * Check malloc times, in Interconnect part, memory are carefully released in tear down
@@ -1806,6 +2131,86 @@ sendAckWithParam(AckSendParam *param)
 	sendControlMessage(&param->msg, ICListenerSocket, (struct sockaddr *)&param->peer, param->peer_len);
 }
 
+/*
+ * sendAcksWithParam
+ * 		Send a batch of acknowledgments to senders.
+ *
+ * Like sendControlMessage, we leave it to retransmit logic to handle
+ * the acknowledgments which can not be sent.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static void
+sendAcksWithParam(int fd, AckSendParam *params, int count)
+{
+#ifdef UDPIC_USE_MMSG
+	struct mmsghdr msgs[MAX_MMSG_BATCH_SIZE];
+	struct iovec iovs[MAX_MMSG_BATCH_SIZE];
+	int			nmsgs = 0;
+	int			sent = 0;
+	int			i;
+
+	Assert(count <= MAX_MMSG_BATCH_SIZE);
+
+	if (count == 1)
+	{
+		sendControlMessage(&params[0].msg, fd, (struct sockaddr *)&params[0].peer, params[0].peer_len);
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckNum, 1);
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckSyscallNum, 1);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		icpkthdr *pkt = &params[i].msg;
+
+#ifdef USE_ASSERT_CHECKING
+		if (testmode_inject_fault(gp_udpic_dropacks_percent))
+			continue;
+#endif
+
+		if (gp_interconnect_full_crc)
+			addCRC(pkt);
+
+		iovs[nmsgs].iov_base = pkt;
+		iovs[nmsgs].iov_len = pkt->len;
+		memset(&msgs[nmsgs], 0, sizeof(struct mmsghdr));
+		msgs[nmsgs].msg_hdr.msg_name = &params[i].peer;
+		msgs[nmsgs].msg_hdr.msg_namelen = params[i].peer_len;
+		msgs[nmsgs].msg_hdr.msg_iov = &iovs[nmsgs];
+		msgs[nmsgs].msg_hdr.msg_iovlen = 1;
+		nmsgs++;
+	}
+
+	while (sent < nmsgs)
+	{
+		int n = sendmmsg(fd, &msgs[sent], nmsgs - sent, 0);
+
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckSyscallNum, 1);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			/* skip the ack which fails, retransmit logic will handle it. */
+			write_log("sendAcksWithParam: got error errno %d seq %d", errno,
+					  ((icpkthdr *) msgs[sent].msg_hdr.msg_iov->iov_base)->seq);
+			n = 1;
+		}
+		sent += n;
+	}
+	pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckNum, nmsgs);
+#else
+	int			i;
+
+	for (i = 0; i < count; i++)
+		sendControlMessage(&params[i].msg, fd, (struct sockaddr *)&params[i].peer, params[i].peer_len);
+	pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckNum, count);
+	pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.sndAckSyscallNum, count);
+#endif
+}
+
 /*
  * sendAck
  * 		Send acknowledgment to sender.
@@ -2949,7 +3354,7 @@ handleCachedPackets(void)
 					putRxBufferToFreeList(&rx_buffer_pool, pkt);
 				}
 
-				ic_statistics.recvPktNum++;
+				pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.recvPktNum, 1);
 				if (param.msg.len != 0)
 					sendAckWithParam(&param);
 
@@ -2984,6 +3389,7 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 	int			outgoing_count = 0;
 	int			expectedTotalIncoming = 0;
 	int			expectedTotalOutgoing = 0;
+	const char *localAddr = NULL;
 
 	ChunkTransportStateEntry *sendingChunkTransportState = NULL;
 
@@ -3028,6 +3434,10 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 	set_test_mode();
 #endif
 
+	/* peers with the same listener address as ours are on the same host. */
+	if (gp_interconnect_shm_transport)
+		localAddr = getLocalListenerAddr(mySlice);
+
 	if (Gp_role == GP_ROLE_DISPATCH)
 	{
 		DistributedTransactionId distTransId = 0;
@@ -3119,6 +3529,9 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 				conn->conn_info.flags = UDPIC_FLAGS_RECEIVER_TO_SENDER;
 
 				connAddHash(&ic_control_info.connHtab, conn);
+
+				if (localAddr != NULL && strcmp(conn->cdbProc->listenerAddr, localAddr) == 0)
+					conn->shmChannel = attachShmChannel(conn, pEntry->motNodeId, true);
 			}
 		}
 
@@ -3153,6 +3566,9 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 			{
 				setupOutgoingUDPConnection(estate->interconnect_context, sendingChunkTransportState, conn);
 				outgoing_count++;
+
+				if (localAddr != NULL && strcmp(conn->cdbProc->listenerAddr, localAddr) == 0)
+					conn->shmChannel = attachShmChannel(conn, sendingChunkTransportState->motNodeId, false);
 			}
 		}
 		snd_control_info.minCwnd = snd_control_info.cwnd;
@@ -3407,6 +3823,9 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 					icBufferListReturn(&conn->unackQueue, Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_CAPACITY ? false : true);
 
 					connDelHash(&ic_control_info.connHtab, conn);
+
+					if (conn->shmChannel)
+						detachShmChannel(conn);
 				}
 				avgRtt = avgRtt / pEntry->numConns;
 				avgDev = avgDev / pEntry->numConns;
@@ -3476,6 +3895,9 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 
 					connDelHash(&ic_control_info.connHtab, conn);
 
+					if (conn->shmChannel)
+						detachShmChannel(conn);
+
 					/* putRxBufferAndSendAck() dequeues messages and moves them to pBuff */
 					while (conn->pkt_q_size > 0)
 					{
@@ -3540,7 +3962,9 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 			" freebuf_avg %f "
 			"mismatch_pkt_num %d disordered_pkt_num %d duplicated_pkt_num %d"
 			" rtt/dev [" UINT64_FORMAT "/" UINT64_FORMAT ", %f/%f, " UINT64_FORMAT "/" UINT64_FORMAT "] "
-			" cwnd %f status_query_msg_num %d",
+			" cwnd %f status_query_msg_num %d"
+			" snd_pkts_per_syscall %f recv_pkts_per_syscall %f acks_per_syscall %f"
+			" snd_shm_pkt_num %d recv_shm_pkt_num %d",
 			ic_control_info.isSender, isReceiver,
 			Gp_interconnect_snd_queue_depth, Gp_interconnect_queue_depth, Gp_max_packet_size,
 			UNACK_QUEUE_RING_SLOTS_NUM, TIMER_SPAN, DEFAULT_RTT,
@@ -3553,7 +3977,11 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 			(double)((double)ic_statistics.totalBuffers)/((double)ic_statistics.bufferCountingTime),
 			ic_statistics.mismatchNum, ic_statistics.disorderedPktNum, ic_statistics.duplicatedPktNum,
 			(minRtt == ~((uint64)0) ? 0 : minRtt), (minDev == ~((uint64)0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
-			snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
+			snd_control_info.cwnd, ic_statistics.statusQueryMsgNum,
+			(double)((double)ic_statistics.sndPktNum)/((double)ic_statistics.sndSyscallNum),
+			(double)((double)(ic_statistics.recvPktNum + ic_statistics.mismatchNum))/((double)ic_statistics.recvSyscallNum),
+			(double)((double)ic_statistics.sndAckNum)/((double)ic_statistics.sndAckSyscallNum),
+			ic_statistics.sndShmPktNum, ic_statistics.recvShmPktNum);
 
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
@@ -4416,6 +4844,64 @@ prepareXmit(MotionConn *conn)
 	}
 }
 
+/*
+ * compressPacket
+ * 		Replace the chunks of the packet being filled by one TC_COMPRESSED
+ * 		chunk holding them pglz-compressed, if that makes the packet smaller.
+ *
+ * pglz gives up on input that does not shrink by its default 25%.  Every
+ * failure makes the motion send the next packets uncompressed, backing off
+ * exponentially, so incompressible data costs few attempts while data whose
+ * ratio improves is picked up again.
+ */
+static void
+compressPacket(MotionLayerState *mlStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, int16 motionId)
+{
+	static PGLZ_Header *compressBuffer = NULL;
+
+	MotionNodeEntry *pMNEntry;
+	uint8	   *payload = conn->pBuff + sizeof(conn->conn_info);
+	int			rawSize = conn->msgSize - sizeof(conn->conn_info);
+	int			compressedSize;
+
+	if (!gp_interconnect_compress || rawSize <= 0)
+		return;
+
+	pMNEntry = getMotionNodeEntry(mlStates, motionId, "compressPacket");
+	pMNEntry->stat_compress_bytes_in += rawSize;
+
+	if (pEntry->compressSkip > 0)
+	{
+		pEntry->compressSkip--;
+		pMNEntry->stat_compress_bytes_out += rawSize;
+		return;
+	}
+
+	/* Gp_max_packet_size cannot change within a backend. */
+	if (compressBuffer == NULL)
+		compressBuffer = MemoryContextAlloc(TopMemoryContext, PGLZ_MAX_OUTPUT(Gp_max_packet_size));
+
+	if (pglz_compress((char *) payload, rawSize, compressBuffer, PGLZ_strategy_default) &&
+		TYPEALIGN(TUPLE_CHUNK_ALIGN, TUPLE_CHUNK_HEADER_SIZE + VARSIZE(compressBuffer)) < rawSize)
+	{
+		compressedSize = TYPEALIGN(TUPLE_CHUNK_ALIGN, TUPLE_CHUNK_HEADER_SIZE + VARSIZE(compressBuffer));
+
+		SetChunkDataSize(payload, VARSIZE(compressBuffer));
+		SetChunkType(payload, TC_COMPRESSED);
+		memcpy(payload + TUPLE_CHUNK_HEADER_SIZE, compressBuffer, VARSIZE(compressBuffer));
+
+		conn->msgSize = sizeof(conn->conn_info) + compressedSize;
+		pEntry->compressBackoff = 0;
+		pMNEntry->stat_compress_bytes_out += compressedSize;
+	}
+	else
+	{
+		pEntry->compressBackoff = Min(Max(pEntry->compressBackoff * 2, MIN_COMPRESS_BACKOFF), MAX_COMPRESS_BACKOFF);
+		pEntry->compressSkip = pEntry->compressBackoff;
+		pMNEntry->stat_compress_bytes_out += rawSize;
+	}
+}
+
 /*
  * sendOnce
  * 		Send a packet.
@@ -4435,6 +4921,9 @@ sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
 	}
 #endif
 
+	if (conn->shmChannel != NULL && sendShmPacket(pEntry, conn, buf->pkt))
+		return;
+
 xmit_retry:
 	n = sendto(pEntry->txfd, buf->pkt, buf->pkt->len, 0,
 			   (struct sockaddr *)&conn->peer, conn->peer_len);
@@ -4485,6 +4974,119 @@ xmit_retry:
 	return;
 }
 
+/*
+ * sendBatch
+ * 		Send a batch of packets of a connection.
+ *
+ * The packets are sent with as few sendmmsg() calls as possible, errors are
+ * handled the same way as sendOnce does.
+ */
+static void
+sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer **bufs, int count, MotionConn *conn)
+{
+#ifdef UDPIC_USE_MMSG
+	struct mmsghdr msgs[MAX_MMSG_BATCH_SIZE];
+	struct iovec iovs[MAX_MMSG_BATCH_SIZE];
+	int			nmsgs = 0;
+	int			sent = 0;
+	int			i;
+
+	Assert(count <= MAX_MMSG_BATCH_SIZE);
+
+	/* sendOnce() copies the packets of a same-host peer into its channel. */
+	if (conn->shmChannel != NULL)
+	{
+		for (i = 0; i < count; i++)
+			sendOnce(transportStates, pEntry, bufs[i], conn);
+		return;
+	}
+
+	if (count == 1)
+	{
+		sendOnce(transportStates, pEntry, bufs[0], conn);
+		ic_statistics.sndSyscallNum++;
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+#ifdef USE_ASSERT_CHECKING
+		if (testmode_inject_fault(gp_udpic_dropxmit_percent))
+		{
+		#ifdef AMS_VERBOSE_LOGGING
+			write_log("THROW PKT with seq %d srcpid %d despid %d", bufs[i]->pkt->seq, bufs[i]->pkt->srcPid, bufs[i]->pkt->dstPid);
+		#endif
+			continue;
+		}
+#endif
+
+		iovs[nmsgs].iov_base = bufs[i]->pkt;
+		iovs[nmsgs].iov_len = bufs[i]->pkt->len;
+		memset(&msgs[nmsgs], 0, sizeof(struct mmsghdr));
+		msgs[nmsgs].msg_hdr.msg_name = &conn->peer;
+		msgs[nmsgs].msg_hdr.msg_namelen = conn->peer_len;
+		msgs[nmsgs].msg_hdr.msg_iov = &iovs[nmsgs];
+		msgs[nmsgs].msg_hdr.msg_iovlen = 1;
+		nmsgs++;
+	}
+
+	while (sent < nmsgs)
+	{
+		int			n;
+
+		n = sendmmsg(pEntry->txfd, &msgs[sent], nmsgs - sent, 0);
+		ic_statistics.sndSyscallNum++;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN) /* no space ? not an error. */
+				return;
+
+			/* See sendOnce(), the packet dropped by iptables is simply skipped. */
+			if (errno == EPERM)
+			{
+				ereport(LOG,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("Interconnect error writing an outgoing packet: %m"),
+						 errdetail("error during sendmmsg() for Remote Connection: contentId=%d at %s",
+								   conn->remoteContentId, conn->remoteHostAndPort)));
+				sent++;
+				continue;
+			}
+
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error writing an outgoing packet: %m"),
+							errdetail("error during sendmmsg() call (error:%d).\n"
+									  "For Remote Connection: contentId=%d at %s",
+									  errno, conn->remoteContentId,
+									  conn->remoteHostAndPort)));
+			/* not reached */
+		}
+
+		for (i = sent; i < sent + n; i++)
+		{
+			if (msgs[i].msg_len != iovs[i].iov_len && DEBUG1 >= log_min_messages)
+				write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendmmsg() call."
+						  "For Remote Connection: contentId=%d at %s", ((icpkthdr *) iovs[i].iov_base)->seq,
+						  (int) iovs[i].iov_len, (int) msgs[i].msg_len,
+						  conn->remoteContentId,
+						  conn->remoteHostAndPort);
+		}
+		sent += n;
+	}
+#else
+	int			i;
+
+	for (i = 0; i < count; i++)
+	{
+		sendOnce(transportStates, pEntry, bufs[i], conn);
+		ic_statistics.sndSyscallNum++;
+	}
+#endif
+}
+
 
 /*
  * handleStopMsgs
@@ -4594,6 +5196,9 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
 static void
 sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
+	ICBuffer   *batch[MAX_MMSG_BATCH_SIZE];
+	int			batchSize = 0;
+
 	while (conn->capacity > 0 && icBufferListLength(&conn->sndQueue) > 0)
 	{
 		ICBuffer *buf = NULL;
@@ -4627,10 +5232,10 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		}
 
 		/*
-		 * Note the place of sendOnce here.
+		 * Note the place of sendBatch here.
 		 * If we send before appending it to the unack queue and
 		 * putting it into unack queue ring, and there is a
-		 * network error occurred in the sendOnce function, error
+		 * network error occurred in the sendBatch function, error
 		 * message will be output. In the time of error message output,
 		 * interrupts is potentially checked, if there is a pending query cancel,
 		 * it will lead to a dangled buffer (memory leak).
@@ -4639,7 +5244,12 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+		batch[batchSize++] = buf;
+		if (batchSize >= Gp_interconnect_mmsg_batch_size)
+		{
+			sendBatch(transportStates, pEntry, batch, batchSize, conn);
+			batchSize = 0;
+		}
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4648,6 +5258,9 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		buf->conn->sentSeq = buf->pkt->seq;
 	}
+
+	if (batchSize > 0)
+		sendBatch(transportStates, pEntry, batch, batchSize, conn);
 }
 
 /*
@@ -5238,6 +5851,7 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 
 	/* try to send it */
 
+	compressPacket(mlStates, pEntry, conn, motionId);
 	prepareXmit(conn);
 
 	icBufferListAppend(&conn->sndQueue, conn->curBuff);
@@ -5844,7 +6458,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 	/* dropped ack or timeout */
 	if (pkt->seq < conn->conn_info.seq)
 	{
-		ic_statistics.duplicatedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.duplicatedPktNum, 1);
 		if (DEBUG3 >= log_min_messages)
 			write_log("dropped ack ? ignored data packet w/ cmd %d conn->cmd %d node %d route %d seq %d expected %d flags 0x%x",
 					  pkt->icId, conn->conn_info.icId, pkt->motNodeId,
@@ -5878,7 +6492,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 		 * This indicates a bug.
 		 */
 		logPkt("Interconnect error: received a packet when the queue is full ", pkt);
-		ic_statistics.disorderedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.disorderedPktNum, 1);
 		conn->stat_count_dropped++;
 		return false;
 	}
@@ -5929,7 +6543,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 				write_log("SAVE conn %p OUT-OF-ORDER pkt [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
 			/* send an ack for out-of-order packet */
-			ic_statistics.disorderedPktNum++;
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.disorderedPktNum, 1);
 			handleDisorderPacket(conn, pos, headSeq + conn->pkt_q_size, pkt);
 		}
 	}
@@ -5939,7 +6553,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 			write_log("DUPLICATE pkt [seq %d], [head seq] %d, queue size %d, queue head %d queue tail %d", pkt->seq, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
 		setAckSendParam(param, conn, UDPIC_FLAGS_DUPLICATE | conn->conn_info.flags, pkt->seq, conn->conn_info.seq - 1);
-		ic_statistics.duplicatedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.duplicatedPktNum, 1);
 		return false;
 	}
 
@@ -5967,11 +6581,537 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 }
 
 /*
- * rxThreadFunc
- * 		Main function of the receive background thread.
- *
- * NOTE: This function MUST NOT contain elog or ereport statements.
- * elog is NOT thread-safe.  Developers should instead use something like:
+ * getLocalListenerAddr
+ * 		Get the listener address of this process in the slice table.
+ *
+ * Returns NULL if this process is not found.
+ */
+static const char *
+getLocalListenerAddr(Slice *mySlice)
+{
+	ListCell   *cell;
+
+	foreach(cell, mySlice->primaryProcesses)
+	{
+		CdbProcess *cdbProc = (CdbProcess *) lfirst(cell);
+
+		if (cdbProc != NULL && cdbProc->pid == MyProcPid &&
+			cdbProc->listenerPort == ICListenerPort &&
+			cdbProc->contentid == Gp_segment)
+			return cdbProc->listenerAddr;
+	}
+
+	return NULL;
+}
+
+/*
+ * attachShmChannel
+ * 		Create or open the shared memory ring of a connection to a same-host peer.
+ *
+ * Both sides map the same ring, named after the session, the interconnect
+ * instance, the motion and the pids of both sides. Returns NULL if the ring can
+ * not be set up, and the connection uses UDP only.
+ *
+ * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED* for receiving connections.
+ */
+static ICShmChannel *
+attachShmChannel(MotionConn *conn, int motNodeId, bool isReceiver)
+{
+	ICShmChannel *channel;
+	ICShmRing  *ring;
+	char		name[64];
+	uint32		nslots = Gp_interconnect_queue_depth;
+	uint32		slotSize = MAXALIGN(Gp_max_packet_size);
+	Size		size = SHM_RING_SLOTS_OFFSET + (Size) nslots * slotSize;
+	int			fd;
+
+	snprintf(name, sizeof(name), "/gpic.%d.%u.%d.%d.%d", gp_session_id, gp_interconnect_id, motNodeId,
+			 isReceiver ? conn->cdbProc->pid : MyProcPid,
+			 isReceiver ? MyProcPid : conn->cdbProc->pid);
+
+	fd = shm_open(name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+	{
+		elog(LOG, "Interconnect could not open shared memory channel \"%s\": %m", name);
+		return NULL;
+	}
+
+	if (ftruncate(fd, size) < 0)
+	{
+		elog(LOG, "Interconnect could not resize shared memory channel \"%s\": %m", name);
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	ring = (ICShmRing *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ring == MAP_FAILED)
+	{
+		elog(LOG, "Interconnect could not map shared memory channel \"%s\": %m", name);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	/* the second side to map the ring removes the name, the mappings stay valid. */
+	if (pg_atomic_fetch_add_u32(&ring->mapped, 1) == 1)
+		shm_unlink(name);
+
+	channel = MemoryContextAllocZero(ic_control_info.memContext, sizeof(ICShmChannel));
+	strlcpy(channel->name, name, sizeof(channel->name));
+	channel->ring = ring;
+	channel->size = size;
+	channel->nslots = nslots;
+	channel->slotSize = slotSize;
+	channel->isReceiver = isReceiver;
+
+	if (isReceiver)
+	{
+		/* the first packet wakes us up. */
+		pg_atomic_write_u32(&ring->receiverWaiting, 1);
+
+		/* the thread which receives the UDP packets of the sender drains the ring. */
+		channel->owner = rxThreadOfSender(conn->cdbProc->pid);
+		channel->next = ic_control_info.shmChannels[channel->owner];
+		ic_control_info.shmChannels[channel->owner] = channel;
+	}
+	else
+	{
+		/*
+		 * The peer listens on our address, so we send from the same address
+		 * and our sender port.
+		 */
+		memcpy(&ring->senderAddr, &conn->peer, conn->peer_len);
+		ring->senderAddrLen = conn->peer_len;
+		if (ring->senderAddr.ss_family == AF_INET6)
+			((struct sockaddr_in6 *) &ring->senderAddr)->sin6_port = htons(ICSenderPort);
+		else
+			((struct sockaddr_in *) &ring->senderAddr)->sin_port = htons(ICSenderPort);
+	}
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG1, "Interconnect attached shared memory channel \"%s\" for %s",
+			 name, isReceiver ? "receiving" : "sending");
+
+	return channel;
+}
+
+/*
+ * detachShmChannel
+ * 		Unmap and remove the shared memory ring of a connection.
+ *
+ * The sender falls back to UDP once the receiver has detached.
+ *
+ * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED* for receiving connections.
+ */
+static void
+detachShmChannel(MotionConn *conn)
+{
+	ICShmChannel *channel = conn->shmChannel;
+
+	if (channel->isReceiver)
+	{
+		ICShmChannel **prev = &ic_control_info.shmChannels[channel->owner];
+
+		while (*prev != channel)
+			prev = &(*prev)->next;
+		*prev = channel->next;
+
+		pg_atomic_write_u32(&channel->ring->detached, 1);
+	}
+
+	/*
+	 * If the peer has not mapped the ring yet, the name is still there. The peer
+	 * then creates a new ring, which nobody writes into or drains.
+	 */
+	if (pg_atomic_read_u32(&channel->ring->mapped) < 2)
+		shm_unlink(channel->name);
+
+	munmap(channel->ring, channel->size);
+
+	pfree(channel);
+	conn->shmChannel = NULL;
+}
+
+/*
+ * sendShmPacket
+ * 		Copy a packet into the shared memory ring of the connection.
+ *
+ * Returns false if the receiver has detached, and the packet should be sent
+ * through UDP instead. A packet which does not fit into the ring is dropped.
+ */
+static bool
+sendShmPacket(ChunkTransportStateEntry *pEntry, MotionConn *conn, icpkthdr *pkt)
+{
+	ICShmChannel *channel = conn->shmChannel;
+	ICShmRing  *ring = channel->ring;
+	uint32		head;
+
+	if (pg_atomic_read_u32(&ring->detached) != 0)
+		return false;
+
+	head = pg_atomic_read_u32(&ring->head);
+	if (head - pg_atomic_read_u32(&ring->tail) < channel->nslots)
+	{
+		memcpy(SHM_CHANNEL_SLOT(channel, head), pkt, pkt->len);
+		pg_write_barrier();
+		pg_atomic_write_u32(&ring->head, head + 1);
+
+		ic_statistics.sndShmPktNum++;
+	}
+
+	/*
+	 * exchange is a full barrier, the receiver either sees the packets or is
+	 * woken up, also when this one did not fit.
+	 */
+	if (pg_atomic_exchange_u32(&ring->receiverWaiting, 0) == 1)
+		(void) sendto(pEntry->txfd, (char *) pkt, SHM_WAKEUP_SIZE, 0, (struct sockaddr *) &conn->peer, conn->peer_len);
+
+	return true;
+}
+
+/*
+ * rxThreadOfSender
+ * 		The index of the rx thread receiving the packets of a sender.
+ *
+ * The same choice as the program of the socket group makes, see
+ * setRxSocketFilter().
+ */
+static int
+rxThreadOfSender(int32 srcPid)
+{
+	return ntohl((uint32) srcPid) % ic_control_info.numRxSockets;
+}
+
+/*
+ * receiveShmPackets
+ * 		Receive up to count packets from the shared memory channels of a thread.
+ *
+ * The packets are copied into pkts, with the address of their sender and their
+ * length in peers/peerLens and readCounts like receivePackets() returns them; a
+ * bad length is returned as -1. Returns the number of packets received.
+ *
+ * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static int
+receiveShmPackets(int owner, icpkthdr **pkts, int count, struct sockaddr_storage *peers, socklen_t *peerLens, int *readCounts)
+{
+	ICShmChannel *channel;
+	int			npkts = 0;
+
+	for (channel = ic_control_info.shmChannels[owner]; channel != NULL && npkts < count; channel = channel->next)
+	{
+		ICShmRing  *ring = channel->ring;
+		uint32		tail = pg_atomic_read_u32(&ring->tail);
+
+		while (npkts < count && tail != pg_atomic_read_u32(&ring->head))
+		{
+			icpkthdr   *slot = SHM_CHANNEL_SLOT(channel, tail);
+			int			len;
+
+			pg_read_barrier();
+
+			len = slot->len;
+			if (len >= sizeof(icpkthdr) && len <= Gp_max_packet_size)
+			{
+				memcpy(pkts[npkts], slot, len);
+				memcpy(&peers[npkts], &ring->senderAddr, ring->senderAddrLen);
+				peerLens[npkts] = ring->senderAddrLen;
+				readCounts[npkts] = len;
+			}
+			else
+				readCounts[npkts] = -1;
+
+			/* the slot can be reused by the sender from now on. */
+			pg_memory_barrier();
+			pg_atomic_write_u32(&ring->tail, ++tail);
+
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.recvShmPktNum, 1);
+			npkts++;
+		}
+	}
+
+	return npkts;
+}
+
+/*
+ * armShmChannels
+ * 		Ask the senders of the shared memory channels of a thread for a wakeup.
+ *
+ * Called before the background thread sleeps in poll(). Returns true if some
+ * channel is not empty, and the thread should not sleep.
+ *
+ * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ */
+static bool
+armShmChannels(int owner)
+{
+	ICShmChannel *channel;
+
+	for (channel = ic_control_info.shmChannels[owner]; channel != NULL; channel = channel->next)
+		pg_atomic_write_u32(&channel->ring->receiverWaiting, 1);
+
+	pg_memory_barrier();
+
+	for (channel = ic_control_info.shmChannels[owner]; channel != NULL; channel = channel->next)
+	{
+		if (pg_atomic_read_u32(&channel->ring->tail) != pg_atomic_read_u32(&channel->ring->head))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * receivePackets
+ * 		Receive up to count packets from the socket with one system call.
+ *
+ * The address of the sender and the length of every received packet are
+ * returned in peers/peerLens and readCounts. Returns the number of packets
+ * received, or -1 and errno is set.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static int
+receivePackets(int fd, icpkthdr **pkts, int count, struct sockaddr_storage *peers, socklen_t *peerLens, int *readCounts)
+{
+#ifdef UDPIC_USE_MMSG
+	struct mmsghdr msgs[MAX_MMSG_BATCH_SIZE];
+	struct iovec iovs[MAX_MMSG_BATCH_SIZE];
+	int			n;
+	int			i;
+
+	Assert(count <= MAX_MMSG_BATCH_SIZE);
+
+	memset(msgs, 0, count * sizeof(struct mmsghdr));
+	for (i = 0; i < count; i++)
+	{
+		iovs[i].iov_base = pkts[i];
+		iovs[i].iov_len = Gp_max_packet_size;
+		msgs[i].msg_hdr.msg_name = &peers[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	/* the socket is non-blocking, this returns what is queued on it right now. */
+	n = recvmmsg(fd, msgs, count, 0, NULL);
+
+	for (i = 0; i < n; i++)
+	{
+		peerLens[i] = msgs[i].msg_hdr.msg_namelen;
+		readCounts[i] = msgs[i].msg_len;
+	}
+
+	return n;
+#else
+	peerLens[0] = sizeof(struct sockaddr_storage);
+	readCounts[0] = recvfrom(fd, (char *)pkts[0], Gp_max_packet_size, 0,
+							 (struct sockaddr *)&peers[0], &peerLens[0]);
+
+	return (readCounts[0] < 0) ? -1 : 1;
+#endif
+}
+
+/*
+ * checkRxPacket
+ * 		Check whether a received packet is complete and valid.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static bool
+checkRxPacket(icpkthdr *pkt, int read_count)
+{
+	if (DEBUG5 >= log_min_messages)
+		write_log("received inbound len %d", read_count);
+
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
+
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
+
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * handleRxPacket
+ * 		Handle a packet received by the background thread.
+ *
+ * peer is the address of the sender. Returns true if the buffer of the packet
+ * is kept, and the acks to send are filled into param.
+ *
+ * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static bool
+handleRxPacket(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t *peerLen, AckSendParam *param)
+{
+	MotionConn *conn = NULL;
+	bool		ret = false;
+
+#ifdef AMS_VERBOSE_LOGGING
+	logPkt("GOT MESSAGE", pkt);
+#endif
+
+	memset(param, 0, sizeof(AckSendParam));
+
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+
+	if (conn != NULL)
+	{
+		/* Handling a regular packet */
+		ret = handleDataPacket(conn, pkt, peer, peerLen, param);
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.recvPktNum, 1);
+	}
+	else
+	{
+		/*
+		 * There may have two kinds of Mismatched packets:
+		 *    a) Past packets from previous command after I was torn down
+		 *    b) Future packets from current command before my connections are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+
+		#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+		#endif
+
+			ret = handleMismatch(pkt, peer, *peerLen);
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.mismatchNum, 1);
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * handleRxPackets
+ * 		Handle the first nrecv of the npkts packets a background thread received.
+ *
+ * The packets are checked without the lock, handled with ic_control_info.lock
+ * held once, and the resulting acks are sent through fd after releasing it.
+ * The buffers which are not consumed are moved to the front of pkts, returns
+ * their number.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * It is called by the background thread.
+ */
+static int
+handleRxPackets(int fd, icpkthdr **pkts, int npkts, int nrecv, struct sockaddr_storage *peers,
+				socklen_t *peerLens, int *readCounts, AckSendParam *params)
+{
+	int			nacks = 0;
+	int			i;
+	int			j;
+
+	/*
+	 * Validate the packets, their CRC included, before taking the lock; the
+	 * wakeups of shared memory channels are marked with a zero read count and
+	 * the bad packets with a negative one.
+	 */
+	for (i = 0; i < nrecv; i++)
+	{
+		if (readCounts[i] == SHM_WAKEUP_SIZE)
+			readCounts[i] = 0;
+		else if (readCounts[i] > 0 && !checkRxPacket(pkts[i], readCounts[i]))
+			readCounts[i] = -1;
+	}
+
+	/*
+	 * Get the connection for the pkts.
+	 *
+	 * 	The connection hash table should be locked until
+	 * 	finishing the processing of the batch to avoid
+	 *  the connection addition/removal from the hash table
+	 *  during the mean time.
+	 */
+	pthread_mutex_lock(&ic_control_info.lock);
+	for (i = 0; i < nrecv; i++)
+	{
+		if (readCounts[i] <= 0)
+			continue;
+
+		if (handleRxPacket(pkts[i], &peers[i], &peerLens[i], &params[nacks]))
+			pkts[i] = NULL;
+
+		if (params[nacks].msg.len != 0)
+			nacks++;
+	}
+	pthread_mutex_unlock(&ic_control_info.lock);
+
+	/* real ack sending is after lock release to decrease the lock holding time. */
+	if (nacks > 0)
+		sendAcksWithParam(fd, params, nacks);
+
+	/* keep the buffers which are not consumed for the next batch. */
+	for (i = 0, j = 0; i < npkts; i++)
+	{
+		if (pkts[i] != NULL)
+			pkts[j++] = pkts[i];
+	}
+
+	return j;
+}
+
+/*
+ * rxThreadFunc
+ * 		Main function of the receive background threads.
+ *
+ * arg is the index of the socket of the thread in ic_control_info.rxSockets,
+ * the thread drains the shared memory channels in ic_control_info.shmChannels
+ * at the same index.
+ *
+ * The thread receives packets in batches of up to gp_interconnect_mmsg_batch_size
+ * packets, checks them, processes the whole batch with ic_control_info.lock
+ * held once, and sends the resulting acks after releasing the lock. Receiving,
+ * checking the length and CRC and sending acks run in parallel when there are
+ * multiple threads.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * elog is NOT thread-safe.  Developers should instead use something like:
  *
  *	if (DEBUG3 >= log_min_messages)
  *		write_log("my brilliant log statement here.");
@@ -5981,9 +7121,17 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr *pkt = NULL;
+	icpkthdr   *pkts[MAX_MMSG_BATCH_SIZE];
+	struct sockaddr_storage peers[MAX_MMSG_BATCH_SIZE];
+	socklen_t	peerLens[MAX_MMSG_BATCH_SIZE];
+	int			readCounts[MAX_MMSG_BATCH_SIZE];
+	AckSendParam params[MAX_MMSG_BATCH_SIZE];
+	int			npkts = 0;
+	int			self = (int) (intptr_t) arg;
+	int			fd = ic_control_info.rxSockets[self];
 	bool	skip_poll = false;
 	uint32 	expected = 1;
+	int			i;
 
 	gp_set_thread_sigmasks();
 
@@ -5991,6 +7139,8 @@ rxThreadFunc(void *arg)
 	{
 		struct pollfd nfd;
 		int		n;
+		int		nrecv;
+		int		batchSize;
 
 		/* check shutdown condition*/
 		expected = 1;
@@ -6003,24 +7153,54 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+		/* Try to get buffers for a batch */
+		batchSize = Min(Gp_interconnect_mmsg_batch_size, rx_control_info.rxBatchSize);
+		if (npkts < batchSize)
 		{
 			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
+			while (npkts < batchSize)
+			{
+				icpkthdr *pkt = getRxBuffer(&rx_buffer_pool);
+
+				if (pkt == NULL)
+					break;
+				pkts[npkts++] = pkt;
+			}
 			pthread_mutex_unlock(&ic_control_info.lock);
 
-			if (pkt == NULL)
+			if (npkts == 0)
 			{
 				setRxThreadError(ENOMEM);
 				continue;
 			}
 		}
 
+		/* Receive the packets of the same-host senders this thread owns. */
+		nrecv = 0;
+		pthread_mutex_lock(&ic_control_info.lock);
+		if (ic_control_info.shmChannels[self] != NULL)
+		{
+			nrecv = receiveShmPackets(self, pkts, Min(npkts, batchSize),
+									  peers, peerLens, readCounts);
+
+			/* if we are about to sleep, make sure the senders wake us up. */
+			if (nrecv > 0 || (!skip_poll && armShmChannels(self)))
+				skip_poll = true;
+		}
+		pthread_mutex_unlock(&ic_control_info.lock);
+
+		if (nrecv > 0)
+		{
+			npkts = handleRxPackets(fd, pkts, npkts, nrecv, peers, peerLens,
+									readCounts, params);
+			if (npkts == 0)
+				continue;
+		}
+
 		if (!skip_poll)
 		{
 			/* Do we have inbound traffic to handle ?*/
-			nfd.fd = ICListenerSocket;
+			nfd.fd = fd;
 			nfd.events = POLLIN;
 
 			n = poll(&nfd, 1, RX_THREAD_POLL_TIMEOUT);
@@ -6060,15 +7240,8 @@ rxThreadFunc(void *arg)
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
-			int read_count = 0;
-
-			struct sockaddr_storage peer;
-			socklen_t peerlen;
-
-			peerlen = sizeof(peer);
-			read_count = recvfrom(ICListenerSocket, (char *)pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *)&peer, &peerlen);
+			nrecv = receivePackets(fd, pkts, Min(npkts, batchSize),
+								   peers, peerLens, readCounts);
 
 			expected = 1;
 			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *)&ic_control_info.shutdown, &expected, 0))
@@ -6080,10 +7253,7 @@ rxThreadFunc(void *arg)
 				break;
 			}
 
-			if (DEBUG5 >= log_min_messages)
-				write_log("received inbound len %d", read_count);
-
-			if (read_count < 0)
+			if (nrecv < 0)
 			{
 				skip_poll = false;
 
@@ -6102,110 +7272,25 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
-
-			/* when we get a "good" recvfrom() result, we can skip poll() until we get a bad one. */
+			/* when we get a "good" receive result, we can skip poll() until we get a bad one. */
 			skip_poll = true;
 
-			/* length must be >= 0 */
-			if (pkt->len < 0)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.recvSyscallNum, 1);
 
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
-			}
-
-			/*
-			 * check the CRC of the payload.
-			 */
-			if (gp_interconnect_full_crc)
-			{
-				if (!checkCRC(pkt))
-				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
-					continue;
-				}
-			}
-
-			#ifdef AMS_VERBOSE_LOGGING
-				logPkt("GOT MESSAGE", pkt);
-			#endif
-
-			AckSendParam param;
-			memset(&param, 0, sizeof(AckSendParam));
-
-			/*
-			 * Get the connection for the pkt.
-			 *
-			 * 	The connection hash table should be locked until
-			 * 	finishing the processing of the packet to avoid
-			 *  the connection addition/removal from the hash table
-			 *  during the mean time.
-			 */
-
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
-
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
-			}
-			else
-			{
-				/*
-				 * There may have two kinds of Mismatched packets:
-				 *    a) Past packets from previous command after I was torn down
-				 *    b) Future packets from current command before my connections are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
-
-				#ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
-				#endif
-
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
-			}
-			pthread_mutex_unlock(&ic_control_info.lock);
-
-			/* real ack sending is after lock release to decrease the lock holding time. */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
+			npkts = handleRxPackets(fd, pkts, npkts, nrecv, peers, peerLens,
+									readCounts, params);
 		}
 
 		/* pthread_yield(); */
 	}
 
-	/* Before return, we release the packet. */
-	if (pkt)
+	/* Before return, we release the packets. */
+	if (npkts > 0)
 	{
 		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
+		for (i = 0; i < npkts; i++)
+			freeRxBuffer(&rx_buffer_pool, pkts[i]);
+		npkts = 0;
 		pthread_mutex_unlock(&ic_control_info.lock);
 	}
 
@@ -6451,7 +7536,7 @@ cacheFuturePacket(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len)
 
 	conn->pkt_q[pkt->seq - 1] = (uint8 *) pkt;
 	rx_buffer_pool.maxCount++;
-	ic_statistics.startupCachedPktNum++;
+	pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&ic_statistics.startupCachedPktNum, 1);
 	return true;
 }
 
@@ -6687,8 +7772,12 @@ WaitInterconnectQuitUDPIFC(void)
 
 	if(ic_control_info.threadCreated)
 	{
+		/*
+		 * The dummy packet wakes up only one of the rx-threads, the others
+		 * notice the shutdown flag within RX_THREAD_POLL_TIMEOUT.
+		 */
 		SendDummyPacket();
-		pthread_join(ic_control_info.threadHandle, NULL);
+		joinRxThreads();
 	}
 	ic_control_info.threadCreated = false;
 }
@@ -0,0 +1,267 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"
+#include "utils/memutils.h"
+
+#include "../cdbhash.c"
+
+#define NUM_VALUES 8
+
+/*
+ * A pg_type tuple, as returned by typeidType(), that has just the fields
+ * typeIsEnumType() looks at.
+ */
+static HeapTuple
+make_type_tuple(bool isEnum)
+{
+	Size		hoff = MAXALIGN(offsetof(HeapTupleHeaderData, t_bits));
+	HeapTuple	tuple = (HeapTuple) palloc0(sizeof(HeapTupleData));
+	Form_pg_type typeform;
+
+	tuple->t_data = (HeapTupleHeader) palloc0(hoff + sizeof(FormData_pg_type));
+	tuple->t_data->t_hoff = hoff;
+
+	typeform = (Form_pg_type) GETSTRUCT(tuple);
+	typeform->typtype = isEnum ? 'e' : 'b';
+	typeform->typinput = isEnum ? F_ENUM_IN : InvalidOid;
+
+	return tuple;
+}
+
+/*
+ * Expect typeIsEnumType() to look up the type the given number of times.
+ */
+static void
+expect_type_lookups(Oid type, bool isEnum, int count)
+{
+	HeapTuple	tuple = make_type_tuple(isEnum);
+
+	expect_value_count(typeidType, id, type, count);
+	will_return_count(typeidType, tuple, count);
+	expect_value_count(ReleaseSysCache, tuple, tuple, count);
+	will_be_called_count(ReleaseSysCache, count);
+}
+
+/*
+ * Check that cdbhashbatch() gives every value the same hash value as
+ * cdbhash() or cdbhashnull() does, starting from the given hash values.
+ */
+static void
+check_batch(Oid type, bool isEnum, Datum *values, bool *isnull, uint32 *init)
+{
+	uint32		hashes[NUM_VALUES];
+	uint32		expected[NUM_VALUES];
+	CdbHash		h;
+	int			nvalues = 0;
+	int			i;
+
+	for (i = 0; i < NUM_VALUES; i++)
+	{
+		if (!isnull[i])
+			nvalues++;
+	}
+
+	/* once for every non-NULL value, and once for the batch */
+	expect_type_lookups(type, isEnum, nvalues + 1);
+
+	for (i = 0; i < NUM_VALUES; i++)
+	{
+		h.hash = init[i];
+		if (isnull[i])
+			cdbhashnull(&h);
+		else
+			cdbhash(&h, values[i], type);
+		expected[i] = h.hash;
+	}
+
+	memcpy(hashes, init, sizeof(hashes));
+	cdbhashbatch(hashes, values, isnull, NUM_VALUES, type);
+
+	for (i = 0; i < NUM_VALUES; i++)
+		assert_int_equal(hashes[i], expected[i]);
+}
+
+/*
+ * Check the values both as the first key of the tuples, and as a key that
+ * follows others.
+ */
+static void
+check_batch_keys(Oid type, bool isEnum, Datum *values, bool *isnull)
+{
+	uint32		init[NUM_VALUES];
+	int			i;
+
+	cdbhashinitbatch(init, NUM_VALUES);
+	for (i = 0; i < NUM_VALUES; i++)
+		assert_int_equal(init[i], FNV1_32_INIT);
+	check_batch(type, isEnum, values, isnull, init);
+
+	for (i = 0; i < NUM_VALUES; i++)
+		init[i] = 0x9e3779b9 * (i + 1);
+	check_batch(type, isEnum, values, isnull, init);
+}
+
+void
+test__cdbhashbatch__int(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES] = {false, false, false, true, false, false, false, false};
+	int16		int2s[NUM_VALUES] = {0, 1, -1, 0, 42, -4242, PG_INT16_MAX, PG_INT16_MIN};
+	int32		int4s[NUM_VALUES] = {0, 1, -1, 0, 42, -424242, PG_INT32_MAX, PG_INT32_MIN};
+	int64		int8s[NUM_VALUES] = {0, 1, -1, 0, INT64CONST(4242424242),
+		INT64CONST(-4242424242), PG_INT64_MAX, PG_INT64_MIN};
+	int			i;
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = Int16GetDatum(int2s[i]);
+	check_batch_keys(INT2OID, false, values, isnull);
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = Int32GetDatum(int4s[i]);
+	check_batch_keys(INT4OID, false, values, isnull);
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = Int64GetDatum(int8s[i]);
+	check_batch_keys(INT8OID, false, values, isnull);
+}
+
+void
+test__cdbhashbatch__oid(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES] = {false, true, false, false, false, false, false, false};
+	Oid			oids[NUM_VALUES] = {InvalidOid, 0, 1, 1259, 16384, 0x7fffffff, 0x80000000, 0xffffffff};
+	Oid			types[] = {OIDOID, REGPROCOID, REGPROCEDUREOID, REGOPEROID,
+		REGOPERATOROID, REGCLASSOID, REGTYPEOID};
+	int			i;
+	int			t;
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = ObjectIdGetDatum(oids[i]);
+
+	for (t = 0; t < lengthof(types); t++)
+		check_batch_keys(types[t], false, values, isnull);
+}
+
+void
+test__cdbhashbatch__enum(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES] = {false, false, false, false, false, false, true, false};
+	Oid			enumTypeOid = 16390;
+	int			i;
+
+	/* enum values are the OIDs of their pg_enum rows */
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = ObjectIdGetDatum(16391 + i * 7);
+
+	check_batch_keys(enumTypeOid, true, values, isnull);
+}
+
+void
+test__cdbhashbatch__date_timestamp(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES] = {false, false, false, false, false, true, false, false};
+	DateADT		dates[NUM_VALUES] = {0, 1, -1, 6000, -730000, 0, DATEVAL_NOBEGIN, DATEVAL_NOEND};
+	int64		usecs[NUM_VALUES] = {0, 1, -1, INT64CONST(518400000000000),
+		INT64CONST(-63072000000000), 0, PG_INT64_MIN, PG_INT64_MAX};
+	int			i;
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = DateADTGetDatum(dates[i]);
+	check_batch_keys(DATEOID, false, values, isnull);
+
+#ifdef HAVE_INT64_TIMESTAMP
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = TimestampGetDatum((Timestamp) usecs[i]);
+	check_batch_keys(TIMESTAMPOID, false, values, isnull);
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = TimestampTzGetDatum((TimestampTz) usecs[i]);
+	check_batch_keys(TIMESTAMPTZOID, false, values, isnull);
+#endif
+}
+
+/*
+ * A type without a batch loop of its own is hashed value by value.
+ */
+void
+test__cdbhashbatch__fallback(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES] = {false, false, false, false, true, false, false, false};
+	float8		float8s[NUM_VALUES] = {0.0, -0.0, 1.5, -1.5, 0.0, 1e300,
+		get_float8_infinity(), get_float8_nan()};
+	int			i;
+
+	for (i = 0; i < NUM_VALUES; i++)
+		values[i] = Float8GetDatum(float8s[i]);
+
+	check_batch_keys(FLOAT8OID, false, values, isnull);
+}
+
+void
+test__cdbhashbatch__all_null(void **state)
+{
+	Datum		values[NUM_VALUES];
+	bool		isnull[NUM_VALUES];
+	int			i;
+
+	for (i = 0; i < NUM_VALUES; i++)
+	{
+		values[i] = Int32GetDatum(i);
+		isnull[i] = true;
+	}
+
+	check_batch_keys(INT4OID, false, values, isnull);
+}
+
+void
+test__cdbhashreducebatch(void **state)
+{
+	uint32		hashes[NUM_VALUES] = {0, 1, 2, 3, 0x7fffffff, 0x80000000, 0xdeadbeef, 0xffffffff};
+	uint32		reduced[NUM_VALUES];
+	int			numsegs[] = {1, 3, 4, 7, 16};
+	CdbHash		h;
+	int			s;
+	int			i;
+
+	for (s = 0; s < lengthof(numsegs); s++)
+	{
+		h.numsegs = numsegs[s];
+		h.reducealg = ispowof2(numsegs[s]) ? REDUCE_BITMASK : REDUCE_LAZYMOD;
+
+		memcpy(reduced, hashes, sizeof(reduced));
+		cdbhashreducebatch(&h, reduced, NUM_VALUES);
+
+		for (i = 0; i < NUM_VALUES; i++)
+		{
+			h.hash = hashes[i];
+			assert_int_equal(reduced[i], cdbhashreduce(&h));
+		}
+	}
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__cdbhashbatch__int),
+		unit_test(test__cdbhashbatch__oid),
+		unit_test(test__cdbhashbatch__enum),
+		unit_test(test__cdbhashbatch__date_timestamp),
+		unit_test(test__cdbhashbatch__fallback),
+		unit_test(test__cdbhashbatch__all_null),
+		unit_test(test__cdbhashreducebatch)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -17,10 +17,13 @@
 
 extern "C" {
 #include "postgres.h"  // NOLINT(build/include)
+#include "cdb/cdbvars.h"
 #include "executor/nodeAgg.h"
 #include "utils/palloc.h"
 #include "executor/executor.h"
 #include "nodes/nodes.h"
+#include "utils/tuplesort.h"
+#include "utils/tuplesort_mk.h"
 }
 
 namespace llvm {
@@ -310,6 +313,58 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceTransitionFunction(
   return true;
 }
 
+void AdvanceAggregatesCodegen::GenerateAddToSortState(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    int aggno,
+    llvm::Value* llvm_value,
+    llvm::Value* llvm_isnull) {
+  auto irb = codegen_utils->ir_builder();
+  AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
+  llvm::Function* advance_aggregates_func = irb->GetInsertBlock()->getParent();
+
+  llvm::BasicBlock* put_datum_block = codegen_utils->CreateBasicBlock(
+      "put_datum_block_aggno_" + std::to_string(aggno),
+      advance_aggregates_func);
+  llvm::BasicBlock* end_put_datum_block = codegen_utils->CreateBasicBlock(
+      "end_put_datum_block_aggno_" + std::to_string(aggno),
+      advance_aggregates_func);
+
+  // If the transfn is strict, we want to check for nullity before storing the
+  // row in the sorter, to save space if there are a lot of nulls.
+  if (peraggstate->transfn.fn_strict) {
+    irb->CreateCondBr(llvm_isnull,
+                      end_put_datum_block /* true */,
+                      put_datum_block /* false */);
+  } else {
+    irb->CreateBr(put_datum_block);
+  }
+
+  // put_datum_block
+  // ---------------
+  // The sorter is created for every group by initialize_aggregates, so we
+  // load it at execution time.
+  irb->SetInsertPoint(put_datum_block);
+  llvm::Value* llvm_sortstate = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          codegen_utils->GetConstant(peraggstate),
+          &AggStatePerAggData::sortstate));
+  // gp_enable_mk_sort cannot change while the query is running.
+  if (gp_enable_mk_sort) {
+    irb->CreateCall(
+        codegen_utils->GetOrRegisterExternalFunction(tuplesort_putdatum_mk,
+                                                     "tuplesort_putdatum_mk"),
+        {llvm_sortstate, llvm_value, llvm_isnull});
+  } else {
+    irb->CreateCall(
+        codegen_utils->GetOrRegisterExternalFunction(tuplesort_putdatum,
+                                                     "tuplesort_putdatum"),
+        {llvm_sortstate, llvm_value, llvm_isnull});
+  }
+  irb->CreateBr(end_put_datum_block);
+
+  irb->SetInsertPoint(end_put_datum_block);
+}
+
 bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
     gpcodegen::GpCodegenUtils* codegen_utils) {
 
@@ -387,11 +442,6 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
 
     AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
 
-    if (peraggstate->numSortCols > 0) {
-      elog(DEBUG1, "We don't codegen DISTINCT and/or ORDER BY case");
-      return false;
-    }
-
     Aggref *aggref = peraggstate->aggref;
     if (!aggref) {
       elog(DEBUG1, "We don't codegen non-aggref functions");
@@ -405,6 +455,18 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
     int nargs = peraggstate->transfn.fn_nargs - 1;
     assert(nargs >= 0);
 
+    // DISTINCT aggregates feed their input to a sorter, and the transition
+    // function is applied on the sorted input by process_sorted_aggregate.
+    bool is_distinct = peraggstate->numSortCols > 0;
+    if (is_distinct && (!aggref->aggdistinct ||
+        nullptr != aggref->aggorder ||
+        1 != peraggstate->numInputs ||
+        1 != nargs)) {
+      elog(DEBUG1, "We codegen only DISTINCT aggregates of one argument, "
+           "without ORDER BY");
+      return false;
+    }
+
     // Since we do not support ordered functions, we do not need to store
     // the value of the variables, which are used as input to the aggregate
     // function, in a slot.
@@ -464,6 +526,12 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
               codegen_utils->GetConstant(i)));
     }
 
+    if (is_distinct) {
+      GenerateAddToSortState(codegen_utils, aggno,
+                             llvm_in_args[1], llvm_in_args_isNull[1]);
+      continue;
+    }
+
     gpcodegen::PGFuncGeneratorInfo pg_func_info(
         advance_aggregates_func,
         overflow_block,
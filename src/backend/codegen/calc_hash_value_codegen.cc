@@ -0,0 +1,221 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    calc_hash_value_codegen.cc
+//
+//  @doc:
+//    Generates code for calc_hash_value function.
+//
+//---------------------------------------------------------------------------
+#include <string>
+
+#include "codegen/calc_hash_value_codegen.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/pg_hash_func_generator.h"
+
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/IRBuilder.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "access/hash.h"
+#include "executor/execHHashagg.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+#include "nodes/plannodes.h"
+#include "utils/elog.h"
+#include "utils/palloc.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::CalcHashValueCodegen;
+
+constexpr char CalcHashValueCodegen::kCalcHashValuePrefix[];
+
+CalcHashValueCodegen::CalcHashValueCodegen(
+    CodegenManager* manager,
+    CalcHashValueFn regular_func_ptr,
+    CalcHashValueFn* ptr_to_regular_func_ptr,
+    AggState *aggstate)
+: BaseCodegen(manager,
+              kCalcHashValuePrefix,
+              regular_func_ptr,
+              ptr_to_regular_func_ptr),
+              aggstate_(aggstate) {
+}
+
+bool CalcHashValueCodegen::GenerateCalcHashValue(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+
+  assert(NULL != codegen_utils);
+  if (nullptr == aggstate_ ||
+      nullptr == aggstate_->hashfunctions) {
+    return false;
+  }
+
+  Agg* agg = reinterpret_cast<Agg*>(aggstate_->ss.ps.plan);
+  if (AGG_HASHED != agg->aggstrategy ||
+      agg->numCols <= 0) {
+    elog(DEBUG1, "We codegen calc_hash_value only for hashed aggregates");
+    return false;
+  }
+
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::Function* calc_hash_value_func = CreateFunction<CalcHashValueFn>(
+      codegen_utils, GetUniqueFuncName());
+
+  // BasicBlock of function entry.
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry_block", calc_hash_value_func);
+  llvm::BasicBlock* implementation_block = codegen_utils->CreateBasicBlock(
+      "implementation_block", calc_hash_value_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback_block", calc_hash_value_func);
+
+  // External functions
+  llvm::Function* llvm_slot_getattr =
+      codegen_utils->GetOrRegisterExternalFunction(slot_getattr_regular,
+                                                   "slot_getattr_regular");
+  llvm::Function* llvm_MemoryContextSwitchTo =
+      codegen_utils->GetOrRegisterExternalFunction(MemoryContextSwitchTo,
+                                                   "MemoryContextSwitchTo");
+  llvm::Function* llvm_hash_any =
+      codegen_utils->GetOrRegisterExternalFunction(hash_any, "hash_any");
+
+  // Function arguments to calc_hash_value
+  llvm::Value* llvm_aggstate_arg = ArgumentByPosition(
+      calc_hash_value_func, 0);
+  llvm::Value* llvm_inputslot_arg = ArgumentByPosition(
+      calc_hash_value_func, 1);
+
+  // Generation-time constants
+  llvm::Value* llvm_aggstate = codegen_utils->GetConstant(aggstate_);
+  llvm::Value *llvm_tuplecontext = codegen_utils->GetConstant<MemoryContext>(
+      aggstate_->tmpcontext->ecxt_per_tuple_memory);
+
+  // entry block
+  // ----------
+  irb->SetInsertPoint(entry_block);
+
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils, DEBUG1,
+                     "Codegen'ed calc_hash_value called!");
+#endif
+
+  // Compare aggstate given during code generation and the one passed
+  // in as an argument to calc_hash_value
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_aggstate, llvm_aggstate_arg),
+      implementation_block /* true */,
+      fallback_block /* false */);
+
+  // implementation block
+  // ----------
+  irb->SetInsertPoint(implementation_block);
+
+  // oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+  llvm::Value *llvm_oldContext = irb->CreateCall(llvm_MemoryContextSwitchTo,
+                                                 {llvm_tuplecontext});
+
+  // The hash table, and its hashkey_buf, are created at execution time.
+  llvm::Value* llvm_hashtable = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_aggstate_arg, &AggState::hhashtable));
+  llvm::Value* llvm_hashkey_buf = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_hashtable, &HashAggTable::hashkey_buf));
+
+  llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "isnull");
+
+  for (int i = 0; i < agg->numCols; i++) {
+    llvm::BasicBlock* hash_key_block = codegen_utils->CreateBasicBlock(
+        "hash_key_block_" + std::to_string(i), calc_hash_value_func);
+    llvm::BasicBlock* store_key_block = codegen_utils->CreateBasicBlock(
+        "store_key_block_" + std::to_string(i), calc_hash_value_func);
+
+    // value = slot_getattr(inputslot, att, &isnull);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                     llvm_isnull_ptr);
+    llvm::Value* llvm_value = irb->CreateCall(llvm_slot_getattr, {
+        llvm_inputslot_arg,
+        codegen_utils->GetConstant<int>(agg->grpColIdx[i]),
+        llvm_isnull_ptr});
+    llvm::BasicBlock* null_key_block = irb->GetInsertBlock();
+    irb->CreateCondBr(irb->CreateLoad(llvm_isnull_ptr),
+                      store_key_block /* true */,
+                      hash_key_block /* false */);
+
+    // hash_key_block
+    // --------------
+    // hashkey_buf[i] = DatumGetUInt32(FunctionCall1(info, value));
+    irb->SetInsertPoint(hash_key_block);
+    llvm::Value* llvm_hash = nullptr;
+    if (!PGHashFuncGenerator::GenerateHashDatum(
+        codegen_utils, aggstate_->hashfunctions[i].fn_oid,
+        calc_hash_value_func, llvm_value, &llvm_hash)) {
+      return false;
+    }
+    llvm::BasicBlock* hash_key_last_block = irb->GetInsertBlock();
+    irb->CreateBr(store_key_block);
+
+    // store_key_block
+    // ---------------
+    // Nulls are treated as having hash key 0xdeadbeef.
+    irb->SetInsertPoint(store_key_block);
+    llvm::PHINode* llvm_key = irb->CreatePHI(
+        codegen_utils->GetType<HashKey>(), 2);
+    llvm_key->addIncoming(codegen_utils->GetConstant<HashKey>(0xdeadbeef),
+                          null_key_block);
+    llvm_key->addIncoming(llvm_hash, hash_key_last_block);
+    irb->CreateStore(llvm_key, irb->CreateInBoundsGEP(
+        llvm_hashkey_buf, codegen_utils->GetConstant(i)));
+  }
+
+  // MemoryContextSwitchTo(oldContext);
+  irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+
+  // return hash_any(hashkey_buf, numCols * sizeof(HashKey));
+  llvm::Value* llvm_hash_any_result = irb->CreateCall(llvm_hash_any, {
+      irb->CreateBitCast(llvm_hashkey_buf,
+                         codegen_utils->GetType<unsigned char*>()),
+      codegen_utils->GetConstant<int>(agg->numCols * sizeof(HashKey))});
+  irb->CreateRet(irb->CreateTrunc(llvm_hash_any_result,
+                                  codegen_utils->GetType<uint32>()));
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  EXPAND_CREATE_ELOG(codegen_utils, DEBUG1,
+                     "Falling back to regular calc_hash_value");
+  codegen_utils->CreateFallback<CalcHashValueFn>(
+      codegen_utils->GetOrRegisterExternalFunction(calc_hash_value,
+                                                   "calc_hash_value"),
+      calc_hash_value_func);
+
+  return true;
+}
+
+
+bool CalcHashValueCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateCalcHashValue(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "CalcHashValue was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "CalcHashValue generation failed!");
+    return false;
+  }
+}
@@ -10,15 +10,23 @@
 //
 //---------------------------------------------------------------------------
 #include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "llvm/Support/raw_ostream.h"
 
 #include "codegen/codegen_interface.h"
 #include "codegen/codegen_manager.h"
+#include "codegen/codegen_module_cache.h"
 #include "codegen/codegen_wrapper.h"
 #include "codegen/utils/codegen_utils.h"
 #include "codegen/utils/gp_codegen_utils.h"
@@ -30,11 +38,21 @@ extern "C" {
 
 using gpcodegen::CodegenManager;
 
-CodegenManager::CodegenManager(const std::string& module_name) {
+CodegenManager::CodegenManager(const std::string& module_name)
+    : compilation_status_(false),
+      compilation_done_(false),
+      compile_time_ms_(0) {
   module_name_ = module_name;
   codegen_utils_.reset(new gpcodegen::GpCodegenUtils(module_name));
 }
 
+CodegenManager::~CodegenManager() {
+  // The compilation thread works on codegen_utils_; wait for it to finish.
+  if (IsCompilationPending()) {
+    compile_thread_.join();
+  }
+}
+
 bool CodegenManager::EnrollCodeGenerator(
     CodegenFuncLifespan funcLifespan, CodegenInterface* generator) {
   // Only CodegenFuncLifespan_Parameter_Invariant is supported as of now
@@ -61,11 +79,9 @@ unsigned int CodegenManager::GenerateCode() {
 }
 
 unsigned int CodegenManager::PrepareGeneratedFunctions() {
-  unsigned int success_count = 0;
-
   // If no generator registered, just return with success count as 0
   if (enrolled_code_generators_.empty()) {
-    return success_count;
+    return 0;
   }
 
   STATIC_ASSERT_OPTIMIZATION_LEVEL(kNone,
@@ -77,12 +93,78 @@ unsigned int CodegenManager::PrepareGeneratedFunctions() {
   STATIC_ASSERT_OPTIMIZATION_LEVEL(kAggressive,
                                    CODEGEN_OPTIMIZATION_LEVEL_AGGRESSIVE);
 
+  if (codegen_module_cache) {
+    module_cache_.reset(new CodegenModuleCache(
+        codegen_optimization_level,
+        static_cast<std::uint64_t>(codegen_module_cache_size) * 1024));
+  }
+
+  const gpcodegen::GpCodegenUtils::OptimizationLevel optimization_level =
+      gpcodegen::GpCodegenUtils::OptimizationLevel(codegen_optimization_level);
+
+  // In the asynchronous mode the regular functions stay in place until
+  // PollGeneratedFunctions() finds the compilation finished.
+  if (codegen_async_compile && StartBackgroundCompilation(optimization_level)) {
+    return 0;
+  }
+
+  CompileModule(optimization_level);
+  return SetToGenerated();
+}
+
+bool CodegenManager::PollGeneratedFunctions() {
+  if (!IsCompilationPending() ||
+      !compilation_done_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  compile_thread_.join();
+  SetToGenerated();
+  return true;
+}
+
+void CodegenManager::CompileModule(
+    gpcodegen::GpCodegenUtils::OptimizationLevel optimization_level) {
+  auto start_time = std::chrono::steady_clock::now();
+
   // Call GpCodegenUtils to compile entire module
-  bool compilation_status = codegen_utils_->PrepareForExecution(
-      gpcodegen::GpCodegenUtils::OptimizationLevel(codegen_optimization_level),
-      true);
+  compilation_status_ = codegen_utils_->PrepareForExecution(
+      optimization_level,
+      true,
+      module_cache_.get());
+  if (compilation_status_) {
+    codegen_utils_->CompileForExecution();
+  }
+
+  compile_time_ms_ = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start_time).count();
+}
+
+bool CodegenManager::StartBackgroundCompilation(
+    gpcodegen::GpCodegenUtils::OptimizationLevel optimization_level) {
+  // Signals must keep being delivered to the backend's main thread, so
+  // block all of them in the compilation thread, which inherits the mask.
+  sigset_t all_signals;
+  sigset_t old_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+
+  bool started = true;
+  try {
+    compile_thread_ = std::thread([this, optimization_level]() {
+      CompileModule(optimization_level);
+      compilation_done_.store(true, std::memory_order_release);
+    });
+  } catch (const std::system_error&) {
+    started = false;
+  }
 
-  if (!compilation_status) {
+  pthread_sigmask(SIG_SETMASK, &old_signals, nullptr);
+  return started;
+}
+
+unsigned int CodegenManager::SetToGenerated() {
+  unsigned int success_count = 0;
+  if (!compilation_status_) {
     return success_count;
   }
 
@@ -96,6 +178,14 @@ unsigned int CodegenManager::PrepareGeneratedFunctions() {
   return success_count;
 }
 
+int CodegenManager::GetCacheHits() const {
+  return module_cache_ ? module_cache_->hits() : 0;
+}
+
+int CodegenManager::GetCacheMisses() const {
+  return module_cache_ ? module_cache_->misses() : 0;
+}
+
 void CodegenManager::NotifyParameterChange() {
   // no support for parameter change yet
   assert(false);
@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_module_cache.cc
+//
+//  @doc:
+//    On-disk cache of compiled object code for generated modules
+//
+//---------------------------------------------------------------------------
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "codegen/codegen_module_cache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+using gpcodegen::CodegenModuleCache;
+
+constexpr char CodegenModuleCache::kCacheDirectory[];
+
+CodegenModuleCache::CodegenModuleCache(int optimization_level,
+                                       std::uint64_t max_size)
+    : optimization_level_(optimization_level),
+      max_size_(max_size),
+      hits_(0),
+      misses_(0) {
+}
+
+std::string CodegenModuleCache::ComputeKey(const llvm::Module* module) {
+  auto it = keys_.find(module);
+  if (it != keys_.end()) {
+    return it->second;
+  }
+
+  std::string ir;
+  llvm::raw_string_ostream out(ir);
+  module->print(out, nullptr);
+  out.flush();
+
+  // Skip the "; ModuleID = ..." line, which only names the module.
+  llvm::StringRef ir_ref(ir);
+  if (ir_ref.startswith("; ModuleID")) {
+    ir_ref = ir_ref.split('\n').second;
+  }
+
+  llvm::MD5 hash;
+  hash.update(ir_ref);
+  hash.update(std::to_string(optimization_level_));
+  hash.update(llvm::sys::getHostCPUName());
+  hash.update(LLVM_VERSION_STRING);
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+  llvm::SmallString<32> digest;
+  llvm::MD5::stringifyResult(result, digest);
+
+  std::string key = digest.str().str();
+  keys_.emplace(module, key);
+  return key;
+}
+
+std::string CodegenModuleCache::GetObjectPath(const std::string& key) {
+  return std::string(kCacheDirectory) + "/" + key + ".o";
+}
+
+void CodegenModuleCache::notifyObjectCompiled(const llvm::Module* module,
+                                              llvm::MemoryBufferRef object) {
+  // Failing to store the object only costs a compilation to the next backend
+  // generating the same module, so errors are silently ignored.
+  if (0 == max_size_ || object.getBufferSize() > max_size_) {
+    return;
+  }
+
+  std::error_code error =
+      llvm::sys::fs::create_directory(kCacheDirectory, true);
+  if (error) {
+    return;
+  }
+
+  // Write to a private file first and rename it into place, so that other
+  // backends never read a partially written object.
+  const std::string path = GetObjectPath(ComputeKey(module));
+  const std::string temp_path = path + "." + std::to_string(getpid());
+  {
+    llvm::raw_fd_ostream out(temp_path, error, llvm::sys::fs::F_None);
+    if (error) {
+      return;
+    }
+    out << object.getBuffer();
+    out.close();
+    if (out.has_error()) {
+      out.clear_error();
+      llvm::sys::fs::remove(temp_path);
+      return;
+    }
+  }
+
+  error = llvm::sys::fs::rename(temp_path, path);
+  if (error) {
+    llvm::sys::fs::remove(temp_path);
+    return;
+  }
+
+  EvictObjects();
+}
+
+void CodegenModuleCache::EvictObjects() {
+  struct CachedObject {
+    std::string path;
+    time_t mtime;
+    std::uint64_t size;
+  };
+  std::vector<CachedObject> objects;
+  std::uint64_t total_size = 0;
+
+  // Temporary files of other backends are counted too, and may be removed
+  // if they are old enough: their rename then fails and is ignored.
+  std::error_code error;
+  for (llvm::sys::fs::directory_iterator it(kCacheDirectory, error), end;
+       !error && it != end; it.increment(error)) {
+    struct stat st;
+    if (0 != stat(it->path().c_str(), &st) || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    objects.push_back({it->path(), st.st_mtime,
+                       static_cast<std::uint64_t>(st.st_size)});
+    total_size += st.st_size;
+  }
+  if (total_size <= max_size_) {
+    return;
+  }
+
+  std::sort(objects.begin(), objects.end(),
+            [](const CachedObject& a, const CachedObject& b) {
+              return a.mtime < b.mtime;
+            });
+  for (const CachedObject& object : objects) {
+    if (total_size <= max_size_) {
+      break;
+    }
+    // Another backend may have removed it already; either way it is gone.
+    llvm::sys::fs::remove(object.path);
+    total_size -= object.size;
+  }
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CodegenModuleCache::getObject(
+    const llvm::Module* module) {
+  const std::string path = GetObjectPath(ComputeKey(module));
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> object =
+      llvm::MemoryBuffer::getFile(path, -1, false);
+  if (!object) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  // Mark the object as recently used, so that it is evicted last.
+  utime(path.c_str(), nullptr);
+  return std::move(object.get());
+}
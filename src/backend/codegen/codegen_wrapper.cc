@@ -15,11 +15,15 @@
 #include <assert.h>
 #include <string>
 #include <type_traits>
+#include <unordered_set>
 
 #include "codegen/codegen_config.h"
 #include "codegen/base_codegen.h"
+#include "codegen/calc_hash_value_codegen.h"
 #include "codegen/codegen_manager.h"
 #include "codegen/exec_eval_expr_codegen.h"
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/exec_scan_filter_project_codegen.h"
 #include "codegen/exec_variable_list_codegen.h"
 #include "codegen/expr_tree_generator.h"
 #include "codegen/utils/gp_codegen_utils.h"
@@ -34,11 +38,20 @@ using gpcodegen::CodegenManager;
 using gpcodegen::BaseCodegen;
 using gpcodegen::ExecVariableListCodegen;
 using gpcodegen::ExecEvalExprCodegen;
+using gpcodegen::ExecScanFilterProjectCodegen;
 using gpcodegen::AdvanceAggregatesCodegen;
+using gpcodegen::CalcHashValueCodegen;
+using gpcodegen::ExecHashGetHashValueCodegen;
 
 // Current code generator manager that oversees all code generators
 static void* ActiveCodeGeneratorManager = nullptr;
 
+// Managers compiling in the background whose generated functions have not
+// been swapped in yet; CodeGeneratorManagerPendingCount is their number
+static std::unordered_set<CodegenManager*> PendingCodeGeneratorManagers;
+
+int CodeGeneratorManagerPendingCount = 0;
+
 // Perform global set-up tasks for code generation. Returns 0 on
 // success, nonzero on error.
 unsigned int InitCodegen() {
@@ -63,7 +76,39 @@ unsigned int CodeGeneratorManagerPrepareGeneratedFunctions(void* manager) {
   if (!codegen) {
     return 0;
   }
-  return static_cast<CodegenManager*>(manager)->PrepareGeneratedFunctions();
+  CodegenManager* codegen_manager = static_cast<CodegenManager*>(manager);
+  unsigned int success_count = codegen_manager->PrepareGeneratedFunctions();
+  if (codegen_manager->IsCompilationPending()) {
+    PendingCodeGeneratorManagers.insert(codegen_manager);
+    CodeGeneratorManagerPendingCount = PendingCodeGeneratorManagers.size();
+  }
+  return success_count;
+}
+
+bool CodeGeneratorManagerPollGeneratedFunctions(void* manager) {
+  if (nullptr == manager ||
+      !static_cast<CodegenManager*>(manager)->PollGeneratedFunctions()) {
+    return false;
+  }
+  assert(PendingCodeGeneratorManagers.count(
+      static_cast<CodegenManager*>(manager)) == 1);
+  PendingCodeGeneratorManagers.erase(static_cast<CodegenManager*>(manager));
+  CodeGeneratorManagerPendingCount = PendingCodeGeneratorManagers.size();
+  return true;
+}
+
+void CodeGeneratorManagerAbortPending() {
+  // The plan states referencing these managers are gone without
+  // ExecEndNode, so nobody else destroys them. The destructor waits for the
+  // compilation thread.
+  for (CodegenManager* manager : PendingCodeGeneratorManagers) {
+    if (manager == ActiveCodeGeneratorManager) {
+      ActiveCodeGeneratorManager = nullptr;
+    }
+    delete manager;
+  }
+  PendingCodeGeneratorManagers.clear();
+  CodeGeneratorManagerPendingCount = 0;
 }
 
 unsigned int CodeGeneratorManagerNotifyParameterChange(void* manager) {
@@ -91,7 +136,28 @@ char* CodeGeneratorManagerGetExplainString(void* manager) {
   return return_string->data;
 }
 
+void CodeGeneratorManagerGetCompileStats(void* manager,
+                                         int* cache_hits,
+                                         int* cache_misses,
+                                         double* compile_ms) {
+  assert(nullptr != cache_hits &&
+         nullptr != cache_misses &&
+         nullptr != compile_ms);
+  *cache_hits = 0;
+  *cache_misses = 0;
+  *compile_ms = 0;
+  if (!codegen || nullptr == manager) {
+    return;
+  }
+  CodegenManager* codegen_manager = static_cast<CodegenManager*>(manager);
+  *cache_hits = codegen_manager->GetCacheHits();
+  *cache_misses = codegen_manager->GetCacheMisses();
+  *compile_ms = codegen_manager->GetCompileTimeMs();
+}
+
 void CodeGeneratorManagerDestroy(void* manager) {
+  PendingCodeGeneratorManagers.erase(static_cast<CodegenManager*>(manager));
+  CodeGeneratorManagerPendingCount = PendingCodeGeneratorManagers.size();
   delete (static_cast<CodegenManager*>(manager));
 }
 
@@ -173,3 +239,50 @@ void* AdvanceAggregatesCodegenEnroll(
   return generator;
 }
 
+
+void* ExecScanFilterProjectCodegenEnroll(
+    ExecScanFilterProjectFn regular_func_ptr,
+    ExecScanFilterProjectFn* ptr_to_chosen_func_ptr,
+    ScanState *node) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  ExecScanFilterProjectCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<ExecScanFilterProjectCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          node);
+  return generator;
+}
+
+void* CalcHashValueCodegenEnroll(
+    CalcHashValueFn regular_func_ptr,
+    CalcHashValueFn* ptr_to_chosen_func_ptr,
+    AggState *aggstate) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  CalcHashValueCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<CalcHashValueCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          aggstate);
+  return generator;
+}
+
+void* ExecHashGetHashValueCodegenEnroll(
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_chosen_func_ptr,
+    HashJoinState *hjstate,
+    bool outer_tuple) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  ExecHashGetHashValueCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<ExecHashGetHashValueCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          hjstate,
+          outer_tuple);
+  return generator;
+}
@@ -0,0 +1,321 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.cc
+//
+//  @doc:
+//    Generates code for ExecHashGetHashValue function.
+//
+//---------------------------------------------------------------------------
+#include <string>
+#include <vector>
+
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/pg_hash_func_generator.h"
+
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/IRBuilder.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "executor/hashjoin.h"
+#include "executor/nodeHash.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "nodes/primnodes.h"
+#include "utils/elog.h"
+#include "utils/lsyscache.h"
+#include "utils/memaccounting.h"
+#include "utils/memutils.h"
+#include "utils/palloc.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::ExecHashGetHashValueCodegen;
+
+constexpr char ExecHashGetHashValueCodegen::kExecHashGetHashValuePrefix[];
+
+ExecHashGetHashValueCodegen::ExecHashGetHashValueCodegen(
+    CodegenManager* manager,
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+    HashJoinState *hjstate,
+    bool outer_tuple)
+: BaseCodegen(manager,
+              kExecHashGetHashValuePrefix,
+              regular_func_ptr,
+              ptr_to_regular_func_ptr),
+              hjstate_(hjstate),
+              outer_tuple_(outer_tuple) {
+}
+
+bool ExecHashGetHashValueCodegen::GenerateExecHashGetHashValue(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+
+  assert(NULL != codegen_utils);
+  if (nullptr == hjstate_) {
+    return false;
+  }
+
+  HashState* hashState = reinterpret_cast<HashState*>(
+      innerPlanState(hjstate_));
+  List* hashkeys = outer_tuple_ ?
+      hjstate_->hj_OuterHashKeys : hjstate_->hj_InnerHashKeys;
+  if (nullptr == hashState ||
+      list_length(hashkeys) != list_length(hjstate_->hj_HashOperators)) {
+    return false;
+  }
+
+  // Collect the attribute, hash function and strictness of every key the way
+  // ExecHashTableCreate() does, and give up on anything but plain Vars.
+  std::vector<AttrNumber> key_attnos;
+  std::vector<Oid> key_hash_funcs;
+  std::vector<bool> key_strict;
+  ListCell* hk = nullptr;
+  ListCell* ho = nullptr;
+  forboth(hk, hashkeys, ho, hjstate_->hj_HashOperators) {
+    ExprState* keyexpr = reinterpret_cast<ExprState*>(lfirst(hk));
+    Oid hashop = lfirst_oid(ho);
+    Oid left_hashfn = InvalidOid;
+    Oid right_hashfn = InvalidOid;
+
+    if (nullptr == keyexpr->expr ||
+        !IsA(keyexpr->expr, Var)) {
+      elog(DEBUG1, "We codegen ExecHashGetHashValue only for Var hash keys");
+      return false;
+    }
+    Var* var = reinterpret_cast<Var*>(keyexpr->expr);
+    if ((outer_tuple_ ? OUTER : INNER) != var->varno ||
+        var->varattno <= 0) {
+      elog(DEBUG1, "Unsupported Var in hash keys");
+      return false;
+    }
+    if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn)) {
+      return false;
+    }
+
+    key_attnos.push_back(var->varattno);
+    key_hash_funcs.push_back(outer_tuple_ ? left_hashfn : right_hashfn);
+    key_strict.push_back(op_strict(hashop));
+  }
+
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::Function* exec_hash_get_hash_value_func =
+      CreateFunction<ExecHashGetHashValueFn>(
+          codegen_utils, GetUniqueFuncName());
+
+  // BasicBlock of function entry.
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry_block", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* implementation_block = codegen_utils->CreateBasicBlock(
+      "implementation_block", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback_block", exec_hash_get_hash_value_func);
+
+  // External functions
+  llvm::Function* llvm_slot_getattr =
+      codegen_utils->GetOrRegisterExternalFunction(slot_getattr_regular,
+                                                   "slot_getattr_regular");
+  llvm::Function* llvm_MemoryContextSwitchTo =
+      codegen_utils->GetOrRegisterExternalFunction(MemoryContextSwitchTo,
+                                                   "MemoryContextSwitchTo");
+  llvm::Function* llvm_MemoryContextReset =
+      codegen_utils->GetOrRegisterExternalFunction(MemoryContextReset,
+                                                   "MemoryContextReset");
+
+  // Function arguments to ExecHashGetHashValue
+  llvm::Value* llvm_econtext_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 2);
+  llvm::Value* llvm_hashkeys_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 3);
+  llvm::Value* llvm_outer_tuple_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 4);
+  llvm::Value* llvm_keep_nulls_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 5);
+  llvm::Value* llvm_hashvalue_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 6);
+  llvm::Value* llvm_hashkeys_null_arg = ArgumentByPosition(
+      exec_hash_get_hash_value_func, 7);
+
+  // Generation-time constants
+  llvm::Value* llvm_hashkeys = codegen_utils->GetConstant(hashkeys);
+  llvm::Value* llvm_active_memory_account_ptr =
+      codegen_utils->GetConstant(&ActiveMemoryAccountId);
+
+  // entry block
+  // ----------
+  irb->SetInsertPoint(entry_block);
+
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils, DEBUG1,
+                     "Codegen'ed ExecHashGetHashValue called!");
+#endif
+
+  // We generated code for the hash keys of one side of this join only;
+  // anything else goes to the regular function.
+  irb->CreateCondBr(
+      irb->CreateAnd(
+          irb->CreateICmpEQ(llvm_hashkeys, llvm_hashkeys_arg),
+          irb->CreateICmpEQ(codegen_utils->GetConstant<bool>(outer_tuple_),
+                            llvm_outer_tuple_arg)),
+      implementation_block /* true */,
+      fallback_block /* false */);
+
+  // implementation block
+  // ----------
+  irb->SetInsertPoint(implementation_block);
+
+  // START_MEMORY_ACCOUNT(hashState->ps.plan->memoryAccountId);
+  llvm::Value* llvm_old_memory_account =
+      irb->CreateLoad(llvm_active_memory_account_ptr);
+  irb->CreateStore(
+      codegen_utils->GetConstant<MemoryAccountIdType>(
+          hashState->ps.plan->memoryAccountId),
+      llvm_active_memory_account_ptr);
+
+  // ResetExprContext(econtext);
+  llvm::Value* llvm_tuplecontext = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_econtext_arg, &ExprContext::ecxt_per_tuple_memory));
+  irb->CreateCall(llvm_MemoryContextReset, {llvm_tuplecontext});
+
+  // oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+  llvm::Value *llvm_oldContext = irb->CreateCall(llvm_MemoryContextSwitchTo,
+                                                 {llvm_tuplecontext});
+
+  // The slot holding the tuple to hash
+  llvm::Value* llvm_slot = irb->CreateLoad(
+      outer_tuple_ ?
+      codegen_utils->GetPointerToMember(
+          llvm_econtext_arg, &ExprContext::ecxt_outertuple) :
+      codegen_utils->GetPointerToMember(
+          llvm_econtext_arg, &ExprContext::ecxt_innertuple));
+
+  llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "isNull");
+
+  llvm::Value* llvm_hashkey = codegen_utils->GetConstant<uint32>(0);
+  llvm::Value* llvm_result = codegen_utils->GetConstant<bool>(true);
+  llvm::Value* llvm_hashkeys_null = codegen_utils->GetConstant<bool>(true);
+
+  for (size_t i = 0; i < key_attnos.size(); ++i) {
+    llvm::BasicBlock* null_key_block = codegen_utils->CreateBasicBlock(
+        "null_key_block_" + std::to_string(i), exec_hash_get_hash_value_func);
+    llvm::BasicBlock* hash_key_block = codegen_utils->CreateBasicBlock(
+        "hash_key_block_" + std::to_string(i), exec_hash_get_hash_value_func);
+    llvm::BasicBlock* next_key_block = codegen_utils->CreateBasicBlock(
+        "next_key_block_" + std::to_string(i), exec_hash_get_hash_value_func);
+
+    // rotate hashkey left 1 bit at each step
+    llvm_hashkey = irb->CreateOr(irb->CreateShl(llvm_hashkey, 1),
+                                 irb->CreateLShr(llvm_hashkey, 31));
+
+    // keyval = ExecEvalExpr(keyexpr, econtext, &isNull, NULL);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                     llvm_isnull_ptr);
+    llvm::Value* llvm_keyval = irb->CreateCall(llvm_slot_getattr, {
+        llvm_slot,
+        codegen_utils->GetConstant<int>(key_attnos[i]),
+        llvm_isnull_ptr});
+    irb->CreateCondBr(irb->CreateLoad(llvm_isnull_ptr),
+                      null_key_block /* true */,
+                      hash_key_block /* false */);
+
+    // null_key_block
+    // --------------
+    // If the join operator is strict, the tuple cannot match unless we keep
+    // nulls. Otherwise leave hashkey unmodified, equivalent to hashcode 0.
+    irb->SetInsertPoint(null_key_block);
+    llvm::Value* llvm_null_result = llvm_result;
+    if (key_strict[i]) {
+      llvm_null_result = irb->CreateAnd(llvm_result, llvm_keep_nulls_arg);
+    }
+    irb->CreateBr(next_key_block);
+
+    // hash_key_block
+    // --------------
+    // hashkey ^= DatumGetUInt32(FunctionCall1(&hashfunctions[i], keyval));
+    // once the tuple is known to be rejected we stop hashing.
+    irb->SetInsertPoint(hash_key_block);
+    llvm::Value* llvm_hkey = nullptr;
+    if (!PGHashFuncGenerator::GenerateHashDatum(
+        codegen_utils, key_hash_funcs[i], exec_hash_get_hash_value_func,
+        llvm_keyval, &llvm_hkey)) {
+      return false;
+    }
+    llvm::Value* llvm_hashed_key = irb->CreateSelect(
+        llvm_result, irb->CreateXor(llvm_hashkey, llvm_hkey), llvm_hashkey);
+    llvm::BasicBlock* hash_key_last_block = irb->GetInsertBlock();
+    irb->CreateBr(next_key_block);
+
+    // next_key_block
+    // --------------
+    irb->SetInsertPoint(next_key_block);
+    llvm::PHINode* llvm_next_hashkey = irb->CreatePHI(
+        codegen_utils->GetType<uint32>(), 2);
+    llvm_next_hashkey->addIncoming(llvm_hashkey, null_key_block);
+    llvm_next_hashkey->addIncoming(llvm_hashed_key, hash_key_last_block);
+    llvm::PHINode* llvm_next_result = irb->CreatePHI(
+        codegen_utils->GetType<bool>(), 2);
+    llvm_next_result->addIncoming(llvm_null_result, null_key_block);
+    llvm_next_result->addIncoming(llvm_result, hash_key_last_block);
+    llvm::PHINode* llvm_next_hashkeys_null = irb->CreatePHI(
+        codegen_utils->GetType<bool>(), 2);
+    llvm_next_hashkeys_null->addIncoming(llvm_hashkeys_null, null_key_block);
+    llvm_next_hashkeys_null->addIncoming(
+        codegen_utils->GetConstant<bool>(false), hash_key_last_block);
+
+    llvm_hashkey = llvm_next_hashkey;
+    llvm_result = llvm_next_result;
+    llvm_hashkeys_null = llvm_next_hashkeys_null;
+  }
+
+  // MemoryContextSwitchTo(oldContext);
+  irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+
+  // *hashvalue = hashkey; *hashkeys_null = ...;
+  irb->CreateStore(llvm_hashkey, llvm_hashvalue_arg);
+  irb->CreateStore(llvm_hashkeys_null, llvm_hashkeys_null_arg);
+
+  // END_MEMORY_ACCOUNT();
+  irb->CreateStore(llvm_old_memory_account, llvm_active_memory_account_ptr);
+  irb->CreateRet(llvm_result);
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  EXPAND_CREATE_ELOG(codegen_utils, DEBUG1,
+                     "Falling back to regular ExecHashGetHashValue");
+  codegen_utils->CreateFallback<ExecHashGetHashValueFn>(
+      codegen_utils->GetOrRegisterExternalFunction(ExecHashGetHashValue,
+                                                   "ExecHashGetHashValue"),
+      exec_hash_get_hash_value_func);
+
+  return true;
+}
+
+
+bool ExecHashGetHashValueCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateExecHashGetHashValue(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "ExecHashGetHashValue was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "ExecHashGetHashValue generation failed!");
+    return false;
+  }
+}
@@ -0,0 +1,383 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_scan_filter_project_codegen.cc
+//
+//  @doc:
+//    Generates code for ExecScanFilterProject function.
+//
+//---------------------------------------------------------------------------
+#include <assert.h>
+#include <stddef.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/exec_scan_filter_project_codegen.h"
+#include "codegen/expr_tree_generator.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/slot_getattr_codegen.h"
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "executor/executor.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodes.h"
+#include "nodes/pg_list.h"
+#include "utils/elog.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::ExecScanFilterProjectCodegen;
+using gpcodegen::SlotGetAttrCodegen;
+
+constexpr char ExecScanFilterProjectCodegen::kExecScanFilterProjectPrefix[];
+
+ExecScanFilterProjectCodegen::ExecScanFilterProjectCodegen(
+    CodegenManager* manager,
+    ExecScanFilterProjectFn regular_func_ptr,
+    ExecScanFilterProjectFn* ptr_to_regular_func_ptr,
+    ScanState* scan_state)
+    : BaseCodegen(manager,
+                  kExecScanFilterProjectPrefix,
+                  regular_func_ptr, ptr_to_regular_func_ptr),
+      scan_state_(scan_state),
+      gen_info_(scan_state->ps.ps_ExprContext, nullptr, nullptr, nullptr, 0),
+      slot_getattr_codegen_(nullptr),
+      proj_max_attr_(0) {
+}
+
+int ExecScanFilterProjectCodegen::ComputeInlineProjectionMaxAttr() {
+  ProjectionInfo* proj_info = scan_state_->ps.ps_ProjInfo;
+  if (nullptr == proj_info ||
+      !proj_info->pi_isVarList ||
+      nullptr == proj_info->pi_targetlist ||
+      nullptr == proj_info->pi_varSlotOffsets ||
+      nullptr == proj_info->pi_varNumbers) {
+    return 0;
+  }
+
+  int natts = scan_state_->ss_ScanTupleSlot->tts_tupleDescriptor->natts;
+  int max_attr = 0;
+  for (int i = list_length(proj_info->pi_targetlist) - 1; i >= 0; i--) {
+    // All the attributes must come from the scan tuple, and none of them may
+    // be a system attribute.
+    if (proj_info->pi_varSlotOffsets[i] !=
+        static_cast<int>(offsetof(ExprContext, ecxt_scantuple)) ||
+        proj_info->pi_varNumbers[i] <= 0 ||
+        proj_info->pi_varNumbers[i] > natts) {
+      return 0;
+    }
+    max_attr = std::max(max_attr, proj_info->pi_varNumbers[i]);
+  }
+  return max_attr;
+}
+
+bool ExecScanFilterProjectCodegen::InitDependencies() {
+  assert(nullptr != scan_state_);
+  OpExprTreeGenerator::InitializeSupportedFunction();
+
+  ListCell* l = nullptr;
+  foreach(l, scan_state_->ps.qual) {
+    ExprState* exprstate = reinterpret_cast<ExprState*>(lfirst(l));
+    std::unique_ptr<ExprTreeGenerator> qual_tree(nullptr);
+    if (!ExprTreeGenerator::VerifyAndCreateExprTree(
+        exprstate, &gen_info_, &qual_tree)) {
+      // One unsupported clause is enough to give up on the whole node.
+      qual_tree_generators_.clear();
+      return true;
+    }
+    qual_tree_generators_.push_back(std::move(qual_tree));
+  }
+
+  proj_max_attr_ = ComputeInlineProjectionMaxAttr();
+
+  // Request one slot_getattr() that deforms the scan tuple far enough for both
+  // the quals and the projection.
+  int max_attr = std::max(static_cast<int>(gen_info_.max_attr),
+                          proj_max_attr_);
+  if (max_attr > 0) {
+    slot_getattr_codegen_ = SlotGetAttrCodegen::GetCodegenInstance(
+        manager(), scan_state_->ss_ScanTupleSlot, max_attr);
+  }
+  return true;
+}
+
+bool ExecScanFilterProjectCodegen::GenerateExecScanFilterProject(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+  assert(nullptr != codegen_utils);
+
+  if (nullptr == scan_state_ ||
+      nullptr == scan_state_->ss_ScanTupleSlot ||
+      nullptr == gen_info_.econtext) {
+    return false;
+  }
+
+  if (qual_tree_generators_.size() !=
+      static_cast<size_t>(list_length(scan_state_->ps.qual))) {
+    elog(DEBUG1, "Cannot generate code for ExecScanFilterProject "
+                 "because some quals are not supported.");
+    return false;
+  }
+
+  // If slot_getattr_codegen_ is not set or generation fails
+  // we revert to use the external slot_getattr()
+  if (nullptr == slot_getattr_codegen_ ||
+      false == slot_getattr_codegen_->GenerateCode(codegen_utils)) {
+    gen_info_.llvm_slot_getattr_func =
+        codegen_utils->GetOrRegisterExternalFunction(slot_getattr_regular,
+                                                     "slot_getattr_regular");
+  } else {
+    gen_info_.llvm_slot_getattr_func =
+        slot_getattr_codegen_->GetGeneratedFunction();
+    assert(nullptr != gen_info_.llvm_slot_getattr_func);
+  }
+
+  llvm::Function* exec_scan_filter_project_func =
+      CreateFunction<ExecScanFilterProjectFn>(
+          codegen_utils, GetUniqueFuncName());
+
+  auto irb = codegen_utils->ir_builder();
+
+  // BasicBlocks
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", exec_scan_filter_project_func);
+  llvm::BasicBlock* qual_block = codegen_utils->CreateBasicBlock(
+      "qual", exec_scan_filter_project_func);
+  llvm::BasicBlock* project_block = codegen_utils->CreateBasicBlock(
+      "project", exec_scan_filter_project_func);
+  llvm::BasicBlock* reject_block = codegen_utils->CreateBasicBlock(
+      "reject", exec_scan_filter_project_func);
+  llvm::BasicBlock* error_block = codegen_utils->CreateBasicBlock(
+      "error_block", exec_scan_filter_project_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", exec_scan_filter_project_func);
+
+  gen_info_.llvm_main_func = exec_scan_filter_project_func;
+  gen_info_.llvm_error_block = error_block;
+
+  // External functions
+  llvm::Function* llvm_ExecProject =
+      codegen_utils->GetOrRegisterExternalFunction(ExecProject,
+                                                   "ExecProject");
+
+  // Generation-time constants
+  ProjectionInfo* proj_info = scan_state_->ps.ps_ProjInfo;
+  llvm::Value* llvm_slot = codegen_utils->GetConstant(
+      scan_state_->ss_ScanTupleSlot);
+  llvm::Value* llvm_null_slot =
+      codegen_utils->GetConstant<TupleTableSlot*>(nullptr);
+
+  // Function arguments to ExecScanFilterProject
+  llvm::Value* llvm_slot_arg = ArgumentByPosition(
+      exec_scan_filter_project_func, 1);
+
+  // Entry block
+  // -----------
+  irb->SetInsertPoint(entry_block);
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Codegen'ed ExecScanFilterProject called!");
+#endif
+  // We generated code for the scan slot of this node only; anything else
+  // goes to the regular function.
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_slot, llvm_slot_arg),
+      qual_block /* true */,
+      fallback_block /* false */);
+
+  // Qual block
+  // ----------
+  irb->SetInsertPoint(qual_block);
+  // econtext->ecxt_scantuple = slot;
+  irb->CreateStore(
+      llvm_slot_arg,
+      codegen_utils->GetConstant(&gen_info_.econtext->ecxt_scantuple));
+
+  // Evaluate the clauses one at a time, treating a NULL result as false, the
+  // same way ExecQual(qual, econtext, false) does.
+  for (size_t i = 0; i < qual_tree_generators_.size(); ++i) {
+    llvm::BasicBlock* qual_value_block = codegen_utils->CreateBasicBlock(
+        "qual_value_" + std::to_string(i), exec_scan_filter_project_func);
+    llvm::BasicBlock* next_block = codegen_utils->CreateBasicBlock(
+        "qual_next_" + std::to_string(i), exec_scan_filter_project_func);
+
+    llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+        codegen_utils->GetType<bool>(), nullptr, "isNull");
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                     llvm_isnull_ptr);
+
+    llvm::Value* llvm_qual_value = nullptr;
+    bool is_generated = qual_tree_generators_[i]->GenerateCode(
+        codegen_utils, gen_info_, &llvm_qual_value, llvm_isnull_ptr);
+    if (!is_generated ||
+        nullptr == llvm_qual_value) {
+      return false;
+    }
+
+    irb->CreateCondBr(irb->CreateLoad(llvm_isnull_ptr),
+                      reject_block /* true */,
+                      qual_value_block /* false */);
+
+    irb->SetInsertPoint(qual_value_block);
+    irb->CreateCondBr(
+        irb->CreateICmpNE(
+            codegen_utils->CreateCppTypeToDatumCast(llvm_qual_value),
+            codegen_utils->GetConstant<Datum>(0)),
+        next_block /* true */,
+        reject_block /* false */);
+
+    irb->SetInsertPoint(next_block);
+  }
+  irb->CreateBr(project_block);
+
+  // Project block
+  // -------------
+  irb->SetInsertPoint(project_block);
+  if (nullptr == proj_info) {
+    // No projection; return the scan tuple itself.
+    irb->CreateRet(llvm_slot_arg);
+  } else if (0 == proj_max_attr_) {
+    // return ExecProject(projInfo, NULL);
+    irb->CreateRet(irb->CreateCall(llvm_ExecProject, {
+        codegen_utils->GetConstant(proj_info),
+        codegen_utils->GetConstant<ExprDoneCond*>(nullptr)}));
+  } else {
+    llvm::BasicBlock* copy_block = codegen_utils->CreateBasicBlock(
+        "copy", exec_scan_filter_project_func);
+    llvm::BasicBlock* regular_project_block = codegen_utils->CreateBasicBlock(
+        "regular_project", exec_scan_filter_project_func);
+
+    llvm::Function* llvm_ExecClearTuple =
+        codegen_utils->GetOrRegisterExternalFunction(ExecClearTuple,
+                                                     "ExecClearTuple");
+    llvm::Function* llvm_ExecStoreVirtualTuple =
+        codegen_utils->GetOrRegisterExternalFunction(ExecStoreVirtualTuple,
+                                                     "ExecStoreVirtualTuple");
+    llvm::Value* llvm_proj_max_attr = codegen_utils->GetConstant(
+        proj_max_attr_);
+    llvm::Value* llvm_result_slot = codegen_utils->GetConstant(
+        proj_info->pi_slot);
+
+    // Deform the scan tuple up to the last projected attribute. This is a
+    // no-op when the quals already did so.
+    llvm::Value* llvm_dummy_isnull =
+        irb->CreateAlloca(codegen_utils->GetType<bool>());
+    irb->CreateCall(gen_info_.llvm_slot_getattr_func, {
+        llvm_slot_arg,
+        llvm_proj_max_attr,
+        llvm_dummy_isnull});
+
+    // Memtuples are not deformed into the slot's values array, in which case
+    // we let the regular ExecProject do the work.
+    llvm::Value* llvm_slot_PRIVATE_tts_nvalid =
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_nvalid));
+    irb->CreateCondBr(
+        irb->CreateICmpSGE(llvm_slot_PRIVATE_tts_nvalid, llvm_proj_max_attr),
+        copy_block /* true */,
+        regular_project_block /* false */);
+
+    // Copy block
+    // ----------
+    irb->SetInsertPoint(copy_block);
+    irb->CreateCall(llvm_ExecClearTuple, {llvm_result_slot});
+    llvm::Value* llvm_slot_PRIVATE_tts_isnull /* bool* */ =
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull));
+    llvm::Value* llvm_slot_PRIVATE_tts_values /* Datum* */ =
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_values));
+    llvm::Value* llvm_result_slot_PRIVATE_tts_isnull /* bool* */ =
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_result_slot, &TupleTableSlot::PRIVATE_tts_isnull));
+    llvm::Value* llvm_result_slot_PRIVATE_tts_values /* Datum* */ =
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_result_slot, &TupleTableSlot::PRIVATE_tts_values));
+
+    int* varNumbers = proj_info->pi_varNumbers;
+    for (int i = list_length(proj_info->pi_targetlist) - 1; i >= 0; i--) {
+      // isnull[i] = slot->PRIVATE_tts_isnull[attnum-1];
+      irb->CreateStore(
+          irb->CreateLoad(irb->CreateInBoundsGEP(
+              llvm_slot_PRIVATE_tts_isnull,
+              {codegen_utils->GetConstant(varNumbers[i] - 1)})),
+          irb->CreateInBoundsGEP(llvm_result_slot_PRIVATE_tts_isnull,
+                                 {codegen_utils->GetConstant(i)}));
+      // values[i] = slot->PRIVATE_tts_values[attnum-1];
+      irb->CreateStore(
+          irb->CreateLoad(irb->CreateInBoundsGEP(
+              llvm_slot_PRIVATE_tts_values,
+              {codegen_utils->GetConstant(varNumbers[i] - 1)})),
+          irb->CreateInBoundsGEP(llvm_result_slot_PRIVATE_tts_values,
+                                 {codegen_utils->GetConstant(i)}));
+    }
+    irb->CreateRet(irb->CreateCall(llvm_ExecStoreVirtualTuple,
+                                   {llvm_result_slot}));
+
+    // Regular project block
+    // ---------------------
+    irb->SetInsertPoint(regular_project_block);
+    irb->CreateRet(irb->CreateCall(llvm_ExecProject, {
+        codegen_utils->GetConstant(proj_info),
+        codegen_utils->GetConstant<ExprDoneCond*>(nullptr)}));
+  }
+
+  // Reject block
+  // ------------
+  // Tuple fails qual; the caller moves on to the next one.
+  irb->SetInsertPoint(reject_block);
+  irb->CreateRet(llvm_null_slot);
+
+  // Error block
+  // -----------
+  // We error out during the execution of built-in function.
+  irb->SetInsertPoint(error_block);
+  irb->CreateRet(llvm_null_slot);
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Falling back to regular ExecScanFilterProject");
+  codegen_utils->CreateFallback<ExecScanFilterProjectFn>(
+      codegen_utils->GetOrRegisterExternalFunction(ExecScanFilterProject,
+                                                   "ExecScanFilterProject"),
+      exec_scan_filter_project_func);
+
+  return true;
+}
+
+bool ExecScanFilterProjectCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateExecScanFilterProject(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "ExecScanFilterProject was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "ExecScanFilterProject generation failed!");
+    return false;
+  }
+}
@@ -21,7 +21,10 @@ extern "C" {
 #include "postgres.h"  // NOLINT(build/include)
 #include "nodes/execnodes.h"
 #include "utils/elog.h"
+#include "utils/lsyscache.h"
 #include "nodes/nodes.h"
+#include "nodes/primnodes.h"
+#include "parser/parse_expr.h"
 }
 
 using gpcodegen::ExprTreeGenerator;
@@ -35,6 +38,7 @@ bool ExprTreeGenerator::VerifyAndCreateExprTree(
          nullptr != expr_tree);
 
   if (!(IsA(expr_state, FuncExprState) ||
+      IsA(expr_state, GenericExprState) ||
       IsA(expr_state, ExprState))) {
     elog(DEBUG1, "Input expression state type (%d) is not supported",
          expr_state->type);
@@ -58,6 +62,26 @@ bool ExprTreeGenerator::VerifyAndCreateExprTree(
           expr_state, gen_info, expr_tree);
       break;
     }
+    case T_RelabelType: {
+      // A relabeling, e.g. of varchar to text, doesn't change the datum if
+      // both types have the same representation. Then ExecEvalRelabelType
+      // just evaluates the argument, and so does the generated code.
+      RelabelType* relabel = reinterpret_cast<RelabelType*>(expr_state->expr);
+      Oid arg_type = exprType(reinterpret_cast<Node*>(relabel->arg));
+      int16 result_typlen = 0, arg_typlen = 0;
+      bool result_typbyval = false, arg_typbyval = false;
+      get_typlenbyval(relabel->resulttype, &result_typlen, &result_typbyval);
+      get_typlenbyval(arg_type, &arg_typlen, &arg_typbyval);
+      if (result_typlen != arg_typlen || result_typbyval != arg_typbyval) {
+        elog(DEBUG1, "Relabeling of type %u to %u is not binary compatible",
+             arg_type, relabel->resulttype);
+        break;
+      }
+      supported_expr_tree = VerifyAndCreateExprTree(
+          reinterpret_cast<const GenericExprState*>(expr_state)->arg,
+          gen_info, expr_tree);
+      break;
+    }
     default : {
       supported_expr_tree = false;
       elog(DEBUG1, "Unsupported expression tree %d found",
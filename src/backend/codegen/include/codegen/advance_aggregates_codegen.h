@@ -53,7 +53,8 @@ class AdvanceAggregatesCodegen: public BaseCodegen<AdvanceAggregatesFn> {
    *
    * @return true on successful generation; false otherwise.
    *
-   * This implementation does not support percentile and ordered aggregates.
+   * This implementation does not support percentile and ordered aggregates,
+   * nor DISTINCT aggregates of more than one argument.
    *
    * If at execution time, we see any of the above types of attributes,
    * we fall backs to the regular function.
@@ -96,6 +97,20 @@ class AdvanceAggregatesCodegen: public BaseCodegen<AdvanceAggregatesFn> {
       int aggno,
       gpcodegen::PGFuncGeneratorInfo* pg_func_info,
       llvm::Value* llvm_mem_manager_arg);
+
+  /**
+   * @brief Generates runtime code that puts the input of a DISTINCT aggregate
+   * in its sorter, as advance_aggregates does when numSortCols > 0.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @param aggno ith aggregate function
+   * @param llvm_value LLVM value of the input datum
+   * @param llvm_isnull LLVM value that is true if the input is NULL
+   */
+  void GenerateAddToSortState(gpcodegen::GpCodegenUtils* codegen_utils,
+                              int aggno,
+                              llvm::Value* llvm_value,
+                              llvm::Value* llvm_isnull);
 };
 
 /** @} */
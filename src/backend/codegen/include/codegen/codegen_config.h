@@ -21,6 +21,12 @@ extern bool codegen_exec_variable_list;
 extern bool codegen_slot_getattr;
 extern bool codegen_exec_eval_expr;
 extern bool codegen_advance_aggregate;
+extern bool codegen_exec_scan_filter_project;
+extern bool codegen_calc_hash_value;
+extern bool codegen_exec_hash_get_hash_value;
+extern bool codegen_module_cache;
+extern int codegen_module_cache_size;
+extern bool codegen_async_compile;
 // TODO(shardikar): Retire this GUC after performing experiments to find the
 // tradeoff of codegen-ing slot_getattr() (potentially by measuring the
 // difference in the number of instructions) when one of the first few
@@ -39,6 +45,9 @@ class ExecVariableListCodegen;
 class SlotGetAttrCodegen;
 class ExecEvalExprCodegen;
 class AdvanceAggregatesCodegen;
+class ExecScanFilterProjectCodegen;
+class CalcHashValueCodegen;
+class ExecHashGetHashValueCodegen;
 
 class CodegenConfig {
  public:
@@ -73,6 +82,21 @@ inline bool CodegenConfig::IsGeneratorEnabled<AdvanceAggregatesCodegen>() {
   return codegen_advance_aggregate;
 }
 
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<ExecScanFilterProjectCodegen>() {
+  return codegen_exec_scan_filter_project;
+}
+
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<CalcHashValueCodegen>() {
+  return codegen_calc_hash_value;
+}
+
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<ExecHashGetHashValueCodegen>() {
+  return codegen_exec_hash_get_hash_value;
+}
+
 
 /** @} */
 
@@ -13,14 +13,18 @@
 #ifndef GPCODEGEN_CODEGEN_MANAGER_H_  // NOLINT(build/header_guard)
 #define GPCODEGEN_CODEGEN_MANAGER_H_
 
+#include <atomic>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 #include <string>
 
 #include "codegen/utils/macros.h"
 #include "codegen/codegen_config.h"
 #include "codegen/codegen_interface.h"
+#include "codegen/codegen_module_cache.h"
 #include "codegen/base_codegen.h"
+#include "codegen/utils/gp_codegen_utils.h"
 
 namespace gpcodegen {
 /** \addtogroup gpcodegen
@@ -46,7 +50,10 @@ class CodegenManager {
    **/
   explicit CodegenManager(const std::string& module_name);
 
-  ~CodegenManager() = default;
+  /**
+   * @brief Destructor. Waits for a background compilation to finish.
+   **/
+  ~CodegenManager();
 
   /**
    * @brief Template function to facilitate enroll for any type of
@@ -132,11 +139,34 @@ class CodegenManager {
    * @brief Compile all the generated functions. On success,
    *        a pointer to the generated method becomes available to the caller.
    *
+   * @note  If codegen_async_compile is on, the module is compiled by a
+   *        background thread and the regular functions stay in use until
+   *        PollGeneratedFunctions() swaps in the generated ones.
+   *
    * @return The number of enrolled codegen that successully generated code
-   *         and 0 on failure
+   *         and 0 on failure or when compiling in the background
    **/
   unsigned int PrepareGeneratedFunctions();
 
+  /**
+   * @return true if a background compilation started by
+   *         PrepareGeneratedFunctions() has not been polled to completion.
+   **/
+  bool IsCompilationPending() const {
+    return compile_thread_.joinable();
+  }
+
+  /**
+   * @brief If the background compilation has finished, make the generated
+   *        functions available to the caller.
+   *
+   * @note  Must be called from the thread that enrolled the generators, at a
+   *        point where none of the regular functions is running.
+   *
+   * @return true if the background compilation finished with this call.
+   **/
+  bool PollGeneratedFunctions();
+
   /**
    * @brief 	Notifies the manager of a parameter change.
    *
@@ -172,7 +202,31 @@ class CodegenManager {
    */
   const std::string& GetExplainString();
 
+  /**
+   * @return Number of modules whose compiled object code was found in the
+   *         module cache by PrepareGeneratedFunctions().
+   **/
+  int GetCacheHits() const;
+
+  /**
+   * @return Number of modules compiled by PrepareGeneratedFunctions() because
+   *         they were not found in the module cache.
+   **/
+  int GetCacheMisses() const;
+
+  /**
+   * @return Time spent compiling or loading the generated code, in
+   *         milliseconds.
+   **/
+  double GetCompileTimeMs() const {
+    return compile_time_ms_;
+  }
+
  private:
+  // Cache of compiled modules, if codegen_module_cache is on. Declared before
+  // codegen_utils_ because the ExecutionEngine refers to it until destroyed.
+  std::unique_ptr<CodegenModuleCache> module_cache_;
+
   // GpCodegenUtils provides a facade to LLVM subsystem.
   std::unique_ptr<gpcodegen::GpCodegenUtils> codegen_utils_;
 
@@ -184,6 +238,38 @@ class CodegenManager {
   // Holds the dumped IR of all underlying modules for EXPLAIN CODEGEN queries
   std::string explain_string_;
 
+  // Whether the module was compiled successfully
+  bool compilation_status_;
+
+  // Thread compiling the module when codegen_async_compile is on, and flag
+  // it raises once done.
+  std::thread compile_thread_;
+  std::atomic<bool> compilation_done_;
+
+  // Time spent compiling or loading the module, in milliseconds
+  double compile_time_ms_;
+
+  /**
+   * @brief Compile the module and record the compilation time.
+   **/
+  void CompileModule(
+      gpcodegen::GpCodegenUtils::OptimizationLevel optimization_level);
+
+  /**
+   * @brief Start compiling the module on a background thread.
+   *
+   * @return false if the thread could not be started.
+   **/
+  bool StartBackgroundCompilation(
+      gpcodegen::GpCodegenUtils::OptimizationLevel optimization_level);
+
+  /**
+   * @brief Swap in the generated functions after a successful compilation.
+   *
+   * @return The number of enrolled codegen whose generated function is used.
+   **/
+  unsigned int SetToGenerated();
+
   DISALLOW_COPY_AND_ASSIGN(CodegenManager);
 };
 
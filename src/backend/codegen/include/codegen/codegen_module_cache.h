@@ -0,0 +1,132 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_module_cache.h
+//
+//  @doc:
+//    On-disk cache of compiled object code for generated modules
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_CODEGEN_MODULE_CACHE_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_CODEGEN_MODULE_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "codegen/utils/macros.h"
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace gpcodegen {
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+/**
+ * @brief llvm::ObjectCache that keeps the object code of compiled modules in
+ *        files under the data directory, so that backends of the same segment
+ *        that generate the same module can skip its compilation.
+ *
+ * @note  The key of a module is a hash of its IR, the optimization level used
+ *        for machine code generation, the host CPU and the LLVM version. The
+ *        IR does not contain the addresses of external functions and
+ *        variables: those are referenced by name and mapped by
+ *        CodegenUtils::PrepareForExecution() when the object is loaded. It is
+ *        thus safe to reuse object code compiled by another backend.
+ *
+ * @note  The cache directory is bounded by codegen_module_cache_size. A hit
+ *        touches the modification time of the object, and the objects that
+ *        were least recently stored or used are removed when a new one does
+ *        not fit.
+ *
+ * @note  The ExecutionEngine may call this cache from the background
+ *        compilation thread (see codegen_async_compile), so it must not use
+ *        elog() or palloc().
+ **/
+class CodegenModuleCache : public llvm::ObjectCache {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param optimization_level Optimization level used to compile the modules
+   *                           going through this cache.
+   * @param max_size Maximum total size in bytes of the cached objects. No
+   *                 object is stored if 0.
+   **/
+  CodegenModuleCache(int optimization_level, std::uint64_t max_size);
+
+  virtual ~CodegenModuleCache() = default;
+
+  /**
+   * @brief Store the object code of a newly compiled module.
+   **/
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+
+  /**
+   * @brief Look up previously compiled object code for the given module.
+   *
+   * @return A buffer with the object code, or NULL on a cache miss.
+   **/
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+  /**
+   * @return Number of modules whose object code was found in the cache.
+   **/
+  int hits() const {
+    return hits_;
+  }
+
+  /**
+   * @return Number of modules that had to be compiled.
+   **/
+  int misses() const {
+    return misses_;
+  }
+
+ private:
+  // Directory, relative to the data directory, holding the cached objects.
+  static constexpr char kCacheDirectory[] = "pg_codegen_cache";
+
+  int optimization_level_;
+  std::uint64_t max_size_;
+  int hits_;
+  int misses_;
+
+  // Keys computed by getObject(), reused by notifyObjectCompiled().
+  std::unordered_map<const llvm::Module*, std::string> keys_;
+
+  /**
+   * @brief Compute the key of a module.
+   **/
+  std::string ComputeKey(const llvm::Module* module);
+
+  /**
+   * @brief Path of the cached object with the given key.
+   **/
+  static std::string GetObjectPath(const std::string& key);
+
+  /**
+   * @brief Remove the least recently used objects until the cache directory
+   *        fits in max_size_.
+   **/
+  void EvictObjects();
+
+  DISALLOW_COPY_AND_ASSIGN(CodegenModuleCache);
+};
+
+/** @} */
+}  // namespace gpcodegen
+
+#endif  // GPCODEGEN_CODEGEN_MODULE_CACHE_H_
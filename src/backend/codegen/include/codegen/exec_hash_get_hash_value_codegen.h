@@ -0,0 +1,89 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.h
+//
+//  @doc:
+//    Headers for ExecHashGetHashValue codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class ExecHashGetHashValueCodegen
+    : public BaseCodegen<ExecHashGetHashValueFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr        Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr  Reference to the function pointer that the
+   *                                caller will call.
+   * @param hjstate                 The HashJoinState whose hash keys to use
+   *                                for generating code.
+   * @param outer_tuple             true to generate code for the outer
+   *                                (probe) side, false for the inner (build)
+   *                                side of the join.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated
+   *        function or the corresponding regular version.
+   *
+   **/
+  explicit ExecHashGetHashValueCodegen(
+      CodegenManager* manager,
+      ExecHashGetHashValueFn regular_func_ptr,
+      ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+      HashJoinState *hjstate,
+      bool outer_tuple);
+
+  virtual ~ExecHashGetHashValueCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for ExecHashGetHashValue.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * This implementation supports hash keys that are plain Vars of the inner
+   * or outer tuple, hashed by one of the hash functions known to
+   * OpExprTreeGenerator (hashint2, hashint4, hashint8, hashtext, hashbpchar,
+   * ...), which are inlined.
+   *
+   * If at execution time, we see a different list of hash keys, we fall back
+   * to the regular function.
+   */
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final;
+
+ private:
+  HashJoinState *hjstate_;
+  bool outer_tuple_;
+
+  static constexpr char kExecHashGetHashValuePrefix[] = "ExecHashGetHashValue";
+
+  /**
+   * @brief Generates runtime code that implements ExecHashGetHashValue.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateExecHashGetHashValue(gpcodegen::GpCodegenUtils* codegen_utils);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_
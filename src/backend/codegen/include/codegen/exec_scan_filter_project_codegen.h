@@ -0,0 +1,118 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_scan_filter_project_codegen.h
+//
+//  @doc:
+//    Headers for ExecScanFilterProject codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EXECSCANFILTERPROJECT_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EXECSCANFILTERPROJECT_CODEGEN_H_
+
+#include <memory>
+#include <vector>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/expr_tree_generator.h"
+#include "codegen/slot_getattr_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class ExecScanFilterProjectCodegen
+    : public BaseCodegen<ExecScanFilterProjectFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr        Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr  Reference to the function pointer that the
+   *                                caller will call.
+   * @param scan_state              The ScanState to use for generating code.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated
+   *        function or the corresponding regular version.
+   *
+   **/
+  explicit ExecScanFilterProjectCodegen(
+      CodegenManager* manager,
+      ExecScanFilterProjectFn regular_func_ptr,
+      ExecScanFilterProjectFn* ptr_to_regular_func_ptr,
+      ScanState* scan_state);
+
+  virtual ~ExecScanFilterProjectCodegen() = default;
+
+  bool InitDependencies() override;
+
+ protected:
+  /**
+   * @brief Generate code for the per-tuple work of ExecScan, i.e. qual
+   * evaluation followed by projection of a qualifying tuple.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note The regular ExecScan loop calls ExecQual, which dispatches through
+   * ExecEvalExpr for each clause, and then ExecProject, which calls
+   * ExecVariableList, each of them retrieving attributes with slot_getattr.
+   * This generates one function for the whole scan node that
+   *  (1) deforms the scan tuple once with the generated slot_getattr(),
+   *  (2) evaluates every qual clause inline, short-circuiting on the first
+   *      false or NULL result, and
+   *  (3) copies the projected attributes straight from the scan slot into
+   *      the projection slot when the target list is a simple Var list.
+   *
+   * Code generation fails if any qual clause is not supported by the
+   * ExprTreeGenerator; the regular ExecScanFilterProject (which may still use
+   * the per-clause generated ExecEvalExpr) is used in that case.
+   *
+   * If at execution time the scan returns a slot other than the one used for
+   * generation, or the attributes needed for projection were not deformed
+   * into the slot (e.g. memtuples), we fall back to the regular function.
+   */
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final;
+
+ private:
+  ScanState* scan_state_;
+
+  ExprTreeGeneratorInfo gen_info_;
+  SlotGetAttrCodegen* slot_getattr_codegen_;
+  std::vector<std::unique_ptr<ExprTreeGenerator>> qual_tree_generators_;
+
+  // Largest attribute referenced by the projection; 0 if the projection
+  // cannot be generated inline.
+  int proj_max_attr_;
+
+  static constexpr char kExecScanFilterProjectPrefix[] =
+      "ExecScanFilterProject";
+
+  /**
+   * @brief Generates runtime code that implements ExecScanFilterProject.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateExecScanFilterProject(gpcodegen::GpCodegenUtils* codegen_utils);
+
+  /**
+   * @brief Check if the projection is a simple Var list on the scan slot
+   * that can be copied directly from the deformed scan tuple.
+   *
+   * @return Largest attribute referenced by the projection if so; 0 otherwise.
+   **/
+  int ComputeInlineProjectionMaxAttr();
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EXECSCANFILTERPROJECT_CODEGEN_H_
@@ -0,0 +1,171 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_hash_func_generator.h
+//
+//  @doc:
+//    Base class for hash support functions to generate code
+//
+//---------------------------------------------------------------------------
+#ifndef GPCODEGEN_PG_HASH_FUNC_GENERATOR_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_PG_HASH_FUNC_GENERATOR_H_
+
+#include "codegen/pg_func_generator_interface.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+namespace llvm {
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class GpCodegenUtils;
+struct PGFuncGeneratorInfo;
+
+/**
+ * @brief Class with Static member functions to generate code for the hash
+ *        support functions used by hash joins and hash aggregates.
+ **/
+class PGHashFuncGenerator {
+ public:
+  /**
+   * @brief Create LLVM instructions for hashint2, hashint4 and hashint8.
+   *        date, oid and the other 4-byte types hashed by hashint4 are covered
+   *        as well.
+   *
+   * @tparam IntType        C++ type of the argument (int16_t, int32_t or
+   *                        int64_t)
+   * @param  codegen_utils  Utility for easy code generation.
+   * @param  pg_func_info   Details for pgfunc generation
+   * @param  llvm_out_value Variable to keep the result (int32)
+   *
+   * @return true if generation was successful otherwise return false.
+   *
+   * @note   The result must be identical to the regular function's, since
+   *         generated and regular hash values may meet in the same hash table.
+   **/
+  template <typename IntType>
+  static bool HashInt(gpcodegen::GpCodegenUtils* codegen_utils,
+                      const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+                      llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create LLVM instructions for hashtext, hashvarlena and
+   *        hashbpchar, i.e. hash_any() over the data of the varlena.
+   *
+   * @tparam kBlankPadded   true for bpchar, whose trailing blanks are not
+   *                        hashed (see bcTruelen).
+   * @param  codegen_utils  Utility for easy code generation.
+   * @param  pg_func_info   Details for pgfunc generation
+   * @param  llvm_out_value Variable to keep the result (int32)
+   *
+   * @return true if generation was successful otherwise return false.
+   **/
+  template <bool kBlankPadded>
+  static bool HashVarlen(gpcodegen::GpCodegenUtils* codegen_utils,
+                         const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+                         llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create LLVM instructions that hash a non-null datum with the given
+   *        hash support function, the way FunctionCall1(hashfn, datum) does.
+   *
+   * @param codegen_utils   Utility for easy code generation.
+   * @param hash_func_oid   Oid of the hash support function (e.g. hashint4)
+   * @param llvm_main_func  Function for which we are generating code
+   * @param llvm_datum      Datum to hash
+   * @param llvm_out_hash   Will contain the hash value (int32)
+   *
+   * @return true if generation was successful; false if the hash function is
+   *         not supported.
+   **/
+  static bool GenerateHashDatum(gpcodegen::GpCodegenUtils* codegen_utils,
+                                unsigned int hash_func_oid,
+                                llvm::Function* llvm_main_func,
+                                llvm::Value* llvm_datum,
+                                llvm::Value** llvm_out_hash);
+
+ private:
+  /**
+   * @brief Create LLVM instructions that implement hash_uint32, i.e. Bob
+   *        Jenkins' mix() of a single 32-bit key.
+   *
+   * @param codegen_utils   Utility for easy code generation.
+   * @param llvm_key        32-bit key to hash
+   *
+   * @return int32 llvm value with the hash of the key.
+   **/
+  static llvm::Value* GenerateHashUInt32(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_key);
+
+  /**
+   * @brief Create LLVM instructions that call hash_any() on the data of the
+   *        given varlena, optionally ignoring its trailing blanks.
+   **/
+  static llvm::Value* GenerateHashVarlena(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_varlena,
+      bool blank_padded);
+};
+
+template <typename IntType>
+bool PGHashFuncGenerator::HashInt(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  static_assert(sizeof(IntType) <= sizeof(int64_t),
+                "hashint functions take at most 8 byte integers");
+  assert(pg_func_info.llvm_args.size() == 1);
+  auto irb = codegen_utils->ir_builder();
+  llvm::Value* llvm_arg = pg_func_info.llvm_args[0];
+
+  llvm::Value* llvm_key = nullptr;
+  if (sizeof(IntType) == sizeof(int64_t)) {
+    // hashint8: lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+    llvm::Value* llvm_lohalf = irb->CreateTrunc(
+        llvm_arg, codegen_utils->GetType<int32_t>());
+    llvm::Value* llvm_hihalf = irb->CreateTrunc(
+        irb->CreateLShr(llvm_arg, 32), codegen_utils->GetType<int32_t>());
+    llvm::Value* llvm_is_positive = irb->CreateICmpSGE(
+        llvm_arg, codegen_utils->GetConstant<int64_t>(0));
+    llvm_key = irb->CreateXor(
+        llvm_lohalf,
+        irb->CreateSelect(llvm_is_positive,
+                          llvm_hihalf,
+                          irb->CreateNot(llvm_hihalf)));
+  } else {
+    // hashint2 and hashint4 hash the sign-extended value
+    llvm_key = irb->CreateSExtOrBitCast(
+        llvm_arg, codegen_utils->GetType<int32_t>());
+  }
+
+  *llvm_out_value = GenerateHashUInt32(codegen_utils, llvm_key);
+  return true;
+}
+
+template <bool kBlankPadded>
+bool PGHashFuncGenerator::HashVarlen(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  assert(pg_func_info.llvm_args.size() == 1);
+  *llvm_out_value = GenerateHashVarlena(codegen_utils,
+                                        pg_func_info.llvm_args[0],
+                                        kBlankPadded);
+  return true;
+}
+
+/** @} */
+}  // namespace gpcodegen
+
+#endif  // GPCODEGEN_PG_HASH_FUNC_GENERATOR_H_
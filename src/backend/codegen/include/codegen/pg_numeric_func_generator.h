@@ -18,6 +18,7 @@
 #include "codegen/pg_func_generator_interface.h"
 
 #include "llvm/IR/Constant.h"
+#include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Value.h"
 
@@ -81,6 +82,55 @@ class PGNumericFuncGenerator {
       const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
       llvm::Value** llvm_out_value);
 
+  /**
+   * @brief Create LLVM instructions for the numeric comparison operators
+   *        (numeric_eq, numeric_lt, ...).
+   *
+   * @tparam kPredicate         Signed integer predicate applied to the result
+   *                            of cmp_numerics, e.g. ICMP_EQ for numeric_eq.
+   * @param  codegen_utils      Utility for easy code generation.
+   * @param  pg_func_info       Details for pgfunc generation
+   * @param  llvm_out_value     Variable to keep the result
+   *
+   * @return true if generation was successful otherwise return false.
+   **/
+  template <llvm::CmpInst::Predicate kPredicate>
+  static bool GenerateNumericCmp(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+      llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create LLVM instructions for numeric_add, the transition function
+   *        of sum(numeric). The addition itself is done by add_numerics,
+   *        which uses 128-bit integer arithmetic when the operands allow it.
+   *
+   * @param codegen_utils      Utility for easy code generation.
+   * @param pg_func_info       Details for pgfunc generation
+   * @param llvm_out_value     Variable to keep the result
+   *
+   * @return true if generation was successful otherwise return false.
+   **/
+  static bool GenerateNumericAdd(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+      llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create LLVM instructions for numeric_avg_accum, the transition
+   *        function of avg(numeric). Only accum case has been implemented.
+   *
+   * @param codegen_utils      Utility for easy code generation.
+   * @param pg_func_info       Details for pgfunc generation
+   * @param llvm_out_value     Variable to keep the result
+   *
+   * @return true if generation was successful otherwise return false.
+   **/
+  static bool GenerateNumericAvgAccum(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+      llvm::Value** llvm_out_value);
+
  private:
   /**
    * @brief A helper function that creates LLVM instructions that check if a
@@ -156,6 +206,32 @@ bool PGNumericFuncGenerator::GenerateIntFloatAvgAccum(
   return true;
 }
 
+template <llvm::CmpInst::Predicate kPredicate>
+bool PGNumericFuncGenerator::GenerateNumericCmp(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  llvm::Function* llvm_pg_detoast_datum = codegen_utils->
+      GetOrRegisterExternalFunction(pg_detoast_datum, "pg_detoast_datum");
+  llvm::Function* llvm_cmp_numerics = codegen_utils->
+      GetOrRegisterExternalFunction(cmp_numerics, "cmp_numerics");
+  auto irb = codegen_utils->ir_builder();
+
+  // Numeric num1 = PG_GETARG_NUMERIC(0);
+  // Numeric num2 = PG_GETARG_NUMERIC(1);
+  llvm::Value* llvm_num1 =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[0]});
+  llvm::Value* llvm_num2 =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[1]});
+
+  // result = cmp_numerics(num1, num2) <op> 0;
+  *llvm_out_value = irb->CreateICmp(
+      kPredicate,
+      irb->CreateCall(llvm_cmp_numerics, {llvm_num1, llvm_num2}),
+      codegen_utils->GetConstant<int>(0));
+  return true;
+}
+
 /** @} */
 }  // namespace gpcodegen
 
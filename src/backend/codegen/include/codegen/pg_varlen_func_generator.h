@@ -0,0 +1,182 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_varlen_func_generator.h
+//
+//  @doc:
+//    Base class for variable length (text, varchar, bpchar) functions to
+//    generate code
+//
+//---------------------------------------------------------------------------
+#ifndef GPCODEGEN_PG_VARLEN_FUNC_GENERATOR_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_PG_VARLEN_FUNC_GENERATOR_H_
+
+#include "codegen/pg_func_generator_interface.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "c.h"  // NOLINT(build/include)
+#include "utils/elog.h"
+#include "utils/pg_locale.h"
+}
+
+namespace llvm {
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class GpCodegenUtils;
+struct PGFuncGeneratorInfo;
+
+/**
+ * @brief Class with Static member function to generate code for text,
+ *        varchar and bpchar comparison operators.
+ **/
+class PGVarlenFuncGenerator {
+ public:
+  /**
+   * @brief Create LLVM instructions for the comparison operators of text
+   *        (texteq, textne, text_lt, ...) and bpchar (bpchareq, ...).
+   *        varchar uses the text operators.
+   *
+   * @tparam kPredicate     Signed integer predicate applied to the result of
+   *                        the comparison, e.g. ICMP_EQ for texteq.
+   * @tparam kBlankPadded   true for bpchar, whose trailing blanks are not
+   *                        significant (see bcTruelen).
+   * @param  codegen_utils  Utility for easy code generation.
+   * @param  pg_func_info   Details for pgfunc generation
+   * @param  llvm_out_value Variable to keep the result
+   *
+   * @return true if generation was successful otherwise return false.
+   *
+   * @note   Equality does not depend on the collation and is always
+   *         generated. Ordering is generated only when LC_COLLATE is C, in
+   *         which case varstr_cmp() reduces to strncmp().
+   **/
+  template <llvm::CmpInst::Predicate kPredicate, bool kBlankPadded>
+  static bool VarlenCmp(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+      llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create LLVM instructions that compute VARDATA_ANY and
+   *        VARSIZE_ANY_EXHDR of the given varlena.
+   *
+   * @param codegen_utils   Utility for easy code generation.
+   * @param llvm_varlena    Pointer to the varlena
+   * @param llvm_out_data   Will contain a pointer to the data
+   * @param llvm_out_len    Will contain the length of the data (int32)
+   *
+   * @note  Short (1-byte header) and plain 4-byte header values are decoded
+   *        inline. Compressed and external values are detoasted by calling
+   *        pg_detoast_datum.
+   **/
+  static void GenerateVarlenDataAndLength(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_varlena,
+      llvm::Value** llvm_out_data,
+      llvm::Value** llvm_out_len);
+
+  /**
+   * @brief Create LLVM instructions that implement bcTruelen, i.e. skip the
+   *        trailing blanks of a bpchar.
+   *
+   * @param codegen_utils   Utility for easy code generation.
+   * @param llvm_data       Pointer to the data of the bpchar
+   * @param llvm_len        Length of the data including trailing blanks
+   *
+   * @return Length of the data without trailing blanks.
+   **/
+  static llvm::Value* GenerateBpCharTrueLength(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_data,
+      llvm::Value* llvm_len);
+
+ private:
+  /**
+   * @brief Create LLVM instructions that compute the equality of two strings
+   *        the way texteq does.
+   *
+   * @return i1 llvm value that is true if both strings are equal.
+   **/
+  static llvm::Value* GenerateVarstrEq(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_data1, llvm::Value* llvm_len1,
+      llvm::Value* llvm_data2, llvm::Value* llvm_len2);
+
+  /**
+   * @brief Create LLVM instructions that implement varstr_cmp for the C
+   *        collation.
+   *
+   * @return int32 llvm value that is less than, equal to or greater than
+   *         zero if the first string is less than, equal to or greater than
+   *         the second one.
+   **/
+  static llvm::Value* GenerateVarstrCmp(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_data1, llvm::Value* llvm_len1,
+      llvm::Value* llvm_data2, llvm::Value* llvm_len2);
+};
+
+template <llvm::CmpInst::Predicate kPredicate, bool kBlankPadded>
+bool PGVarlenFuncGenerator::VarlenCmp(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  constexpr bool kEquality = (llvm::CmpInst::ICMP_EQ == kPredicate ||
+                              llvm::CmpInst::ICMP_NE == kPredicate);
+  if (!kEquality && !lc_collate_is_c()) {
+    elog(DEBUG1, "Non-C collation: varlena ordering is not supported.");
+    return false;
+  }
+
+  assert(pg_func_info.llvm_args.size() == 2);
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::Value* llvm_data1 = nullptr;
+  llvm::Value* llvm_len1 = nullptr;
+  llvm::Value* llvm_data2 = nullptr;
+  llvm::Value* llvm_len2 = nullptr;
+  GenerateVarlenDataAndLength(codegen_utils, pg_func_info.llvm_args[0],
+                              &llvm_data1, &llvm_len1);
+  GenerateVarlenDataAndLength(codegen_utils, pg_func_info.llvm_args[1],
+                              &llvm_data2, &llvm_len2);
+
+  if (kBlankPadded) {
+    llvm_len1 = GenerateBpCharTrueLength(codegen_utils, llvm_data1, llvm_len1);
+    llvm_len2 = GenerateBpCharTrueLength(codegen_utils, llvm_data2, llvm_len2);
+  }
+
+  if (kEquality) {
+    llvm::Value* llvm_eq = GenerateVarstrEq(codegen_utils,
+                                            llvm_data1, llvm_len1,
+                                            llvm_data2, llvm_len2);
+    *llvm_out_value = (llvm::CmpInst::ICMP_EQ == kPredicate) ?
+        llvm_eq : irb->CreateNot(llvm_eq);
+  } else {
+    llvm::Value* llvm_cmp = GenerateVarstrCmp(codegen_utils,
+                                              llvm_data1, llvm_len1,
+                                              llvm_data2, llvm_len2);
+    *llvm_out_value = irb->CreateICmp(kPredicate, llvm_cmp,
+                                      codegen_utils->GetConstant<int32>(0));
+  }
+  return true;
+}
+
+/** @} */
+}  // namespace gpcodegen
+
+#endif  // GPCODEGEN_PG_VARLEN_FUNC_GENERATOR_H_
@@ -32,6 +32,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -464,11 +465,25 @@ class CodegenUtils {
    *        code at the expense of increased compilation time.
    * @param optimize_for_host_cpu If true, LLVM will optimize generated machine
    *        code for the specific CPU model we are running on.
+   * @param object_cache If not NULL, the ExecutionEngine consults this cache
+   *        for previously compiled object code before compiling a module, and
+   *        notifies it of newly compiled object code. The cache must outlive
+   *        this CodegenUtils.
    * @return true if an ExecutionEngine was set up successfully, false if some
    *         error occured.
    **/
   bool PrepareForExecution(const OptimizationLevel cpu_opt_level,
-                           const bool optimize_for_host_cpu);
+                           const bool optimize_for_host_cpu,
+                           llvm::ObjectCache* object_cache = nullptr);
+
+  /**
+   * @brief Compile all modules handed to the ExecutionEngine by
+   *        PrepareForExecution() right away, instead of on the first call to
+   *        GetFunctionPointer().
+   *
+   * @note PrepareForExecution() should be called before calling this method.
+   **/
+  void CompileForExecution();
 
   /**
    * @brief Get a pointer to the compiled machine-code version of a function
@@ -25,7 +25,9 @@
 #include "codegen/utils/gp_codegen_utils.h"
 #include "codegen/pg_arith_func_generator.h"
 #include "codegen/pg_date_func_generator.h"
+#include "codegen/pg_hash_func_generator.h"
 #include "codegen/pg_numeric_func_generator.h"
+#include "codegen/pg_varlen_func_generator.h"
 
 #include "llvm/IR/IRBuilder.h"
 
@@ -49,6 +51,7 @@ using gpcodegen::GpCodegenUtils;
 using gpcodegen::PGFuncGeneratorInterface;
 using gpcodegen::PGFuncGeneratorFn;
 using gpcodegen::CodeGenFuncMap;
+using llvm::CmpInst;
 using llvm::IRBuilder;
 
 
@@ -125,6 +128,16 @@ void OpExprTreeGenerator::InitializeSupportedFunction() {
           nullptr,
           false));
 
+  // int8inc_any is the transition function of count(any); its second argument
+  // is only checked for NULL, which the strict logic of the caller does.
+  supported_function_[2804] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, void*>(
+          2804,
+          "int8inc_any",
+          &PGArithUnaryFuncGenerator<int64_t, int64_t>::IncWithOverflow,
+          nullptr,
+          true));
+
   supported_function_[216] = std::unique_ptr<PGFuncGeneratorInterface>(
       new PGGenericFuncGenerator<float8, float8, float8>(
           216,
@@ -193,6 +206,218 @@ void OpExprTreeGenerator::InitializeSupportedFunction() {
           &PGNumericFuncGenerator::GenerateIntFloatAvgAmalg,
           nullptr,
           true));
+
+  supported_function_[1724] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<void*, void*, void*>(
+          1724,
+          "numeric_add",
+          &PGNumericFuncGenerator::GenerateNumericAdd,
+          nullptr,
+          true));
+
+  supported_function_[3102] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<void*, void*, void*>(
+          3102,
+          "numeric_avg_accum",
+          &PGNumericFuncGenerator::GenerateNumericAvgAccum,
+          nullptr,
+          true));
+
+  // text and varchar (which uses the text operators) comparisons. Ordering
+  // operators are only generated when LC_COLLATE is C.
+  supported_function_[67] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          67,
+          "texteq",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_EQ, false>,
+          nullptr,
+          true));
+
+  supported_function_[157] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          157,
+          "textne",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_NE, false>,
+          nullptr,
+          true));
+
+  supported_function_[740] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          740,
+          "text_lt",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SLT, false>,
+          nullptr,
+          true));
+
+  supported_function_[741] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          741,
+          "text_le",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SLE, false>,
+          nullptr,
+          true));
+
+  supported_function_[742] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          742,
+          "text_gt",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SGT, false>,
+          nullptr,
+          true));
+
+  supported_function_[743] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          743,
+          "text_ge",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SGE, false>,
+          nullptr,
+          true));
+
+  // bpchar comparisons ignore trailing blanks.
+  supported_function_[1048] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1048,
+          "bpchareq",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_EQ, true>,
+          nullptr,
+          true));
+
+  supported_function_[1053] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1053,
+          "bpcharne",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_NE, true>,
+          nullptr,
+          true));
+
+  supported_function_[1049] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1049,
+          "bpcharlt",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SLT, true>,
+          nullptr,
+          true));
+
+  supported_function_[1050] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1050,
+          "bpcharle",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SLE, true>,
+          nullptr,
+          true));
+
+  supported_function_[1051] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1051,
+          "bpchargt",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SGT, true>,
+          nullptr,
+          true));
+
+  supported_function_[1052] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1052,
+          "bpcharge",
+          &PGVarlenFuncGenerator::VarlenCmp<CmpInst::ICMP_SGE, true>,
+          nullptr,
+          true));
+
+  supported_function_[1718] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1718,
+          "numeric_eq",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_EQ>,
+          nullptr,
+          true));
+
+  supported_function_[1719] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1719,
+          "numeric_ne",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_NE>,
+          nullptr,
+          true));
+
+  supported_function_[1722] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1722,
+          "numeric_lt",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_SLT>,
+          nullptr,
+          true));
+
+  supported_function_[1723] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1723,
+          "numeric_le",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_SLE>,
+          nullptr,
+          true));
+
+  supported_function_[1720] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1720,
+          "numeric_gt",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_SGT>,
+          nullptr,
+          true));
+
+  supported_function_[1721] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1721,
+          "numeric_ge",
+          &PGNumericFuncGenerator::GenerateNumericCmp<CmpInst::ICMP_SGE>,
+          nullptr,
+          true));
+
+  // Hash support functions, used by hash joins and hash aggregates
+  supported_function_[449] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int16_t>(
+          449,
+          "hashint2",
+          &PGHashFuncGenerator::HashInt<int16_t>,
+          nullptr,
+          true));
+
+  supported_function_[450] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int32_t>(
+          450,
+          "hashint4",
+          &PGHashFuncGenerator::HashInt<int32_t>,
+          nullptr,
+          true));
+
+  supported_function_[949] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int64_t>(
+          949,
+          "hashint8",
+          &PGHashFuncGenerator::HashInt<int64_t>,
+          nullptr,
+          true));
+
+  supported_function_[400] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, void*>(
+          400,
+          "hashtext",
+          &PGHashFuncGenerator::HashVarlen<false>,
+          nullptr,
+          true));
+
+  supported_function_[456] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, void*>(
+          456,
+          "hashvarlena",
+          &PGHashFuncGenerator::HashVarlen<false>,
+          nullptr,
+          true));
+
+  supported_function_[1080] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, void*>(
+          1080,
+          "hashbpchar",
+          &PGHashFuncGenerator::HashVarlen<true>,
+          nullptr,
+          true));
 }
 
 PGFuncGeneratorInterface* OpExprTreeGenerator::GetPGFuncGenerator(
@@ -0,0 +1,145 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_hash_func_generator.cc
+//
+//  @doc:
+//    Base class for hash support functions to generate code
+//
+//---------------------------------------------------------------------------
+
+#include <assert.h>
+#include <cstdint>
+#include <vector>
+
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/pg_hash_func_generator.h"
+#include "codegen/pg_varlen_func_generator.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "c.h"  // NOLINT(build/include)
+#include "access/hash.h"
+#include "utils/elog.h"
+}
+
+using gpcodegen::GpCodegenUtils;
+using gpcodegen::OpExprTreeGenerator;
+using gpcodegen::PGFuncGeneratorInfo;
+using gpcodegen::PGFuncGeneratorInterface;
+using gpcodegen::PGHashFuncGenerator;
+using gpcodegen::PGVarlenFuncGenerator;
+
+namespace {
+
+// rot(x, k) of hashfunc.c
+llvm::Value* GenerateRot(GpCodegenUtils* codegen_utils,
+                         llvm::Value* llvm_x,
+                         int k) {
+  auto irb = codegen_utils->ir_builder();
+  return irb->CreateOr(irb->CreateShl(llvm_x, k),
+                       irb->CreateLShr(llvm_x, 32 - k));
+}
+
+}  // namespace
+
+llvm::Value* PGHashFuncGenerator::GenerateHashUInt32(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_key) {
+  auto irb = codegen_utils->ir_builder();
+
+  // a = 0xdeadbeef + k; b = 0xdeadbeef; c = 3923095 + sizeof(uint32);
+  llvm::Value* a = irb->CreateAdd(
+      codegen_utils->GetConstant<uint32_t>(0xdeadbeef), llvm_key);
+  llvm::Value* b = codegen_utils->GetConstant<uint32_t>(0xdeadbeef);
+  llvm::Value* c = codegen_utils->GetConstant<uint32_t>(
+      3923095 + sizeof(uint32));
+
+  // mix(a, b, c) {{{
+  a = irb->CreateXor(irb->CreateSub(a, c), GenerateRot(codegen_utils, c, 4));
+  c = irb->CreateAdd(c, b);
+  b = irb->CreateXor(irb->CreateSub(b, a), GenerateRot(codegen_utils, a, 6));
+  a = irb->CreateAdd(a, c);
+  c = irb->CreateXor(irb->CreateSub(c, b), GenerateRot(codegen_utils, b, 8));
+  b = irb->CreateAdd(b, a);
+  a = irb->CreateXor(irb->CreateSub(a, c), GenerateRot(codegen_utils, c, 16));
+  c = irb->CreateAdd(c, b);
+  b = irb->CreateXor(irb->CreateSub(b, a), GenerateRot(codegen_utils, a, 19));
+  a = irb->CreateAdd(a, c);
+  c = irb->CreateXor(irb->CreateSub(c, b), GenerateRot(codegen_utils, b, 4));
+  // }}}
+
+  return c;
+}
+
+llvm::Value* PGHashFuncGenerator::GenerateHashVarlena(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_varlena,
+    bool blank_padded) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* llvm_hash_any = codegen_utils->
+      GetOrRegisterExternalFunction(hash_any, "hash_any");
+
+  llvm::Value* llvm_data = nullptr;
+  llvm::Value* llvm_len = nullptr;
+  PGVarlenFuncGenerator::GenerateVarlenDataAndLength(
+      codegen_utils, llvm_varlena, &llvm_data, &llvm_len);
+  if (blank_padded) {
+    llvm_len = PGVarlenFuncGenerator::GenerateBpCharTrueLength(
+        codegen_utils, llvm_data, llvm_len);
+  }
+
+  // Detoasted copies are left to the per-tuple memory context of the caller,
+  // unlike hashbpchar's PG_FREE_IF_COPY.
+  return irb->CreateTrunc(
+      irb->CreateCall(llvm_hash_any, {llvm_data, llvm_len}),
+      codegen_utils->GetType<int32_t>());
+}
+
+bool PGHashFuncGenerator::GenerateHashDatum(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    unsigned int hash_func_oid,
+    llvm::Function* llvm_main_func,
+    llvm::Value* llvm_datum,
+    llvm::Value** llvm_out_hash) {
+  assert(nullptr != llvm_out_hash);
+  PGFuncGeneratorInterface* pg_func_gen =
+      OpExprTreeGenerator::GetPGFuncGenerator(hash_func_oid);
+  if (nullptr == pg_func_gen ||
+      1 != pg_func_gen->GetTotalArgCount()) {
+    elog(DEBUG1, "We do not support hash function with oid = %d",
+         hash_func_oid);
+    return false;
+  }
+
+  auto irb = codegen_utils->ir_builder();
+  // The caller deals with NULL keys, so the argument is never null here.
+  std::vector<llvm::Value*> llvm_args = {llvm_datum};
+  std::vector<llvm::Value*> llvm_args_isNull = {
+      codegen_utils->GetConstant<bool>(false)};
+  PGFuncGeneratorInfo pg_func_info(llvm_main_func,
+                                   nullptr /* hash functions do not fail */,
+                                   llvm_args,
+                                   llvm_args_isNull);
+  llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "hash_isnull");
+
+  llvm::Value* llvm_hash = nullptr;
+  if (!pg_func_gen->GenerateCode(codegen_utils, pg_func_info,
+                                 &llvm_hash, llvm_isnull_ptr) ||
+      nullptr == llvm_hash ||
+      codegen_utils->GetType<int32_t>() != llvm_hash->getType()) {
+    elog(DEBUG1, "Hash function with oid = %d was not generated successfully!",
+         hash_func_oid);
+    return false;
+  }
+  *llvm_out_hash = llvm_hash;
+  return true;
+}
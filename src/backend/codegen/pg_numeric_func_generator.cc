@@ -80,6 +80,58 @@ bool PGNumericFuncGenerator::GenerateIntFloatAvgAmalg(
   return true;
 }
 
+bool PGNumericFuncGenerator::GenerateNumericAdd(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  llvm::Function* llvm_pg_detoast_datum = codegen_utils->
+      GetOrRegisterExternalFunction(pg_detoast_datum, "pg_detoast_datum");
+  llvm::Function* llvm_add_numerics = codegen_utils->
+      GetOrRegisterExternalFunction(add_numerics, "add_numerics");
+  auto irb = codegen_utils->ir_builder();
+
+  // Numeric num1 = PG_GETARG_NUMERIC(0);
+  // Numeric num2 = PG_GETARG_NUMERIC(1);
+  llvm::Value* llvm_num1 =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[0]});
+  llvm::Value* llvm_num2 =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[1]});
+
+  // PG_RETURN_NUMERIC(add_numerics(num1, num2));
+  *llvm_out_value = irb->CreateCall(llvm_add_numerics,
+                                    {llvm_num1, llvm_num2});
+  return true;
+}
+
+bool PGNumericFuncGenerator::GenerateNumericAvgAccum(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const gpcodegen::PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  llvm::Function* llvm_pg_detoast_datum = codegen_utils->
+      GetOrRegisterExternalFunction(pg_detoast_datum, "pg_detoast_datum");
+  llvm::Function* llvm_numeric_avg_accum_decum = codegen_utils->
+      GetOrRegisterExternalFunction(numeric_avg_accum_decum,
+                                    "numeric_avg_accum_decum");
+  auto irb = codegen_utils->ir_builder();
+
+  // NumericAvgTransData *tr = (NumericAvgTransData *) PG_GETARG_BYTEA_P(0);
+  // Numeric newval = PG_GETARG_NUMERIC(1);
+  llvm::Value* llvm_tr =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[0]});
+  llvm::Value* llvm_newval =
+      irb->CreateCall(llvm_pg_detoast_datum, {pg_func_info.llvm_args[1]});
+
+  // result = numeric_avg_accum_decum(tr, newval, true);
+  llvm::Value* llvm_result = irb->CreateCall(
+      llvm_numeric_avg_accum_decum, {
+          llvm_tr,
+          llvm_newval,
+          codegen_utils->GetConstant<bool>(true)});
+  *llvm_out_value = codegen_utils->CreateDatumToCppTypeCast<void*>(
+      llvm_result);
+  return true;
+}
+
 bool PGNumericFuncGenerator::GenerateVarlenSizeCheck(
     gpcodegen::GpCodegenUtils* codegen_utils,
     llvm::Value* llvm_ptr,
@@ -0,0 +1,261 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_varlen_func_generator.cc
+//
+//  @doc:
+//    Base class for variable length (text, varchar, bpchar) functions to
+//    generate code
+//
+//---------------------------------------------------------------------------
+
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+
+#include "codegen/pg_varlen_func_generator.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "c.h"  // NOLINT(build/include)
+#include "fmgr.h"
+}
+
+using gpcodegen::GpCodegenUtils;
+using gpcodegen::PGVarlenFuncGenerator;
+
+void PGVarlenFuncGenerator::GenerateVarlenDataAndLength(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_varlena,
+    llvm::Value** llvm_out_data,
+    llvm::Value** llvm_out_len) {
+  assert(nullptr != llvm_varlena);
+  assert(nullptr != llvm_out_data);
+  assert(nullptr != llvm_out_len);
+
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* current_function = irb->GetInsertBlock()->getParent();
+
+  llvm::BasicBlock* short_block = codegen_utils->CreateBasicBlock(
+      "varlena_short", current_function);
+  llvm::BasicBlock* not_short_block = codegen_utils->CreateBasicBlock(
+      "varlena_not_short", current_function);
+  llvm::BasicBlock* detoast_block = codegen_utils->CreateBasicBlock(
+      "varlena_detoast", current_function);
+  llvm::BasicBlock* long_block = codegen_utils->CreateBasicBlock(
+      "varlena_long", current_function);
+  llvm::BasicBlock* end_block = codegen_utils->CreateBasicBlock(
+      "varlena_end", current_function);
+
+  // The flag bits are in the physically first byte of the header.
+  llvm::Value* llvm_header = irb->CreateLoad(llvm_varlena);
+
+  // if (VARATT_IS_1B(PTR) && !VARATT_IS_1B_E(PTR)) {{
+  llvm::Value* llvm_is_short = irb->CreateAnd(
+      irb->CreateICmpEQ(
+          irb->CreateAnd(llvm_header, codegen_utils->GetConstant<uint8>(0x80)),
+          codegen_utils->GetConstant<uint8>(0x80)),
+      irb->CreateICmpNE(llvm_header, codegen_utils->GetConstant<uint8>(0x80)));
+  irb->CreateCondBr(llvm_is_short, short_block, not_short_block);
+  // }}
+
+  // data = VARDATA_1B(PTR); len = VARSIZE_1B(PTR) - VARHDRSZ_SHORT; {{
+  irb->SetInsertPoint(short_block);
+  llvm::Value* llvm_short_data = irb->CreateInBoundsGEP(
+      llvm_varlena, codegen_utils->GetConstant<int32>(VARHDRSZ_SHORT));
+  llvm::Value* llvm_short_len = irb->CreateSub(
+      irb->CreateZExt(
+          irb->CreateAnd(llvm_header, codegen_utils->GetConstant<uint8>(0x7F)),
+          codegen_utils->GetType<int32>()),
+      codegen_utils->GetConstant<int32>(VARHDRSZ_SHORT));
+  irb->CreateBr(end_block);
+  // }}
+
+  // if (VARATT_IS_EXTENDED(PTR)) PTR = pg_detoast_datum(PTR); {{
+  irb->SetInsertPoint(not_short_block);
+  llvm::Value* llvm_is_4b_u = irb->CreateICmpEQ(
+      irb->CreateAnd(llvm_header, codegen_utils->GetConstant<uint8>(0xC0)),
+      codegen_utils->GetConstant<uint8>(0));
+  irb->CreateCondBr(llvm_is_4b_u, long_block, detoast_block);
+
+  irb->SetInsertPoint(detoast_block);
+  llvm::Function* llvm_pg_detoast_datum = codegen_utils->
+      GetOrRegisterExternalFunction(pg_detoast_datum, "pg_detoast_datum");
+  llvm::Value* llvm_detoasted = irb->CreateCall(llvm_pg_detoast_datum,
+                                                {llvm_varlena});
+  irb->CreateBr(long_block);
+  // }}
+
+  // data = VARDATA_4B(PTR); len = VARSIZE_4B(PTR) - VARHDRSZ; {{
+  irb->SetInsertPoint(long_block);
+  llvm::PHINode* llvm_long_varlena = irb->CreatePHI(
+      llvm_varlena->getType(), 2);
+  llvm_long_varlena->addIncoming(llvm_varlena, not_short_block);
+  llvm_long_varlena->addIncoming(llvm_detoasted, detoast_block);
+
+  // The 4-byte header is stored in network byte order (see VARSIZE_4B), so
+  // assemble it byte by byte to stay independent of the host endianness.
+  llvm::Value* llvm_long_header = codegen_utils->GetConstant<int32>(0);
+  for (int i = 0; i < VARHDRSZ; ++i) {
+    llvm::Value* llvm_byte = irb->CreateZExt(
+        irb->CreateLoad(irb->CreateInBoundsGEP(
+            llvm_long_varlena, codegen_utils->GetConstant<int32>(i))),
+        codegen_utils->GetType<int32>());
+    llvm_long_header = irb->CreateOr(
+        irb->CreateShl(llvm_long_header, 8), llvm_byte);
+  }
+  llvm::Value* llvm_long_len = irb->CreateSub(
+      irb->CreateAnd(llvm_long_header,
+                     codegen_utils->GetConstant<int32>(0x3FFFFFFF)),
+      codegen_utils->GetConstant<int32>(VARHDRSZ));
+  llvm::Value* llvm_long_data = irb->CreateInBoundsGEP(
+      llvm_long_varlena, codegen_utils->GetConstant<int32>(VARHDRSZ));
+  irb->CreateBr(end_block);
+  // }}
+
+  irb->SetInsertPoint(end_block);
+  llvm::PHINode* llvm_data = irb->CreatePHI(llvm_short_data->getType(), 2);
+  llvm_data->addIncoming(llvm_short_data, short_block);
+  llvm_data->addIncoming(llvm_long_data, long_block);
+  llvm::PHINode* llvm_len = irb->CreatePHI(
+      codegen_utils->GetType<int32>(), 2);
+  llvm_len->addIncoming(llvm_short_len, short_block);
+  llvm_len->addIncoming(llvm_long_len, long_block);
+
+  *llvm_out_data = llvm_data;
+  *llvm_out_len = llvm_len;
+}
+
+llvm::Value* PGVarlenFuncGenerator::GenerateBpCharTrueLength(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_data,
+    llvm::Value* llvm_len) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::BasicBlock* entry_block = irb->GetInsertBlock();
+  llvm::Function* current_function = entry_block->getParent();
+
+  llvm::BasicBlock* loop_block = codegen_utils->CreateBasicBlock(
+      "bcTruelen_loop", current_function);
+  llvm::BasicBlock* check_blank_block = codegen_utils->CreateBasicBlock(
+      "bcTruelen_check_blank", current_function);
+  llvm::BasicBlock* end_block = codegen_utils->CreateBasicBlock(
+      "bcTruelen_end", current_function);
+
+  irb->CreateBr(loop_block);
+
+  // for (i = len - 1; i >= 0; i--) { if (s[i] != ' ') break; } {{
+  irb->SetInsertPoint(loop_block);
+  llvm::PHINode* llvm_true_len = irb->CreatePHI(
+      codegen_utils->GetType<int32>(), 2);
+  llvm_true_len->addIncoming(llvm_len, entry_block);
+  llvm::Value* llvm_is_empty = irb->CreateICmpSLE(
+      llvm_true_len, codegen_utils->GetConstant<int32>(0));
+  irb->CreateCondBr(llvm_is_empty, end_block, check_blank_block);
+
+  irb->SetInsertPoint(check_blank_block);
+  llvm::Value* llvm_last = irb->CreateSub(
+      llvm_true_len, codegen_utils->GetConstant<int32>(1));
+  llvm::Value* llvm_last_char = irb->CreateLoad(
+      irb->CreateInBoundsGEP(llvm_data, llvm_last));
+  llvm::Value* llvm_is_blank = irb->CreateICmpEQ(
+      llvm_last_char, codegen_utils->GetConstant<char>(' '));
+  llvm_true_len->addIncoming(llvm_last, check_blank_block);
+  irb->CreateCondBr(llvm_is_blank, loop_block, end_block);
+  // }}
+
+  irb->SetInsertPoint(end_block);
+  llvm::PHINode* llvm_out_len = irb->CreatePHI(
+      codegen_utils->GetType<int32>(), 2);
+  llvm_out_len->addIncoming(llvm_true_len, loop_block);
+  llvm_out_len->addIncoming(llvm_true_len, check_blank_block);
+  return llvm_out_len;
+}
+
+llvm::Value* PGVarlenFuncGenerator::GenerateVarstrEq(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_data1, llvm::Value* llvm_len1,
+    llvm::Value* llvm_data2, llvm::Value* llvm_len2) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::BasicBlock* entry_block = irb->GetInsertBlock();
+  llvm::Function* current_function = entry_block->getParent();
+
+  llvm::BasicBlock* strncmp_block = codegen_utils->CreateBasicBlock(
+      "varstr_eq_strncmp", current_function);
+  llvm::BasicBlock* end_block = codegen_utils->CreateBasicBlock(
+      "varstr_eq_end", current_function);
+
+  // if (len1 != len2) result = false; {{
+  irb->CreateCondBr(irb->CreateICmpEQ(llvm_len1, llvm_len2),
+                    strncmp_block, end_block);
+  // }}
+
+  // else result = (strncmp(data1, data2, len1) == 0); {{
+  irb->SetInsertPoint(strncmp_block);
+  llvm::Function* llvm_strncmp = codegen_utils->
+      GetOrRegisterExternalFunction(strncmp, "strncmp");
+  llvm::Value* llvm_strncmp_eq = irb->CreateICmpEQ(
+      irb->CreateCall(llvm_strncmp, {
+          llvm_data1,
+          llvm_data2,
+          irb->CreateZExt(llvm_len1, codegen_utils->GetType<size_t>())}),
+      codegen_utils->GetConstant<int>(0));
+  irb->CreateBr(end_block);
+  // }}
+
+  irb->SetInsertPoint(end_block);
+  llvm::PHINode* llvm_eq = irb->CreatePHI(codegen_utils->GetType<bool>(), 2);
+  llvm_eq->addIncoming(codegen_utils->GetConstant<bool>(false), entry_block);
+  llvm_eq->addIncoming(llvm_strncmp_eq, strncmp_block);
+  return llvm_eq;
+}
+
+llvm::Value* PGVarlenFuncGenerator::GenerateVarstrCmp(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_data1, llvm::Value* llvm_len1,
+    llvm::Value* llvm_data2, llvm::Value* llvm_len2) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* current_function = irb->GetInsertBlock()->getParent();
+
+  // result = strncmp(arg1, arg2, Min(len1, len2)); {{
+  llvm::Function* llvm_strncmp = codegen_utils->
+      GetOrRegisterExternalFunction(strncmp, "strncmp");
+  llvm::Value* llvm_min_len = irb->CreateSelect(
+      irb->CreateICmpSLT(llvm_len1, llvm_len2), llvm_len1, llvm_len2);
+  llvm::Value* llvm_strncmp_result = irb->CreateCall(llvm_strncmp, {
+      llvm_data1,
+      llvm_data2,
+      irb->CreateZExt(llvm_min_len, codegen_utils->GetType<size_t>())});
+  llvm::BasicBlock* strncmp_block = irb->GetInsertBlock();
+  // }}
+
+  llvm::BasicBlock* len_cmp_block = codegen_utils->CreateBasicBlock(
+      "varstr_cmp_len", current_function);
+  llvm::BasicBlock* end_block = codegen_utils->CreateBasicBlock(
+      "varstr_cmp_end", current_function);
+
+  // if ((result == 0) && (len1 != len2))
+  //   result = (len1 < len2) ? -1 : 1; {{
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_strncmp_result,
+                        codegen_utils->GetConstant<int>(0)),
+      len_cmp_block, end_block);
+
+  irb->SetInsertPoint(len_cmp_block);
+  llvm::Value* llvm_len_cmp = irb->CreateSub(llvm_len1, llvm_len2);
+  irb->CreateBr(end_block);
+  // }}
+
+  irb->SetInsertPoint(end_block);
+  llvm::PHINode* llvm_result = irb->CreatePHI(
+      codegen_utils->GetType<int32>(), 2);
+  llvm_result->addIncoming(llvm_strncmp_result, strncmp_block);
+  llvm_result->addIncoming(llvm_len_cmp, len_cmp_block);
+  return llvm_result;
+}
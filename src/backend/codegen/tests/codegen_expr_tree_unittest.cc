@@ -0,0 +1,132 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_expr_tree_unittest.cc
+//
+//  @doc:
+//    Unit tests for ExprTreeGenerator, on expressions the planner wraps in
+//    relabelings, such as varchar comparisons.
+//
+//  @test:
+//
+//---------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <stdarg.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"  // NOLINT(build/include)
+#undef newNode  // undef newNode so it doesn't have name collision with llvm
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "nodes/execnodes.h"
+#include "nodes/makefuncs.h"
+#include "nodes/primnodes.h"
+#include "optimizer/clauses.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/elog.h"
+#undef elog
+#define elog(...)
+}
+
+#include "codegen/expr_tree_generator.h"
+
+namespace gpcodegen {
+
+namespace {
+
+const Oid kTextEqOperator = 98;
+const Oid kInt4EqOperator = 96;
+
+// The ExprState of "arg = const", with arg relabeled from arg_type to
+// rel_type, as the planner does for varchar_column = 'abc'::text.
+ExprState* MakeRelabeledComparison(Oid arg_type, Oid rel_type,
+                                   Oid eq_operator, Oid eq_func,
+                                   int constlen, bool constbyval) {
+  Var* var = makeVar(1, 3, arg_type, -1, 0);
+  RelabelType* relabel = makeRelabelType(reinterpret_cast<Expr*>(var),
+                                         rel_type, -1, COERCE_IMPLICIT_CAST);
+  Const* constant = makeConst(rel_type, -1, constlen, (Datum) 0, true,
+                              constbyval);
+  OpExpr* op_expr = reinterpret_cast<OpExpr*>(make_opclause(
+      eq_operator, BOOLOID, false, reinterpret_cast<Expr*>(relabel),
+      reinterpret_cast<Expr*>(constant)));
+  op_expr->opfuncid = eq_func;
+  return ExecInitExpr(reinterpret_cast<Expr*>(op_expr), nullptr);
+}
+
+// Expect the generator to look up the representation of the result type
+// and of the argument type of the relabeling.
+void ExpectTypLenByVal(Oid type, int16 typlen, bool typbyval) {
+  expect_value(get_typlenbyval, typid, type);
+  expect_any(get_typlenbyval, typlen);
+  expect_any(get_typlenbyval, typbyval);
+  will_assign_value(get_typlenbyval, typlen, typlen);
+  will_assign_value(get_typlenbyval, typbyval, typbyval);
+  will_be_called(get_typlenbyval);
+}
+
+// varchar = text: the relabeling of the varchar column to text is passed
+// through, and the column is still known to be read.
+void CheckVarcharRelabel(void** state) {
+  ExprState* expr_state = MakeRelabeledComparison(
+      VARCHAROID, TEXTOID, kTextEqOperator, F_TEXTEQ, -1, false);
+  ExprTreeGeneratorInfo gen_info(nullptr, nullptr, nullptr, nullptr, 0);
+  std::unique_ptr<ExprTreeGenerator> expr_tree;
+
+  ExpectTypLenByVal(TEXTOID, -1, false);
+  ExpectTypLenByVal(VARCHAROID, -1, false);
+  EXPECT_TRUE(ExprTreeGenerator::VerifyAndCreateExprTree(
+      expr_state, &gen_info, &expr_tree));
+  EXPECT_NE(nullptr, expr_tree.get());
+  EXPECT_EQ(3, gen_info.max_attr);
+}
+
+// A relabeling between types of different representations is not passed
+// through, and the expression is left to the interpreter.
+void CheckIncompatibleRelabel(void** state) {
+  ExprState* expr_state = MakeRelabeledComparison(
+      INT8OID, INT4OID, kInt4EqOperator, F_INT4EQ, 4, true);
+  ExprTreeGeneratorInfo gen_info(nullptr, nullptr, nullptr, nullptr, 0);
+  std::unique_ptr<ExprTreeGenerator> expr_tree;
+
+  ExpectTypLenByVal(INT4OID, 4, true);
+  ExpectTypLenByVal(INT8OID, 8, true);
+  EXPECT_FALSE(ExprTreeGenerator::VerifyAndCreateExprTree(
+      expr_state, &gen_info, &expr_tree));
+  EXPECT_EQ(nullptr, expr_tree.get());
+}
+
+}  // namespace
+
+class CodegenExprTreeTest : public ::testing::Test {
+};
+
+// Test generating a comparison of a varchar column with a text constant
+TEST_F(CodegenExprTreeTest, VarcharRelabelTest) {
+  EXPECT_EQ(0, run_test(CheckVarcharRelabel));
+}
+
+// Test rejecting a relabeling which changes the representation
+TEST_F(CodegenExprTreeTest, IncompatibleRelabelTest) {
+  EXPECT_EQ(0, run_test(CheckIncompatibleRelabel));
+}
+
+}  // namespace gpcodegen
+
+int main(int argc, char **argv) {
+  MemoryContextInit();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
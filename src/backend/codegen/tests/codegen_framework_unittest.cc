@@ -22,6 +22,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -482,6 +483,31 @@ TEST_F(CodegenManagerTest, PrepareGeneratedFunctionsNoCompilationErrorTest) {
   ASSERT_TRUE(SumFuncRegular == failed_func_ptr);
 }
 
+TEST_F(CodegenManagerTest, PrepareGeneratedFunctionsAsyncTest) {
+  codegen_async_compile = true;
+
+  sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular, &sum_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+
+  // Compilation happens in the background, and the regular version stays in
+  // use until the manager is polled after the compilation finished.
+  EXPECT_EQ(0, manager_->PrepareGeneratedFunctions());
+  ASSERT_TRUE(manager_->IsCompilationPending());
+  ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+  EXPECT_EQ(3, sum_func_ptr(1, 2));
+
+  while (!manager_->PollGeneratedFunctions()) {
+    ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+    std::this_thread::yield();
+  }
+  ASSERT_FALSE(manager_->IsCompilationPending());
+  ASSERT_TRUE(SumFuncRegular != sum_func_ptr);
+  EXPECT_EQ(3, sum_func_ptr(1, 2));
+
+  codegen_async_compile = false;
+}
+
 TEST_F(CodegenManagerTest, UnCompilableFailedGenerationTest) {
   // Test if generation happens successfully
   sum_func_ptr = nullptr;
@@ -0,0 +1,366 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_hash_value_unittest.cc
+//
+//  @doc:
+//    Unit tests for the generated calc_hash_value and ExecHashGetHashValue,
+//    comparing their hash values with the regular functions'.
+//
+//  @test:
+//
+//---------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <stdarg.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"  // NOLINT(build/include)
+#undef newNode  // undef newNode so it doesn't have name collision with llvm
+#include "access/tupdesc.h"
+#include "catalog/pg_type.h"
+#include "executor/execHHashagg.h"
+#include "executor/executor.h"
+#include "executor/hashjoin.h"
+#include "executor/nodeHash.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "nodes/execnodes.h"
+#include "nodes/makefuncs.h"
+#include "nodes/pg_list.h"
+#include "nodes/plannodes.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memaccounting.h"
+#include "utils/memutils.h"
+#include "utils/elog.h"
+#undef elog
+#define elog(...)
+}
+
+#include "codegen/calc_hash_value_codegen.h"
+#include "codegen/codegen_manager.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+extern bool codegen_validate_functions;
+
+namespace gpcodegen {
+
+namespace {
+
+// A hash key column: its type, and the equality operator and hash function
+// a hash join or hash aggregate on it uses.
+struct HashKeyColumn {
+  Oid type_oid;
+  int16 typlen;
+  bool typbyval;
+  char typalign;
+  Oid eq_op;
+  Oid hash_func;
+};
+
+// One column of every type with a generated hash function
+const std::vector<HashKeyColumn> kColumns = {
+  {INT2OID, 2, true, 's', 94 /* int2eq */, F_HASHINT2},
+  {INT4OID, 4, true, 'i', 96 /* int4eq */, F_HASHINT4},
+  {INT8OID, 8, true, 'd', 410 /* int8eq */, F_HASHINT8},
+  {TEXTOID, -1, false, 'i', 98 /* texteq */, F_HASHTEXT},
+  {BPCHAROID, -1, false, 'i', 1054 /* bpchareq */, F_HASHBPCHAR},
+  {BYTEAOID, -1, false, 'i', 1955 /* byteaeq */, F_HASHVARLENA},
+};
+
+// Values of the varlena columns
+const std::vector<std::string> kStrings = {
+  "", "a", "abc", "abc  ", "  abc", "a somewhat longer string, to hash",
+};
+
+// Make a varlena with either a short (1-byte) or a regular (4-byte) header,
+// as found in tuples on disk and in memory respectively.
+Datum MakeVarlena(const std::string& str, bool short_header) {
+  char* buffer = static_cast<char*>(palloc(str.size() + VARHDRSZ));
+  if (short_header) {
+    SET_VARSIZE_1B(buffer, str.size() + VARHDRSZ_SHORT);
+    memcpy(VARDATA_1B(buffer), str.data(), str.size());
+  } else {
+    SET_VARSIZE_4B(buffer, str.size() + VARHDRSZ);
+    memcpy(VARDATA_4B(buffer), str.data(), str.size());
+  }
+  return PointerGetDatum(buffer);
+}
+
+// The tuple descriptor of kColumns, built without catalog access.
+TupleDesc MakeTupleDesc() {
+  TupleDesc tupdesc = CreateTemplateTupleDesc(kColumns.size(), false);
+  for (size_t i = 0; i < kColumns.size(); ++i) {
+    Form_pg_attribute attr = tupdesc->attrs[i];
+    memset(attr, 0, ATTRIBUTE_FIXED_PART_SIZE);
+    attr->attnum = i + 1;
+    attr->atttypid = kColumns[i].type_oid;
+    attr->atttypmod = -1;
+    attr->attlen = kColumns[i].typlen;
+    attr->attbyval = kColumns[i].typbyval;
+    attr->attalign = kColumns[i].typalign;
+    attr->attstorage = kColumns[i].typlen == -1 ? 'x' : 'p';
+  }
+  return tupdesc;
+}
+
+// Virtual tuples with all kinds of values of kColumns, with NULLs in one,
+// some and all of the columns.
+std::vector<TupleTableSlot*> MakeSlots(TupleDesc tupdesc) {
+  std::vector<TupleTableSlot*> slots;
+  const int64 ints[] = {0, 1, -1, 42, -4242, PG_INT16_MAX, PG_INT16_MIN,
+                        PG_INT32_MAX, PG_INT32_MIN, PG_INT64_MAX, PG_INT64_MIN};
+  const int nints = sizeof(ints) / sizeof(ints[0]);
+  const int nrows = nints * static_cast<int>(kStrings.size()) * 2;
+
+  for (int row = 0; row < nrows + 2; ++row) {
+    TupleTableSlot* slot = MakeSingleTupleTableSlot(tupdesc);
+    Datum* values = slot_get_values(slot);
+    bool* isnull = slot_get_isnull(slot);
+    int64 ival = ints[row % nints];
+    const std::string& str = kStrings[row / nints % kStrings.size()];
+    bool short_header = row / (nints * kStrings.size()) % 2;
+
+    values[0] = Int16GetDatum(static_cast<int16>(ival));
+    values[1] = Int32GetDatum(static_cast<int32>(ival));
+    values[2] = Int64GetDatum(ival);
+    values[3] = MakeVarlena(str, short_header);
+    values[4] = MakeVarlena(str, short_header);
+    values[5] = MakeVarlena(str, !short_header);
+    for (size_t col = 0; col < kColumns.size(); ++col) {
+      if (row == nrows) {
+        isnull[col] = true;  // all NULL
+      } else if (row == nrows + 1) {
+        isnull[col] = (col % 2 == 0);  // some NULL
+      } else {
+        isnull[col] = (row % (kColumns.size() + 3) == col);  // one NULL
+      }
+    }
+    ExecStoreVirtualTuple(slot);
+    slots.push_back(slot);
+  }
+  return slots;
+}
+
+// FmgrInfos of the hash functions of kColumns; they are all built-in, so
+// this doesn't need the catalog either.
+FmgrInfo* MakeHashFunctions() {
+  FmgrInfo* hashfunctions = static_cast<FmgrInfo*>(
+      palloc0(kColumns.size() * sizeof(FmgrInfo)));
+  for (size_t i = 0; i < kColumns.size(); ++i) {
+    fmgr_info(kColumns[i].hash_func, &hashfunctions[i]);
+  }
+  return hashfunctions;
+}
+
+// A HashJoinState with hash keys on all of kColumns, on both sides.
+HashJoinState* MakeHashJoinState() {
+  HashJoinState* hjstate = makeNode(HashJoinState);
+  HashState* hashstate = makeNode(HashState);
+  Hash* hash = makeNode(Hash);
+
+  hash->plan.memoryAccountId = ActiveMemoryAccountId;
+  hashstate->ps.plan = reinterpret_cast<Plan*>(hash);
+  hjstate->js.ps.righttree = reinterpret_cast<PlanState*>(hashstate);
+
+  for (size_t i = 0; i < kColumns.size(); ++i) {
+    Var* outer_var = makeVar(OUTER, i + 1, kColumns[i].type_oid, -1, 0);
+    Var* inner_var = makeVar(INNER, i + 1, kColumns[i].type_oid, -1, 0);
+    hjstate->hj_OuterHashKeys = lappend(
+        hjstate->hj_OuterHashKeys,
+        ExecInitExpr(reinterpret_cast<Expr*>(outer_var), nullptr));
+    hjstate->hj_InnerHashKeys = lappend(
+        hjstate->hj_InnerHashKeys,
+        ExecInitExpr(reinterpret_cast<Expr*>(inner_var), nullptr));
+    hjstate->hj_HashOperators = lappend_oid(hjstate->hj_HashOperators,
+                                            kColumns[i].eq_op);
+  }
+  return hjstate;
+}
+
+// Expect ExecHashGetHashValueCodegen to look up the hash functions and the
+// strictness of the hash join operators of kColumns.
+void ExpectHashOperatorLookups() {
+  for (const HashKeyColumn& column : kColumns) {
+    expect_value(get_op_hash_functions, opno, column.eq_op);
+    expect_any(get_op_hash_functions, lhs_procno);
+    expect_any(get_op_hash_functions, rhs_procno);
+    will_assign_value(get_op_hash_functions, lhs_procno, column.hash_func);
+    will_assign_value(get_op_hash_functions, rhs_procno, column.hash_func);
+    will_return(get_op_hash_functions, true);
+
+    expect_value(op_strict, opno, column.eq_op);
+    will_return(op_strict, true);
+  }
+}
+
+// Generate ExecHashGetHashValue for both sides of a hash join, and check
+// that the generated functions compute the same hash values as the regular
+// one, with and without keeping NULLs. The lsyscache functions the generator
+// calls are mocked, so this runs as a cmockery test.
+void CheckExecHashGetHashValue(void** state) {
+  std::unique_ptr<CodegenManager> manager(
+      new CodegenManager("ExecHashGetHashValueTest"));
+  HashJoinState* hjstate = MakeHashJoinState();
+  HashState* hashstate = reinterpret_cast<HashState*>(
+      innerPlanState(hjstate));
+  ExecHashGetHashValueFn outer_fn = nullptr;
+  ExecHashGetHashValueFn inner_fn = nullptr;
+
+  ExpectHashOperatorLookups();
+  ExpectHashOperatorLookups();
+  ASSERT_TRUE(manager->EnrollCodeGenerator(
+      CodegenFuncLifespan_Parameter_Invariant,
+      new ExecHashGetHashValueCodegen(manager.get(), ExecHashGetHashValue,
+                                      &outer_fn, hjstate, true)));
+  ASSERT_TRUE(manager->EnrollCodeGenerator(
+      CodegenFuncLifespan_Parameter_Invariant,
+      new ExecHashGetHashValueCodegen(manager.get(), ExecHashGetHashValue,
+                                      &inner_fn, hjstate, false)));
+  ASSERT_EQ(2, manager->GenerateCode());
+  ASSERT_TRUE(manager->PrepareGeneratedFunctions());
+  ASSERT_TRUE(ExecHashGetHashValue != outer_fn);
+  ASSERT_TRUE(ExecHashGetHashValue != inner_fn);
+
+  HashJoinTable hashtable = static_cast<HashJoinTable>(
+      palloc0(sizeof(HashJoinTableData)));
+  hashtable->outer_hashfunctions = MakeHashFunctions();
+  hashtable->inner_hashfunctions = MakeHashFunctions();
+  hashtable->hashStrict = static_cast<bool*>(
+      palloc(kColumns.size() * sizeof(bool)));
+  for (size_t i = 0; i < kColumns.size(); ++i) {
+    hashtable->hashStrict[i] = true;
+  }
+
+  ExprContext* econtext = CreateStandaloneExprContext();
+  for (TupleTableSlot* slot : MakeSlots(MakeTupleDesc())) {
+    econtext->ecxt_outertuple = slot;
+    econtext->ecxt_innertuple = slot;
+
+    for (bool outer_tuple : {true, false}) {
+      ExecHashGetHashValueFn fn = outer_tuple ? outer_fn : inner_fn;
+      List* hashkeys = outer_tuple ?
+          hjstate->hj_OuterHashKeys : hjstate->hj_InnerHashKeys;
+
+      for (bool keep_nulls : {true, false}) {
+        uint32 expected_hash = 0;
+        uint32 hash = 0;
+        bool expected_hashkeys_null = false;
+        bool hashkeys_null = false;
+        bool expected_result = ExecHashGetHashValue(
+            hashstate, hashtable, econtext, hashkeys, outer_tuple,
+            keep_nulls, &expected_hash, &expected_hashkeys_null);
+        bool result = fn(
+            hashstate, hashtable, econtext, hashkeys, outer_tuple,
+            keep_nulls, &hash, &hashkeys_null);
+
+        EXPECT_EQ(expected_result, result);
+        EXPECT_EQ(expected_hashkeys_null, hashkeys_null);
+        if (expected_result) {
+          EXPECT_EQ(expected_hash, hash);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+class CodegenHashValueTestEnvironment : public ::testing::Environment {
+ public:
+  virtual void SetUp() {
+    ASSERT_EQ(InitCodegen(), 1);
+  }
+};
+
+class CodegenHashValueTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    manager_.reset(new CodegenManager("CodegenHashValueTest"));
+    codegen_validate_functions = true;
+  }
+
+  std::unique_ptr<CodegenManager> manager_;
+};
+
+// Test generated calc_hash_value of a hash aggregate grouping by all of
+// kColumns, and by each of them alone
+TEST_F(CodegenHashValueTest, CalcHashValueTest) {
+  TupleDesc tupdesc = MakeTupleDesc();
+  std::vector<AggState*> aggstates;
+  std::vector<CalcHashValueFn> fns(kColumns.size() + 1, nullptr);
+
+  for (size_t i = 0; i <= kColumns.size(); ++i) {
+    // the last one groups by all columns
+    int num_cols = (i < kColumns.size()) ? 1 : kColumns.size();
+    AggState* aggstate = makeNode(AggState);
+    Agg* agg = makeNode(Agg);
+    HashAggTable* hashtable = static_cast<HashAggTable*>(
+        palloc0(sizeof(HashAggTable)));
+
+    agg->aggstrategy = AGG_HASHED;
+    agg->numCols = num_cols;
+    agg->grpColIdx = static_cast<AttrNumber*>(
+        palloc(num_cols * sizeof(AttrNumber)));
+    aggstate->hashfunctions = static_cast<FmgrInfo*>(
+        palloc0(num_cols * sizeof(FmgrInfo)));
+    for (int col = 0; col < num_cols; ++col) {
+      int attno = (num_cols == 1) ? i : col;
+      agg->grpColIdx[col] = attno + 1;
+      fmgr_info(kColumns[attno].hash_func, &aggstate->hashfunctions[col]);
+    }
+    hashtable->hashkey_buf = static_cast<HashKey*>(
+        palloc(num_cols * sizeof(HashKey)));
+
+    aggstate->ss.ps.plan = reinterpret_cast<Plan*>(agg);
+    aggstate->hhashtable = hashtable;
+    aggstate->tmpcontext = CreateStandaloneExprContext();
+    aggstates.push_back(aggstate);
+
+    ASSERT_TRUE(manager_->EnrollCodeGenerator(
+        CodegenFuncLifespan_Parameter_Invariant,
+        new CalcHashValueCodegen(manager_.get(), calc_hash_value, &fns[i],
+                                 aggstate)));
+  }
+
+  ASSERT_EQ(static_cast<int>(fns.size()), manager_->GenerateCode());
+  ASSERT_TRUE(manager_->PrepareGeneratedFunctions());
+
+  for (TupleTableSlot* slot : MakeSlots(tupdesc)) {
+    for (size_t i = 0; i < fns.size(); ++i) {
+      ASSERT_TRUE(calc_hash_value != fns[i]);
+      EXPECT_EQ(calc_hash_value(aggstates[i], slot),
+                fns[i](aggstates[i], slot));
+    }
+  }
+}
+
+// Test generated ExecHashGetHashValue of both sides of a hash join on all of
+// kColumns
+TEST_F(CodegenHashValueTest, ExecHashGetHashValueTest) {
+  EXPECT_EQ(0, run_test(CheckExecHashGetHashValue));
+}
+
+}  // namespace gpcodegen
+
+int main(int argc, char **argv) {
+  MemoryContextInit();
+  testing::InitGoogleTest(&argc, argv);
+  AddGlobalTestEnvironment(new gpcodegen::CodegenHashValueTestEnvironment);
+  return RUN_ALL_TESTS();
+}
@@ -17,6 +17,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <initializer_list>
 #include <limits>
@@ -63,6 +64,7 @@ extern "C" {
 #include "codegen/base_codegen.h"
 #include "codegen/pg_func_generator.h"
 #include "codegen/pg_arith_func_generator.h"
+#include "codegen/pg_varlen_func_generator.h"
 
 
 namespace gpcodegen {
@@ -377,6 +379,120 @@ TEST_F(CodegenPGFuncGeneratorTest, PGGenericFuncGeneratorOneArgTest) {
   EXPECT_EQ(3, fn(2));
 }
 
+
+// Helper to create a varlena with either a short (1-byte) or a regular
+// (4-byte) header in the given buffer.
+void* MakeVarlena(char* buffer, const std::string& str, bool short_header) {
+  if (short_header) {
+    SET_VARSIZE_1B(buffer, str.size() + VARHDRSZ_SHORT);
+    memcpy(VARDATA_1B(buffer), str.data(), str.size());
+  } else {
+    SET_VARSIZE_4B(buffer, str.size() + VARHDRSZ);
+    memcpy(VARDATA_4B(buffer), str.data(), str.size());
+  }
+  return buffer;
+}
+
+// Generate code for the given varlena comparison and run it on a few strings
+// with short and regular varlena headers.
+template <llvm::CmpInst::Predicate kPredicate, bool kBlankPadded>
+void CheckVarlenCmp(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const std::vector<std::pair<std::string, std::string>>& equal_strings,
+    const std::vector<std::pair<std::string, std::string>>& unequal_strings) {
+  using VarlenCmpFn = bool (*) (Datum, Datum);
+
+  llvm::Function* varlen_cmp_fn =
+      codegen_utils->CreateFunction<VarlenCmpFn>("varlen_cmp_fn");
+
+  llvm::BasicBlock* main_block =
+      codegen_utils->CreateBasicBlock("main", varlen_cmp_fn);
+  llvm::BasicBlock* error_block =
+      codegen_utils->CreateBasicBlock("error", varlen_cmp_fn);
+
+  auto irb = codegen_utils->ir_builder();
+
+  irb->SetInsertPoint(main_block);
+
+  auto generator = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          0,
+          "",
+          &PGVarlenFuncGenerator::VarlenCmp<kPredicate, kBlankPadded>,
+          nullptr,
+          true));
+
+  llvm::Value* result = nullptr;
+  llvm::Value* llvm_isNull = irb->CreateAlloca(
+        codegen_utils->GetType<bool>(), nullptr, "isNull");
+  irb->CreateStore(codegen_utils->GetConstant<bool>(false), llvm_isNull);
+  std::vector<llvm::Value*> args = {
+      ArgumentByPosition(varlen_cmp_fn, 0),
+      ArgumentByPosition(varlen_cmp_fn, 1)};
+  std::vector<llvm::Value*> args_isNull = {
+      codegen_utils->GetConstant<bool>(false),
+      codegen_utils->GetConstant<bool>(false)};
+  PGFuncGeneratorInfo pg_gen_info(varlen_cmp_fn, error_block, args,
+                                  args_isNull);
+
+  EXPECT_TRUE(generator->GenerateCode(codegen_utils,
+                                      pg_gen_info,
+                                      &result,
+                                      llvm_isNull));
+  irb->CreateRet(result);
+
+  irb->SetInsertPoint(error_block);
+  irb->CreateRet(codegen_utils->GetConstant<bool>(false));
+
+  EXPECT_FALSE(llvm::verifyFunction(*varlen_cmp_fn));
+  EXPECT_FALSE(llvm::verifyModule(*codegen_utils->module()));
+
+  // Prepare generated code for execution.
+  EXPECT_TRUE(codegen_utils->PrepareForExecution(
+      CodegenUtils::OptimizationLevel::kNone,
+      true));
+  EXPECT_EQ(nullptr, codegen_utils->module());
+
+  VarlenCmpFn fn =
+      codegen_utils->GetFunctionPointer<VarlenCmpFn>("varlen_cmp_fn");
+
+  char buffer1[64], buffer2[64];
+  for (bool short_header1 : {true, false}) {
+    for (bool short_header2 : {true, false}) {
+      for (const auto& strings : equal_strings) {
+        EXPECT_TRUE(fn(
+            PointerGetDatum(MakeVarlena(buffer1, strings.first,
+                                        short_header1)),
+            PointerGetDatum(MakeVarlena(buffer2, strings.second,
+                                        short_header2))));
+      }
+      for (const auto& strings : unequal_strings) {
+        EXPECT_FALSE(fn(
+            PointerGetDatum(MakeVarlena(buffer1, strings.first,
+                                        short_header1)),
+            PointerGetDatum(MakeVarlena(buffer2, strings.second,
+                                        short_header2))));
+      }
+    }
+  }
+}
+
+// Test generated texteq
+TEST_F(CodegenPGFuncGeneratorTest, PGVarlenFuncGeneratorTextEqTest) {
+  CheckVarlenCmp<llvm::CmpInst::ICMP_EQ, false>(
+      codegen_utils_.get(),
+      {{"", ""}, {"abc", "abc"}},
+      {{"abc", "abd"}, {"abc", "ab"}, {"abc ", "abc"}, {"", "a"}});
+}
+
+// Test generated bpchareq, which ignores trailing blanks
+TEST_F(CodegenPGFuncGeneratorTest, PGVarlenFuncGeneratorBpCharEqTest) {
+  CheckVarlenCmp<llvm::CmpInst::ICMP_EQ, true>(
+      codegen_utils_.get(),
+      {{"", ""}, {"abc", "abc"}, {"abc  ", "abc"}, {"  ", ""}},
+      {{"abc", "abd"}, {"abc", "ab"}, {" abc", "abc"}, {"", "a"}});
+}
+
 }  // namespace gpcodegen
 
 
@@ -6,9 +6,14 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
 #include "cdb/cdbaocsam.h"
+#include "utils/fmgroids.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 
 static void
 InitAOCSScanOpaque(ScanState *scanState)
@@ -59,6 +64,144 @@ FreeAOCSScanOpaque(ScanState *scanState)
 	state->opaque = NULL;
 }
 
+/*
+ * Comparison functions that can be evaluated on the column batches of the
+ * scan, see MakeAOCSBatchQual.
+ */
+static const struct
+{
+	Oid			funcid;
+	AOCSBatchQualType type;
+	AOCSBatchQualOp op;
+}	aocsBatchQualFuncs[] =
+{
+	{F_INT2EQ, AOCSBatchQualType_Int2, AOCSBatchQualOp_Eq},
+	{F_INT2NE, AOCSBatchQualType_Int2, AOCSBatchQualOp_Ne},
+	{F_INT2LT, AOCSBatchQualType_Int2, AOCSBatchQualOp_Lt},
+	{F_INT2LE, AOCSBatchQualType_Int2, AOCSBatchQualOp_Le},
+	{F_INT2GT, AOCSBatchQualType_Int2, AOCSBatchQualOp_Gt},
+	{F_INT2GE, AOCSBatchQualType_Int2, AOCSBatchQualOp_Ge},
+	{F_INT4EQ, AOCSBatchQualType_Int4, AOCSBatchQualOp_Eq},
+	{F_INT4NE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Ne},
+	{F_INT4LT, AOCSBatchQualType_Int4, AOCSBatchQualOp_Lt},
+	{F_INT4LE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Le},
+	{F_INT4GT, AOCSBatchQualType_Int4, AOCSBatchQualOp_Gt},
+	{F_INT4GE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Ge},
+	/* DateADT is an int32 */
+	{F_DATE_EQ, AOCSBatchQualType_Int4, AOCSBatchQualOp_Eq},
+	{F_DATE_NE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Ne},
+	{F_DATE_LT, AOCSBatchQualType_Int4, AOCSBatchQualOp_Lt},
+	{F_DATE_LE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Le},
+	{F_DATE_GT, AOCSBatchQualType_Int4, AOCSBatchQualOp_Gt},
+	{F_DATE_GE, AOCSBatchQualType_Int4, AOCSBatchQualOp_Ge},
+	{F_INT8EQ, AOCSBatchQualType_Int8, AOCSBatchQualOp_Eq},
+	{F_INT8NE, AOCSBatchQualType_Int8, AOCSBatchQualOp_Ne},
+	{F_INT8LT, AOCSBatchQualType_Int8, AOCSBatchQualOp_Lt},
+	{F_INT8LE, AOCSBatchQualType_Int8, AOCSBatchQualOp_Le},
+	{F_INT8GT, AOCSBatchQualType_Int8, AOCSBatchQualOp_Gt},
+	{F_INT8GE, AOCSBatchQualType_Int8, AOCSBatchQualOp_Ge},
+	{F_FLOAT8EQ, AOCSBatchQualType_Float8, AOCSBatchQualOp_Eq},
+	{F_FLOAT8NE, AOCSBatchQualType_Float8, AOCSBatchQualOp_Ne},
+	{F_FLOAT8LT, AOCSBatchQualType_Float8, AOCSBatchQualOp_Lt},
+	{F_FLOAT8LE, AOCSBatchQualType_Float8, AOCSBatchQualOp_Le},
+	{F_FLOAT8GT, AOCSBatchQualType_Float8, AOCSBatchQualOp_Gt},
+	{F_FLOAT8GE, AOCSBatchQualType_Float8, AOCSBatchQualOp_Ge}
+};
+
+/*
+ * Translate a qual of the form "column op constant" into an AOCSBatchQual.
+ * Returns false if the qual is of any other form.
+ */
+static bool
+MakeAOCSBatchQual(Expr *qual, AOCSBatchQual *batchQual)
+{
+	OpExpr	   *opexpr;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *con;
+	Oid			opno;
+	Oid			funcid;
+	int			i;
+
+	if (!IsA(qual, OpExpr))
+		return false;
+
+	opexpr = (OpExpr *) qual;
+	if (list_length(opexpr->args) != 2)
+		return false;
+
+	left = (Node *) linitial(opexpr->args);
+	right = (Node *) lsecond(opexpr->args);
+	opno = opexpr->opno;
+
+	/* Turn "constant op column" around */
+	if (IsA(left, Const) && IsA(right, Var))
+	{
+		Node	   *tmp = left;
+
+		left = right;
+		right = tmp;
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return false;
+	}
+
+	if (!IsA(left, Var) || !IsA(right, Const))
+		return false;
+
+	var = (Var *) left;
+	con = (Const *) right;
+	if (var->varattno <= 0 || con->constisnull ||
+		var->vartype != con->consttype)
+		return false;
+
+	funcid = get_opcode(opno);
+	for (i = 0; i < lengthof(aocsBatchQualFuncs); i++)
+	{
+		if (aocsBatchQualFuncs[i].funcid == funcid)
+			break;
+	}
+	if (i == lengthof(aocsBatchQualFuncs))
+		return false;
+
+	/* NaN compares differently in C, see aocs_batch_filter */
+	if (aocsBatchQualFuncs[i].type == AOCSBatchQualType_Float8 &&
+		isnan(DatumGetFloat8(con->constvalue)))
+		return false;
+
+	batchQual->type = aocsBatchQualFuncs[i].type;
+	batchQual->op = aocsBatchQualFuncs[i].op;
+	batchQual->attno = var->varattno - 1;
+	batchQual->value = con->constvalue;
+	return true;
+}
+
+/*
+ * Switch the scan to batch mode, pushing down the quals that
+ * MakeAOCSBatchQual understands. The executor still evaluates the whole qual
+ * on the rows that the scan returns.
+ */
+static void
+BeginAOCSBatchMode(ScanState *scanState)
+{
+	AOCSScanState *node = (AOCSScanState *)scanState;
+	List	   *qual = scanState->ps.plan->qual;
+	AOCSBatchQual *batchQuals;
+	int			nquals = 0;
+	ListCell   *lc;
+
+	batchQuals = palloc(sizeof(AOCSBatchQual) * Max(list_length(qual), 1));
+	foreach(lc, qual)
+	{
+		if (MakeAOCSBatchQual((Expr *) lfirst(lc), &batchQuals[nquals]))
+			nquals++;
+	}
+
+	aocs_begin_batchmode(node->opaque->scandesc, batchQuals, nquals);
+	pfree(batchQuals);
+}
+
 TupleTableSlot *
 AOCSScanNext(ScanState *scanState)
 {
@@ -102,6 +245,9 @@ BeginScanAOCSRelation(ScanState *scanState)
 					   NULL /* relationTupleDesc */,
 					   node->opaque->proj);
 
+	if (gp_appendonly_batch_scan)
+		BeginAOCSBatchMode(scanState);
+
 	node->ss.scan_state = SCAN_SCAN;
 }
  
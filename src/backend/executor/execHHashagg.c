@@ -36,6 +36,7 @@
 
 #include "cdb/cdbexplain.h"
 #include "cdb/cdbvars.h"
+#include "codegen/codegen_wrapper.h"
 #include "postmaster/primary_mirror_mode.h"
 
 
@@ -105,7 +106,6 @@ static void *readHashEntry(AggState *aggstate,
 						   int32 *p_input_size);
 
 /* Methods for hash table */
-static uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
 static void spill_hash_table(AggState *aggstate);
 static void init_agg_hash_iter(HashAggTable* ht);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
@@ -818,7 +818,7 @@ agg_hash_initial_pass(AggState *aggstate)
 
 		/* Find or (if there's room) build a hash table entry for the
 		 * input tuple's group. */
-		hashkey = calc_hash_value(aggstate, outerslot);
+		hashkey = call_CalcHashValue(aggstate, outerslot);
 		entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
 									  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
 		
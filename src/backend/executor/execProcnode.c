@@ -82,6 +82,7 @@
 
 #include "executor/executor.h"
 #include "executor/instrument.h"
+#include "executor/execHHashagg.h"
 #include "executor/nodeAgg.h"
 #include "executor/nodeAppend.h"
 #include "executor/nodeAssertOp.h"
@@ -165,6 +166,8 @@ static void
 static void
 			EnrollProjInfoTargetList(PlanState *result, ProjectionInfo *ProjInfo);
 
+static void ExplainCodegenCompileStats(PlanState *node);
+
 /*
  * setSubplanSliceId
  *	 Set the slice id info for the given subplan.
@@ -369,6 +372,18 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			{
 			  EnrollProjInfoTargetList(result, result->ps_ProjInfo);
 			}
+
+			/*
+			 * Enroll the fused qual & projection step of ExecScan in
+			 * codegen_manager
+			 */
+			if (NULL != result &&
+				NULL != result->qual)
+			{
+				enroll_ExecScanFilterProject_codegen(ExecScanFilterProject,
+						&((ScanState *) result)->ExecScanFilterProject_gen_info.ExecScanFilterProject_fn,
+						(ScanState *) result);
+			}
 			}
 			END_MEMORY_ACCOUNT();
 			break;
@@ -548,6 +563,22 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			{
 			result = (PlanState *) ExecInitHashJoin((HashJoin *) node,
 													estate, eflags);
+			/*
+			 * Enroll the hash value computation of both sides of the join
+			 * in codegen_manager. The hash keys are set up by
+			 * ExecInitHashJoin, after the inner Hash node is initialized.
+			 */
+			if (NULL != result)
+			{
+			  enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+			        &((HashState *) innerPlanState(result))->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn,
+			        ((HashState *) innerPlanState(result))->ExecHashGetHashValue_gen_info,
+			        (HashJoinState *) result, false /* inner tuple */);
+			  enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+			        &((HashJoinState *) result)->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn,
+			        ((HashJoinState *) result)->ExecHashGetHashValue_gen_info,
+			        (HashJoinState *) result, true /* outer tuple */);
+			}
 			}
 			END_MEMORY_ACCOUNT();
 			break;
@@ -612,7 +643,14 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			  }
 			  enroll_AdvanceAggregates_codegen(advance_aggregates,
 			        &aggstate->AdvanceAggregates_gen_info.AdvanceAggregates_fn,
-			        aggstate);			}
+			        aggstate);
+			  if (((Agg *) node)->aggstrategy == AGG_HASHED)
+			  {
+			    enroll_CalcHashValue_codegen(calc_hash_value,
+			          &aggstate->CalcHashValue_gen_info.CalcHashValue_fn,
+			          aggstate);
+			  }
+			}
 			}
 			END_MEMORY_ACCOUNT();
 			break;
@@ -808,6 +846,7 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			if (!isExplainCodegenOnMaster)
 			{
 				(void) CodeGeneratorManagerPrepareGeneratedFunctions(CodegenManager);
+				ExplainCodegenCompileStats(result);
 			}
 		}
 	}
@@ -817,6 +856,37 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	return result;
 }
 
+/* ----------------------------------------------------------------
+ *	  ExplainCodegenCompileStats
+ *
+ *	  Report the compilation statistics of the node's code generator
+ *	  manager in EXPLAIN ANALYZE.
+ * ----------------------------------------------------------------
+ */
+static void
+ExplainCodegenCompileStats(PlanState *node)
+{
+	int			cache_hits = 0;
+	int			cache_misses = 0;
+	double		compile_ms = 0;
+
+	if (!codegen || !node->instrument)
+		return;
+
+	CodeGeneratorManagerGetCompileStats(node->CodegenManager,
+										&cache_hits,
+										&cache_misses,
+										&compile_ms);
+	if (cache_hits + cache_misses == 0 && compile_ms == 0)
+		return;
+
+	if (!node->cdbexplainbuf)
+		node->cdbexplainbuf = makeStringInfo();
+	appendStringInfo(node->cdbexplainbuf,
+					 "Codegen compile time: %.3f ms, module cache hits: %d, misses: %d.\n",
+					 compile_ms, cache_hits, cache_misses);
+}
+
 /* ----------------------------------------------------------------
  *	  EnrollQualList
  *
@@ -958,6 +1028,14 @@ ExecProcNode(PlanState *node)
 
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * Swap in the generated functions of this node once they have been
+	 * compiled in the background (see codegen_async_compile).
+	 */
+	if (CodeGeneratorManagerPendingCount > 0 &&
+		CodeGeneratorManagerPollGeneratedFunctions(node->CodegenManager))
+		ExplainCodegenCompileStats(node);
+
 	/*
 	 * Even if we are requested to finish query, Motion has to do its work
 	 * to tell End of Stream message to upper slice.  He will probably get
@@ -1213,6 +1291,11 @@ MultiExecProcNode(PlanState *node)
 
 	Assert(NULL != node->plan);
 
+	/* Hash is driven from here only, so swap in its functions here too */
+	if (CodeGeneratorManagerPendingCount > 0 &&
+		CodeGeneratorManagerPollGeneratedFunctions(node->CodegenManager))
+		ExplainCodegenCompileStats(node);
+
 	START_MEMORY_ACCOUNT(node->plan->memoryAccountId);
 	{
 		PG_TRACE5(execprocnode__enter, Gp_segment, currentSliceId, nodeTag(node), node->plan->plan_node_id, node->plan->plan_parent_node_id);
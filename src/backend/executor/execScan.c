@@ -108,6 +108,17 @@ ExecScan(ScanState *node,
 	econtext = node->ps.ps_ExprContext;
 	ResetExprContext(econtext);
 
+#ifdef USE_CODEGEN
+	/*
+	 * Scan nodes that were not enrolled for code generation use the regular
+	 * ExecScanFilterProject.
+	 */
+	if (NULL == node->ExecScanFilterProject_gen_info.ExecScanFilterProject_fn)
+	{
+		node->ExecScanFilterProject_gen_info.ExecScanFilterProject_fn = ExecScanFilterProject;
+	}
+#endif
+
 	/*
 	 * get a tuple from the access method loop until we obtain a tuple which
 	 * passes the qualification.
@@ -115,6 +126,7 @@ ExecScan(ScanState *node,
 	for (;;)
 	{
 		TupleTableSlot *slot;
+		TupleTableSlot *resultSlot;
 
 		CHECK_FOR_INTERRUPTS();
 
@@ -138,37 +150,16 @@ ExecScan(ScanState *node,
 		}
 
 		/*
-		 * place the current tuple into the expr context
+		 * check that the current tuple satisfies the qual-clause, and if so,
+		 * project it
 		 */
-		econtext->ecxt_scantuple = slot;
-
-		/*
-		 * check that the current tuple satisfies the qual-clause
-		 *
-		 * check for non-nil qual here to avoid a function call to ExecQual()
-		 * when the qual is nil ... saves only a few cycles, but they add up
-		 * ...
-		 */
-		if (!qual || ExecQual(qual, econtext, false))
+		resultSlot = call_ExecScanFilterProject(node, slot);
+		if (NULL != resultSlot)
 		{
 			/*
 			 * Found a satisfactory scan tuple.
 			 */
-			if (projInfo)
-			{
-				/*
-				 * Form a projection tuple, store it in the result tuple slot
-				 * and return it.
-				 */
-				return ExecProject(projInfo, NULL);
-			}
-			else
-			{
-				/*
-				 * Here, we aren't projecting, so just return scan tuple.
-				 */
-				return slot;
-			}
+			return resultSlot;
 		}
 
 		/*
@@ -178,6 +169,55 @@ ExecScan(ScanState *node,
 	}
 }
 
+/* ----------------------------------------------------------------
+ *		ExecScanFilterProject
+ *
+ *		Checks the given scan tuple against the qual-clause of the node
+ *		and, if it qualifies, forms the projection tuple.
+ *
+ *		Returns the projection result slot (or the scan tuple itself when
+ *		there is no projection) if the tuple qualifies, NULL otherwise.
+ *		This is the per-tuple part of ExecScan, split out so that it can be
+ *		replaced by a generated function when codegen is enabled.
+ * ----------------------------------------------------------------
+ */
+TupleTableSlot *
+ExecScanFilterProject(ScanState *node, TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ps.ps_ExprContext;
+	List	   *qual = node->ps.qual;
+	ProjectionInfo *projInfo = node->ps.ps_ProjInfo;
+
+	/*
+	 * place the current tuple into the expr context
+	 */
+	econtext->ecxt_scantuple = slot;
+
+	/*
+	 * check that the current tuple satisfies the qual-clause
+	 *
+	 * check for non-nil qual here to avoid a function call to ExecQual()
+	 * when the qual is nil ... saves only a few cycles, but they add up
+	 * ...
+	 */
+	if (qual && !ExecQual(qual, econtext, false))
+		return NULL;
+
+	if (projInfo)
+	{
+		/*
+		 * Form a projection tuple, store it in the result tuple slot
+		 * and return it.
+		 */
+		return ExecProject(projInfo, NULL);
+	}
+
+	/*
+	 * Here, we aren't projecting, so just return scan tuple.
+	 */
+	return slot;
+}
+
 /*
  * ExecAssignScanProjectionInfo
  *		Set up projection info for a scan node, if necessary.
@@ -42,6 +42,7 @@
 
 #include "cdb/cdbexplain.h"
 #include "cdb/cdbvars.h"
+#include "codegen/codegen_wrapper.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf);
@@ -130,8 +131,9 @@ MultiExecHash(HashState *node)
 		econtext->ecxt_innertuple = slot;
 		bool hashkeys_null = false;
 
-		if (ExecHashGetHashValue(node, hashtable, econtext, hashkeys, false,
-								 node->hs_keepnull, &hashvalue, &hashkeys_null))
+		if (call_ExecHashGetHashValue(node->ExecHashGetHashValue_gen_info,
+									  node, hashtable, econtext, hashkeys, false,
+									  node->hs_keepnull, &hashvalue, &hashkeys_null))
 		{
 			ExecHashTableInsert(node, hashtable, slot, hashvalue);
 		}
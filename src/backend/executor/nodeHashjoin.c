@@ -25,6 +25,7 @@
 #include "utils/memutils.h"
 
 #include "cdb/cdbvars.h"
+#include "codegen/codegen_wrapper.h"
 #include "miscadmin.h"			/* work_mem */
 
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
@@ -726,12 +727,13 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 					(hjstate->js.jointype == JOIN_LASJ) ||
 					(hjstate->js.jointype == JOIN_LASJ_NOTIN) ||
 					hjstate->hj_nonequijoin;
-			if (ExecHashGetHashValue(hashState, hashtable, econtext,
-									 hjstate->hj_OuterHashKeys,
-									 true,		/* outer tuple */
-									 keep_nulls,
-									 hashvalue,
-									 &hashkeys_null))
+			if (call_ExecHashGetHashValue(hjstate->ExecHashGetHashValue_gen_info,
+										  hashState, hashtable, econtext,
+										  hjstate->hj_OuterHashKeys,
+										  true,		/* outer tuple */
+										  keep_nulls,
+										  hashvalue,
+										  &hashkeys_null))
 			{
 				/* remember outer relation is not empty for possible rescan */
 				hjstate->hj_OuterNotEmpty = true;
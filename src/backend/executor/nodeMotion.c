@@ -43,6 +43,14 @@
 
 /* #define CDB_MOTION_DEBUG */
 
+/*
+ * Redistribute Motions whose rows are estimated to be wider than this, in
+ * bytes, hash and send their tuples one at a time.  A batch keeps a copy of
+ * each of its tuples, and copying a wide tuple costs more than hashing its
+ * keys in a batch saves.
+ */
+#define MOTION_HASH_BATCH_MAX_WIDTH 128
+
 #ifdef CDB_MOTION_DEBUG
 #include "lib/stringinfo.h"     /* StringInfo */
 #endif
@@ -106,6 +114,7 @@ CdbMergeComparator_DestroyContext(CdbMergeComparatorContext *ctx);
  * FUNCTIONS PROTOTYPES
  */
 static TupleTableSlot *execMotionSender(MotionState * node);
+static void execMotionSenderBatch(MotionState * node);
 static TupleTableSlot *execMotionUnsortedReceiver(MotionState * node);
 static TupleTableSlot *execMotionSortedReceiver(MotionState * node);
 static TupleTableSlot *execMotionSortedReceiver_mk(MotionState * node);
@@ -118,6 +127,8 @@ static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes
 
 static void doSendEndOfStream(Motion * motion, MotionState * node);
 static void doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
+static void doSendTupleToRoute(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot, int16 targetRoute);
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
 /*=========================================================================
@@ -315,6 +326,12 @@ execMotionSender(MotionState * node)
 			(motion->motionType == MOTIONTYPE_FIXED && motion->numOutputSegs <= 1));
 	Assert(node->ps.state->interconnect_context);
 
+	if (node->batchSize > 0)
+	{
+		execMotionSenderBatch(node);
+		return NULL;
+	}
+
 	while (!done)
 	{
 		/* grab TupleTableSlot from our child. */
@@ -388,6 +405,125 @@ execMotionSender(MotionState * node)
 }
 
 
+/*
+ * Sender of a hash motion with gp_motion_hash_batch_size > 1.
+ *
+ * Copies a batch of tuples from the child and evaluates their hash keys,
+ * hashes the batch one key at a time with cdbhashbatch(), then sends the
+ * tuples grouped by segment.  Tuples to the same segment keep the order the
+ * child returned them in, and follow each other into the same packet.
+ */
+static void
+execMotionSenderBatch(MotionState * node)
+{
+	Motion	   *motion = (Motion *) node->ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	ExprContext *econtext = node->ps.ps_ExprContext;
+	int			batchSize = node->batchSize;
+	int			numsegs = node->cdbhash->numsegs;
+	bool		done = false;
+
+	Assert(motion->motionType == MOTIONTYPE_HASH);
+	Assert(node->cdbhash->numsegs == motion->numOutputSegs);
+
+	while (!done)
+	{
+		MemoryContext oldContext;
+		ListCell   *hk;
+		ListCell   *ht;
+		int			ntuples = 0;
+		int			i;
+		int			k;
+
+		/* Key values of the last batch are no longer needed. */
+		ResetExprContext(econtext);
+		oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+		while (ntuples < batchSize)
+		{
+			TupleTableSlot *outerTupleSlot = ExecProcNode(outerNode);
+			TupleTableSlot *slot;
+
+			if (TupIsNull(outerTupleSlot))
+			{
+				done = true;
+				break;
+			}
+
+			node->numTuplesFromChild++;
+
+			/* The child may reuse its slot, so keep a copy. */
+			slot = ExecCopySlot(node->batchSlots[ntuples], outerTupleSlot);
+			econtext->ecxt_outertuple = slot;
+
+			k = 0;
+			foreach(hk, node->hashExpr)
+			{
+				int			idx = k * batchSize + ntuples;
+
+				node->batchValues[idx] = ExecEvalExpr((ExprState *) lfirst(hk), econtext,
+													  &node->batchIsnull[idx], NULL);
+				k++;
+			}
+			ntuples++;
+		}
+
+		cdbhashinitbatch(node->batchHashes, ntuples);
+		k = 0;
+		foreach(ht, motion->hashDataTypes)
+		{
+			cdbhashbatch(node->batchHashes,
+						 &node->batchValues[k * batchSize],
+						 &node->batchIsnull[k * batchSize],
+						 ntuples, lfirst_oid(ht));
+			k++;
+		}
+		cdbhashreducebatch(node->cdbhash, node->batchHashes, ntuples);
+
+		MemoryContextSwitchTo(oldContext);
+
+		/* Counting sort of the batch by segment, stable. */
+		memset(node->batchSegCounts, 0, (numsegs + 1) * sizeof(int));
+		for (i = 0; i < ntuples; i++)
+		{
+			Assert(node->batchHashes[i] < getgpsegmentCount() && "redistribute destination outside segment array");
+			node->batchSegCounts[node->batchHashes[i] + 1]++;
+		}
+		for (i = 0; i < numsegs; i++)
+			node->batchSegCounts[i + 1] += node->batchSegCounts[i];
+		for (i = 0; i < ntuples; i++)
+			node->batchOrder[node->batchSegCounts[node->batchHashes[i]]++] = i;
+
+		for (i = 0; i < ntuples && !node->stopRequested; i++)
+		{
+			int			idx = node->batchOrder[i];
+			int16		targetRoute = motion->outputSegIdx[node->batchHashes[idx]];
+
+			/* See doSendTuple(). */
+			Assert(targetRoute != BROADCAST_SEGIDX);
+
+			doSendTupleToRoute(motion, node, node->batchSlots[idx], targetRoute);
+
+			Gpmon_M_Incr_Rows_Out(GpmonPktFromMotionState(node));
+			setMotionStatsForGpmon(node);
+			CheckSendPlanStateGpmonPkt(&node->ps);
+		}
+
+		if (node->stopRequested)
+		{
+			elog(gp_workfile_caching_loglevel, "Motion initiating Squelch walker");
+			/* propagate stop notification to our children */
+			ExecSquelchNode(outerNode);
+			break;
+		}
+
+		if (done)
+			doSendEndOfStream(motion, node);
+	}
+
+	Assert(node->stopRequested || node->numTuplesFromChild == node->numTuplesToAMS);
+}
+
 static TupleTableSlot *
 execMotionUnsortedReceiver(MotionState * node)
 {
@@ -1020,6 +1156,28 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 		 * Create hash API reference
 		 */
 		motionstate->cdbhash = makeCdbHash(node->numOutputSegs);
+
+		/*
+		 * Hash and send the tuples in batches, see execMotionSenderBatch().
+		 * Without keys every tuple takes the next round-robin value, so
+		 * there is nothing to batch.
+		 */
+		if (nkeys > 0 && Gp_motion_hash_batch_size > 1 &&
+			node->plan.plan_width <= MOTION_HASH_BATCH_MAX_WIDTH)
+		{
+			int			batchSize = Gp_motion_hash_batch_size;
+			int			slotno;
+
+			motionstate->batchSize = batchSize;
+			motionstate->batchSlots = palloc(batchSize * sizeof(TupleTableSlot *));
+			for (slotno = 0; slotno < batchSize; slotno++)
+				motionstate->batchSlots[slotno] = MakeSingleTupleTableSlot(tupDesc);
+			motionstate->batchValues = palloc(nkeys * batchSize * sizeof(Datum));
+			motionstate->batchIsnull = palloc(nkeys * batchSize * sizeof(bool));
+			motionstate->batchHashes = palloc(batchSize * sizeof(uint32));
+			motionstate->batchOrder = palloc(batchSize * sizeof(int));
+			motionstate->batchSegCounts = palloc((node->numOutputSegs + 1) * sizeof(int));
+		}
     }
 
 	/* Merge Receive: Set up the key comparator and priority queue. */
@@ -1047,6 +1205,12 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
         }
 	}
 
+	/*
+	 * CDB: Offer interconnect compression info for EXPLAIN ANALYZE.
+	 */
+	if (estate->es_instrument && motionstate->mstype != MOTIONSTATE_NONE)
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
+
 	/*
 	 * Perform per-node initialization in the motion layer.
 	 */
@@ -1193,6 +1357,22 @@ ExecEndMotion(MotionState * node)
 		node->cdbhash = NULL;
 	}
 
+	/* Free the batch of a batched hash motion sender. */
+	if (node->batchSize > 0)
+	{
+		int			slotno;
+
+		for (slotno = 0; slotno < node->batchSize; slotno++)
+			ExecDropSingleTupleTableSlot(node->batchSlots[slotno]);
+		pfree(node->batchSlots);
+		pfree(node->batchValues);
+		pfree(node->batchIsnull);
+		pfree(node->batchHashes);
+		pfree(node->batchOrder);
+		pfree(node->batchSegCounts);
+		node->batchSize = 0;
+	}
+
 	/*
 	 * Free up this motion node's resources in the Motion Layer.
 	 *
@@ -1439,8 +1619,6 @@ void
 doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 {
 	int16		    targetRoute;
-	HeapTuple       tuple;
-	SendReturnCode  sendRC;
 	ExprContext    *econtext = node->ps.ps_ExprContext;
 	
 	/* We got a tuple from the child-plan. */
@@ -1505,6 +1683,18 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 		Assert(!is_null);
 	}
 
+	doSendTupleToRoute(motion, node, outerTupleSlot, targetRoute);
+}
+
+/*
+ * Send a tuple from the child to targetRoute.
+ */
+void
+doSendTupleToRoute(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot, int16 targetRoute)
+{
+	HeapTuple       tuple;
+	SendReturnCode  sendRC;
+
 	tuple = ExecFetchSlotGenericTuple(outerTupleSlot, true);
 
 	CheckAndSendRecordCache(node->ps.state->motionlayer_context,
@@ -1603,6 +1793,37 @@ ExecStopMotion(MotionState * node)
 					motion->motionID);
 }
 
+/*
+ * ExecMotionExplainEnd
+ *      Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports the bytes before and after compression of the packets this
+ * motion sent or received compressed (gp_interconnect_compress).
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	Motion	   *motion = (Motion *) planstate->plan;
+	MotionNodeEntry *pMNEntry;
+
+	pMNEntry = getMotionNodeEntry(planstate->state->motionlayer_context,
+								  motion->motionID, "ExecMotionExplainEnd");
+
+	if (pMNEntry->stat_compress_bytes_in > 0)
+		appendStringInfo(buf,
+						 "Interconnect compression: sent " UINT64_FORMAT
+						 " bytes as " UINT64_FORMAT " bytes.\n",
+						 pMNEntry->stat_compress_bytes_in,
+						 pMNEntry->stat_compress_bytes_out);
+
+	if (pMNEntry->stat_decompress_bytes_in > 0)
+		appendStringInfo(buf,
+						 "Interconnect compression: received " UINT64_FORMAT
+						 " bytes as " UINT64_FORMAT " bytes.\n",
+						 pMNEntry->stat_decompress_bytes_in,
+						 pMNEntry->stat_decompress_bytes_out);
+}
+
 void
 initGpmonPktForMotion(Plan *planNode, gpmon_packet_t *gpmon_pkt, EState *estate)
 {
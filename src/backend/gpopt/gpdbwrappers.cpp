@@ -807,6 +807,30 @@ gpdb::HtAttrStats
 	return NULL;
 }
 
+void
+gpdb::PrefetchAttrStats
+	(
+	Oid relid
+	)
+{
+	GP_WRAP_START;
+	{
+		/*
+		 * catalog tables: pg_statistic
+		 *
+		 * A list search reads all the rows of the relation in one index
+		 * scan, and enters them in the catalog cache, where they stay after
+		 * the list is released.
+		 */
+		CatCList   *catlist = SearchSysCacheList1(STATRELATT,
+												  ObjectIdGetDatum(relid));
+
+		ReleaseSysCacheList(catlist);
+		return;
+	}
+	GP_WRAP_END;
+}
+
 Oid
 gpdb::OidCommutatorOp
 	(
@@ -2935,16 +2959,190 @@ static bool mdcache_invalidation_counter_registered = false;
 static int64 mdcache_invalidation_counter = 0;
 static int64 last_mdcache_invalidation_counter = 0;
 
+/*
+ * The metadata provider cache holds the serialized DXL of the metadata
+ * objects that CMDProviderRelcache has translated from the relcache, for the
+ * whole session. It sits underneath the ORCA metadata cache: when the latter
+ * is blown away because something changed, the objects that were not
+ * affected by the change are served from here, instead of being translated
+ * again. That matters for partitioned tables, whose relation and statistics
+ * objects are built from all of their leaf partitions.
+ *
+ * Unlike the ORCA cache, entries are invalidated individually:
+ *
+ * - a relcache invalidation drops the entries keyed on that relation (its
+ *   relation, index and statistics objects). If the relation is a leaf
+ *   partition, the entries of the partitioned table and all index entries
+ *   are dropped too. Finding out the partitioned table needs catalog access,
+ *   which we cannot do from the callback, so relids are queued and
+ *   processed on the next lookup.
+ *
+ * - a pg_statistic invalidation drops all statistics objects, as the
+ *   callback doesn't tell us which relation they belong to.
+ *
+ * - any other syscache invalidation drops the whole cache.
+ *
+ * When the cache grows beyond optimizer_mdcache_size, it is emptied too.
+ */
+#define MDPROVIDER_CACHE_MAX_PENDING	64
+
+typedef struct MDProviderCacheEntry
+{
+	char		key[MDPROVIDER_CACHE_KEYLEN];	/* mdid string, hash key */
+	Oid			relid;			/* relation/index the object belongs to */
+	bool		isstats;		/* relation or column statistics? */
+	bool		isindex;		/* index object? */
+	Size		size;			/* size of dxl, in bytes */
+	WCHAR	   *dxl;			/* serialized object */
+	Dlelem		relelem;		/* link in the entries of the relation */
+	Dlelem		kindelem;		/* link in the statistics or index entries */
+} MDProviderCacheEntry;
+
+/* The entries that belong to a relation, so they can be found by relid */
+typedef struct MDProviderCacheRelEntry
+{
+	Oid			relid;			/* hash key */
+	Dllist		entries;		/* MDProviderCacheEntrys of the relation */
+} MDProviderCacheRelEntry;
+
+static MemoryContext mdprovider_cache_context = NULL;
+static HTAB *mdprovider_cache = NULL;
+static HTAB *mdprovider_cache_rels = NULL;
+static Dllist mdprovider_cache_stats;
+static Dllist mdprovider_cache_indexes;
+static Size mdprovider_cache_size = 0;
+
+/* relcache invalidations not processed yet */
+static Oid	mdprovider_pending_relids[MDPROVIDER_CACHE_MAX_PENDING];
+static int	mdprovider_npending = 0;
+
+static void
+mdprovider_cache_reset(void)
+{
+	if (mdprovider_cache_context != NULL)
+		MemoryContextResetAndDeleteChildren(mdprovider_cache_context);
+	mdprovider_cache = NULL;
+	mdprovider_cache_rels = NULL;
+	mdprovider_cache_size = 0;
+	mdprovider_npending = 0;
+}
+
+/*
+ * Unlink an entry from the lists it is in, and drop it.
+ */
+static void
+mdprovider_cache_remove_entry(MDProviderCacheEntry *entry)
+{
+	Dllist	   *rellist = DLGetListHdr(&entry->relelem);
+
+	DLRemove(&entry->relelem);
+	if (DLGetHead(rellist) == NULL)
+		hash_search(mdprovider_cache_rels, &entry->relid, HASH_REMOVE, NULL);
+
+	if (DLGetListHdr(&entry->kindelem) != NULL)
+		DLRemove(&entry->kindelem);
+
+	mdprovider_cache_size -= entry->size;
+	pfree(entry->dxl);
+	hash_search(mdprovider_cache, entry->key, HASH_REMOVE, NULL);
+}
+
+/*
+ * Drop all the entries in a list, either the entries of a relation, or the
+ * statistics or index entries.
+ */
+static void
+mdprovider_cache_remove_list(Dllist *list)
+{
+	Dlelem	   *elem;
+
+	/* removing the last entry of a relation frees its list, check first */
+	while ((elem = DLGetHead(list)) != NULL)
+	{
+		bool		last = (DLGetSucc(elem) == NULL);
+
+		mdprovider_cache_remove_entry((MDProviderCacheEntry *) DLE_VAL(elem));
+		if (last)
+			break;
+	}
+}
+
+/*
+ * Drop the entries that belong to the given relation.
+ */
+static void
+mdprovider_cache_remove_rel(Oid relid)
+{
+	MDProviderCacheRelEntry *relentry;
+
+	if (mdprovider_cache == NULL)
+		return;
+
+	relentry = (MDProviderCacheRelEntry *) hash_search(mdprovider_cache_rels,
+													   &relid, HASH_FIND, NULL);
+	if (relentry != NULL)
+		mdprovider_cache_remove_list(&relentry->entries);
+}
+
+/*
+ * Process the queued relcache invalidations. This may access the catalogs,
+ * and thereby process more invalidations, so loop until there are none
+ * left.
+ */
+static void
+mdprovider_cache_process_pending(void)
+{
+	bool		indexes = false;
+
+	/* the partitioning catalogs are only populated on the master */
+	if (mdprovider_npending > 0 && Gp_segment != -1)
+		mdprovider_cache_reset();
+
+	while (mdprovider_npending > 0)
+	{
+		Oid			relid = mdprovider_pending_relids[--mdprovider_npending];
+		Oid			masterid;
+
+		mdprovider_cache_remove_rel(relid);
+
+		/* catalog tables: pg_partition, pg_partition_rule */
+		masterid = rel_partition_get_master(relid);
+		if (OidIsValid(masterid) && masterid != relid)
+		{
+			mdprovider_cache_remove_rel(masterid);
+			indexes = true;
+		}
+	}
+
+	/* a leaf partition changed, drop the index entries just once */
+	if (indexes && mdprovider_cache != NULL)
+		mdprovider_cache_remove_list(&mdprovider_cache_indexes);
+}
+
 static void
 mdsyscache_invalidation_counter_callback(Datum arg, int cacheid,  ItemPointer tuplePtr)
 {
 	mdcache_invalidation_counter++;
+
+	if (cacheid == STATRELATT)
+	{
+		if (mdprovider_cache != NULL)
+			mdprovider_cache_remove_list(&mdprovider_cache_stats);
+	}
+	else
+		mdprovider_cache_reset();
 }
 
 static void
 mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
 {
 	mdcache_invalidation_counter++;
+
+	if (!OidIsValid(relid) ||
+		mdprovider_npending == MDPROVIDER_CACHE_MAX_PENDING)
+		mdprovider_cache_reset();
+	else if (mdprovider_cache != NULL)
+		mdprovider_pending_relids[mdprovider_npending++] = relid;
 }
 
 static void
@@ -3042,4 +3240,150 @@ gpdb::FMDCacheNeedsReset
 	return true;
 }
 
+// Look up the serialized DXL of a metadata object in the metadata provider
+// cache. The result points into the cache, and is only valid until the next
+// call to a backend function.
+const WCHAR *
+gpdb::WszMDProviderCacheLookup
+	(
+	const char *szKey
+	)
+{
+	GP_WRAP_START;
+	{
+		MDProviderCacheEntry *entry;
+
+		// without the invalidation callbacks, we cannot trust the cache
+		if (!mdcache_invalidation_counter_registered ||
+			strlen(szKey) >= MDPROVIDER_CACHE_KEYLEN)
+			return NULL;
+
+		mdprovider_cache_process_pending();
+		if (mdprovider_cache == NULL)
+			return NULL;
+
+		entry = (MDProviderCacheEntry *) hash_search(mdprovider_cache, szKey,
+													 HASH_FIND, NULL);
+		if (entry == NULL)
+			return NULL;
+
+		return entry->dxl;
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Number of catalog invalidations seen so far
+int64
+gpdb::LlMDCacheInvalidationCounter
+	(
+	void
+	)
+{
+	return mdcache_invalidation_counter;
+}
+
+// Add the serialized DXL of a metadata object to the metadata provider cache.
+// Translating the object may have processed invalidations of the catalog rows
+// it was built from, after which the DXL is stale and must not be cached.
+void
+gpdb::MDProviderCacheInsert
+	(
+	const char *szKey,
+	Oid oidRel,
+	bool fStats,
+	bool fIndex,
+	const WCHAR *wszDXL,
+	ULONG ulLength,
+	int64 llInvalidationCounter
+	)
+{
+	GP_WRAP_START;
+	{
+		MDProviderCacheEntry *entry;
+		MDProviderCacheRelEntry *relentry;
+		Size		size = (ulLength + 1) * sizeof(WCHAR);
+		bool		found;
+
+		if (!mdcache_invalidation_counter_registered ||
+			strlen(szKey) >= MDPROVIDER_CACHE_KEYLEN)
+			return;
+
+		mdprovider_cache_process_pending();
+
+		/* processing the pending relids may accept invalidations, too */
+		if (llInvalidationCounter != mdcache_invalidation_counter)
+			return;
+
+		if (optimizer_mdcache_size > 0 &&
+			mdprovider_cache_size + size > (Size) optimizer_mdcache_size * 1024L)
+			mdprovider_cache_reset();
+
+		if (mdprovider_cache_context == NULL)
+			mdprovider_cache_context =
+				AllocSetContextCreate(CacheMemoryContext,
+									  "ORCA metadata provider cache",
+									  ALLOCSET_DEFAULT_MINSIZE,
+									  ALLOCSET_DEFAULT_INITSIZE,
+									  ALLOCSET_DEFAULT_MAXSIZE);
+
+		if (mdprovider_cache == NULL)
+		{
+			HASHCTL		ctl;
+
+			MemSet(&ctl, 0, sizeof(ctl));
+			ctl.keysize = MDPROVIDER_CACHE_KEYLEN;
+			ctl.entrysize = sizeof(MDProviderCacheEntry);
+			ctl.hash = string_hash;
+			ctl.hcxt = mdprovider_cache_context;
+			mdprovider_cache = hash_create("ORCA metadata provider cache", 1024,
+										   &ctl,
+										   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+			MemSet(&ctl, 0, sizeof(ctl));
+			ctl.keysize = sizeof(Oid);
+			ctl.entrysize = sizeof(MDProviderCacheRelEntry);
+			ctl.hash = oid_hash;
+			ctl.hcxt = mdprovider_cache_context;
+			mdprovider_cache_rels = hash_create("ORCA metadata provider cache relations",
+												256, &ctl,
+												HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+			DLInitList(&mdprovider_cache_stats);
+			DLInitList(&mdprovider_cache_indexes);
+		}
+
+		entry = (MDProviderCacheEntry *) hash_search(mdprovider_cache, szKey,
+													 HASH_FIND, NULL);
+		if (entry != NULL)
+			mdprovider_cache_remove_entry(entry);
+
+		entry = (MDProviderCacheEntry *) hash_search(mdprovider_cache, szKey,
+													 HASH_ENTER, &found);
+		entry->relid = oidRel;
+		entry->isstats = fStats;
+		entry->isindex = fIndex;
+		entry->size = size;
+		entry->dxl = (WCHAR *) MemoryContextAlloc(mdprovider_cache_context, size);
+		memcpy(entry->dxl, wszDXL, size);
+		mdprovider_cache_size += size;
+
+		relentry = (MDProviderCacheRelEntry *) hash_search(mdprovider_cache_rels,
+														   &oidRel, HASH_ENTER,
+														   &found);
+		if (!found)
+			DLInitList(&relentry->entries);
+		DLInitElem(&entry->relelem, entry);
+		DLAddTail(&relentry->entries, &entry->relelem);
+
+		DLInitElem(&entry->kindelem, entry);
+		if (fStats)
+			DLAddTail(&mdprovider_cache_stats, &entry->kindelem);
+		else if (fIndex)
+			DLAddTail(&mdprovider_cache_indexes, &entry->kindelem);
+	}
+	GP_WRAP_END;
+}
+
 // EOF
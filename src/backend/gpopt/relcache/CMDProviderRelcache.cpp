@@ -15,11 +15,17 @@
 //---------------------------------------------------------------------------
 
 #include "postgres.h"
+#include "utils/guc.h"
+
+#include "gpopt/gpdbwrappers.h"
 #include "gpopt/relcache/CMDProviderRelcache.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
 #include "gpopt/mdcache/CMDAccessor.h"
 
 #include "naucrates/dxl/CDXLUtils.h"
+#include "naucrates/md/CMDIdColStats.h"
+#include "naucrates/md/CMDIdGPDB.h"
+#include "naucrates/md/CMDIdRelStats.h"
 
 #include "naucrates/exception.h"
 
@@ -45,12 +51,49 @@ CMDProviderRelcache::CMDProviderRelcache
 	GPOS_ASSERT(NULL != m_pmp);
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::OidRelation
+//
+//	@doc:
+//		Returns the oid of the relation, or index, whose invalidation
+//		invalidates the given metadata object. For other GPDB objects, the
+//		object's own oid is returned, which is harmless. Returns InvalidOid
+//		for objects only invalidated by catalog changes
+//
+//---------------------------------------------------------------------------
+OID
+CMDProviderRelcache::OidRelation
+	(
+	IMDId *pmdid
+	)
+{
+	switch (pmdid->Emdidt())
+	{
+		case IMDId::EmdidGPDB:
+			return CMDIdGPDB::PmdidConvert(pmdid)->OidObjectId();
+
+		case IMDId::EmdidRelStats:
+			return CMDIdGPDB::PmdidConvert(CMDIdRelStats::PmdidConvert(pmdid)->PmdidRel())->OidObjectId();
+
+		case IMDId::EmdidColStats:
+			return CMDIdGPDB::PmdidConvert(CMDIdColStats::PmdidConvert(pmdid)->PmdidRel())->OidObjectId();
+
+		default:
+			return InvalidOid;
+	}
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDProviderRelcache::PstrObject
 //
 //	@doc:
-//		Returns the DXL of the requested object in the provided memory pool
+//		Returns the DXL of the requested object in the provided memory pool.
+//		With metadata caching enabled, the DXL is kept in the session-level
+//		metadata provider cache of gpdbwrappers.cpp, so that it doesn't need
+//		to be translated again after the metadata cache is reset, unless the
+//		object itself was invalidated
 //
 //---------------------------------------------------------------------------
 CWStringBase *
@@ -62,6 +105,35 @@ CMDProviderRelcache::PstrObject
 	)
 	const
 {
+	// the mdid string is the cache key; it consists of digits and dots only
+	CHAR szKey[MDPROVIDER_CACHE_KEYLEN];
+	BOOL fCache = false;
+
+	if (optimizer_metadata_caching)
+	{
+		const WCHAR *wszMDId = pmdid->Wsz();
+		ULONG ul = 0;
+
+		for (; ul < MDPROVIDER_CACHE_KEYLEN - 1 && L'\0' != wszMDId[ul]; ul++)
+		{
+			szKey[ul] = (CHAR) wszMDId[ul];
+		}
+		szKey[ul] = '\0';
+		fCache = (L'\0' == wszMDId[ul]);
+	}
+
+	if (fCache)
+	{
+		const WCHAR *wszDXL = gpdb::WszMDProviderCacheLookup(szKey);
+		if (NULL != wszDXL)
+		{
+			return GPOS_NEW(m_pmp) CWStringDynamic(m_pmp, wszDXL);
+		}
+	}
+
+	// translating may lock relations and thus process invalidations
+	int64 llInvalidationCounter = gpdb::LlMDCacheInvalidationCounter();
+
 	IMDCacheObject *pimdobj = CTranslatorRelcacheToDXL::Pimdobj(pmp, pmda, pmdid);
 
 	GPOS_ASSERT(NULL != pimdobj);
@@ -71,6 +143,15 @@ CMDProviderRelcache::PstrObject
 	// cleanup DXL object
 	pimdobj->Release();
 
+	if (fCache)
+	{
+		OID oidRel = OidRelation(pmdid);
+		BOOL fStats = (IMDId::EmdidRelStats == pmdid->Emdidt() || IMDId::EmdidColStats == pmdid->Emdidt());
+		BOOL fIndex = (IMDId::EmdidGPDB == pmdid->Emdidt() && gpdb::FIndexExists(oidRel));
+
+		gpdb::MDProviderCacheInsert(szKey, oidRel, fStats, fIndex, pstr->Wsz(), pstr->UlLength(), llInvalidationCounter);
+	}
+
 	return pstr;
 }
 
@@ -2148,6 +2148,10 @@ CTranslatorRelcacheToDXL::PimdobjRelStats
 			rows = rel->rd_rel->reltuples;
 		}
 
+		// the column statistics are requested next, one column at a time:
+		// fetch the pg_statistic rows of all columns at once
+		gpdb::PrefetchAttrStats(oidRelation);
+
 		pmdidRelStats->AddRef();
 		gpdb::CloseRelation(rel);
 	}
@@ -69,6 +69,21 @@
 typedef int16 NumericDigit;
 #endif
 
+/* ----------
+ * Additions of numerics with few enough digits are done in 128-bit integer
+ * arithmetic when the compiler provides it.  NUMERIC_INT128_MAX_NDIGITS is
+ * the largest number of NBASE digits, counted from the first integral digit
+ * down to the last digit of the result scale, such that the sum of two such
+ * values cannot overflow an int128.
+ * ----------
+ */
+#if defined(__SIZEOF_INT128__)
+#define USE_NUMERIC_INT128
+typedef __int128 int128;
+
+#define NUMERIC_INT128_MAX_NDIGITS	9
+#endif
+
 
 /* ----------
  * NumericVar is the format we use for arithmetic.	The digit-array part
@@ -307,6 +322,14 @@ static int	cmp_var_common(const NumericDigit *var1digits, int var1ndigits,
 			   const NumericDigit *var2digits, int var2ndigits,
 			   int var2weight, int var2sign);
 static void add_var(NumericVar *var1, NumericVar *var2, NumericVar *result);
+static void add_var_fast(NumericVar *var1, NumericVar *var2,
+						 NumericVar *result);
+#ifdef USE_NUMERIC_INT128
+static bool numericvar_to_int128(NumericVar *var, int fracdigits,
+								 int128 *result);
+static void int128_to_numericvar(int128 val, int fracdigits, int dscale,
+								 NumericVar *var);
+#endif
 static void sub_var(NumericVar *var1, NumericVar *var2, NumericVar *result);
 static void mul_var(NumericVar *var1, NumericVar *var2, NumericVar *result,
 		int rscale);
@@ -1269,30 +1292,40 @@ numeric_add(PG_FUNCTION_ARGS)
 {
 	Numeric		num1 = PG_GETARG_NUMERIC(0);
 	Numeric		num2 = PG_GETARG_NUMERIC(1);
+
+	PG_RETURN_NUMERIC(add_numerics(num1, num2));
+}
+
+/*
+ * add_numerics() -
+ *
+ *	Add two detoasted numerics.  This is the body of numeric_add(), exposed
+ *	for callers that bypass the fmgr interface, such as generated code.
+ */
+Numeric
+add_numerics(Numeric num1, Numeric num2)
+{
 	NumericVar	arg1;
 	NumericVar	arg2;
 	NumericVar	result;
-	Numeric		res;
 
 	/*
 	 * Handle NaN
 	 */
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
-		PG_RETURN_NUMERIC(make_result(&const_nan));
+		return make_result(&const_nan);
 
 	/*
-	 * Unpack the values, let add_var() compute the result and return it.
+	 * Unpack the values, let add_var_fast() compute the result and return it.
 	 */
 	quick_init_var(&result);
 
 	init_ro_var_from_num(num1, &arg1);
 	init_ro_var_from_num(num2, &arg2);
 
-	add_var(&arg1, &arg2, &result);
-
-	res = make_result(&result);
+	add_var_fast(&arg1, &arg2, &result);
 
-	PG_RETURN_NUMERIC(res);
+	return make_result(&result);
 }
 
 
@@ -3167,16 +3200,6 @@ float8_avg(PG_FUNCTION_ARGS)
  * AVG for numeric types
  */
 
-typedef struct NumericAvgTransData
-{
-	int32 _len; /* varattrib len, do not touch directly */
-#if 1
-	int32   pad;  /* pad so int64 and float64 will be 8 bytes alligned */
-#endif
-	int64 count; 
-	NumericData sum;
-} NumericAvgTransData;
-	
 static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, NumericVar *var)
 {
 	int oldlen = VARSIZE(tr) - offsetof(NumericAvgTransData, sum);
@@ -3207,7 +3230,7 @@ static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, Nu
 	return tr;
 }
 
-static Datum 
+Datum 
 numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc) 
 {
 	if(!tr || VARSIZE(tr) < sizeof(NumericAvgTransData))
@@ -3250,7 +3273,7 @@ numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc)
 			init_ro_var_from_num(newval, &v2);
 
 			if(acc)
-				add_var(&v1, &v2, &result);
+				add_var_fast(&v1, &v2, &result);
 			else
 				sub_var(&v1, &v2, &result);
 
@@ -4518,6 +4541,113 @@ add_var(NumericVar *var1, NumericVar *var2, NumericVar *result)
 }
 
 
+/*
+ * add_var_fast() -
+ *
+ *	Same as add_var(), but first tries to do the addition in 128-bit integer
+ *	arithmetic, which avoids the digit-by-digit loops and the allocation of
+ *	a result buffer for the common case of operands with a modest number of
+ *	digits, e.g. when accumulating sum(numeric) and avg(numeric).
+ */
+static void
+add_var_fast(NumericVar *var1, NumericVar *var2, NumericVar *result)
+{
+#ifdef USE_NUMERIC_INT128
+	int			dscale = Max(var1->dscale, var2->dscale);
+	int			fracdigits = (dscale + DEC_DIGITS - 1) / DEC_DIGITS;
+	int128		val1;
+	int128		val2;
+
+	if (numericvar_to_int128(var1, fracdigits, &val1) &&
+		numericvar_to_int128(var2, fracdigits, &val2))
+	{
+		int128_to_numericvar(val1 + val2, fracdigits, dscale, result);
+		return;
+	}
+#endif
+
+	add_var(var1, var2, result);
+}
+
+#ifdef USE_NUMERIC_INT128
+/*
+ * numericvar_to_int128() -
+ *
+ *	Convert a non-NaN variable to an int128 holding its value multiplied by
+ *	NBASE^fracdigits.  Returns false if the variable has too many digits for
+ *	the sum of two such values to fit.
+ */
+static bool
+numericvar_to_int128(NumericVar *var, int fracdigits, int128 *result)
+{
+	int128		val = 0;
+	int			i;
+
+	Assert(var->sign != NUMERIC_NAN);
+
+	if (var->ndigits == 0)
+	{
+		*result = 0;
+		return true;
+	}
+
+	/* Digits below the requested scale cannot be represented */
+	if (var->ndigits - var->weight - 1 > fracdigits)
+		return false;
+
+	if (Max(var->weight + 1, 0) + fracdigits > NUMERIC_INT128_MAX_NDIGITS)
+		return false;
+
+	for (i = 0; i < var->ndigits; i++)
+		val = val * NBASE + var->digits[i];
+
+	/* Append the stripped trailing zero digits down to the requested scale */
+	for (i = var->ndigits - var->weight - 1; i < fracdigits; i++)
+		val *= NBASE;
+
+	*result = (var->sign == NUMERIC_NEG) ? -val : val;
+	return true;
+}
+
+/*
+ * int128_to_numericvar() -
+ *
+ *	Inverse of numericvar_to_int128(): store val / NBASE^fracdigits into var,
+ *	using var's local digit buffer.
+ */
+static void
+int128_to_numericvar(int128 val, int fracdigits, int dscale, NumericVar *var)
+{
+	NumericDigit *ptr;
+	int			ndigits = 0;
+
+	digitbuf_free(var);
+
+	var->sign = NUMERIC_POS;
+	if (val < 0)
+	{
+		var->sign = NUMERIC_NEG;
+		val = -val;
+	}
+
+	ptr = var->buf + NUMERIC_LOCAL_NDIG;
+	while (val != 0)
+	{
+		*--ptr = (NumericDigit) (val % NBASE);
+		val /= NBASE;
+		ndigits++;
+	}
+
+	var->digits = ptr;
+	var->ndigits = ndigits;
+	var->weight = ndigits - fracdigits - 1;
+	var->dscale = dscale;
+
+	strip_var(var);
+}
+#endif   /* USE_NUMERIC_INT128 */
+
+
 /*
  * sub_var() -
  *
@@ -30,6 +30,17 @@
  * just to invalidate all plans.  We expect updates on those catalogs to
  * be infrequent enough that more-detailed tracking is not worth the effort.
  *
+ * In GPDB, a prepared statement that is executed with parameter values is
+ * normally planned again with those values (a "custom plan"), because that
+ * can give a much better plan. For short queries, the planning can take
+ * longer than the execution, though. With gp_enable_generic_plan_reuse, we
+ * keep track of the custom plans, and once a few of them have been made, we
+ * also try a plan made without the parameter values (a "generic plan"). If it
+ * doesn't look worse than the custom plans, it is reused for subsequent
+ * executions, until it is invalidated. As the choice depends on the
+ * statistics, generic plans of parameterized statements are also
+ * invalidated on updates to pg_statistic.
+ *
  *
  * Portions Copyright (c) 1996-2008, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -44,6 +55,7 @@
 #include "utils/plancache.h"
 #include "access/transam.h"
 #include "catalog/namespace.h"
+#include "cdb/cdbvars.h"
 #include "executor/executor.h"
 #include "executor/spi.h"
 #include "nodes/nodeFuncs.h"
@@ -59,6 +71,13 @@
 #include "utils/syscache.h"
 
 
+/*
+ * Number of custom plans made before we consider using a generic plan, and
+ * how much more a generic plan may cost than the average custom plan.
+ */
+#define MIN_CUSTOM_PLANS			5
+#define GENERIC_PLAN_COST_FACTOR	1.1
+
 static List *cached_plans_list = NIL;
 
 static void StoreCachedPlan(CachedPlanSource *plansource, List *stmt_list,
@@ -72,6 +91,12 @@ static bool plan_list_is_transient(List *stmt_list);
 static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheFuncCallback(Datum arg, int cacheid, ItemPointer tuplePtr);
 static void PlanCacheSysCallback(Datum arg, int cacheid, ItemPointer tuplePtr);
+static void PlanCacheStatsCallback(Datum arg, int cacheid, ItemPointer tuplePtr);
+static void reset_plan_choice(CachedPlanSource *plansource);
+static bool choose_custom_plan(CachedPlanSource *plansource,
+				   ParamListInfo boundParams, IntoClause *intoClause);
+static void record_plan_cost(CachedPlanSource *plansource, List *stmt_list,
+				 bool custom);
 
 
 /*
@@ -87,6 +112,7 @@ InitPlanCache(void)
 	CacheRegisterSyscacheCallback(NAMESPACEOID, PlanCacheSysCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(OPEROID, PlanCacheSysCallback, (Datum) 0);
 	CacheRegisterSyscacheCallback(AMOPOPID, PlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(STATRELATT, PlanCacheStatsCallback, (Datum) 0);
 }
 
 /*
@@ -163,6 +189,11 @@ CreateCachedPlan(Node *raw_parse_tree,
 	plansource->plan = NULL;
 	plansource->context = source_context;
 	plansource->orig_plan = NULL;
+	plansource->num_generic_execs = 0;
+	plansource->num_custom_execs = 0;
+	reset_plan_choice(plansource);
+	if (fully_planned)
+		record_plan_cost(plansource, stmt_list, false);
 
 	/*
 	 * Copy the current output plans into the plancache entry.
@@ -245,6 +276,11 @@ FastCreateCachedPlan(Node *raw_parse_tree,
 	plansource->plan = NULL;
 	plansource->context = context;
 	plansource->orig_plan = NULL;
+	plansource->num_generic_execs = 0;
+	plansource->num_custom_execs = 0;
+	reset_plan_choice(plansource);
+	if (fully_planned)
+		record_plan_cost(plansource, stmt_list, false);
 
 	/*
 	 * Store the current output plans into the plancache entry.
@@ -316,6 +352,7 @@ StoreCachedPlan(CachedPlanSource *plansource,
 	plan->stmt_list = stmt_list;
 	plan->fully_planned = plansource->fully_planned;
 	plan->dead = false;
+	plan->custom = false;
 	if (plansource->fully_planned && plan_list_is_transient(stmt_list))
 	{
 		Assert(TransactionIdIsNormal(TransactionXmin));
@@ -413,6 +450,7 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 							   ParamListInfo boundParams, IntoClause *intoClause)
 {
 	CachedPlan *plan;
+	bool		custom;
 
 	/* Validity check that we were given a CachedPlanSource */
 	Assert(list_member_ptr(cached_plans_list, plansource));
@@ -424,11 +462,20 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 	 */
 	plan = plansource->plan;
 
+	/*
+	 * If the plan has been invalidated, e.g. because the statistics changed,
+	 * what we have learned about custom and generic plans is stale, too.
+	 */
+	if (plan && plan->dead)
+		reset_plan_choice(plansource);
+
 	/*
 	 * If we are to use the parameter values in the plan, or this is a
-	 * CREATE TABLE AS EXECUTE, we cannot re-use a generic plan.
+	 * CREATE TABLE AS EXECUTE, we cannot re-use a generic plan. Conversely,
+	 * a plan made for such an execution cannot be reused.
 	 */
-	if (plan && (boundParams || intoClause))
+	custom = choose_custom_plan(plansource, boundParams, intoClause);
+	if (plan && (custom || plan->custom))
 		plan->dead = true;
 
 	if (plan && !plan->dead)
@@ -558,15 +605,20 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 				 * causes a problem if we're already inside one.  Rather than
 				 * expect all SPI-using code to do SPI_push whenever a replan
 				 * could happen, it seems best to take care of the case here.
+				 *
+				 * A generic plan is made without the parameter values.
 				 */
 				bool	pushed;
 
 				pushed = SPI_push_conditional();
 
 				slist = pg_plan_queries(slist, plansource->cursor_options,
-										boundParams, false);
+										custom ? boundParams : NULL, false);
 
 				SPI_pop_conditional(pushed);
+
+				if (!intoClause)
+					record_plan_cost(plansource, slist, custom);
 			}
 
 			/*
@@ -630,8 +682,19 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 		 * If we used the parameter values to create the plan, or this is a
 		 * CREATE TABLE AS, we cannot re-use this plan on subsequent calls.
 		 */
-		if (boundParams || intoClause)
+		if (custom)
+		{
+			plan->custom = true;
 			plan->saved_xmin = BootstrapTransactionId;
+		}
+	}
+
+	if (plansource->fully_planned)
+	{
+		if (plan->custom)
+			plansource->num_custom_execs++;
+		else
+			plansource->num_generic_execs++;
 	}
 
 	/*
@@ -656,6 +719,114 @@ RevalidateCachedPlan(CachedPlanSource *plansource, bool useResOwner)
 	return RevalidateCachedPlanWithParams(plansource, useResOwner, NULL, NULL);
 }
 
+/*
+ * reset_plan_choice: forget the custom and generic plans seen so far.
+ */
+static void
+reset_plan_choice(CachedPlanSource *plansource)
+{
+	plansource->num_custom_plans = 0;
+	plansource->total_custom_cost = 0;
+	plansource->custom_plan_gen = PLANGEN_PLANNER;
+	plansource->custom_plans_direct = true;
+	plansource->generic_cost = -1;
+	plansource->generic_plan_gen = PLANGEN_PLANNER;
+	plansource->generic_plan_direct = false;
+}
+
+/*
+ * choose_custom_plan: choose whether to make a custom plan, for the given
+ * parameter values, or to use a generic plan.
+ *
+ * Without gp_enable_generic_plan_reuse, we always use the parameter values
+ * if we have any. Otherwise, we make custom plans until we have seen a few,
+ * then try a generic plan, and keep using it if it costs at most a bit more
+ * than the average custom plan. ORCA can't handle parameters, so a generic
+ * plan of a statement that ORCA made the custom plans of comes from the
+ * Postgres planner. The costs of the two planners are not comparable, so in
+ * that case we keep making custom plans.
+ *
+ * Either way, if the parameter values allowed all the custom plans to be
+ * dispatched to a single segment, but the generic plan has to be dispatched
+ * to all of them, we keep making custom plans. The costs don't account for
+ * the dispatch.
+ */
+static bool
+choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams,
+				   IntoClause *intoClause)
+{
+	double		avg_custom_cost;
+
+	if (intoClause)
+		return true;
+	if (!boundParams || !plansource->fully_planned)
+		return false;
+	if (!gp_enable_generic_plan_reuse)
+		return true;
+
+	if (plansource->num_custom_plans < MIN_CUSTOM_PLANS)
+		return true;
+
+	/* Try a generic plan, to find out its cost */
+	if (plansource->generic_cost < 0)
+		return false;
+
+	if (plansource->custom_plans_direct && !plansource->generic_plan_direct)
+		return true;
+
+	if (plansource->generic_plan_gen != plansource->custom_plan_gen)
+		return true;
+
+	avg_custom_cost = plansource->total_custom_cost / plansource->num_custom_plans;
+
+	return plansource->generic_cost > avg_custom_cost * GENERIC_PLAN_COST_FACTOR;
+}
+
+/*
+ * record_plan_cost: remember the cost, the planner, and whether it is direct
+ * dispatched, of a freshly made plan, for choose_custom_plan.
+ */
+static void
+record_plan_cost(CachedPlanSource *plansource, List *stmt_list, bool custom)
+{
+	ListCell   *lc;
+	double		cost = 0;
+	PlanGenerator plangen = PLANGEN_PLANNER;
+	bool		direct = true;
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+
+		cost += plannedstmt->planTree->total_cost;
+		if (plannedstmt->planGen == PLANGEN_OPTIMIZER)
+			plangen = PLANGEN_OPTIMIZER;
+		if (!plannedstmt->planTree->directDispatch.isDirectDispatch)
+			direct = false;
+	}
+
+	if (!custom)
+	{
+		plansource->generic_cost = cost;
+		plansource->generic_plan_gen = plangen;
+		plansource->generic_plan_direct = direct;
+		return;
+	}
+
+	if (!direct)
+		plansource->custom_plans_direct = false;
+
+	/* any custom plan made by ORCA makes the costs incomparable */
+	if (plangen == PLANGEN_OPTIMIZER)
+		plansource->custom_plan_gen = PLANGEN_OPTIMIZER;
+
+	plansource->num_custom_plans++;
+	plansource->total_custom_cost += cost;
+}
+
 /*
  * ReleaseCachedPlan: release active use of a cached plan.
  *
@@ -1118,6 +1289,30 @@ PlanCacheSysCallback(Datum arg, int cacheid, ItemPointer tuplePtr)
 	ResetPlanCache();
 }
 
+/*
+ * PlanCacheStatsCallback
+ *		Syscache inval callback function for STATRELATT cache
+ *
+ * Invalidate the generic plans of statements that have parameters, as with
+ * different statistics, a custom plan might be better. We don't know which
+ * relation the statistics belong to, so invalidate them all.
+ */
+static void
+PlanCacheStatsCallback(Datum arg, int cacheid, ItemPointer tuplePtr)
+{
+	ListCell   *lc;
+
+	foreach(lc, cached_plans_list)
+	{
+		CachedPlanSource *plansource = (CachedPlanSource *) lfirst(lc);
+		CachedPlan *plan = plansource->plan;
+
+		if (plan && plan->fully_planned && !plan->custom &&
+			plansource->num_params > 0)
+			plan->dead = true;
+	}
+}
+
 /*
  * ResetPlanCache: drop all cached plans.
  */
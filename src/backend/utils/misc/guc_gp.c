@@ -184,6 +184,7 @@ bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_verify_eof = true;
 bool		gp_appendonly_compaction = true;
+bool		gp_appendonly_batch_scan = false;
 int			gp_appendonly_compaction_threshold = 0;
 bool		gp_heap_require_relhasoids_match = true;
 bool		Debug_appendonly_rezero_quicklz_compress_scratch = false;
@@ -455,6 +456,7 @@ bool		gp_eager_preunique = FALSE;
 bool		gp_enable_sequential_window_plans = FALSE;
 bool		gp_hashagg_streambottom = true;
 bool		gp_enable_agg_distinct = true;
+bool		gp_enable_generic_plan_reuse = false;
 bool		gp_enable_dqa_pruning = true;
 bool		gp_eager_dqa_pruning = FALSE;
 bool		gp_eager_one_phase_agg = FALSE;
@@ -569,7 +571,13 @@ bool		codegen_exec_variable_list;
 bool		codegen_slot_getattr;
 bool		codegen_exec_eval_expr;
 bool		codegen_advance_aggregate;
+bool		codegen_exec_scan_filter_project;
+bool		codegen_calc_hash_value;
+bool		codegen_exec_hash_get_hash_value;
+bool		codegen_module_cache;
+bool		codegen_async_compile;
 int		codegen_varlen_tolerance;
+int		codegen_module_cache_size;
 int		codegen_optimization_level;
 static char 	*codegen_optimization_level_str = NULL;
 
@@ -784,6 +792,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"gp_enable_generic_plan_reuse", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable reusing generic plans of prepared statements executed with parameters."),
+			gettext_noop("If false, such statements are planned with the parameter values on "
+						 "every execution.")
+		},
+		&gp_enable_generic_plan_reuse,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_enable_preunique", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable 2-phase duplicate removal."),
@@ -1137,6 +1155,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_batch_scan", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Scan append-only columnar tables a batch of rows at a time."),
+			gettext_noop("Simple comparisons of fixed-width columns with constants "
+						 "are evaluated on whole column batches."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL
+		},
+		&gp_appendonly_batch_scan,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -1263,6 +1292,26 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_shm_transport", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Pass interconnect packets to the segments on the same host through shared memory."),
+			gettext_noop("Remote peers are always reached through UDP."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_shm_transport,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_compress", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Compress the data packets of the UDP interconnect."),
+			gettext_noop("Motions whose packets do not compress well are sent uncompressed."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_compress,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_full_crc", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sanity check incoming data stream."),
@@ -3223,6 +3272,68 @@ struct config_bool ConfigureNamesBool_gp[] =
 #endif
 		assign_codegen, NULL
 	},
+	{
+		{"codegen_exec_scan_filter_project", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for the fused qual and projection loop of table scans"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_exec_scan_filter_project,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_calc_hash_value", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for the hash value computation of hash aggregates"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_calc_hash_value,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_exec_hash_get_hash_value", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for the hash value computation of hash joins"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_exec_hash_get_hash_value,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_module_cache", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Reuse object code compiled by any backend of this segment for identical generated modules"),
+			gettext_noop("Compiled modules are kept in the pg_codegen_cache directory, up to codegen_module_cache_size, and the directory can be removed at any time."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_module_cache,
+		false,
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_async_compile", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Compile generated code in a background thread while the regular functions are in use"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_async_compile,
+		false,
+		assign_codegen, NULL
+	},
 
 	{
 		{"vmem_process_interrupt", PGC_USERSET, DEVELOPER_OPTIONS,
@@ -3686,6 +3797,36 @@ struct config_int ConfigureNamesInt_gp[] =
 		2, 1, 4096, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_mmsg_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of packets sent or received with one system call by the UDP interconnect"),
+			gettext_noop("1 sends and receives every packet with its own system call."),
+			GUC_GPDB_ADDOPT
+		},
+		&Gp_interconnect_mmsg_batch_size,
+		16, 1, 64, NULL, NULL
+	},
+
+	{
+		{"gp_motion_hash_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of tuples a Redistribute Motion hashes at once."),
+			gettext_noop("1 hashes and sends every tuple as it comes."),
+			GUC_GPDB_ADDOPT
+		},
+		&Gp_motion_hash_batch_size,
+		64, 1, 1024, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_rx_threads", PGC_BACKEND, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of threads receiving packets of the UDP interconnect in every process"),
+			gettext_noop("Every thread has its own socket on the interconnect port, the senders are spread across them by their pid. Only used where SO_ATTACH_REUSEPORT_CBPF is supported."),
+			GUC_GPDB_ADDOPT
+		},
+		&Gp_interconnect_rx_threads,
+		1, 1, 16, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_timer_period", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the timer period (in ms) for UDP interconnect"),
@@ -4621,6 +4762,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"codegen_module_cache_size", PGC_SIGHUP, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum size of the compiled modules kept in the pg_codegen_cache directory."),
+			gettext_noop("The least recently used modules are removed to make room for new ones. Zero disables storing new modules."),
+			GUC_UNIT_KB | GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_module_cache_size,
+		65536, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"dtx_phase2_retry_count", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Maximum number of retries during two phase commit after which master PANICs."),
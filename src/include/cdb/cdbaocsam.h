@@ -67,6 +67,61 @@ typedef struct AOCSInsertDescData
 
 typedef AOCSInsertDescData *AOCSInsertDesc;
 
+/*
+ * Batch mode of AOCS scans.
+ *
+ * In batch mode the scan decodes up to AOCS_BATCH_SIZE values of every
+ * projected column at once, one column at a time, and evaluates simple
+ * "column op constant" quals on these column vectors before any tuple is
+ * formed.  Rows rejected by the batch quals are never returned; the others
+ * are still checked by the executor's own qual.
+ *
+ * Batch mode is only used when all the projected columns are pass-by-value,
+ * so the decoded datums stay valid after their block has been consumed.
+ */
+#define AOCS_BATCH_SIZE 1024
+
+typedef enum AOCSBatchQualOp
+{
+	AOCSBatchQualOp_Eq,
+	AOCSBatchQualOp_Ne,
+	AOCSBatchQualOp_Lt,
+	AOCSBatchQualOp_Le,
+	AOCSBatchQualOp_Gt,
+	AOCSBatchQualOp_Ge
+} AOCSBatchQualOp;
+
+typedef enum AOCSBatchQualType
+{
+	AOCSBatchQualType_Int2,
+	AOCSBatchQualType_Int4,
+	AOCSBatchQualType_Int8,
+	AOCSBatchQualType_Float8
+} AOCSBatchQualType;
+
+typedef struct AOCSBatchQual
+{
+	int			attno;			/* 0-based column number */
+	AOCSBatchQualType type;
+	AOCSBatchQualOp op;
+	Datum		value;			/* the constant, never NULL */
+} AOCSBatchQual;
+
+typedef struct AOCSBatch
+{
+	int			nrows;			/* number of rows in the batch */
+	int			nextrow;		/* next row to return */
+	bool		segExhausted;	/* current segment file has no more rows */
+
+	Datum	  **values;			/* per column, NULL if not projected */
+	bool	  **nulls;
+	int64	   *rowNums;
+	bool	   *selected;		/* rows that passed all the batch quals */
+
+	int			nquals;
+	AOCSBatchQual *quals;
+} AOCSBatch;
+
 /*
  * used for scan of append only relations using BufferedRead and VarBlocks
  */
@@ -119,6 +174,9 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/* Batch mode state, NULL unless aocs_begin_batchmode() succeeded */
+	AOCSBatch  *batch;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
@@ -206,6 +264,7 @@ extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
 extern void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
+extern bool aocs_begin_batchmode(AOCSScanDesc scan, AOCSBatchQual *quals, int nquals);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
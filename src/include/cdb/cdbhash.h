@@ -78,6 +78,14 @@ extern void cdbhashnokey(CdbHash *h);
  */
 extern unsigned int cdbhashreduce(CdbHash *h);
 
+/*
+ * Hash a batch of n tuples: initialize their hash values, add one attribute
+ * of all of them at a time, and reduce the hash values to segment numbers.
+ */
+extern void cdbhashinitbatch(uint32 *hashes, int n);
+extern void cdbhashbatch(uint32 *hashes, Datum *values, bool *isnull, int n, Oid typid);
+extern void cdbhashreducebatch(CdbHash *h, uint32 *hashes, int n);
+
 /*
  * Return true if Oid is hashable internally in Greenplum Database.
  */
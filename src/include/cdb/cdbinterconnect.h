@@ -285,6 +285,12 @@ struct MotionConn
 	 * all the remap information.
 	 */
 	TupleRemapper	*remapper;
+
+	/*
+	 * shared memory channel of the data packets when the peer is on the same
+	 * host, NULL if all packets go through UDP.
+	 */
+	struct ICShmChannel *shmChannel;
 };
 
 /*
@@ -321,6 +327,13 @@ typedef struct ChunkTransportStateEntry
 	uint64 stat_max_resent;
 	uint64 stat_count_dropped;
 
+	/*
+	 * Adaptive packet compression: number of packets still to be sent
+	 * uncompressed, and how many to skip after the next failed attempt.
+	 */
+	int			compressSkip;
+	int			compressBackoff;
+
 }	ChunkTransportStateEntry;
 
 /* ChunkTransportState array initial size */
@@ -437,6 +450,11 @@ typedef struct MotionNodeEntry
 	uint64          stat_tuples_available;  /* Total tuples awaiting receive. */
 	uint64          stat_tuples_available_hwm;              /* High-water-mark of this
 		* value. */
+	uint64          stat_compress_bytes_in; /* Packet payload bytes offered to compression. */
+	uint64          stat_compress_bytes_out;        /* The same payloads, as sent. */
+	uint64          stat_decompress_bytes_in;       /* Compressed chunk bytes received. */
+	uint64          stat_decompress_bytes_out;      /* Bytes they decompressed to. */
+
 	uint64          sel_rd_wait;            /* Total time (usec) spent in select wait trying to read */
 	uint64          sel_wr_wait;            /* Total time spent (usec) in select wait trying to write */
 
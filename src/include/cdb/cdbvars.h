@@ -438,6 +438,56 @@ extern int	Gp_interconnect_min_rto;
 extern int  Gp_interconnect_transmit_timeout;
 extern int	Gp_interconnect_min_retries_before_timeout;
 
+/*
+ * Parameter Gp_interconnect_mmsg_batch_size
+ *
+ * The run-time parameter Gp_interconnect_mmsg_batch_size controls the
+ * maximum number of packets the UDP interconnect receives or sends with
+ * one recvmmsg()/sendmmsg() call.  1 disables batching.
+ *
+ * This guc is specific to the UDP-interconnect.
+ *
+ */
+extern int	Gp_interconnect_mmsg_batch_size;
+
+/*
+ * Parameter Gp_interconnect_rx_threads
+ *
+ * The run-time parameter Gp_interconnect_rx_threads controls the number of
+ * background threads receiving packets, each with its own socket bound to
+ * the interconnect port with SO_REUSEPORT. Platforms without
+ * SO_ATTACH_REUSEPORT_CBPF always use one thread.
+ *
+ * This guc is specific to the UDP-interconnect.
+ *
+ */
+extern int	Gp_interconnect_rx_threads;
+
+/*
+ * Parameter gp_interconnect_shm_transport
+ *
+ * Pass the data packets of the UDP interconnect to peers on the same host
+ * through shared memory instead of the socket.
+ */
+extern bool gp_interconnect_shm_transport;
+
+/*
+ * Parameter gp_interconnect_compress
+ *
+ * Compress the data packets of the UDP interconnect before sending them.  A
+ * motion that does not compress well stops trying for a while.
+ */
+extern bool gp_interconnect_compress;
+
+/*
+ * Parameter gp_motion_hash_batch_size
+ *
+ * Number of tuples a Redistribute Motion sender hashes at once before sending
+ * them.  1 hashes and sends every tuple as it comes, and so do Motions of rows
+ * wider than MOTION_HASH_BATCH_MAX_WIDTH bytes (see nodeMotion.c).
+ */
+extern int	Gp_motion_hash_batch_size;
+
 /* UDP recv buf size in KB.  For testing */
 extern int 	Gp_udp_bufsize_k;
 
@@ -794,6 +844,15 @@ extern bool gp_enable_sort_limit;
  */
 extern bool gp_enable_sort_distinct;
 
+/*
+ * "gp_enable_generic_plan_reuse"
+ *
+ * May a prepared statement that is executed with parameter values reuse a
+ * generic plan, made without the values, instead of being planned again on
+ * every execution?  See choose_custom_plan() in plancache.c.
+ */
+extern bool gp_enable_generic_plan_reuse;
+
 /* Greenplum MK Sort */
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
@@ -31,7 +31,12 @@ struct ProjectionInfo;
 struct ExprContext;
 struct ExprState;
 struct PlanState;
+struct ScanState;
 struct AggState;
+struct HashState;
+struct HashJoinState;
+struct HashJoinTableData;
+struct List;
 struct MemoryManagerContainer;
 struct AggStatePerGroupData;
 /*
@@ -45,6 +50,9 @@ typedef void (*AdvanceAggregatesFn) (struct AggState *aggstate, /*struct AggStat
 typedef void (*ExecVariableListFn) (struct ProjectionInfo *projInfo, Datum *values, bool *isnull);
 typedef Datum (*ExecEvalExprFn) (struct ExprState *expression, struct ExprContext *econtext, bool *isNull, /*ExprDoneCond*/ tmp_enum *isDone);
 typedef Datum (*SlotGetAttrFn) (struct TupleTableSlot *slot, int attnum, bool *isnull);
+typedef struct TupleTableSlot *(*ExecScanFilterProjectFn) (struct ScanState *node, struct TupleTableSlot *slot);
+typedef uint32 (*CalcHashValueFn) (struct AggState *aggstate, struct TupleTableSlot *inputslot);
+typedef bool (*ExecHashGetHashValueFn) (struct HashState *hashState, struct HashJoinTableData *hashtable, struct ExprContext *econtext, struct List *hashkeys, bool outer_tuple, bool keep_nulls, uint32 *hashvalue, bool *hashkeys_null);
 
 #ifndef USE_CODEGEN
 
@@ -55,6 +63,10 @@ typedef Datum (*SlotGetAttrFn) (struct TupleTableSlot *slot, int attnum, bool *i
 #define CodeGeneratorManagerNotifyParameterChange(manager) ((unsigned int) 1)
 #define CodeGeneratorManagerAccumulateExplainString(manager) ((void) 1)
 #define CodeGeneratorManagerGetExplainString(manager) ((char *) NULL)
+#define CodeGeneratorManagerGetCompileStats(manager, cache_hits, cache_misses, compile_ms) ((void) 1)
+#define CodeGeneratorManagerPollGeneratedFunctions(manager) (false)
+#define CodeGeneratorManagerPendingCount 0
+#define CodeGeneratorManagerAbortPending() ((void) 1)
 #define CodeGeneratorManagerDestroy(manager) ((void) 1)
 #define GetActiveCodeGeneratorManager() ((void *) NULL)
 #define SetActiveCodeGeneratorManager(manager) ((void) 1)
@@ -67,6 +79,13 @@ typedef Datum (*SlotGetAttrFn) (struct TupleTableSlot *slot, int attnum, bool *i
 #define enroll_ExecVariableList_codegen(regular_func, ptr_to_chosen_func, proj_info, slot)
 #define call_AdvanceAggregates(aggstate, pergroup, mem_manager) advance_aggregates(aggstate, pergroup, mem_manager)
 #define enroll_AdvanceAggregates_codegen(regular_func, ptr_to_chosen_func, aggstate)
+#define call_ExecScanFilterProject(node, slot) ExecScanFilterProject(node, slot)
+#define enroll_ExecScanFilterProject_codegen(regular_func, ptr_to_chosen_func, node)
+#define call_CalcHashValue(aggstate, inputslot) calc_hash_value(aggstate, inputslot)
+#define enroll_CalcHashValue_codegen(regular_func, ptr_to_chosen_func, aggstate)
+#define call_ExecHashGetHashValue(gen_info, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		ExecHashGetHashValue(hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+#define enroll_ExecHashGetHashValue_codegen(regular_func, ptr_to_chosen_func, gen_info, hjstate, outer_tuple)
 #else
 
 /*
@@ -149,6 +168,34 @@ CodeGeneratorManagerAccumulateExplainString(void* manager);
 char*
 CodeGeneratorManagerGetExplainString(void* manager);
 
+/*
+ * Number of managers compiling in the background whose generated functions
+ * have not been swapped in yet
+ */
+extern int CodeGeneratorManagerPendingCount;
+
+/*
+ * Swaps in the generated functions of a manager once its background
+ * compilation has finished. Returns true if it finished with this call
+ */
+bool
+CodeGeneratorManagerPollGeneratedFunctions(void* manager);
+
+/*
+ * Waits for and destroys the managers still compiling in the background when
+ * the transaction aborts, after the portals have been cleaned up
+ */
+void
+CodeGeneratorManagerAbortPending(void);
+
+/*
+ * Return the compilation statistics of a manager: number of modules found in
+ * and missing from the compiled module cache, and compilation time in ms
+ */
+void
+CodeGeneratorManagerGetCompileStats(void* manager, int* cache_hits,
+		int* cache_misses, double* compile_ms);
+
 /*
  * Get the active code generator manager
  */
@@ -212,6 +259,31 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 		AdvanceAggregatesFn* ptr_to_regular_func_ptr,
 		struct AggState *aggstate);
 
+/*
+ * Enroll and returns the pointer to ExecScanFilterProjectGenerator
+ */
+void*
+ExecScanFilterProjectCodegenEnroll(ExecScanFilterProjectFn regular_func_ptr,
+		ExecScanFilterProjectFn* ptr_to_regular_func_ptr,
+		struct ScanState *node);
+
+/*
+ * Enroll and returns the pointer to CalcHashValueGenerator
+ */
+void*
+CalcHashValueCodegenEnroll(CalcHashValueFn regular_func_ptr,
+		CalcHashValueFn* ptr_to_regular_func_ptr,
+		struct AggState *aggstate);
+
+/*
+ * Enroll and returns the pointer to ExecHashGetHashValueGenerator
+ */
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+		ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+		struct HashJoinState *hjstate,
+		bool outer_tuple);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -269,6 +341,29 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 #define call_AdvanceAggregates(aggstate, pergroup, mem_manager) \
 		aggstate->AdvanceAggregates_gen_info.AdvanceAggregates_fn(aggstate, pergroup, mem_manager)
 
+/*
+ * Call ExecScanFilterProject using function pointer ExecScanFilterProject_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_ExecScanFilterProject(node, slot) \
+		node->ExecScanFilterProject_gen_info.ExecScanFilterProject_fn(node, slot)
+
+/*
+ * Call calc_hash_value using function pointer CalcHashValue_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_CalcHashValue(aggstate, inputslot) \
+		(aggstate)->CalcHashValue_gen_info.CalcHashValue_fn(aggstate, inputslot)
+
+/*
+ * Call ExecHashGetHashValue using function pointer ExecHashGetHashValue_fn
+ * of the given gen_info, which belongs to the HashState for the inner side
+ * and to the HashJoinState for the outer side of a hash join.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_ExecHashGetHashValue(gen_info, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		(gen_info).ExecHashGetHashValue_fn(hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+
 /*
  * Enrollment macros
  * The enrollment process also ensures that the generated function pointer
@@ -289,6 +384,21 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 				regular_func, ptr_to_regular_func_ptr, aggstate); \
 				Assert(aggstate->AdvanceAggregates_gen_info.AdvanceAggregates_fn == regular_func); \
 
+#define enroll_ExecScanFilterProject_codegen(regular_func, ptr_to_regular_func_ptr, node) \
+		(node)->ExecScanFilterProject_gen_info.code_generator = ExecScanFilterProjectCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, node); \
+				Assert((node)->ExecScanFilterProject_gen_info.ExecScanFilterProject_fn == regular_func); \
+
+#define enroll_CalcHashValue_codegen(regular_func, ptr_to_regular_func_ptr, aggstate) \
+		(aggstate)->CalcHashValue_gen_info.code_generator = CalcHashValueCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, aggstate); \
+				Assert((aggstate)->CalcHashValue_gen_info.CalcHashValue_fn == regular_func); \
+
+#define enroll_ExecHashGetHashValue_codegen(regular_func, ptr_to_regular_func_ptr, gen_info, hjstate, outer_tuple) \
+		(gen_info).code_generator = ExecHashGetHashValueCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, hjstate, outer_tuple); \
+				Assert((gen_info).ExecHashGetHashValue_fn == regular_func); \
+
 #endif //USE_CODEGEN
 
 #endif  // CODEGEN_WRAPPER_H_
@@ -19,6 +19,10 @@
 #include "access/attnum.h"
 #include "utils/faultinjector.h"
 
+// maximum length of a metadata provider cache key, including the
+// terminating zero
+#define MDPROVIDER_CACHE_KEYLEN 64
+
 // fwd declarations
 typedef struct SysScanDescData *SysScanDesc;
 typedef int LOCKMODE;
@@ -190,6 +194,10 @@ namespace gpdb {
 	// attribute statistics
 	HeapTuple HtAttrStats(Oid relid, AttrNumber attnum);
 
+	// load the statistics of all attributes of a relation into the catalog
+	// cache, so that the following HtAttrStats calls don't scan pg_statistic
+	void PrefetchAttrStats(Oid relid);
+
 	// function oids
 	List *PlFunctionOids(void);
 
@@ -625,6 +633,19 @@ namespace gpdb {
 	// table has been changed?)
 	bool FMDCacheNeedsReset(void);
 
+	// look up the serialized DXL of a metadata object in the metadata
+	// provider cache, returns NULL if it is not there
+	const gpos::WCHAR *WszMDProviderCacheLookup(const char *szKey);
+
+	// number of catalog invalidations seen so far, to be taken before
+	// translating an object for MDProviderCacheInsert
+	int64 LlMDCacheInvalidationCounter(void);
+
+	// add the serialized DXL of a metadata object belonging to the given
+	// relation (or index) to the metadata provider cache, unless there were
+	// invalidations since llInvalidationCounter was taken
+	void MDProviderCacheInsert(const char *szKey, Oid oidRel, bool fStats, bool fIndex, const gpos::WCHAR *wszDXL, gpos::ULONG ulLength, int64 llInvalidationCounter);
+
 } //namespace gpdb
 
 #define ForEach(cell, l)	\
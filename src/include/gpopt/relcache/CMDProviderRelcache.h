@@ -52,6 +52,10 @@ namespace gpmd
 			// private copy ctor
 			CMDProviderRelcache(const CMDProviderRelcache&);
 
+			// oid of the relation whose invalidation invalidates the given object
+			static
+			OID OidRelation(IMDId *pmdid);
+
 		public:
 			// ctor/dtor
 			explicit
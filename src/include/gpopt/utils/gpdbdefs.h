@@ -53,6 +53,7 @@ extern "C" {
 #include "optimizer/tlist.h"
 #include "nodes/makefuncs.h"
 #include "catalog/pg_operator.h"
+#include "lib/dllist.h"
 #include "lib/stringinfo.h"
 #include "utils/elog.h"
 #include "utils/rel.h"
@@ -66,6 +67,10 @@ extern "C" {
 #include "utils/selfuncs.h"
 #include "utils/faultinjector.h"
 #include "funcapi.h"
+#include "cdb/cdbvars.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
 
 extern
 Query *preprocess_query_optimizer(Query *pquery, ParamListInfo boundParams);
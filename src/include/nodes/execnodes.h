@@ -1624,6 +1624,14 @@ typedef enum
 	TableTypeInvalid,
 } TableType;
 
+typedef struct ExecScanFilterProjectCodegenInfo
+{
+	/* Pointer to store ExecScanFilterProjectCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated ExecScanFilterProject */
+	ExecScanFilterProjectFn ExecScanFilterProject_fn;
+} ExecScanFilterProjectCodegenInfo;
+
 /* ----------------
  *	 ScanState information
  *
@@ -1649,6 +1657,10 @@ typedef struct ScanState
 
 	/* The type of the table that is being scanned */
 	TableType	tableType;
+
+#ifdef USE_CODEGEN
+	ExecScanFilterProjectCodegenInfo ExecScanFilterProject_gen_info;
+#endif
 } ScanState;
 
 /*
@@ -2212,6 +2224,14 @@ typedef struct MergeJoinState
 typedef struct HashJoinTupleData *HashJoinTuple;
 typedef struct HashJoinTableData *HashJoinTable;
 
+typedef struct ExecHashGetHashValueCodegenInfo
+{
+	/* Pointer to store ExecHashGetHashValueCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated ExecHashGetHashValue */
+	ExecHashGetHashValueFn ExecHashGetHashValue_fn;
+} ExecHashGetHashValueCodegenInfo;
+
 typedef struct HashJoinState
 {
 	JoinState	js;				/* its first field is NodeTag */
@@ -2237,6 +2257,11 @@ typedef struct HashJoinState
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
+
+#ifdef USE_CODEGEN
+	/* hashes the outer tuples, see HashState for the inner ones */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
+#endif
 } HashJoinState;
 
 
@@ -2350,6 +2375,14 @@ typedef struct AdvanceAggregatesCodegenInfo
 	AdvanceAggregatesFn AdvanceAggregates_fn;
 } AdvanceAggregatesCodegenInfo;
 
+typedef struct CalcHashValueCodegenInfo
+{
+	/* Pointer to store CalcHashValueCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated calc_hash_value */
+	CalcHashValueFn CalcHashValue_fn;
+} CalcHashValueCodegenInfo;
+
 /* these structs are private in nodeAgg.c: */
 typedef struct AggStatePerAggData *AggStatePerAgg;
 typedef struct AggStatePerGroupData *AggStatePerGroup;
@@ -2410,6 +2443,7 @@ typedef struct AggState
 
 #ifdef USE_CODEGEN
 	AdvanceAggregatesCodegenInfo AdvanceAggregates_gen_info;
+	CalcHashValueCodegenInfo CalcHashValue_gen_info;
 #endif
 } AggState;
 
@@ -2502,6 +2536,11 @@ typedef struct HashState
 	bool		hs_quit_if_hashkeys_null;	/* quit building hash table if hashkeys are all null */
 	bool		hs_hashkeys_null;	/* found an instance wherein hashkeys are all null */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+
+#ifdef USE_CODEGEN
+	/* enrolled by the parent HashJoin, which owns the hash keys */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
+#endif
 } HashState;
 
 /* ----------------
@@ -2643,6 +2682,15 @@ typedef struct MotionState
 	List	   *hashExpr;		/* state struct used for evaluating the hash expressions */
 	struct CdbHash *cdbhash;	/* hash api object */
 
+	/* For batched hash motion send, see execMotionSenderBatch() */
+	int			batchSize;		/* tuples hashed at once; 0 if not batching */
+	struct TupleTableSlot **batchSlots;	/* copies of the tuples of the batch */
+	Datum	   *batchValues;	/* key values of the batch, key by key */
+	bool	   *batchIsnull;	/* and whether they are NULL */
+	uint32	   *batchHashes;	/* hash values, then segment numbers */
+	int		   *batchOrder;		/* batch indexes grouped by segment */
+	int		   *batchSegCounts;	/* work space of the grouping */
+
 	/* For Motion recv */
 	void	   *tupleheap;		/* data structure for match merge in sorted motion node */
 	int			routeIdNext;	/* for a sorted motion node, the routeId to get next (same as
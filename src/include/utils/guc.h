@@ -184,6 +184,7 @@ extern bool gp_appendonly_verify_block_checksums;
 extern bool gp_appendonly_verify_write_block;
 extern bool gp_appendonly_verify_eof;
 extern bool gp_appendonly_compaction;
+extern bool gp_appendonly_batch_scan;
 
 /*
  * Threshold of the ratio of dirty data in a segment file
@@ -86,6 +86,7 @@ typedef NumericData *Numeric;
 extern double numeric_to_double_no_overflow(Numeric num);
 extern int64 numeric_to_pos_int8_trunc(Numeric num);
 extern int cmp_numerics(Numeric num1, Numeric num2);
+extern Numeric add_numerics(Numeric num1, Numeric num2);
 extern float8 numeric_li_fraction(Numeric x, Numeric x0, Numeric x1, 
 								  bool *eq_bounds, bool *eq_abscissas);
 extern Numeric numeric_li_value(float8 f, Numeric y0, Numeric y1);
@@ -107,4 +108,20 @@ typedef struct IntFloatAvgTransdata
 
 extern Datum intfloat_avg_accum_decum(IntFloatAvgTransdata *transdata, float8 newval, bool acc);
 
+/*
+ * Routines for avg numeric type.  The transition datatype is a int64 for count, and a numeric for sum.
+ */
+
+typedef struct NumericAvgTransData
+{
+	int32 _len; /* varattrib len, do not touch directly */
+#if 1
+	int32   pad;  /* pad so int64 and float64 will be 8 bytes alligned */
+#endif
+	int64 count; 
+	NumericData sum;
+} NumericAvgTransData;
+
+extern Datum numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc);
+
 #endif   /* _PG_NUMERIC_H_ */
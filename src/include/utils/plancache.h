@@ -18,6 +18,7 @@
 #include "access/tupdesc.h"
 #include "nodes/params.h"
 #include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
 
 /*
  * CachedPlanSource represents the portion of a cached plan that persists
@@ -63,6 +64,22 @@ typedef struct CachedPlanSource
 	struct CachedPlan *plan;	/* link to plan, or NULL if not valid */
 	MemoryContext context;		/* context containing this CachedPlanSource */
 	struct CachedPlan *orig_plan;		/* link to plan owning my context */
+
+	/*
+	 * GPDB: information for choosing between custom and generic plans, see
+	 * choose_custom_plan(). Reset when the plan is invalidated.
+	 */
+	int			num_custom_plans;	/* # of custom plans considered */
+	double		total_custom_cost;	/* total cost of those custom plans */
+	PlanGenerator custom_plan_gen;	/* who made them, ORCA if any of them */
+	bool		custom_plans_direct;	/* were all of them direct dispatched? */
+	double		generic_cost;	/* cost of generic plan, or -1 if not known */
+	PlanGenerator generic_plan_gen; /* who made the generic plan */
+	bool		generic_plan_direct;	/* was the generic plan direct dispatched? */
+
+	/* GPDB: counters shown in pg_prepared_statements */
+	int64		num_generic_execs;	/* # of executions using a generic plan */
+	int64		num_custom_execs;	/* # of executions using a custom plan */
 } CachedPlanSource;
 
 /*
@@ -78,6 +95,8 @@ typedef struct CachedPlan
 	List	   *stmt_list;		/* list of statement or Query nodes */
 	bool		fully_planned;	/* do we cache planner or rewriter output? */
 	bool		dead;			/* if true, do not use */
+	bool		custom;			/* GPDB: made for specific parameter values
+								 * or CREATE TABLE AS, use only once */
 	TransactionId saved_xmin;	/* if valid, replan when TransactionXmin
 								 * changes from this value */
 	int			refcount;		/* count of live references to this struct */
@@ -0,0 +1,147 @@
+--
+-- Test scanning AOCS tables in batches (gp_appendonly_batch_scan). Every
+-- query is run with batch scans off and on, and must return the same result.
+--
+-- Only the quals of the form "column op constant" on int2, int4, int8, date
+-- and float8 columns are evaluated on the batches, the others are written
+-- so that they are not.
+--
+
+CREATE TABLE aocs_batch_scan (
+	id int,
+	i2 int2,
+	i4 int4 ENCODING (compresstype=rle_type),
+	i8 int8,
+	f8 float8,
+	d date,
+	t text
+) WITH (appendonly=true, orientation=column, compresstype=zlib, compresslevel=1)
+DISTRIBUTED BY (id);
+
+INSERT INTO aocs_batch_scan
+SELECT id,
+	CASE WHEN id % 17 = 0 THEN NULL ELSE id % 200 - 100 END,
+	CASE WHEN id % 13 = 0 THEN NULL ELSE id * 7 % 1000 - 500 END,
+	CASE WHEN id % 11 = 0 THEN NULL
+		 WHEN id % 2 = 0 THEN id::int8 * 10000000000
+		 ELSE -id::int8 * 10000000000 END,
+	CASE WHEN id % 50 = 0 THEN 'NaN'::float8
+		 WHEN id % 19 = 0 THEN NULL
+		 WHEN id % 97 = 0 THEN '-Infinity'::float8
+		 ELSE (id % 100 / 4.0 - 10)::float8 END,
+	CASE WHEN id % 23 = 0 THEN NULL ELSE date '2000-01-01' + id % 400 END,
+	'row ' || id
+FROM generate_series(1, 6000) id;
+
+-- Move the rows left by the DELETE to a new segment file, and add more rows
+-- to another one.
+DELETE FROM aocs_batch_scan WHERE id % 3 = 0;
+VACUUM aocs_batch_scan;
+
+INSERT INTO aocs_batch_scan
+SELECT id,
+	CASE WHEN id % 17 = 0 THEN NULL ELSE id % 200 - 100 END,
+	CASE WHEN id % 13 = 0 THEN NULL ELSE id * 7 % 1000 - 500 END,
+	CASE WHEN id % 11 = 0 THEN NULL
+		 WHEN id % 2 = 0 THEN id::int8 * 10000000000
+		 ELSE -id::int8 * 10000000000 END,
+	CASE WHEN id % 50 = 0 THEN 'NaN'::float8
+		 WHEN id % 19 = 0 THEN NULL
+		 WHEN id % 97 = 0 THEN '-Infinity'::float8
+		 ELSE (id % 100 / 4.0 - 10)::float8 END,
+	CASE WHEN id % 23 = 0 THEN NULL ELSE date '2000-01-01' + id % 400 END,
+	'row ' || id
+FROM generate_series(6001, 9000) id;
+
+-- Rows hidden by the visibility map must stay hidden.
+DELETE FROM aocs_batch_scan WHERE id % 7 = 0;
+
+SELECT count(DISTINCT segno) > 1 AS many_segfiles
+FROM gp_toolkit.__gp_aocsseg_name('aocs_batch_scan') WHERE tupcount > 0;
+
+-- Keep a copy of the rows read without batch scans.
+SET gp_appendonly_batch_scan = off;
+CREATE TABLE aocs_batch_scan_off AS
+SELECT id, i2, i4, i8, f8, d FROM aocs_batch_scan WHERE i4 > -200
+DISTRIBUTED BY (id);
+
+-- Integer quals
+SET gp_appendonly_batch_scan = off;
+SELECT count(*), sum(id), sum(i2), sum(i8) FROM aocs_batch_scan
+WHERE i4 < 0 AND i2 >= -50::int2;
+SELECT count(*), min(i4), max(i4) FROM aocs_batch_scan
+WHERE 0::int8 < i8 AND i2 <> 7::int2;
+SET gp_appendonly_batch_scan = on;
+SELECT count(*), sum(id), sum(i2), sum(i8) FROM aocs_batch_scan
+WHERE i4 < 0 AND i2 >= -50::int2;
+SELECT count(*), min(i4), max(i4) FROM aocs_batch_scan
+WHERE 0::int8 < i8 AND i2 <> 7::int2;
+
+-- Float quals, NaN sorts above all other values
+SET gp_appendonly_batch_scan = off;
+SELECT 'f8 > 5' AS qual, count(*) FROM aocs_batch_scan WHERE f8 > 5
+UNION ALL
+SELECT 'f8 <= 5', count(*) FROM aocs_batch_scan WHERE f8 <= 5
+UNION ALL
+SELECT 'f8 = 2.75', count(*) FROM aocs_batch_scan WHERE f8 = 2.75
+UNION ALL
+SELECT 'f8 <> 2.75', count(*) FROM aocs_batch_scan WHERE f8 <> 2.75
+UNION ALL
+SELECT 'f8 < Infinity', count(*) FROM aocs_batch_scan WHERE f8 < 'Infinity'
+UNION ALL
+SELECT 'f8 >= NaN', count(*) FROM aocs_batch_scan WHERE f8 >= 'NaN';
+SET gp_appendonly_batch_scan = on;
+SELECT 'f8 > 5' AS qual, count(*) FROM aocs_batch_scan WHERE f8 > 5
+UNION ALL
+SELECT 'f8 <= 5', count(*) FROM aocs_batch_scan WHERE f8 <= 5
+UNION ALL
+SELECT 'f8 = 2.75', count(*) FROM aocs_batch_scan WHERE f8 = 2.75
+UNION ALL
+SELECT 'f8 <> 2.75', count(*) FROM aocs_batch_scan WHERE f8 <> 2.75
+UNION ALL
+SELECT 'f8 < Infinity', count(*) FROM aocs_batch_scan WHERE f8 < 'Infinity'
+UNION ALL
+SELECT 'f8 >= NaN', count(*) FROM aocs_batch_scan WHERE f8 >= 'NaN';
+
+-- Date quals
+SET gp_appendonly_batch_scan = off;
+SELECT count(*), min(id), max(id) FROM aocs_batch_scan
+WHERE d >= '2000-03-01' AND d < '2000-07-01';
+SET gp_appendonly_batch_scan = on;
+SELECT count(*), min(id), max(id) FROM aocs_batch_scan
+WHERE d >= '2000-03-01' AND d < '2000-07-01';
+
+-- NULLs
+SET gp_appendonly_batch_scan = off;
+SELECT count(*), count(i2), count(i4) FROM aocs_batch_scan WHERE i2 > -1000::int2;
+SELECT count(*) FROM aocs_batch_scan WHERE i4 IS NULL AND i8 IS NOT NULL;
+SET gp_appendonly_batch_scan = on;
+SELECT count(*), count(i2), count(i4) FROM aocs_batch_scan WHERE i2 > -1000::int2;
+SELECT count(*) FROM aocs_batch_scan WHERE i4 IS NULL AND i8 IS NOT NULL;
+
+-- Projections without the qual columns
+SET gp_appendonly_batch_scan = off;
+SELECT count(*), sum(i2) FROM aocs_batch_scan WHERE i8 < 0::int8 AND i4 >= 100;
+SELECT count(*) FROM aocs_batch_scan WHERE i4 = 3;
+SET gp_appendonly_batch_scan = on;
+SELECT count(*), sum(i2) FROM aocs_batch_scan WHERE i8 < 0::int8 AND i4 >= 100;
+SELECT count(*) FROM aocs_batch_scan WHERE i4 = 3;
+
+-- A by-reference column is projected, the scan does not use batches
+SET gp_appendonly_batch_scan = on;
+SELECT count(*), max(t) FROM aocs_batch_scan WHERE i2 = 7::int2;
+
+-- Compare all the rows with the copy
+SET gp_appendonly_batch_scan = on;
+SELECT count(*) FROM (
+	SELECT id, i2, i4, i8, f8, d FROM aocs_batch_scan WHERE i4 > -200
+	EXCEPT ALL
+	SELECT * FROM aocs_batch_scan_off) x;
+SELECT count(*) FROM (
+	SELECT * FROM aocs_batch_scan_off
+	EXCEPT ALL
+	SELECT id, i2, i4, i8, f8, d FROM aocs_batch_scan WHERE i4 > -200) x;
+
+RESET gp_appendonly_batch_scan;
+DROP TABLE aocs_batch_scan_off;
+DROP TABLE aocs_batch_scan;
@@ -0,0 +1,41 @@
+--
+-- Test passing interconnect packets to the segments on the same host through
+-- shared memory (gp_interconnect_shm_transport). All data packets of such a
+-- connection go through its ring, which has gp_interconnect_queue_depth slots.
+--
+CREATE TABLE ic_shm (a int, b int, c text) DISTRIBUTED BY (a);
+INSERT INTO ic_shm SELECT i, i % 1000, repeat('x', 50) || i FROM generate_series(1, 200000) i;
+
+SET gp_interconnect_shm_transport = on;
+
+-- Redistribute
+SELECT count(*), sum(t1.a), sum(length(t2.c))
+FROM ic_shm t1 JOIN ic_shm t2 ON t1.a = t2.b;
+
+-- Gather
+SELECT count(*), sum(length(c)) FROM (SELECT a, c FROM ic_shm ORDER BY a LIMIT 150000) x;
+
+-- The receivers stop the senders early
+SELECT count(*) FROM (SELECT t2.c FROM ic_shm t1 JOIN ic_shm t2 ON t1.a = t2.b LIMIT 10) x;
+SELECT count(*) FROM (SELECT c FROM ic_shm LIMIT 100) x;
+
+-- The next statements use new rings
+SELECT count(*), sum(t1.a), sum(length(t2.c))
+FROM ic_shm t1 JOIN ic_shm t2 ON t1.a = t2.b;
+SELECT count(*), sum(length(c)) FROM (SELECT a, c FROM ic_shm ORDER BY a LIMIT 150000) x;
+
+-- Rings of a single slot
+SET gp_interconnect_queue_depth = 1;
+SELECT count(*), sum(t1.a), sum(length(t2.c))
+FROM ic_shm t1 JOIN ic_shm t2 ON t1.a = t2.b;
+SELECT count(*), sum(length(c)) FROM (SELECT a, c FROM ic_shm ORDER BY a LIMIT 150000) x;
+RESET gp_interconnect_queue_depth;
+
+-- Same results through UDP only
+SET gp_interconnect_shm_transport = off;
+SELECT count(*), sum(t1.a), sum(length(t2.c))
+FROM ic_shm t1 JOIN ic_shm t2 ON t1.a = t2.b;
+SELECT count(*), sum(length(c)) FROM (SELECT a, c FROM ic_shm ORDER BY a LIMIT 150000) x;
+
+RESET gp_interconnect_shm_transport;
+DROP TABLE ic_shm;
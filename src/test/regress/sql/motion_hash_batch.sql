@@ -0,0 +1,119 @@
+--
+-- Test that a Redistribute Motion sends every row to the same segment
+-- whether it hashes the rows one at a time (gp_motion_hash_batch_size = 1)
+-- or in batches (the default). The rows of the table are narrow enough to
+-- be hashed in batches.
+--
+
+CREATE TYPE mhb_color AS ENUM ('red', 'green', 'blue');
+
+CREATE TABLE mhb (
+	id int,
+	i2 int2,
+	i4 int4,
+	i8 int8,
+	o oid,
+	rc regclass,
+	e mhb_color,
+	d date,
+	ts timestamp,
+	tstz timestamptz,
+	t text
+) DISTRIBUTED BY (id);
+
+INSERT INTO mhb
+SELECT id,
+	CASE WHEN id % 17 = 0 THEN NULL ELSE id % 300 - 150 END,
+	CASE WHEN id % 13 = 0 THEN NULL ELSE id * 7919 % 100000 - 50000 END,
+	CASE WHEN id % 11 = 0 THEN NULL
+		 WHEN id % 2 = 0 THEN id * 123456789012
+		 ELSE id * -123456789012 END,
+	CASE WHEN id % 19 = 0 THEN NULL ELSE (id * 3 + 16384)::oid END,
+	CASE WHEN id % 23 = 0 THEN NULL ELSE (id % 100 + 1)::oid::regclass END,
+	CASE WHEN id % 29 = 0 THEN NULL
+		 ELSE (ARRAY['red', 'green', 'blue']::mhb_color[])[id % 3 + 1] END,
+	CASE WHEN id % 31 = 0 THEN NULL ELSE date '2000-01-01' + (id % 1000 - 500) END,
+	CASE WHEN id % 37 = 0 THEN NULL
+		 ELSE timestamp '2000-01-01' + (id - 2500) * interval '37 minutes 11 seconds' END,
+	CASE WHEN id % 41 = 0 THEN NULL
+		 ELSE timestamptz '2000-01-01 00:00:00+00' + (id - 2500) * interval '1 day 1 second' END,
+	CASE WHEN id % 43 = 0 THEN NULL ELSE 'text ' || id % 500 END
+FROM generate_series(1, 5000) id;
+
+-- Distribute the rows by every key, one row at a time and in batches
+SET gp_motion_hash_batch_size = 1;
+CREATE TABLE mhb_i2_1 AS SELECT * FROM mhb DISTRIBUTED BY (i2);
+CREATE TABLE mhb_i4_1 AS SELECT * FROM mhb DISTRIBUTED BY (i4);
+CREATE TABLE mhb_i8_1 AS SELECT * FROM mhb DISTRIBUTED BY (i8);
+CREATE TABLE mhb_o_1 AS SELECT * FROM mhb DISTRIBUTED BY (o);
+CREATE TABLE mhb_rc_1 AS SELECT * FROM mhb DISTRIBUTED BY (rc);
+CREATE TABLE mhb_e_1 AS SELECT * FROM mhb DISTRIBUTED BY (e);
+CREATE TABLE mhb_d_1 AS SELECT * FROM mhb DISTRIBUTED BY (d);
+CREATE TABLE mhb_ts_1 AS SELECT * FROM mhb DISTRIBUTED BY (ts);
+CREATE TABLE mhb_tstz_1 AS SELECT * FROM mhb DISTRIBUTED BY (tstz);
+CREATE TABLE mhb_t_1 AS SELECT * FROM mhb DISTRIBUTED BY (t);
+CREATE TABLE mhb_multi_1 AS SELECT * FROM mhb DISTRIBUTED BY (i2, e, t, d);
+
+RESET gp_motion_hash_batch_size;
+CREATE TABLE mhb_i2_n AS SELECT * FROM mhb DISTRIBUTED BY (i2);
+CREATE TABLE mhb_i4_n AS SELECT * FROM mhb DISTRIBUTED BY (i4);
+CREATE TABLE mhb_i8_n AS SELECT * FROM mhb DISTRIBUTED BY (i8);
+CREATE TABLE mhb_o_n AS SELECT * FROM mhb DISTRIBUTED BY (o);
+CREATE TABLE mhb_rc_n AS SELECT * FROM mhb DISTRIBUTED BY (rc);
+CREATE TABLE mhb_e_n AS SELECT * FROM mhb DISTRIBUTED BY (e);
+CREATE TABLE mhb_d_n AS SELECT * FROM mhb DISTRIBUTED BY (d);
+CREATE TABLE mhb_ts_n AS SELECT * FROM mhb DISTRIBUTED BY (ts);
+CREATE TABLE mhb_tstz_n AS SELECT * FROM mhb DISTRIBUTED BY (tstz);
+CREATE TABLE mhb_t_n AS SELECT * FROM mhb DISTRIBUTED BY (t);
+CREATE TABLE mhb_multi_n AS SELECT * FROM mhb DISTRIBUTED BY (i2, e, t, d);
+
+-- Every row must be on the same segment in both tables, id is unique
+SELECT 'i2' AS key, count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_i2_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_i2_n) x
+UNION ALL
+SELECT 'i4', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_i4_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_i4_n) x
+UNION ALL
+SELECT 'i8', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_i8_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_i8_n) x
+UNION ALL
+SELECT 'o', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_o_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_o_n) x
+UNION ALL
+SELECT 'rc', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_rc_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_rc_n) x
+UNION ALL
+SELECT 'e', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_e_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_e_n) x
+UNION ALL
+SELECT 'd', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_d_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_d_n) x
+UNION ALL
+SELECT 'ts', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_ts_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_ts_n) x
+UNION ALL
+SELECT 'tstz', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_tstz_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_tstz_n) x
+UNION ALL
+SELECT 't', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_t_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_t_n) x
+UNION ALL
+SELECT 'multi', count(*) FROM (
+	SELECT gp_segment_id, id FROM mhb_multi_1 EXCEPT ALL SELECT gp_segment_id, id FROM mhb_multi_n) x;
+
+-- Joins and aggregates that redistribute on the fly
+SET gp_motion_hash_batch_size = 1;
+SELECT count(*), count(DISTINCT a.i8), sum(b.i4) FROM mhb a JOIN mhb b ON a.i4 = b.i2;
+SELECT e, count(*), count(DISTINCT d), count(tstz) FROM mhb GROUP BY e;
+SELECT count(*) FROM (SELECT t FROM mhb GROUP BY t LIMIT 10) x;
+RESET gp_motion_hash_batch_size;
+SELECT count(*), count(DISTINCT a.i8), sum(b.i4) FROM mhb a JOIN mhb b ON a.i4 = b.i2;
+SELECT e, count(*), count(DISTINCT d), count(tstz) FROM mhb GROUP BY e;
+SELECT count(*) FROM (SELECT t FROM mhb GROUP BY t LIMIT 10) x;
+
+DROP TABLE mhb_i2_1, mhb_i4_1, mhb_i8_1, mhb_o_1, mhb_rc_1, mhb_e_1,
+	mhb_d_1, mhb_ts_1, mhb_tstz_1, mhb_t_1, mhb_multi_1;
+DROP TABLE mhb_i2_n, mhb_i4_n, mhb_i8_n, mhb_o_n, mhb_rc_n, mhb_e_n,
+	mhb_d_n, mhb_ts_n, mhb_tstz_n, mhb_t_n, mhb_multi_n;
+DROP TABLE mhb;
+DROP TYPE mhb_color;
@@ -809,3 +809,10 @@ INSERT INTO num_input_test(n1) VALUES ('');
 INSERT INTO num_input_test(n1) VALUES (' N aN ');
 
 SELECT * FROM num_input_test;
+
+--
+-- sum() and avg() on both sides of the limit of the 128-bit integer fast
+-- path of numeric addition
+--
+SELECT sum(x), avg(x) = sum(x) / count(x) AS avg_ok FROM (VALUES (1.5), (-0.25), (0.000001), (12345678901234567890123456789012.1), (12345678901234567890123456789012.1)) v(x);
+SELECT sum(x), avg(x) = sum(x) / count(x) AS avg_ok FROM (VALUES (1.5), (-0.25), (0.000001), (12345678901234567890123456789012.1), (12345678901234567890123456789012.1), (-99999999999999999999999999999999999999.9)) v(x);
@@ -0,0 +1,64 @@
+--
+-- Test that ORCA sees the changes made to a partitioned table between two
+-- queries, when the metadata of the table and its partitions is served from
+-- the metadata provider cache. Every query is planned once before the change,
+-- to populate the cache, and once after it.
+--
+
+SET optimizer = on;
+SET client_min_messages = warning;
+
+-- Estimated number of rows of the top plan node of a query
+CREATE FUNCTION orca_mdcache_rows(query text) RETURNS int AS
+$$
+DECLARE
+	explainrow text;
+BEGIN
+	FOR explainrow IN EXECUTE 'EXPLAIN ' || query
+	LOOP
+		RETURN substring(explainrow FROM 'rows=([0-9]+)')::int;
+	END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE orca_mdcache (a int, b int, c int)
+DISTRIBUTED BY (a)
+PARTITION BY RANGE (b) (START (0) END (40) EVERY (10));
+
+INSERT INTO orca_mdcache SELECT i, i % 40, i % 7 FROM generate_series(1, 1000) i;
+
+-- An index on a leaf partition
+SELECT count(*), sum(a) FROM orca_mdcache WHERE c = 3 AND b >= 10 AND b < 20;
+CREATE INDEX orca_mdcache_leaf_idx ON orca_mdcache_1_prt_2 (c);
+SELECT count(*), sum(a) FROM orca_mdcache WHERE c = 3 AND b >= 10 AND b < 20;
+DROP INDEX orca_mdcache_leaf_idx;
+SELECT count(*), sum(a) FROM orca_mdcache WHERE c = 3 AND b >= 10 AND b < 20;
+
+-- New statistics. The query results do not depend on them, so check the
+-- row estimates instead: 25 rows with the old ones, 75 with the new ones.
+ANALYZE orca_mdcache;
+SELECT orca_mdcache_rows('SELECT * FROM orca_mdcache WHERE b = 15') BETWEEN 10 AND 40 AS old_stats;
+INSERT INTO orca_mdcache SELECT i, i % 40, i % 7 FROM generate_series(1001, 3000) i;
+ANALYZE orca_mdcache;
+SELECT orca_mdcache_rows('SELECT * FROM orca_mdcache WHERE b = 15') BETWEEN 50 AND 100 AS new_stats;
+
+-- A new distribution key. With the old one, the query would be dispatched
+-- to a single segment, and the join would not redistribute its inputs.
+SELECT count(*) FROM orca_mdcache WHERE a = 77;
+SELECT count(*) FROM orca_mdcache x JOIN orca_mdcache y ON x.a = y.a WHERE x.b < 5;
+ALTER TABLE orca_mdcache SET DISTRIBUTED BY (c);
+SELECT count(*) FROM orca_mdcache WHERE a = 77;
+SELECT count(*) FROM orca_mdcache x JOIN orca_mdcache y ON x.a = y.a WHERE x.b < 5;
+
+-- A new column and a new partition of the root
+SELECT count(*), sum(b) FROM orca_mdcache WHERE b >= 35;
+ALTER TABLE orca_mdcache ADD COLUMN d int DEFAULT 1;
+ALTER TABLE orca_mdcache ADD PARTITION START (40) END (50);
+INSERT INTO orca_mdcache SELECT i, 40 + i % 10, i % 7, 2 FROM generate_series(1, 500) i;
+SELECT count(*), sum(b) FROM orca_mdcache WHERE b >= 35;
+SELECT count(*), sum(d) FROM orca_mdcache WHERE b >= 35;
+
+DROP TABLE orca_mdcache;
+DROP FUNCTION orca_mdcache_rows(text);
+RESET client_min_messages;
+RESET optimizer;
@@ -76,3 +76,36 @@ DEALLOCATE ALL;
 SELECT name, statement, parameter_types FROM pg_prepared_statements
     ORDER BY name;
 
+
+-- with gp_enable_generic_plan_reuse, a statement executed with parameters
+-- switches to a generic plan once a few custom plans have been made
+SET gp_enable_generic_plan_reuse = on;
+PREPARE q8(int) AS SELECT unique2 FROM tenk1 WHERE unique2 = $1;
+EXECUTE q8(1);
+EXECUTE q8(2);
+EXECUTE q8(3);
+EXECUTE q8(4);
+EXECUTE q8(5);
+EXECUTE q8(6);
+EXECUTE q8(7);
+EXECUTE q8(8);
+SELECT name, generic_plans > 0 AS generic, custom_plans >= 5 AS custom
+    FROM pg_prepared_statements WHERE name = 'q8';
+
+-- but not if the parameter is compared with the distribution key, so that
+-- the custom plans are dispatched to a single segment, and the generic plan
+-- is not
+PREPARE q9(int) AS SELECT unique1 FROM tenk1 WHERE unique1 = $1;
+EXECUTE q9(1);
+EXECUTE q9(2);
+EXECUTE q9(3);
+EXECUTE q9(4);
+EXECUTE q9(5);
+EXECUTE q9(6);
+EXECUTE q9(7);
+EXECUTE q9(8);
+SELECT name, generic_plans, custom_plans
+    FROM pg_prepared_statements WHERE name = 'q9';
+RESET gp_enable_generic_plan_reuse;
+DEALLOCATE q8;
+DEALLOCATE q9;
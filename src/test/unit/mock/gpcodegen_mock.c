@@ -70,6 +70,38 @@ CodeGeneratorManagerGetExplainString(void* manager)
 	return NULL;
 }
 
+int CodeGeneratorManagerPendingCount = 0;
+
+/*
+ * Swaps in the generated functions of a manager once its background
+ * compilation has finished
+ */
+bool
+CodeGeneratorManagerPollGeneratedFunctions(void* manager)
+{
+	elog(ERROR, "mock implementation of CodeGeneratorManagerPollGeneratedFunctions called");
+	return false;
+}
+
+/*
+ * Waits for and destroys the managers still compiling in the background when
+ * the transaction aborts
+ */
+void
+CodeGeneratorManagerAbortPending(void)
+{
+}
+
+/*
+ * Return the compilation statistics of a manager
+ */
+void
+CodeGeneratorManagerGetCompileStats(void* manager, int* cache_hits,
+		int* cache_misses, double* compile_ms)
+{
+	elog(ERROR, "mock implementation of CodeGeneratorManagerGetCompileStats called");
+}
+
 // get the active code generator manager
 void*
 GetActiveCodeGeneratorManager()
@@ -120,3 +152,34 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 	return NULL;
 }
 
+
+// Enroll and returns the pointer to ExecScanFilterProjectGenerator
+void*
+ExecScanFilterProjectCodegenEnroll(ExecScanFilterProjectFn regular_func_ptr,
+		ExecScanFilterProjectFn* ptr_to_regular_func_ptr,
+		struct ScanState *node) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of ExecScanFilterProjectCodegenEnroll called");
+	return NULL;
+}
+
+// Enroll and returns the pointer to CalcHashValueGenerator
+void*
+CalcHashValueCodegenEnroll(CalcHashValueFn regular_func_ptr,
+		CalcHashValueFn* ptr_to_regular_func_ptr,
+		struct AggState *aggstate) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of CalcHashValueCodegenEnroll called");
+	return NULL;
+}
+
+// Enroll and returns the pointer to ExecHashGetHashValueGenerator
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+		ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+		struct HashJoinState *hjstate,
+		bool outer_tuple) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of ExecHashGetHashValueCodegenEnroll called");
+	return NULL;
+}